@@ -60,6 +60,15 @@
          calling stbir_resize_extended_profile_info() or stbir_resize_split_profile_info()
          after a resize.
 
+      THREADING
+         You can split a resize across threads yourself with the extended API
+         (stbir_build_samplers_with_splits and stbir_resize_extended_split), or
+         call stbir_resize_extended_threaded with a callback into your own job
+         system. If you define STBIR_USE_THREADS before the implementation
+         #include, we also include a small pthreads/Win32 thread pool to use as
+         that job system (stbir_thread_pool_create, stbir_thread_pool_dispatch).
+         The output is identical to a single threaded resize.
+
       SIMD
          Most of the routines have optimized SSE2, AVX, NEON and WASM versions.
 
@@ -78,7 +87,10 @@
          On x86 platforms, you can also define STBIR_FP16C to turn on FP16C instructions
          for converting back and forth to half-floats. This is autoselected when we
          are using AVX2. Clang and GCC also require the -mf16c switch. ARM always uses
-         the built-in half float hardware NEON instructions.
+         the built-in half float hardware NEON instructions. BFLOAT16 just needs
+         shifts and adds, so it uses whichever SIMD is on (8 at a time on AVX2). To
+         pick the F16C and AVX2 coders at runtime, use the dispatch build below - the
+         AVX2 and AVX-512 variants only run on cpus with F16C.
 
          You can also tell us to use multiply-add instructions with STBIR_USE_FMA.
          Because x86 doesn't always have fma, we turn it off by default to maintain
@@ -90,6 +102,42 @@
          off AVX or AVX2 specifically with STBIR_NO_AVX or STBIR_NO_AVX2. AVX is 10%
          to 40% faster, and AVX2 is generally another 12%.
 
+         When compiling for AVX-512 (-mavx512f or /arch:AVX512, or defining
+         STBIR_AVX512), the vertical resamplers use 512-bit registers on top of
+         AVX2 for everything else. STBIR_NO_AVX512 turns that off.
+
+      RUNTIME CPU DISPATCH
+         The SIMD choices above are made at compile time. To ship one binary that
+         uses AVX2 or AVX-512 when the cpu has them, compile the implementation
+         once per instruction set, each in its own file, plus one more file
+         that picks between them at runtime:
+
+            // stbir_base.c   (normal switches)
+            #define STBIR_DISPATCH_BASE
+            #define STB_IMAGE_RESIZE_IMPLEMENTATION
+            #include "stb_image_resize2.h"
+
+            // stbir_avx2.c   (-mavx2 -mf16c, or /arch:AVX2)
+            #define STBIR_DISPATCH_AVX2
+            ...same two lines...
+
+            // stbir_avx512.c (-mavx512f -mf16c, or /arch:AVX512)
+            #define STBIR_DISPATCH_AVX512
+            ...same two lines...
+
+            // stbir_dispatch.c (normal switches)
+            #define STBIR_RUNTIME_DISPATCH
+            ...same two lines...
+
+         The variants get _base, _avx2 and _avx512 suffixes on all of their
+         functions, and the dispatch file provides the normal API, which calls
+         the best variant the cpu (and OS) supports. If you don't build one of
+         the variants, define STBIR_DISPATCH_NO_AVX512 (or STBIR_DISPATCH_NO_AVX2)
+         in the dispatch file. All four files must agree on any other STBIR_
+         defines. Because we are deterministic, every variant produces the same
+         pixels. You can query or limit the variant with stbir_get_dispatch_level
+         and stbir_set_dispatch_level.
+
       ALPHA CHANNEL
          Most of the resizing functions provide the ability to control how the alpha
          channel of an image is processed.
@@ -410,6 +458,66 @@ typedef uint64_t stbir_uint64;
 #endif
 #endif
 
+// when building one of the runtime dispatch variants (see RUNTIME CPU DISPATCH),
+//   every entry point gets a suffix, so the variants can be linked together
+#if defined(STBIR_DISPATCH_BASE) || defined(STBIR_DISPATCH_AVX2) || defined(STBIR_DISPATCH_AVX512)
+  #define STBIR__DISPATCH_PASTE2( a, b ) a##b
+  #define STBIR__DISPATCH_PASTE( a, b ) STBIR__DISPATCH_PASTE2( a, b )
+  #if defined(STBIR_DISPATCH_AVX512)
+    #define STBIR__DISPATCH_NAME( name ) STBIR__DISPATCH_PASTE( name, _avx512 )
+  #elif defined(STBIR_DISPATCH_AVX2)
+    #define STBIR__DISPATCH_NAME( name ) STBIR__DISPATCH_PASTE( name, _avx2 )
+  #else
+    #define STBIR__DISPATCH_NAME( name ) STBIR__DISPATCH_PASTE( name, _base )
+  #endif
+  #define stbir_resize_uint8_srgb                   STBIR__DISPATCH_NAME( stbir_resize_uint8_srgb )
+  #define stbir_resize_uint8_linear                 STBIR__DISPATCH_NAME( stbir_resize_uint8_linear )
+  #define stbir_resize_float_linear                 STBIR__DISPATCH_NAME( stbir_resize_float_linear )
+  #define stbir_resize                              STBIR__DISPATCH_NAME( stbir_resize )
+  #define stbir_resize_init                         STBIR__DISPATCH_NAME( stbir_resize_init )
+  #define stbir_set_datatypes                       STBIR__DISPATCH_NAME( stbir_set_datatypes )
+  #define stbir_set_pixel_callbacks                 STBIR__DISPATCH_NAME( stbir_set_pixel_callbacks )
+  #define stbir_set_user_data                       STBIR__DISPATCH_NAME( stbir_set_user_data )
+  #define stbir_set_buffer_ptrs                     STBIR__DISPATCH_NAME( stbir_set_buffer_ptrs )
+  #define stbir_set_output_color_matrix             STBIR__DISPATCH_NAME( stbir_set_output_color_matrix )
+  #define stbir_set_pixel_layouts                   STBIR__DISPATCH_NAME( stbir_set_pixel_layouts )
+  #define stbir_set_edgemodes                       STBIR__DISPATCH_NAME( stbir_set_edgemodes )
+  #define stbir_set_filters                         STBIR__DISPATCH_NAME( stbir_set_filters )
+  #define stbir_set_filter_callbacks                STBIR__DISPATCH_NAME( stbir_set_filter_callbacks )
+  #define stbir_set_pixel_subrect                   STBIR__DISPATCH_NAME( stbir_set_pixel_subrect )
+  #define stbir_set_input_subrect                   STBIR__DISPATCH_NAME( stbir_set_input_subrect )
+  #define stbir_set_output_pixel_subrect            STBIR__DISPATCH_NAME( stbir_set_output_pixel_subrect )
+  #define stbir_set_non_pm_alpha_speed_over_quality STBIR__DISPATCH_NAME( stbir_set_non_pm_alpha_speed_over_quality )
+  #define stbir_set_uint8_fixed_point               STBIR__DISPATCH_NAME( stbir_set_uint8_fixed_point )
+  #define stbir_build_samplers                      STBIR__DISPATCH_NAME( stbir_build_samplers )
+  #define stbir_free_samplers                       STBIR__DISPATCH_NAME( stbir_free_samplers )
+  #define stbir_resize_extended                     STBIR__DISPATCH_NAME( stbir_resize_extended )
+  #define stbir_build_samplers_with_splits          STBIR__DISPATCH_NAME( stbir_build_samplers_with_splits )
+  #define stbir_resize_extended_split               STBIR__DISPATCH_NAME( stbir_resize_extended_split )
+  #define stbir_resize_extended_threaded            STBIR__DISPATCH_NAME( stbir_resize_extended_threaded )
+  #define stbir_resize_batch                        STBIR__DISPATCH_NAME( stbir_resize_batch )
+  #define stbir_thread_pool_create                  STBIR__DISPATCH_NAME( stbir_thread_pool_create )
+  #define stbir_thread_pool_destroy                 STBIR__DISPATCH_NAME( stbir_thread_pool_destroy )
+  #define stbir_thread_pool_dispatch                STBIR__DISPATCH_NAME( stbir_thread_pool_dispatch )
+  #define stbir_sampler_cache_create                STBIR__DISPATCH_NAME( stbir_sampler_cache_create )
+  #define stbir_sampler_cache_destroy               STBIR__DISPATCH_NAME( stbir_sampler_cache_destroy )
+  #define stbir_build_samplers_from_cache           STBIR__DISPATCH_NAME( stbir_build_samplers_from_cache )
+  #define stbir_build_mipmaps                       STBIR__DISPATCH_NAME( stbir_build_mipmaps )
+  #define stbir_resize_mipmaps_extended             STBIR__DISPATCH_NAME( stbir_resize_mipmaps_extended )
+  #define stbir_free_mipmaps                        STBIR__DISPATCH_NAME( stbir_free_mipmaps )
+  #define stbir_resize_mipmaps                      STBIR__DISPATCH_NAME( stbir_resize_mipmaps )
+  #define stbir_warp_affine                         STBIR__DISPATCH_NAME( stbir_warp_affine )
+  #define stbir_calibrate_vertical_first            STBIR__DISPATCH_NAME( stbir_calibrate_vertical_first )
+  #define stbir_reset_vertical_first_calibration    STBIR__DISPATCH_NAME( stbir_reset_vertical_first_calibration )
+  #define stbir_get_vertical_first_calibration      STBIR__DISPATCH_NAME( stbir_get_vertical_first_calibration )
+  #define stbir_set_vertical_first_calibration      STBIR__DISPATCH_NAME( stbir_set_vertical_first_calibration )
+  #define stbir_save_vertical_first_calibration     STBIR__DISPATCH_NAME( stbir_save_vertical_first_calibration )
+  #define stbir_load_vertical_first_calibration     STBIR__DISPATCH_NAME( stbir_load_vertical_first_calibration )
+  #define stbir_resize_build_profile_info           STBIR__DISPATCH_NAME( stbir_resize_build_profile_info )
+  #define stbir_resize_extended_profile_info        STBIR__DISPATCH_NAME( stbir_resize_extended_profile_info )
+  #define stbir_resize_split_profile_info           STBIR__DISPATCH_NAME( stbir_resize_split_profile_info )
+#endif
+
 //////////////////////////////////////////////////////////////////////////////
 ////   start "header file" ///////////////////////////////////////////////////
 //
@@ -483,7 +591,7 @@ STBIRDEF float * stbir_resize_float_linear( const float *input_pixels , int inpu
 //
 // This extends the easy-to-use API as follows:
 //
-//     * Can specify the datatype - U8, U8_SRGB, U16, FLOAT, HALF_FLOAT
+//     * Can specify the datatype - U8, U8_SRGB, U16, FLOAT, HALF_FLOAT, BFLOAT16
 //     * Edge wrap can selected explicitly
 //     * Filter can be selected explicitly
 //--------------------------------
@@ -515,7 +623,8 @@ typedef enum
   STBIR_TYPE_UINT8_SRGB_ALPHA = 2,  // alpha channel, when present, should also be SRGB (this is very unusual)
   STBIR_TYPE_UINT16           = 3,
   STBIR_TYPE_FLOAT            = 4,
-  STBIR_TYPE_HALF_FLOAT       = 5
+  STBIR_TYPE_HALF_FLOAT       = 5,
+  STBIR_TYPE_BFLOAT16         = 6,  // top 16 bits of a float (ML tensor formats) - rounds to nearest even on output
 } stbir_datatype;
 
 // medium api
@@ -582,6 +691,9 @@ typedef struct STBIR_RESIZE  // use the stbir_resize_init and stbir_override fun
   int output_stride_in_bytes;
   int splits;
   int fast_alpha;
+  int uint8_fixed_point;
+  int use_output_color_matrix;
+  float output_color_matrix[12];
   int needs_rebuild;
   int called_alloc;
   stbir_pixel_layout input_pixel_layout_public;
@@ -613,6 +725,18 @@ STBIRDEF void stbir_set_pixel_callbacks( STBIR_RESIZE * resize, stbir_input_call
 STBIRDEF void stbir_set_user_data( STBIR_RESIZE * resize, void * user_data );                                               // pass back STBIR_RESIZE* by default
 STBIRDEF void stbir_set_buffer_ptrs( STBIR_RESIZE * resize, const void * input_pixels, int input_stride_in_bytes, void * output_pixels, int output_stride_in_bytes );
 
+// applies a 3x4 color matrix to every output pixel, in linear float just before it's
+//   encoded (so in the same pass as the resize). The matrix is 12 floats, row by row:
+//     r' = m[0]*r + m[1]*g + m[2]*b + m[3]  (then g' from m[4..7], and b' from m[8..11])
+//   The channels are always named in RGB order, whatever the output layout is, and
+//   alpha passes through. If the output is premultiplied, the offsets are scaled by
+//   alpha (so it's the same as applying the matrix before premultiplying). Channel
+//   swaps and premultiplying on the way out don't need this - just use a swizzled or
+//   _PM output layout with stbir_set_pixel_layouts. Pass NULL to turn it off. Returns
+//   0 (and is ignored) for 1 and 2 channel layouts. The uint8 fixed point path is
+//   skipped when a matrix is set.
+STBIRDEF int stbir_set_output_color_matrix( STBIR_RESIZE * resize, float const * matrix );
+
 //===============================================================
 
 
@@ -635,6 +759,19 @@ STBIRDEF int stbir_set_output_pixel_subrect( STBIR_RESIZE * resize, int subx, in
 //   zero alpha, you can call this function to get about a 25% speed improvement for STBIR_RGBA to STBIR_RGBA
 //   types of resizes.
 STBIRDEF int stbir_set_non_pm_alpha_speed_over_quality( STBIR_RESIZE * resize, int non_pma_alpha_speed_over_quality );
+
+// for STBIR_TYPE_UINT8 in and out (linear, not sRGB), you can resample with 16-bit fixed point
+//   math instead of floats, when scaling down (thumbnails, say). This reads your input bytes
+//   directly, so there's no decode buffer and no ring of float scanlines (just one 16-bit
+//   scanline), and is about 1.1x to 1.5x faster than floats (up to ~1.7x at big reductions with
+//   AVX2). Coefficients have 14 bits of fraction and the vertically resampled values have 6,
+//   so every output pixel is within 1 of the float result (and usually identical). It's only
+//   used where it measurably wins, which is scaling down vertically between 1/4 (1/7 for 2
+//   channel layouts) and ~1/8 - milder reductions are no faster than floats, or slower. It
+//   also needs the input and output layouts the same, no alpha weighting (so 1 to 4 channels,
+//   or the _PM layouts), no callbacks, and no wrap edge mode horizontally. Otherwise, we
+//   quietly use the float path.
+STBIRDEF int stbir_set_uint8_fixed_point( STBIR_RESIZE * resize, int use_fixed_point );
 //===============================================================
 
 
@@ -686,6 +823,259 @@ STBIRDEF int stbir_resize_extended_split( STBIR_RESIZE * resize, int split_start
 //===============================================================
 
 
+//===============================================================
+// Built-in threading driver.
+//   Rather than dispatching the splits yourself, you can hand us a callback
+//   into your job system, and we'll build the splits, run them through it
+//   (most expensive first), and return when they're all done.
+//--------------------------------
+
+// One unit of work: runs task number task_index (0 to task_count-1).
+typedef void stbir_task_func( void * task_data, int task_index );
+
+// Your job system: call task( task_data, i ) once for every i from 0 to task_count-1
+//   on any threads in any order (although starting them in increasing order balances
+//   best), and only return once they have all finished.
+typedef void stbir_dispatch_callback( stbir_task_func * task, void * task_data, int task_count, void * dispatch_context );
+
+// Resizes on up to max_threads threads. If the samplers aren't built, we build them with
+//   max_threads * STBIR_SPLITS_PER_THREAD splits and free them when done (just like
+//   stbir_resize_extended); if you built them with stbir_build_samplers_with_splits,
+//   your splits are used. If dispatch is NULL, we use a temporary stbir_thread_pool
+//   when compiled with STBIR_USE_THREADS, otherwise the splits run on this thread.
+STBIRDEF int stbir_resize_extended_threaded( STBIR_RESIZE * resize, int max_threads, stbir_dispatch_callback * dispatch, void * dispatch_context );
+
+#ifdef STBIR_USE_THREADS
+// Simple default job system on pthreads (or Win32 threads). num_threads includes the
+//   thread calling dispatch, so a pool of 8 starts 7 worker threads. Create one and
+//   pass stbir_thread_pool_dispatch with the pool as the dispatch_context to avoid
+//   starting threads on every resize. Only dispatch from one thread at a time.
+typedef struct stbir_thread_pool stbir_thread_pool;
+
+STBIRDEF stbir_thread_pool * stbir_thread_pool_create( int num_threads, void * user_data ); // user_data is passed to STBIR_MALLOC
+STBIRDEF void stbir_thread_pool_destroy( stbir_thread_pool * pool );
+STBIRDEF void stbir_thread_pool_dispatch( stbir_task_func * task, void * task_data, int task_count, void * pool );
+#endif
+//===============================================================
+
+
+//===============================================================
+// Batch resizing
+//   Resizes many images with the same geometry (sizes, subrects, layouts, datatypes,
+//   filters and edges) in one call. The samplers are built once and every image runs
+//   back to back through the same coefficients (and scanline buffers), so for lots of
+//   small images (sprite crops, thumbnails, ML inputs) you don't pay the per-resize
+//   setup over and over. With more than one thread, the images are divided evenly
+//   between the threads, and each thread gets its own scanline buffers (the
+//   coefficients are still shared).
+//--------------------------------
+
+typedef struct stbir_batch_image
+{
+  const void * input_pixels;
+  int input_stride_in_bytes;   // 0 for packed
+  void * output_pixels;
+  int output_stride_in_bytes;  // 0 for packed
+} stbir_batch_image;
+
+// Set up resize as usual (the buffer pointers in it are ignored), and this resizes each
+//   of the images with it. If the samplers aren't built, we build them (with one split)
+//   and free them when done, otherwise yours are used. max_threads, dispatch and
+//   dispatch_context work like stbir_resize_extended_threaded (and with max_threads
+//   of 1 or less, everything runs on this thread). Returns 1 for success.
+STBIRDEF int stbir_resize_batch( STBIR_RESIZE * resize, stbir_batch_image const * images, int image_count, int max_threads, stbir_dispatch_callback * dispatch, void * dispatch_context );
+//===============================================================
+
+
+//===============================================================
+// Sampler cache
+//   Building the samplers (the filter contributors and coefficients) can cost
+//   as much as a small resize. If you resize lots of images with the same few
+//   geometries, a sampler cache builds the coefficients for each geometry once,
+//   and shares them (read-only) between every STBIR_RESIZE that matches, on any
+//   thread, with any pixel buffers. Each STBIR_RESIZE still gets its own
+//   scanline buffers, so they can all run at the same time.
+//
+//   The geometry is the sizes, subrects, pixel layouts, filters and edges (not the
+//   datatypes, pixel pointers, strides or callbacks). Cached samplers are built
+//   with the cache's user_data, which is also what custom filter callbacks get.
+//--------------------------------
+
+typedef struct stbir_sampler_cache stbir_sampler_cache;
+
+// max_entries is the number of geometries to keep - once it's full, new geometries
+//   are just built normally. user_data is passed to STBIR_MALLOC.
+STBIRDEF stbir_sampler_cache * stbir_sampler_cache_create( int max_entries, void * user_data );
+
+// You must free every STBIR_RESIZE built from the cache before destroying it.
+STBIRDEF void stbir_sampler_cache_destroy( stbir_sampler_cache * cache );
+
+// Like stbir_build_samplers_with_splits, but shares the coefficients from the cache
+//   (building and adding them if this geometry is new). Free with stbir_free_samplers
+//   as usual. When compiled with STBIR_USE_THREADS, this is safe to call from many
+//   threads at once - otherwise, you must serialize calls that share a cache (the
+//   resizes themselves can run in parallel either way).
+STBIRDEF int stbir_build_samplers_from_cache( STBIR_RESIZE * resize, stbir_sampler_cache * cache, int try_splits );
+//===============================================================
+
+
+//===============================================================
+// Mipmap chain API
+//   Generates mip levels 1 to N of an image in one call. The full size input is
+//   decoded only once (straight into a linear float, premultiplied copy of level 1),
+//   then each level is resized from the float copy of the level above it, and
+//   encoded back to your datatype and layout. All of the coefficient sets are
+//   built once, so a STBIR_MIPMAPS can be reused for every texture of the same size.
+//
+//   Level n is max(1,input_w>>n) by max(1,input_h>>n) pixels. Since each level is
+//   made from the previous one (and not from the original), the results are not
+//   bit-identical to calling stbir_resize for each level, but are the same quality
+//   for the standard filters. FLOAT images are resized level to level directly
+//   in your output buffers (there's nothing to decode).
+//--------------------------------
+
+typedef struct STBIR_MIPMAPS  // use stbir_build_mipmaps to fill this out
+{
+  void * user_data;
+  int input_w, input_h;
+  int levels;                 // number of levels generated (not counting the input)
+  stbir_pixel_layout pixel_layout;
+  stbir_datatype data_type;
+  STBIR_RESIZE * resizes;     // level resizes, then the encoding resizes (when not float)
+} STBIR_MIPMAPS;
+
+// Builds the samplers for levels 1 to num_levels (0 for all of them, down to 1x1).
+//   user_data is passed to STBIR_MALLOC. Returns 1 for success, 0 for failure.
+STBIRDEF int stbir_build_mipmaps( STBIR_MIPMAPS * mips, int input_w, int input_h, int num_levels,
+                                  stbir_pixel_layout pixel_layout, stbir_datatype data_type,
+                                  stbir_edge edge, stbir_filter filter, void * user_data );
+
+// Resizes input_pixels into level_pixels[0] (level 1) to level_pixels[mips->levels-1].
+//   level_strides can be NULL (or contain zeros) for packed levels.
+STBIRDEF int stbir_resize_mipmaps_extended( STBIR_MIPMAPS * mips, const void * input_pixels, int input_stride_in_bytes,
+                                            void * const * level_pixels, int const * level_strides );
+
+STBIRDEF void stbir_free_mipmaps( STBIR_MIPMAPS * mips );
+
+// One shot version of the three calls above - returns the number of levels generated
+//   (0 on failure, or for a 1x1 input). level_pixels must have room for num_levels
+//   entries (or every level, when num_levels is 0).
+STBIRDEF int stbir_resize_mipmaps( const void * input_pixels, int input_w, int input_h, int input_stride_in_bytes,
+                                   void * const * level_pixels, int const * level_strides, int num_levels,
+                                   stbir_pixel_layout pixel_layout, stbir_datatype data_type,
+                                   stbir_edge edge, stbir_filter filter );
+//===============================================================
+
+
+//===============================================================
+// Affine warp
+//   Resamples the input through a 2x3 matrix that maps output pixel
+//   coordinates to input pixel coordinates (so it's the inverse of the
+//   transform you want to apply to the image):
+//
+//     input_x = matrix[0] * output_x + matrix[1] * output_y + matrix[2]
+//     input_y = matrix[3] * output_x + matrix[4] * output_y + matrix[5]
+//
+//   Coordinates are continuous, with pixel centers at +0.5 (like the subrect
+//   calls), so { 1,0,0, 0,1,0 } is a copy.
+//
+//   When the matrix is just a scale and an offset (no rotation, shear or flip)
+//   that stays inside the input, this is a normal resize with stbir_set_input_subrect,
+//   so you get the full separable filtering (including the anti-aliasing when scaling
+//   down). Otherwise, the part of the input that's used is decoded to linear float once,
+//   each output pixel is gathered from its neighbors (a 2x2 bilinear or 4x4
+//   bicubic footprint), and the result is encoded back to your datatype and layout.
+//   The gather doesn't widen the filter when shrinking, so for big reductions
+//   resize (or use a mip level) first and then warp.
+//
+//   The filter picks the gather: STBIR_FILTER_POINT_SAMPLE is nearest, BOX and
+//   TRIANGLE are bilinear, and CUBICBSPLINE, CATMULLROM and MITCHELL use their
+//   kernel over 4x4 pixels (DEFAULT is STBIR_DEFAULT_FILTER_UPSAMPLE). The edge
+//   mode is used for samples that land outside of the input.
+//
+//   Returns 1 on success, 0 on failure (bad parameters or out of memory).
+//--------------------------------
+
+STBIRDEF int stbir_warp_affine( const void *input_pixels, int input_w, int input_h, int input_stride_in_bytes,
+                                void *output_pixels, int output_w, int output_h, int output_stride_in_bytes,
+                                stbir_pixel_layout pixel_layout, stbir_datatype data_type,
+                                stbir_edge edge, stbir_filter filter, float const matrix[6] );
+//===============================================================
+
+
+//===============================================================
+// Vertical first calibration
+//   Each resize runs either the horizontal or the vertical pass first, and the
+//   order is picked by a cost model that was trained offline on a handful of
+//   machines (see stb_image_resize_test/vf_train.c). On a given CPU, it can be
+//   wrong for some kinds of resizes, so you can time both orders on the actual
+//   machine, and whichever was faster is then used for similar resizes from
+//   then on (the same channel count, scale range and predicted cost ratio).
+//
+//   Calibrating is slow (it runs the resize 2*(repeats+1) times), so the usual
+//   thing to do is calibrate a few typical resizes once, save the results to a
+//   file, and load them at startup on later runs. The calibration is kept per
+//   dispatch level (and the saved data records the SIMD it was measured with -
+//   loading data from a different build is ignored).
+//
+//   The calibration is one global table per dispatch level, shared by every
+//   resize in the process. None of these functions are thread safe with each
+//   other, or with building samplers (stbir_build_samplers, or stbir_resize*
+//   calls) on other threads, since builds read the table these write. Calibrate
+//   or load at startup, before other threads start resizing.
+//--------------------------------
+
+// Times resize with both orders, and adds the result to the calibration for this
+//   kind of resize. resize must be completely set up (with real input and output
+//   buffers - the output is written). If you had built samplers, they're rebuilt
+//   afterwards (using the new calibration). Returns 1 if horizontal first was
+//   faster, 2 if vertical first was, 3 if they were within timing noise of each
+//   other (~5%), or 0 if it couldn't be built (or timed). Each call only adds one
+//   timing; a kind of resize only overrules the trained costs once its timings
+//   average more than the noise margin. The uint8 fixed point option is ignored
+//   while calibrating (that path always runs vertical first when it's used).
+STBIRDEF int stbir_calibrate_vertical_first( STBIR_RESIZE * resize, int repeats );
+
+// Forgets all of the calibration (back to just the trained cost model).
+STBIRDEF void stbir_reset_vertical_first_calibration( void );
+
+// Copies the calibration into buffer (a small, portable binary blob). Returns the
+//   number of bytes written, or the number needed if buffer_size is too small.
+STBIRDEF int stbir_get_vertical_first_calibration( void * buffer, int buffer_size );
+
+// Replaces the calibration with one from stbir_get_vertical_first_calibration.
+//   Returns 1 on success, or 0 if the data is damaged or from a different SIMD.
+STBIRDEF int stbir_set_vertical_first_calibration( const void * buffer, int buffer_size );
+
+#ifndef STBIR_NO_STDIO
+// Same as the get and set calls above, but through a file. Return 1 on success.
+STBIRDEF int stbir_save_vertical_first_calibration( char const * filename );
+STBIRDEF int stbir_load_vertical_first_calibration( char const * filename );
+#endif
+//===============================================================
+
+
+//===============================================================
+// Runtime CPU dispatch - these only exist when you build the dispatch
+//   variants (see RUNTIME CPU DISPATCH at the top of the file).
+//--------------------------------
+
+typedef enum
+{
+  STBIR_DISPATCH_LEVEL_BASE   = 0,  // whatever the STBIR_DISPATCH_BASE file was compiled for (SSE2 on x64)
+  STBIR_DISPATCH_LEVEL_AVX2   = 1,
+  STBIR_DISPATCH_LEVEL_AVX512 = 2
+} stbir_dispatch_level;
+
+// returns the variant being used (the best one this cpu and the linked variants support)
+STBIRDEF int stbir_get_dispatch_level( void );
+
+// limits the variant used to max_level, returns the level now in use. Only call this
+//   when no samplers are built - samplers must be used with the variant that built them.
+STBIRDEF int stbir_set_dispatch_level( int max_level );
+//===============================================================
+
+
 //===============================================================
 // Pixel Callbacks info:
 //--------------------------------
@@ -757,6 +1147,12 @@ typedef struct STBIR_PROFILE_INFO
 
   // count of clocks and descriptions
   stbir_uint32 count;
+
+  // memory for the whole resize (samplers plus every split's buffers), the working buffers
+  //   of just one split, and how many scanlines each split's ring buffer holds
+  size_t total_memory;
+  size_t split_memory;
+  stbir_uint32 ring_buffer_entries;
 } STBIR_PROFILE_INFO;
 
 // use after calling stbir_resize_extended (or stbir_build_samplers or stbir_build_samplers_with_splits)
@@ -776,7 +1172,219 @@ STBIRDEF void stbir_resize_split_profile_info( STBIR_PROFILE_INFO * out_info, ST
 ////   end header file   /////////////////////////////////////////////////////
 #endif // STBIR_INCLUDE_STB_IMAGE_RESIZE2_H
 
-#if defined(STB_IMAGE_RESIZE_IMPLEMENTATION) || defined(STB_IMAGE_RESIZE2_IMPLEMENTATION)
+#if ( defined(STB_IMAGE_RESIZE_IMPLEMENTATION) || defined(STB_IMAGE_RESIZE2_IMPLEMENTATION) ) && defined(STBIR_RUNTIME_DISPATCH)
+
+// Runtime dispatch: this file only contains the forwarding functions - the resizers
+//   themselves are in the STBIR_DISPATCH_BASE/AVX2/AVX512 files.
+
+#if defined(_x86_64) || defined( __x86_64__ ) || defined( _M_X64 ) || defined(__x86_64) || defined(_M_AMD64) || defined(__i386__) || defined(_M_IX86)
+  #define STBIR__DISPATCH_X86
+  #if defined( _MSC_VER ) && !defined(__clang__)
+    #include <intrin.h>
+    static void stbir__cpuid( int leaf, int regs[4] ) { __cpuidex( regs, leaf, 0 ); }
+    static stbir_uint64 stbir__xgetbv( void ) { return _xgetbv( 0 ); }
+  #else
+    #include <cpuid.h>
+    static void stbir__cpuid( int leaf, int regs[4] )
+    {
+      unsigned int a, b, c, d;
+      __cpuid_count( leaf, 0, a, b, c, d );
+      regs[0] = (int) a; regs[1] = (int) b; regs[2] = (int) c; regs[3] = (int) d;
+    }
+    static stbir_uint64 stbir__xgetbv( void )
+    {
+      unsigned int lo, hi;
+      __asm__ __volatile__( "xgetbv" : "=a"(lo), "=d"(hi) : "c"(0) );
+      return ( ( (stbir_uint64) hi ) << 32 ) | lo;
+    }
+  #endif
+#endif
+
+#ifdef STBIR_DISPATCH_NO_AVX2
+#define STBIR__DISPATCH_MAX_LEVEL STBIR_DISPATCH_LEVEL_BASE
+#elif defined(STBIR_DISPATCH_NO_AVX512)
+#define STBIR__DISPATCH_MAX_LEVEL STBIR_DISPATCH_LEVEL_AVX2
+#else
+#define STBIR__DISPATCH_MAX_LEVEL STBIR_DISPATCH_LEVEL_AVX512
+#endif
+
+static int stbir__cpu_dispatch_level( void )
+{
+  int level = STBIR_DISPATCH_LEVEL_BASE;
+
+  #ifdef STBIR__DISPATCH_X86
+  int regs[4];
+
+  stbir__cpuid( 0, regs );
+  if ( regs[0] >= 7 )
+  {
+    stbir__cpuid( 1, regs );
+    // need osxsave (27), avx (28) and f16c (29)
+    if ( ( regs[2] & ( 7 << 27 ) ) == ( 7 << 27 ) )
+    {
+      stbir_uint64 xcr0 = stbir__xgetbv();
+
+      stbir__cpuid( 7, regs );
+      // os saves the ymm registers, and avx2 (ebx 5)
+      if ( ( ( xcr0 & 6 ) == 6 ) && ( regs[1] & ( 1 << 5 ) ) )
+      {
+        level = STBIR_DISPATCH_LEVEL_AVX2;
+
+        // os saves the zmm registers and opmasks, and avx512f (ebx 16)
+        if ( ( ( xcr0 & 0xe6 ) == 0xe6 ) && ( regs[1] & ( 1 << 16 ) ) )
+          level = STBIR_DISPATCH_LEVEL_AVX512;
+      }
+    }
+  }
+  #endif
+
+  return ( level < STBIR__DISPATCH_MAX_LEVEL ) ? level : STBIR__DISPATCH_MAX_LEVEL;
+}
+
+static int stbir__dispatch_level = -1;  // -1 until first use (racing to set it is harmless)
+
+STBIRDEF int stbir_get_dispatch_level( void )
+{
+  if ( stbir__dispatch_level < 0 )
+    stbir__dispatch_level = stbir__cpu_dispatch_level();
+  return stbir__dispatch_level;
+}
+
+STBIRDEF int stbir_set_dispatch_level( int max_level )
+{
+  int level = stbir__cpu_dispatch_level();
+  stbir__dispatch_level = ( max_level < level ) ? ( ( max_level < 0 ) ? 0 : max_level ) : level;
+  return stbir__dispatch_level;
+}
+
+#ifdef STBIR_DISPATCH_NO_AVX2
+#define STBIR__IF_DISPATCH_AVX2( x )
+#else
+#define STBIR__IF_DISPATCH_AVX2( x ) x
+#endif
+
+#if defined(STBIR_DISPATCH_NO_AVX2) || defined(STBIR_DISPATCH_NO_AVX512)
+#define STBIR__IF_DISPATCH_AVX512( x )
+#else
+#define STBIR__IF_DISPATCH_AVX512( x ) x
+#endif
+
+// every entry point: return type, name, parameters and arguments
+
+#define STBIR__DISPATCH_FUNCS( RET, VOID ) \
+  RET( unsigned char *, stbir_resize_uint8_srgb, ( const unsigned char *input_pixels, int input_w, int input_h, int input_stride_in_bytes, unsigned char *output_pixels, int output_w, int output_h, int output_stride_in_bytes, stbir_pixel_layout pixel_type ), \
+                                                  ( input_pixels, input_w, input_h, input_stride_in_bytes, output_pixels, output_w, output_h, output_stride_in_bytes, pixel_type ) ) \
+  RET( unsigned char *, stbir_resize_uint8_linear, ( const unsigned char *input_pixels, int input_w, int input_h, int input_stride_in_bytes, unsigned char *output_pixels, int output_w, int output_h, int output_stride_in_bytes, stbir_pixel_layout pixel_type ), \
+                                                  ( input_pixels, input_w, input_h, input_stride_in_bytes, output_pixels, output_w, output_h, output_stride_in_bytes, pixel_type ) ) \
+  RET( float *, stbir_resize_float_linear, ( const float *input_pixels, int input_w, int input_h, int input_stride_in_bytes, float *output_pixels, int output_w, int output_h, int output_stride_in_bytes, stbir_pixel_layout pixel_type ), \
+                                                  ( input_pixels, input_w, input_h, input_stride_in_bytes, output_pixels, output_w, output_h, output_stride_in_bytes, pixel_type ) ) \
+  RET( void *, stbir_resize, ( const void *input_pixels, int input_w, int input_h, int input_stride_in_bytes, void *output_pixels, int output_w, int output_h, int output_stride_in_bytes, stbir_pixel_layout pixel_layout, stbir_datatype data_type, stbir_edge edge, stbir_filter filter ), \
+                             ( input_pixels, input_w, input_h, input_stride_in_bytes, output_pixels, output_w, output_h, output_stride_in_bytes, pixel_layout, data_type, edge, filter ) ) \
+  VOID( stbir_resize_init, ( STBIR_RESIZE * resize, const void *input_pixels, int input_w, int input_h, int input_stride_in_bytes, void *output_pixels, int output_w, int output_h, int output_stride_in_bytes, stbir_pixel_layout pixel_layout, stbir_datatype data_type ), \
+                           ( resize, input_pixels, input_w, input_h, input_stride_in_bytes, output_pixels, output_w, output_h, output_stride_in_bytes, pixel_layout, data_type ) ) \
+  VOID( stbir_set_datatypes, ( STBIR_RESIZE * resize, stbir_datatype input_type, stbir_datatype output_type ), ( resize, input_type, output_type ) ) \
+  VOID( stbir_set_pixel_callbacks, ( STBIR_RESIZE * resize, stbir_input_callback * input_cb, stbir_output_callback * output_cb ), ( resize, input_cb, output_cb ) ) \
+  VOID( stbir_set_user_data, ( STBIR_RESIZE * resize, void * user_data ), ( resize, user_data ) ) \
+  VOID( stbir_set_buffer_ptrs, ( STBIR_RESIZE * resize, const void * input_pixels, int input_stride_in_bytes, void * output_pixels, int output_stride_in_bytes ), ( resize, input_pixels, input_stride_in_bytes, output_pixels, output_stride_in_bytes ) ) \
+  RET( int, stbir_set_output_color_matrix, ( STBIR_RESIZE * resize, float const * matrix ), ( resize, matrix ) ) \
+  RET( int, stbir_set_pixel_layouts, ( STBIR_RESIZE * resize, stbir_pixel_layout input_pixel_layout, stbir_pixel_layout output_pixel_layout ), ( resize, input_pixel_layout, output_pixel_layout ) ) \
+  RET( int, stbir_set_edgemodes, ( STBIR_RESIZE * resize, stbir_edge horizontal_edge, stbir_edge vertical_edge ), ( resize, horizontal_edge, vertical_edge ) ) \
+  RET( int, stbir_set_filters, ( STBIR_RESIZE * resize, stbir_filter horizontal_filter, stbir_filter vertical_filter ), ( resize, horizontal_filter, vertical_filter ) ) \
+  RET( int, stbir_set_filter_callbacks, ( STBIR_RESIZE * resize, stbir__kernel_callback * horizontal_filter, stbir__support_callback * horizontal_support, stbir__kernel_callback * vertical_filter, stbir__support_callback * vertical_support ), \
+                                        ( resize, horizontal_filter, horizontal_support, vertical_filter, vertical_support ) ) \
+  RET( int, stbir_set_pixel_subrect, ( STBIR_RESIZE * resize, int subx, int suby, int subw, int subh ), ( resize, subx, suby, subw, subh ) ) \
+  RET( int, stbir_set_input_subrect, ( STBIR_RESIZE * resize, double s0, double t0, double s1, double t1 ), ( resize, s0, t0, s1, t1 ) ) \
+  RET( int, stbir_set_output_pixel_subrect, ( STBIR_RESIZE * resize, int subx, int suby, int subw, int subh ), ( resize, subx, suby, subw, subh ) ) \
+  RET( int, stbir_set_non_pm_alpha_speed_over_quality, ( STBIR_RESIZE * resize, int non_pma_alpha_speed_over_quality ), ( resize, non_pma_alpha_speed_over_quality ) ) \
+  RET( int, stbir_set_uint8_fixed_point, ( STBIR_RESIZE * resize, int use_fixed_point ), ( resize, use_fixed_point ) ) \
+  RET( int, stbir_build_samplers, ( STBIR_RESIZE * resize ), ( resize ) ) \
+  VOID( stbir_free_samplers, ( STBIR_RESIZE * resize ), ( resize ) ) \
+  RET( int, stbir_resize_extended, ( STBIR_RESIZE * resize ), ( resize ) ) \
+  RET( int, stbir_build_samplers_with_splits, ( STBIR_RESIZE * resize, int try_splits ), ( resize, try_splits ) ) \
+  RET( int, stbir_resize_extended_split, ( STBIR_RESIZE * resize, int split_start, int split_count ), ( resize, split_start, split_count ) ) \
+  RET( int, stbir_resize_extended_threaded, ( STBIR_RESIZE * resize, int max_threads, stbir_dispatch_callback * dispatch, void * dispatch_context ), ( resize, max_threads, dispatch, dispatch_context ) ) \
+  RET( int, stbir_resize_batch, ( STBIR_RESIZE * resize, stbir_batch_image const * images, int image_count, int max_threads, stbir_dispatch_callback * dispatch, void * dispatch_context ), \
+                                ( resize, images, image_count, max_threads, dispatch, dispatch_context ) ) \
+  RET( stbir_sampler_cache *, stbir_sampler_cache_create, ( int max_entries, void * user_data ), ( max_entries, user_data ) ) \
+  VOID( stbir_sampler_cache_destroy, ( stbir_sampler_cache * cache ), ( cache ) ) \
+  RET( int, stbir_build_samplers_from_cache, ( STBIR_RESIZE * resize, stbir_sampler_cache * cache, int try_splits ), ( resize, cache, try_splits ) ) \
+  RET( int, stbir_build_mipmaps, ( STBIR_MIPMAPS * mips, int input_w, int input_h, int num_levels, stbir_pixel_layout pixel_layout, stbir_datatype data_type, stbir_edge edge, stbir_filter filter, void * user_data ), \
+                                 ( mips, input_w, input_h, num_levels, pixel_layout, data_type, edge, filter, user_data ) ) \
+  RET( int, stbir_resize_mipmaps_extended, ( STBIR_MIPMAPS * mips, const void * input_pixels, int input_stride_in_bytes, void * const * level_pixels, int const * level_strides ), \
+                                           ( mips, input_pixels, input_stride_in_bytes, level_pixels, level_strides ) ) \
+  VOID( stbir_free_mipmaps, ( STBIR_MIPMAPS * mips ), ( mips ) ) \
+  RET( int, stbir_resize_mipmaps, ( const void * input_pixels, int input_w, int input_h, int input_stride_in_bytes, void * const * level_pixels, int const * level_strides, int num_levels, stbir_pixel_layout pixel_layout, stbir_datatype data_type, stbir_edge edge, stbir_filter filter ), \
+                                  ( input_pixels, input_w, input_h, input_stride_in_bytes, level_pixels, level_strides, num_levels, pixel_layout, data_type, edge, filter ) ) \
+  RET( int, stbir_warp_affine, ( const void *input_pixels, int input_w, int input_h, int input_stride_in_bytes, void *output_pixels, int output_w, int output_h, int output_stride_in_bytes, stbir_pixel_layout pixel_layout, stbir_datatype data_type, stbir_edge edge, stbir_filter filter, float const matrix[6] ), \
+                               ( input_pixels, input_w, input_h, input_stride_in_bytes, output_pixels, output_w, output_h, output_stride_in_bytes, pixel_layout, data_type, edge, filter, matrix ) ) \
+  RET( int, stbir_calibrate_vertical_first, ( STBIR_RESIZE * resize, int repeats ), ( resize, repeats ) ) \
+  VOID( stbir_reset_vertical_first_calibration, ( void ), () ) \
+  RET( int, stbir_get_vertical_first_calibration, ( void * buffer, int buffer_size ), ( buffer, buffer_size ) ) \
+  RET( int, stbir_set_vertical_first_calibration, ( const void * buffer, int buffer_size ), ( buffer, buffer_size ) ) \
+  STBIR__DISPATCH_STDIO_FUNCS( RET, VOID ) \
+  STBIR__DISPATCH_THREAD_FUNCS( RET, VOID ) \
+  STBIR__DISPATCH_PROFILE_FUNCS( RET, VOID )
+
+#ifndef STBIR_NO_STDIO
+#define STBIR__DISPATCH_STDIO_FUNCS( RET, VOID ) \
+  RET( int, stbir_save_vertical_first_calibration, ( char const * filename ), ( filename ) ) \
+  RET( int, stbir_load_vertical_first_calibration, ( char const * filename ), ( filename ) )
+#else
+#define STBIR__DISPATCH_STDIO_FUNCS( RET, VOID )
+#endif
+
+#ifdef STBIR_USE_THREADS
+#define STBIR__DISPATCH_THREAD_FUNCS( RET, VOID ) \
+  RET( stbir_thread_pool *, stbir_thread_pool_create, ( int num_threads, void * user_data ), ( num_threads, user_data ) ) \
+  VOID( stbir_thread_pool_destroy, ( stbir_thread_pool * pool ), ( pool ) ) \
+  VOID( stbir_thread_pool_dispatch, ( stbir_task_func * task, void * task_data, int task_count, void * pool ), ( task, task_data, task_count, pool ) )
+#else
+#define STBIR__DISPATCH_THREAD_FUNCS( RET, VOID )
+#endif
+
+#ifdef STBIR_PROFILE
+#define STBIR__DISPATCH_PROFILE_FUNCS( RET, VOID ) \
+  VOID( stbir_resize_build_profile_info, ( STBIR_PROFILE_INFO * out_info, STBIR_RESIZE const * resize ), ( out_info, resize ) ) \
+  VOID( stbir_resize_extended_profile_info, ( STBIR_PROFILE_INFO * out_info, STBIR_RESIZE const * resize ), ( out_info, resize ) ) \
+  VOID( stbir_resize_split_profile_info, ( STBIR_PROFILE_INFO * out_info, STBIR_RESIZE const * resize, int split_start, int split_num ), ( out_info, resize, split_start, split_num ) )
+#else
+#define STBIR__DISPATCH_PROFILE_FUNCS( RET, VOID )
+#endif
+
+// prototypes for each variant
+#define STBIR__DISPATCH_PROTO_RET( ret, name, params, args ) \
+  STBIRDEF ret name##_base params; \
+  STBIR__IF_DISPATCH_AVX2( STBIRDEF ret name##_avx2 params; ) \
+  STBIR__IF_DISPATCH_AVX512( STBIRDEF ret name##_avx512 params; )
+#define STBIR__DISPATCH_PROTO_VOID( name, params, args ) STBIR__DISPATCH_PROTO_RET( void, name, params, args )
+
+STBIR__DISPATCH_FUNCS( STBIR__DISPATCH_PROTO_RET, STBIR__DISPATCH_PROTO_VOID )
+
+// and the forwarding functions
+#define STBIR__DISPATCH_FORWARD_RET( ret, name, params, args ) \
+  STBIRDEF ret name params \
+  { \
+    switch ( stbir_get_dispatch_level() ) \
+    { \
+      STBIR__IF_DISPATCH_AVX512( case STBIR_DISPATCH_LEVEL_AVX512: return name##_avx512 args; ) \
+      STBIR__IF_DISPATCH_AVX2( case STBIR_DISPATCH_LEVEL_AVX2: return name##_avx2 args; ) \
+      default: return name##_base args; \
+    } \
+  }
+#define STBIR__DISPATCH_FORWARD_VOID( name, params, args ) \
+  STBIRDEF void name params \
+  { \
+    switch ( stbir_get_dispatch_level() ) \
+    { \
+      STBIR__IF_DISPATCH_AVX512( case STBIR_DISPATCH_LEVEL_AVX512: name##_avx512 args; break; ) \
+      STBIR__IF_DISPATCH_AVX2( case STBIR_DISPATCH_LEVEL_AVX2: name##_avx2 args; break; ) \
+      default: name##_base args; break; \
+    } \
+  }
+
+STBIR__DISPATCH_FUNCS( STBIR__DISPATCH_FORWARD_RET, STBIR__DISPATCH_FORWARD_VOID )
+
+#elif defined(STB_IMAGE_RESIZE_IMPLEMENTATION) || defined(STB_IMAGE_RESIZE2_IMPLEMENTATION)
 
 #ifndef STBIR_ASSERT
 #include <assert.h>
@@ -898,7 +1506,7 @@ typedef enum
 
 // must match stbir_datatype
 static unsigned char stbir__type_size[] = {
-  1,1,1,2,4,2 // STBIR_TYPE_UINT8,STBIR_TYPE_UINT8_SRGB,STBIR_TYPE_UINT8_SRGB_ALPHA,STBIR_TYPE_UINT16,STBIR_TYPE_FLOAT,STBIR_TYPE_HALF_FLOAT
+  1,1,1,2,4,2,2 // STBIR_TYPE_UINT8,STBIR_TYPE_UINT8_SRGB,STBIR_TYPE_UINT8_SRGB_ALPHA,STBIR_TYPE_UINT16,STBIR_TYPE_FLOAT,STBIR_TYPE_HALF_FLOAT,STBIR_TYPE_BFLOAT16
 };
 
 // When gathering, the contributors are which source pixels contribute.
@@ -1036,6 +1644,10 @@ struct stbir__info
   void * alloced_mem;
   stbir__per_split_info * split_info;  // by default 1, but there will be N of these allocated based on the thread init you did
 
+  stbir__info const * shared_samplers; // if set, horizontal and vertical coefficients belong to this info (see stbir_sampler_cache)
+  int * fixed_horizontal_coefficients; // 16-bit copies of the coefficients for the uint8 fixed point path, packed in pairs
+  int * fixed_vertical_coefficients;
+
   stbir__decode_pixels_func * decode_pixels;
   stbir__alpha_weight_func * alpha_weight;
   stbir__horizontal_gather_channels_func * horizontal_gather_channels;
@@ -1051,9 +1663,13 @@ struct stbir__info
   int input_color_and_type;
   int offset_x, offset_y; // offset within output_data
   int vertical_first;
+  int fixed_point;        // using the uint8 fixed point path (the one ring buffer entry holds shorts)
+  int color_matrix_mode;  // 0 = no output color matrix, 1 = straight colors, 2 = premultiplied (offsets scale by alpha)
+  float color_matrix[12]; // in the channel order of the encode buffer
   int channels;
   int effective_channels; // same as channels, except on RGBA/ARGB (7), or XA/AX (3)
   size_t alloced_total;
+  size_t split_buffers_size; // decode, ring and vertical buffers for one split
 };
 
 
@@ -1165,6 +1781,10 @@ static stbir__inline stbir_uint8 stbir__linear_to_srgb_uchar(float in)
 #define STBIR_FORCE_MINIMUM_SCANLINES_FOR_SPLITS 4 // when threading, what is the minimum number of scanlines for a split?
 #endif
 
+#ifndef STBIR_SPLITS_PER_THREAD
+#define STBIR_SPLITS_PER_THREAD 2 // how many splits per thread stbir_resize_extended_threaded builds (more balances better, but each split re-decodes its filter margin)
+#endif
+
 #define STBIR_INPUT_CALLBACK_PADDING 3
 
 #ifdef _M_IX86_FP
@@ -1180,10 +1800,41 @@ static stbir__inline stbir_uint8 stbir__linear_to_srgb_uchar(float in)
   #define STBIR_NO_SIMD
 #endif
 
+// the runtime dispatch variants force their instruction set (see RUNTIME CPU DISPATCH)
+#if defined(STBIR_DISPATCH_AVX512)
+  #if !defined(__AVX512F__) || !defined(__AVX2__)
+    #error Compile the STBIR_DISPATCH_AVX512 file with AVX-512 enabled (-mavx512f -mf16c or /arch:AVX512).
+  #endif
+  #ifndef STBIR_AVX512
+    #define STBIR_AVX512
+  #endif
+#elif defined(STBIR_DISPATCH_AVX2)
+  #if !defined(__AVX2__)
+    #error Compile the STBIR_DISPATCH_AVX2 file with AVX2 enabled (-mavx2 -mf16c or /arch:AVX2).
+  #endif
+  #ifndef STBIR_AVX2
+    #define STBIR_AVX2
+  #endif
+#endif
+
 #if defined(_x86_64) || defined( __x86_64__ ) || defined( _M_X64 ) || defined(__x86_64) || defined(_M_AMD64) || defined(__SSE2__) || defined(STBIR_SSE) || defined(STBIR_SSE2)
   #ifndef STBIR_SSE2
     #define STBIR_SSE2
   #endif
+  #if defined(__AVX512F__) || defined(STBIR_AVX512)
+    #ifdef STBIR_NO_AVX512
+      #ifdef STBIR_AVX512
+        #undef STBIR_AVX512
+      #endif
+    #else
+      #ifndef STBIR_AVX512
+        #define STBIR_AVX512
+      #endif
+      #if !defined(STBIR_AVX2) && !defined(STBIR_NO_AVX2)
+        #define STBIR_AVX2
+      #endif
+    #endif
+  #endif
   #if defined(__AVX__) || defined(STBIR_AVX2)
     #ifndef STBIR_AVX
       #ifndef STBIR_NO_AVX
@@ -1284,6 +1935,10 @@ static stbir__inline stbir_uint8 stbir__linear_to_srgb_uchar(float in)
 #undef STBIR_AVX2
 #endif
 
+#ifdef STBIR_AVX512
+#undef STBIR_AVX512
+#endif
+
 #ifdef STBIR_FP16C
 #undef STBIR_FP16C
 #endif
@@ -1666,6 +2321,21 @@ static stbir__inline stbir_uint8 stbir__linear_to_srgb_uchar(float in)
     #endif
     #define stbir__if_simdf8_cast_to_simdf4( val ) _mm256_castps256_ps128( val )
 
+    // AVX-512 is only used for the wide vertical loops (everything else stays AVX/AVX2)
+    #ifdef STBIR_AVX512
+      #define STBIR_SIMD16
+      #define stbir__simdf16 __m512
+      #define stbir__simdf16_load( out, ptr ) (out) = _mm512_loadu_ps( (float const *)(ptr) )
+      #define stbir__simdf16_store( ptr, reg ) _mm512_storeu_ps( (float*)(ptr), reg )
+      #define stbir__simdf16_mult( out, a, b ) (out) = _mm512_mul_ps( (a), (b) )
+      #define stbir__simdf16_frep16( fval ) _mm512_set1_ps( fval )
+      #ifdef STBIR_USE_FMA
+      #define stbir__simdf16_madd( out, add, mul1, mul2 ) (out) = _mm512_fmadd_ps( mul1, mul2, add )
+      #else
+      #define stbir__simdf16_madd( out, add, mul1, mul2 ) (out) = _mm512_add_ps( add, _mm512_mul_ps( mul1, mul2 ) )
+      #endif
+    #endif
+
   #endif
 
   #ifdef STBIR_FLOORF
@@ -2526,6 +3196,123 @@ static stbir__inline stbir_uint8 stbir__linear_to_srgb_uchar(float in)
 
 #endif
 
+// bfloat16 is just the top half of a float, so decoding is a shift, and encoding is a
+//   round-to-nearest-even add and a shift (NaNs are truncated and kept quiet instead,
+//   so that the rounding can't turn them into infinities)
+
+static stbir__inline float stbir__bf16_to_float( unsigned short h )
+{
+  stbir__FP32 o;
+  o.u = ( (unsigned int) h ) << 16;
+  return o.f;
+}
+
+static stbir__inline unsigned short stbir__float_to_bf16( float f )
+{
+  stbir__FP32 i;
+  i.f = f;
+  if ( ( i.u & 0x7fffffff ) > 0x7f800000 )
+    return (unsigned short) ( ( i.u >> 16 ) | 0x40 );
+  return (unsigned short) ( ( i.u + 0x7fff + ( ( i.u >> 16 ) & 1 ) ) >> 16 );
+}
+
+#if defined(STBIR_AVX2)
+
+  static stbir__inline void stbir__bf16_to_float_SIMD(float * output, unsigned short const * input)
+  {
+    __m256i i = _mm256_cvtepu16_epi32( _mm_loadu_si128( (__m128i const*)input ) );
+    _mm256_storeu_si256( (__m256i*)output, _mm256_slli_epi32( i, 16 ) );
+  }
+
+  static stbir__inline void stbir__float_to_bf16_SIMD(unsigned short * output, float const * input)
+  {
+    __m256  f    = _mm256_loadu_ps( input );
+    __m256i i    = _mm256_castps_si256( f );
+    __m256i odd  = _mm256_and_si256( _mm256_srli_epi32( i, 16 ), _mm256_set1_epi32( 1 ) );
+    __m256i r    = _mm256_add_epi32( _mm256_add_epi32( i, _mm256_set1_epi32( 0x7fff ) ), odd );
+    __m256i nan  = _mm256_castps_si256( _mm256_cmp_ps( f, f, _CMP_UNORD_Q ) );
+    r = _mm256_blendv_epi8( r, _mm256_or_si256( i, _mm256_set1_epi32( 0x400000 ) ), nan );
+    r = _mm256_srli_epi32( r, 16 );
+    _mm_storeu_si128( (__m128i*)output, _mm_packus_epi32( _mm256_castsi256_si128( r ), _mm256_extracti128_si256( r, 1 ) ) );
+  }
+
+#elif defined(STBIR_SSE2)
+
+  static stbir__inline void stbir__bf16_to_float_SIMD(float * output, unsigned short const * input)
+  {
+    __m128i i = _mm_loadu_si128( (__m128i const*)input );
+    _mm_storeu_si128( (__m128i*)( output + 0 ), _mm_unpacklo_epi16( _mm_setzero_si128(), i ) );
+    _mm_storeu_si128( (__m128i*)( output + 4 ), _mm_unpackhi_epi16( _mm_setzero_si128(), i ) );
+  }
+
+  static stbir__inline __m128i stbir__float_to_bf16_4( float const * input )
+  {
+    __m128  f    = _mm_loadu_ps( input );
+    __m128i i    = _mm_castps_si128( f );
+    __m128i odd  = _mm_and_si128( _mm_srli_epi32( i, 16 ), _mm_set1_epi32( 1 ) );
+    __m128i r    = _mm_add_epi32( _mm_add_epi32( i, _mm_set1_epi32( 0x7fff ) ), odd );
+    __m128i nan  = _mm_castps_si128( _mm_cmpunord_ps( f, f ) );
+    r = _mm_or_si128( _mm_andnot_si128( nan, r ), _mm_and_si128( nan, _mm_or_si128( i, _mm_set1_epi32( 0x400000 ) ) ) );
+    // arithmetic shift, so the signed pack below passes the top halves through unchanged
+    return _mm_srai_epi32( r, 16 );
+  }
+
+  static stbir__inline void stbir__float_to_bf16_SIMD(unsigned short * output, float const * input)
+  {
+    _mm_storeu_si128( (__m128i*)output, _mm_packs_epi32( stbir__float_to_bf16_4( input ), stbir__float_to_bf16_4( input + 4 ) ) );
+  }
+
+#elif defined(STBIR_NEON)
+
+  static stbir__inline void stbir__bf16_to_float_SIMD(float * output, unsigned short const * input)
+  {
+    uint16x8_t i = vld1q_u16( input );
+    vst1q_u32( (uint32_t*)( output + 0 ), vshll_n_u16( vget_low_u16( i ), 16 ) );
+    vst1q_u32( (uint32_t*)( output + 4 ), vshll_n_u16( vget_high_u16( i ), 16 ) );
+  }
+
+  static stbir__inline uint16x4_t stbir__float_to_bf16_4( float const * input )
+  {
+    float32x4_t f    = vld1q_f32( input );
+    uint32x4_t i     = vreinterpretq_u32_f32( f );
+    uint32x4_t odd   = vandq_u32( vshrq_n_u32( i, 16 ), vdupq_n_u32( 1 ) );
+    uint32x4_t r     = vaddq_u32( vaddq_u32( i, vdupq_n_u32( 0x7fff ) ), odd );
+    uint32x4_t notnan = vceqq_f32( f, f );
+    r = vbslq_u32( notnan, r, vorrq_u32( i, vdupq_n_u32( 0x400000 ) ) );
+    return vshrn_n_u32( r, 16 );
+  }
+
+  static stbir__inline void stbir__float_to_bf16_SIMD(unsigned short * output, float const * input)
+  {
+    vst1q_u16( output, vcombine_u16( stbir__float_to_bf16_4( input ), stbir__float_to_bf16_4( input + 4 ) ) );
+  }
+
+#elif defined(STBIR_WASM)
+
+  static stbir__inline void stbir__bf16_to_float_SIMD(float * output, unsigned short const * input)
+  {
+    v128_t i = wasm_v128_load( input );
+    wasm_v128_store( output + 0, wasm_i32x4_shl( wasm_u32x4_extend_low_u16x8( i ), 16 ) );
+    wasm_v128_store( output + 4, wasm_i32x4_shl( wasm_u32x4_extend_high_u16x8( i ), 16 ) );
+  }
+
+  static stbir__inline v128_t stbir__float_to_bf16_4( float const * input )
+  {
+    v128_t i    = wasm_v128_load( input );
+    v128_t odd  = wasm_v128_and( wasm_u32x4_shr( i, 16 ), wasm_i32x4_splat( 1 ) );
+    v128_t r    = wasm_i32x4_add( wasm_i32x4_add( i, wasm_i32x4_splat( 0x7fff ) ), odd );
+    v128_t nan  = wasm_f32x4_ne( i, i );
+    r = wasm_v128_bitselect( wasm_v128_or( i, wasm_i32x4_splat( 0x400000 ) ), r, nan );
+    return wasm_u32x4_shr( r, 16 );
+  }
+
+  static stbir__inline void stbir__float_to_bf16_SIMD(unsigned short * output, float const * input)
+  {
+    wasm_v128_store( output, wasm_u16x8_narrow_i32x4( stbir__float_to_bf16_4( input ), stbir__float_to_bf16_4( input + 4 ) ) );
+  }
+
+#endif
+
 
 #ifdef STBIR_SIMD
 
@@ -2720,12 +3507,13 @@ static void stbir_overlapping_memcpy( void * dest, void const * src, size_t byte
 #endif // SSE2
 
 
-#ifdef STBIR_PROFILE
-
+// the tick counter is used by the profiler, and by stbir_calibrate_vertical_first when available
 #ifndef STBIR_PROFILE_FUNC
 
 #if defined(_x86_64) || defined( __x86_64__ ) || defined( _M_X64 ) || defined(__x86_64) || defined(__SSE2__) || defined(STBIR_SSE) || defined( _M_IX86_FP ) || defined(__i386) || defined( __i386__ ) || defined( _M_IX86 ) || defined( _X86_ )
 
+#define STBIR__HAS_PROFILE_FUNC
+
 #ifdef _MSC_VER
 
   STBIRDEF stbir_uint64 __rdtsc();
@@ -2736,7 +3524,7 @@ static void stbir_overlapping_memcpy( void * dest, void const * src, size_t byte
   static stbir__inline stbir_uint64 STBIR_PROFILE_FUNC()
   {
     stbir_uint32 lo, hi;
-    asm volatile ("rdtsc" : "=a" (lo), "=d" (hi) );
+    __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi) );
     return ( ( (stbir_uint64) hi ) << 32 ) | ( (stbir_uint64) lo );
   }
 
@@ -2744,6 +3532,8 @@ static void stbir_overlapping_memcpy( void * dest, void const * src, size_t byte
 
 #elif defined( _M_ARM64 ) || defined( __aarch64__ ) || defined( __arm64__ ) || defined(__ARM_NEON__)
 
+#define STBIR__HAS_PROFILE_FUNC
+
 #if defined( _MSC_VER ) && !defined(__clang__)
 
   #define STBIR_PROFILE_FUNC() _ReadStatusReg(ARM64_CNTVCT)
@@ -2753,20 +3543,26 @@ static void stbir_overlapping_memcpy( void * dest, void const * src, size_t byte
   static stbir__inline stbir_uint64 STBIR_PROFILE_FUNC()
   {
     stbir_uint64 tsc;
-    asm volatile("mrs %0, cntvct_el0" : "=r" (tsc));
+    __asm__ __volatile__ ("mrs %0, cntvct_el0" : "=r" (tsc));
     return tsc;
   }
 
 #endif
 
-#else // x64, arm
+#elif defined( STBIR_PROFILE )
 
 #error Unknown platform for profiling.
 
 #endif  // x64, arm
 
+#else
+
+#define STBIR__HAS_PROFILE_FUNC
+
 #endif // STBIR_PROFILE_FUNC
 
+#ifdef STBIR_PROFILE
+
 #define STBIR_ONLY_PROFILE_GET_SPLIT_INFO ,stbir__per_split_info * split_info
 #define STBIR_ONLY_PROFILE_SET_SPLIT_INFO ,split_info
 
@@ -6153,6 +6949,62 @@ static STBIR_VERTICAL_SCATTERFUNC * stbir__vertical_scatter_blends[ 8 ] =
 };
 
 
+// the output color matrix (see stbir_set_output_color_matrix), in place on the float scanline
+static void stbir__apply_color_matrix( stbir__info const * stbir_info, float * encode_buffer, int num_pixels )
+{
+  float const * m = stbir_info->color_matrix;
+  int channels = stbir_info->channels;
+  int premultiplied = ( stbir_info->color_matrix_mode == 2 );
+  float * p = encode_buffer;
+  float * end = encode_buffer + num_pixels * channels;
+
+  #ifdef STBIR_SIMD
+  if ( channels == 4 )
+  {
+    // out = col0*r + col1*g + col2*b + col3*(1 or a) + keep*a
+    static float const keep_alpha[ 4 ] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    float const cols[ 4 ][ 4 ] = { { m[0], m[4], m[8], 0.0f }, { m[1], m[5], m[9], 0.0f }, { m[2], m[6], m[10], 0.0f }, { m[3], m[7], m[11], 0.0f } };
+    stbir__simdf c0, c1, c2, c3, keep, one;
+    stbir__simdf_load( c0, cols[ 0 ] );
+    stbir__simdf_load( c1, cols[ 1 ] );
+    stbir__simdf_load( c2, cols[ 2 ] );
+    stbir__simdf_load( c3, cols[ 3 ] );
+    stbir__simdf_load( keep, keep_alpha );
+    stbir__simdf_load1frep4( one, 1.0f );
+
+    STBIR_SIMD_NO_UNROLL_LOOP_START
+    for( ; p < end ; p += 4 )
+    {
+      stbir__simdf v, t, o;
+      stbir__simdf_load( v, p );
+      if ( premultiplied )
+        stbir__simdf_0123to3333( o, v );
+      else
+        o = one;
+      stbir__simdf_mult( o, o, c3 );
+      stbir__simdf_madd( o, o, v, keep );
+      stbir__simdf_0123to0000( t, v );
+      stbir__simdf_madd( o, o, t, c0 );
+      stbir__simdf_0123to1111( t, v );
+      stbir__simdf_madd( o, o, t, c1 );
+      stbir__simdf_0123to2222( t, v );
+      stbir__simdf_madd( o, o, t, c2 );
+      stbir__simdf_store( p, o );
+    }
+    return;
+  }
+  #endif
+
+  for( ; p < end ; p += channels )
+  {
+    float r = p[ 0 ], g = p[ 1 ], b = p[ 2 ];
+    float o = ( premultiplied ) ? p[ 3 ] : 1.0f;
+    p[ 0 ] = m[ 0 ] * r + m[ 1 ] * g + m[ 2 ]  * b + m[ 3 ]  * o;
+    p[ 1 ] = m[ 4 ] * r + m[ 5 ] * g + m[ 6 ]  * b + m[ 7 ]  * o;
+    p[ 2 ] = m[ 8 ] * r + m[ 9 ] * g + m[ 10 ] * b + m[ 11 ] * o;
+  }
+}
+
 static void stbir__encode_scanline( stbir__info const * stbir_info, void *output_buffer_data, float * encode_buffer, int row  STBIR_ONLY_PROFILE_GET_SPLIT_INFO )
 {
   int num_pixels = stbir_info->horizontal.scale_info.output_sub_size;
@@ -6176,6 +7028,9 @@ static void stbir__encode_scanline( stbir__info const * stbir_info, void *output
     output_buffer = encode_buffer;
 
   STBIR_PROFILE_START( encode );
+  if ( stbir_info->color_matrix_mode )
+    stbir__apply_color_matrix( stbir_info, encode_buffer, num_pixels );
+
   // convert into the output buffer
   stbir_info->encode_pixels( output_buffer, width_times_channels, encode_buffer );
   STBIR_PROFILE_END( encode );
@@ -6340,31 +7195,397 @@ static void stbir__vertical_gather_loop( stbir__info const * stbir_info, stbir__
   }
 }
 
-#define STBIR__FLOAT_EMPTY_MARKER 3.0e+38F
-#define STBIR__FLOAT_BUFFER_IS_EMPTY(ptr) ((ptr)[0]==STBIR__FLOAT_EMPTY_MARKER)
-
-static void stbir__encode_first_scanline_from_scatter(stbir__info const * stbir_info, stbir__per_split_info* split_info)
-{
-  // evict a scanline out into the output buffer
-  float* ring_buffer_entry = stbir__get_ring_buffer_entry(stbir_info, split_info, split_info->ring_buffer_begin_index );
-
-  // dump the scanline out
-  stbir__encode_scanline( stbir_info, ( (char *)stbir_info->output_data ) + ( (size_t)split_info->ring_buffer_first_scanline * (size_t)stbir_info->output_stride_bytes ), ring_buffer_entry, split_info->ring_buffer_first_scanline  STBIR_ONLY_PROFILE_SET_SPLIT_INFO );
+//=================
+// uint8 fixed point path (see stbir_set_uint8_fixed_point)
+//   This is always vertical first: the input scanlines are resampled straight from the
+//   caller's bytes into one 16-bit scanline with STBIR__FIXED_FRAC_BITS of fraction (no
+//   decode, and no ring of scanlines), which is then resampled horizontally into the output.
+//   Both filters use 16-bit coefficients with STBIR__FIXED_COEFF_BITS of fraction, and all
+//   of the sums are exact 32-bit integers. The coefficients are stored as pairs packed into
+//   ints (low tap in the low 16 bits), which is what pmaddwd wants, with each contributor
+//   padded with zero taps to a multiple of 8.
 
-  // mark it as empty
-  ring_buffer_entry[ 0 ] = STBIR__FLOAT_EMPTY_MARKER;
+#define STBIR__FIXED_COEFF_BITS 14
+#define STBIR__FIXED_FRAC_BITS 6
+#define STBIR__FIXED_VERTICAL_SHIFT ( STBIR__FIXED_COEFF_BITS - STBIR__FIXED_FRAC_BITS )
+#define STBIR__FIXED_HORIZONTAL_SHIFT ( STBIR__FIXED_COEFF_BITS + STBIR__FIXED_FRAC_BITS )
+#define STBIR__FIXED_PAIRS( coefficient_width ) ( ( ( coefficient_width ) + 7 ) >> 3 << 2 )
 
-  // advance the first scanline
-  split_info->ring_buffer_first_scanline++;
-  if ( ++split_info->ring_buffer_begin_index == stbir_info->ring_buffer_num_entries )
-    split_info->ring_buffer_begin_index = 0;
+static int stbir__fixed_round( float f )
+{
+  f *= (float) ( 1 << STBIR__FIXED_COEFF_BITS );
+  return (int) ( f + ( ( f < 0.0f ) ? -0.5f : 0.5f ) );
 }
 
-static void stbir__horizontal_resample_and_encode_first_scanline_from_scatter(stbir__info const * stbir_info, stbir__per_split_info* split_info)
+// converts one axis of float coefficients, nudging the largest in each set so the set's sum is exact
+static void stbir__build_fixed_coefficients( int * fixed, stbir__contributors const * contributors, float const * coefficients, int coefficient_width, int count )
 {
-  // evict a scanline out into the output buffer
+  int pairs = STBIR__FIXED_PAIRS( coefficient_width );
+  int i, j;
 
-  float* ring_buffer_entry = stbir__get_ring_buffer_entry(stbir_info, split_info, split_info->ring_buffer_begin_index );
+  for( i = 0 ; i < count ; i++ )
+  {
+    int n = contributors[ i ].n1 - contributors[ i ].n0 + 1;
+    int sum = 0, target, largest = 0, largest_value = -65536;
+    float total = 0.0f;
+
+    for( j = 0 ; j < n ; j++ )
+    {
+      int c = stbir__fixed_round( coefficients[ j ] );
+      total += coefficients[ j ];
+      sum += c;
+      if ( c > largest_value )
+      {
+        largest_value = c;
+        largest = j;
+      }
+    }
+
+    target = stbir__fixed_round( total );
+
+    for( j = 0 ; j < pairs * 2 ; j += 2 )
+    {
+      int c0 = ( j < n ) ? stbir__fixed_round( coefficients[ j ] ) : 0;
+      int c1 = ( ( j + 1 ) < n ) ? stbir__fixed_round( coefficients[ j + 1 ] ) : 0;
+      if ( j == largest ) c0 += target - sum;
+      if ( ( j + 1 ) == largest ) c1 += target - sum;
+      fixed[ j >> 1 ] = (int) ( (unsigned int) (unsigned short) c0 | ( (unsigned int) (unsigned short) c1 << 16 ) );
+    }
+
+    fixed += pairs;
+    coefficients += coefficient_width;
+  }
+}
+
+static void stbir__fixed_vertical_gather( stbir__info const * stbir_info, stbir__per_split_info * split_info, short * output, int contrib_n0, int contrib_n1, int const * coefficients )
+{
+  int channels = stbir_info->channels;
+  int x0 = stbir_info->scanline_extents.conservative.n0;
+  int x1 = stbir_info->scanline_extents.conservative.n1 + 1;
+  int * accumulate = (int *) split_info->vertical_buffer;  // running sums, when there are more than 16 scanlines
+  int k, total = contrib_n1 - contrib_n0 + 1;
+
+  if ( x0 < 0 ) x0 = 0;
+  if ( x1 > stbir_info->horizontal.scale_info.input_full_size ) x1 = stbir_info->horizontal.scale_info.input_full_size;
+  x0 *= channels;
+  x1 *= channels;
+
+  // do the scanlines in groups of up to 16 (8 pairs)
+  for( k = 0 ; k < total ; k += 16 )
+  {
+    unsigned char const * inputs[ 16 ];
+    int const * coeffs = coefficients + ( k >> 1 );
+    int i, x, pairs, rows = total - k;
+    int first = ( k == 0 ), last = ( rows <= 16 );
+
+    if ( rows > 16 ) rows = 16;
+    pairs = ( rows + 1 ) >> 1;
+
+    for( i = 0 ; i < pairs * 2 ; i++ )
+    {
+      // an odd scanline is paired with itself (its partner coefficient is a zero pad)
+      int r = ( i < rows ) ? i : i - 1;
+      int row = stbir__edge_wrap( stbir_info->vertical.edge, contrib_n0 + k + r, stbir_info->vertical.scale_info.input_full_size );
+      inputs[ i ] = ( (unsigned char const *) stbir_info->input_data ) + (size_t) row * (size_t) stbir_info->input_stride_bytes;
+    }
+
+    x = x0;
+  #ifdef STBIR_AVX2
+    // the 128-bit lanes unpack separately, so the accumulators hold the lanes out of order (which
+    //   doesn't matter, since every group uses the same x steps), and get put in order on the store
+    for( ; x + 32 <= x1 ; x += 32 )
+    {
+      __m256i zero = _mm256_setzero_si256();
+      __m256i a0, a1, a2, a3;
+      if ( first )
+        a0 = a1 = a2 = a3 = _mm256_set1_epi32( 1 << ( STBIR__FIXED_VERTICAL_SHIFT - 1 ) );
+      else
+      {
+        a0 = _mm256_loadu_si256( (__m256i const*) ( accumulate + x ) );
+        a1 = _mm256_loadu_si256( (__m256i const*) ( accumulate + x + 8 ) );
+        a2 = _mm256_loadu_si256( (__m256i const*) ( accumulate + x + 16 ) );
+        a3 = _mm256_loadu_si256( (__m256i const*) ( accumulate + x + 24 ) );
+      }
+
+      for( i = 0 ; i < pairs ; i++ )
+      {
+        __m256i r0 = _mm256_loadu_si256( (__m256i const*) ( inputs[ i * 2 ] + x ) );
+        __m256i r1 = _mm256_loadu_si256( (__m256i const*) ( inputs[ i * 2 + 1 ] + x ) );
+        __m256i c = _mm256_set1_epi32( coeffs[ i ] );
+        __m256i lo = _mm256_unpacklo_epi8( r0, r1 );
+        __m256i hi = _mm256_unpackhi_epi8( r0, r1 );
+        a0 = _mm256_add_epi32( a0, _mm256_madd_epi16( _mm256_unpacklo_epi8( lo, zero ), c ) );
+        a1 = _mm256_add_epi32( a1, _mm256_madd_epi16( _mm256_unpackhi_epi8( lo, zero ), c ) );
+        a2 = _mm256_add_epi32( a2, _mm256_madd_epi16( _mm256_unpacklo_epi8( hi, zero ), c ) );
+        a3 = _mm256_add_epi32( a3, _mm256_madd_epi16( _mm256_unpackhi_epi8( hi, zero ), c ) );
+      }
+
+      if ( last )
+      {
+        __m256i s01 = _mm256_packs_epi32( _mm256_srai_epi32( a0, STBIR__FIXED_VERTICAL_SHIFT ), _mm256_srai_epi32( a1, STBIR__FIXED_VERTICAL_SHIFT ) );
+        __m256i s23 = _mm256_packs_epi32( _mm256_srai_epi32( a2, STBIR__FIXED_VERTICAL_SHIFT ), _mm256_srai_epi32( a3, STBIR__FIXED_VERTICAL_SHIFT ) );
+        _mm256_storeu_si256( (__m256i*) ( output + x ), _mm256_permute2x128_si256( s01, s23, 0x20 ) );
+        _mm256_storeu_si256( (__m256i*) ( output + x + 16 ), _mm256_permute2x128_si256( s01, s23, 0x31 ) );
+      }
+      else
+      {
+        _mm256_storeu_si256( (__m256i*) ( accumulate + x ), a0 );
+        _mm256_storeu_si256( (__m256i*) ( accumulate + x + 8 ), a1 );
+        _mm256_storeu_si256( (__m256i*) ( accumulate + x + 16 ), a2 );
+        _mm256_storeu_si256( (__m256i*) ( accumulate + x + 24 ), a3 );
+      }
+    }
+  #endif
+  #ifdef STBIR_SSE2
+    for( ; x + 16 <= x1 ; x += 16 )
+    {
+      __m128i zero = _mm_setzero_si128();
+      __m128i a0, a1, a2, a3;
+      if ( first )
+        a0 = a1 = a2 = a3 = _mm_set1_epi32( 1 << ( STBIR__FIXED_VERTICAL_SHIFT - 1 ) );
+      else
+      {
+        a0 = _mm_loadu_si128( (__m128i const*) ( accumulate + x ) );
+        a1 = _mm_loadu_si128( (__m128i const*) ( accumulate + x + 4 ) );
+        a2 = _mm_loadu_si128( (__m128i const*) ( accumulate + x + 8 ) );
+        a3 = _mm_loadu_si128( (__m128i const*) ( accumulate + x + 12 ) );
+      }
+
+      for( i = 0 ; i < pairs ; i++ )
+      {
+        __m128i r0 = _mm_loadu_si128( (__m128i const*) ( inputs[ i * 2 ] + x ) );
+        __m128i r1 = _mm_loadu_si128( (__m128i const*) ( inputs[ i * 2 + 1 ] + x ) );
+        __m128i c = _mm_set1_epi32( coeffs[ i ] );
+        __m128i lo = _mm_unpacklo_epi8( r0, r1 );
+        __m128i hi = _mm_unpackhi_epi8( r0, r1 );
+        a0 = _mm_add_epi32( a0, _mm_madd_epi16( _mm_unpacklo_epi8( lo, zero ), c ) );
+        a1 = _mm_add_epi32( a1, _mm_madd_epi16( _mm_unpackhi_epi8( lo, zero ), c ) );
+        a2 = _mm_add_epi32( a2, _mm_madd_epi16( _mm_unpacklo_epi8( hi, zero ), c ) );
+        a3 = _mm_add_epi32( a3, _mm_madd_epi16( _mm_unpackhi_epi8( hi, zero ), c ) );
+      }
+
+      if ( last )
+      {
+        _mm_storeu_si128( (__m128i*) ( output + x ), _mm_packs_epi32( _mm_srai_epi32( a0, STBIR__FIXED_VERTICAL_SHIFT ), _mm_srai_epi32( a1, STBIR__FIXED_VERTICAL_SHIFT ) ) );
+        _mm_storeu_si128( (__m128i*) ( output + x + 8 ), _mm_packs_epi32( _mm_srai_epi32( a2, STBIR__FIXED_VERTICAL_SHIFT ), _mm_srai_epi32( a3, STBIR__FIXED_VERTICAL_SHIFT ) ) );
+      }
+      else
+      {
+        _mm_storeu_si128( (__m128i*) ( accumulate + x ), a0 );
+        _mm_storeu_si128( (__m128i*) ( accumulate + x + 4 ), a1 );
+        _mm_storeu_si128( (__m128i*) ( accumulate + x + 8 ), a2 );
+        _mm_storeu_si128( (__m128i*) ( accumulate + x + 12 ), a3 );
+      }
+    }
+  #endif
+
+    for( ; x < x1 ; x++ )
+    {
+      int sum = ( first ) ? ( 1 << ( STBIR__FIXED_VERTICAL_SHIFT - 1 ) ) : accumulate[ x ];
+      for( i = 0 ; i < pairs ; i++ )
+        sum += inputs[ i * 2 ][ x ] * (short) coeffs[ i ] + inputs[ i * 2 + 1 ][ x ] * (short) ( coeffs[ i ] >> 16 );
+      if ( last )
+      {
+        sum >>= STBIR__FIXED_VERTICAL_SHIFT;
+        STBIR_CLAMP( sum, -32768, 32767 );
+        output[ x ] = (short) sum;
+      }
+      else
+        accumulate[ x ] = sum;
+    }
+  }
+}
+
+#ifdef STBIR_SSE2
+
+// loads 16 bytes, but zero fills anything at or past end (only used at the right edge of the scanline)
+static __m128i stbir__fixed_load_tail( short const * in, short const * end )
+{
+  short values[ 8 ];
+  int i;
+  for( i = 0 ; i < 8 ; i++ )
+    values[ i ] = ( ( in + i ) < end ) ? in[ i ] : 0;
+  return _mm_loadu_si128( (__m128i const*) values );
+}
+
+// two taps at a time: interleave two pixels (r0 r1 g0 g1 ...) so pmaddwd does a pair per channel.
+//   quads can eat taps four at a time first (setting up acc and advancing k and in).
+#define stbir__fixed_horizontal_pairs( chans, quads, store )                                          \
+  for( x = 0 ; x < output_w ; x++ )                                                                   \
+  {                                                                                                   \
+    short const * in = input + contributors->n0 * chans;                                              \
+    int k = 0, n = contributors->n1 - contributors->n0 + 1;                                           \
+    __m128i acc = round;                                                                              \
+    quads                                                                                             \
+    for( ; k < n ; k += 2 )                                                                           \
+    {                                                                                                 \
+      __m128i p = ( in <= safe_end ) ? _mm_loadu_si128( (__m128i const*) in ) : stbir__fixed_load_tail( in, end ); \
+      p = _mm_unpacklo_epi16( p, _mm_srli_si128( p, chans * 2 ) );                                    \
+      acc = _mm_add_epi32( acc, _mm_madd_epi16( p, _mm_set1_epi32( coefficients[ k >> 1 ] ) ) );      \
+      in += 2 * chans;                                                                                \
+    }                                                                                                 \
+    acc = _mm_srai_epi32( acc, STBIR__FIXED_HORIZONTAL_SHIFT );                                       \
+    acc = _mm_packs_epi32( acc, acc );                                                                \
+    acc = _mm_packus_epi16( acc, acc );                                                               \
+    store                                                                                             \
+    output += chans;                                                                                  \
+    ++contributors;                                                                                   \
+    coefficients += pairs;                                                                            \
+  }
+
+#ifdef STBIR_AVX2
+// 4 channel pixels are 16 bytes a pair, so with 256-bit registers, each 128-bit lane can do its own pair
+#define stbir__fixed_horizontal_quads4                                                                \
+  {                                                                                                   \
+    __m256i acc8 = _mm256_setzero_si256();                                                            \
+    for( ; ( k < n ) && ( in <= safe_end8 ) ; k += 4 )                                                \
+    {                                                                                                 \
+      __m256i p = _mm256_loadu_si256( (__m256i const*) in );                                          \
+      __m256i c = _mm256_permutevar8x32_epi32( _mm256_castsi128_si256( _mm_loadl_epi64( (__m128i const*) ( coefficients + ( k >> 1 ) ) ) ), spread ); \
+      p = _mm256_unpacklo_epi16( p, _mm256_srli_si256( p, 8 ) );                                      \
+      acc8 = _mm256_add_epi32( acc8, _mm256_madd_epi16( p, c ) );                                     \
+      in += 16;                                                                                       \
+    }                                                                                                 \
+    acc = _mm_add_epi32( acc, _mm_add_epi32( _mm256_castsi256_si128( acc8 ), _mm256_extracti128_si256( acc8, 1 ) ) ); \
+  }
+#else
+#define stbir__fixed_horizontal_quads4
+#endif
+
+#endif
+
+static void stbir__fixed_horizontal_gather( stbir__info const * stbir_info, unsigned char * output, short const * input )
+{
+  stbir__contributors const * contributors = stbir_info->horizontal.contributors;
+  int const * coefficients = stbir_info->fixed_horizontal_coefficients;
+  int pairs = STBIR__FIXED_PAIRS( stbir_info->horizontal.coefficient_width );
+  int channels = stbir_info->channels;
+  int x, output_w = stbir_info->horizontal.scale_info.output_sub_size;
+
+#ifdef STBIR_SSE2
+  short const * end = input + stbir_info->horizontal.scale_info.input_full_size * channels;
+  short const * safe_end = end - 8;
+  __m128i round = _mm_set1_epi32( 1 << ( STBIR__FIXED_HORIZONTAL_SHIFT - 1 ) );
+
+  switch( channels )
+  {
+    case 1:
+      for( x = 0 ; x < output_w ; x++ )
+      {
+        short const * in = input + contributors->n0;
+        int k, sum, n = contributors->n1 - contributors->n0 + 1;
+        __m128i acc = _mm_setzero_si128();
+        for( k = 0 ; k < n ; k += 8 )
+        {
+          __m128i p = ( in <= safe_end ) ? _mm_loadu_si128( (__m128i const*) in ) : stbir__fixed_load_tail( in, end );
+          acc = _mm_add_epi32( acc, _mm_madd_epi16( p, _mm_loadu_si128( (__m128i const*) ( coefficients + ( k >> 1 ) ) ) ) );
+          in += 8;
+        }
+        acc = _mm_add_epi32( acc, _mm_shuffle_epi32( acc, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+        acc = _mm_add_epi32( acc, _mm_shuffle_epi32( acc, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+        sum = ( _mm_cvtsi128_si32( acc ) + ( 1 << ( STBIR__FIXED_HORIZONTAL_SHIFT - 1 ) ) ) >> STBIR__FIXED_HORIZONTAL_SHIFT;
+        STBIR_CLAMP( sum, 0, 255 );
+        *output++ = (unsigned char) sum;
+        ++contributors;
+        coefficients += pairs;
+      }
+      return;
+    case 2:
+      stbir__fixed_horizontal_pairs( 2, , { int v = _mm_cvtsi128_si32( acc ); output[ 0 ] = (unsigned char) v; output[ 1 ] = (unsigned char) ( v >> 8 ); } )
+      return;
+    case 3:
+      stbir__fixed_horizontal_pairs( 3, , { int v = _mm_cvtsi128_si32( acc ); output[ 0 ] = (unsigned char) v; output[ 1 ] = (unsigned char) ( v >> 8 ); output[ 2 ] = (unsigned char) ( v >> 16 ); } )
+      return;
+    case 4:
+    {
+    #ifdef STBIR_AVX2
+      short const * safe_end8 = end - 16;
+      __m256i spread = _mm256_setr_epi32( 0, 0, 0, 0, 1, 1, 1, 1 );
+    #endif
+      stbir__fixed_horizontal_pairs( 4, stbir__fixed_horizontal_quads4, stbir__simdi_store1( output, acc ); )
+      return;
+    }
+  }
+#endif
+
+  for( x = 0 ; x < output_w ; x++ )
+  {
+    short const * in = input + contributors->n0 * channels;
+    int n = contributors->n1 - contributors->n0 + 1;
+    int k, c;
+
+    for( c = 0 ; c < channels ; c++ )
+    {
+      int sum = 1 << ( STBIR__FIXED_HORIZONTAL_SHIFT - 1 );
+      for( k = 0 ; k < n ; k++ )
+        sum += in[ k * channels + c ] * (short) ( coefficients[ k >> 1 ] >> ( ( k & 1 ) * 16 ) );
+      sum >>= STBIR__FIXED_HORIZONTAL_SHIFT;
+      STBIR_CLAMP( sum, 0, 255 );
+      *output++ = (unsigned char) sum;
+    }
+
+    ++contributors;
+    coefficients += pairs;
+  }
+}
+
+static void stbir__fixed_gather_loop( stbir__info const * stbir_info, stbir__per_split_info* split_info, int split_count )
+{
+  int y, start_output_y, end_output_y;
+  stbir__contributors* vertical_contributors = stbir_info->vertical.contributors;
+  int const * vertical_coefficients = stbir_info->fixed_vertical_coefficients;
+  int vertical_pairs = STBIR__FIXED_PAIRS( stbir_info->vertical.coefficient_width );
+  short * scanline = (short *) stbir__get_ring_buffer_entry( stbir_info, split_info, 0 );
+
+  STBIR_ASSERT( stbir_info->vertical.is_gather );
+  STBIR_ASSERT( stbir_info->vertical_first );
+
+  start_output_y = split_info->start_output_y;
+  end_output_y = split_info[split_count-1].end_output_y;
+
+  vertical_contributors += start_output_y;
+  vertical_coefficients += start_output_y * vertical_pairs;
+
+  for (y = start_output_y; y < end_output_y; y++)
+  {
+    STBIR_PROFILE_START( vertical );
+    stbir__fixed_vertical_gather( stbir_info, split_info, scanline, vertical_contributors->n0, vertical_contributors->n1, vertical_coefficients );
+    STBIR_PROFILE_END( vertical );
+
+    STBIR_PROFILE_START( horizontal );
+    stbir__fixed_horizontal_gather( stbir_info, ( (unsigned char *) stbir_info->output_data ) + (size_t) y * (size_t) stbir_info->output_stride_bytes, scanline );
+    STBIR_PROFILE_END( horizontal );
+
+    ++vertical_contributors;
+    vertical_coefficients += vertical_pairs;
+  }
+}
+
+#define STBIR__FLOAT_EMPTY_MARKER 3.0e+38F
+#define STBIR__FLOAT_BUFFER_IS_EMPTY(ptr) ((ptr)[0]==STBIR__FLOAT_EMPTY_MARKER)
+
+static void stbir__encode_first_scanline_from_scatter(stbir__info const * stbir_info, stbir__per_split_info* split_info)
+{
+  // evict a scanline out into the output buffer
+  float* ring_buffer_entry = stbir__get_ring_buffer_entry(stbir_info, split_info, split_info->ring_buffer_begin_index );
+
+  // dump the scanline out
+  stbir__encode_scanline( stbir_info, ( (char *)stbir_info->output_data ) + ( (size_t)split_info->ring_buffer_first_scanline * (size_t)stbir_info->output_stride_bytes ), ring_buffer_entry, split_info->ring_buffer_first_scanline  STBIR_ONLY_PROFILE_SET_SPLIT_INFO );
+
+  // mark it as empty
+  ring_buffer_entry[ 0 ] = STBIR__FLOAT_EMPTY_MARKER;
+
+  // advance the first scanline
+  split_info->ring_buffer_first_scanline++;
+  if ( ++split_info->ring_buffer_begin_index == stbir_info->ring_buffer_num_entries )
+    split_info->ring_buffer_begin_index = 0;
+}
+
+static void stbir__horizontal_resample_and_encode_first_scanline_from_scatter(stbir__info const * stbir_info, stbir__per_split_info* split_info)
+{
+  // evict a scanline out into the output buffer
+
+  float* ring_buffer_entry = stbir__get_ring_buffer_entry(stbir_info, split_info, split_info->ring_buffer_begin_index );
 
   // Now resample it into the buffer.
   stbir__resample_horizontal_gather( stbir_info, split_info->vertical_buffer, ring_buffer_entry  STBIR_ONLY_PROFILE_SET_SPLIT_INFO );
@@ -6511,9 +7732,10 @@ static void stbir__vertical_scatter_loop( stbir__info const * stbir_info, stbir_
 
       // Now it's sitting in the buffer ready to be distributed into the ring buffers.
 
-      // evict from the ringbuffer, if we need are full
-      if ( ( ( split_info->ring_buffer_last_scanline - split_info->ring_buffer_first_scanline + 1 ) == stbir_info->ring_buffer_num_entries ) &&
-           ( out_last_scanline > split_info->ring_buffer_last_scanline ) )
+      // evict from the ringbuffer until the new scanlines fit (usually one, but more if an input
+      //   scanline had no weights, since the ring buffer is only as big as the widest scatter)
+      while ( ( split_info->ring_buffer_last_scanline >= split_info->ring_buffer_first_scanline ) &&
+              ( ( out_last_scanline - split_info->ring_buffer_first_scanline + 1 ) > stbir_info->ring_buffer_num_entries ) )
         handle_scanline_for_scatter( stbir_info, split_info );
 
       // Now the horizontal buffer is ready to write to all ring buffer rows, so do it.
@@ -6822,13 +8044,21 @@ static void stbir__free_internal_mem( stbir__info *info )
       STBIR__FREE_AND_CLEAR( info->split_info[i].vertical_buffer );
     }
     STBIR__FREE_AND_CLEAR( info->split_info );
-    if ( info->vertical.coefficients != info->horizontal.coefficients )
+    if ( info->shared_samplers == 0 )
     {
-      STBIR__FREE_AND_CLEAR( info->vertical.coefficients );
-      STBIR__FREE_AND_CLEAR( info->vertical.contributors );
+      if ( info->vertical.coefficients != info->horizontal.coefficients )
+      {
+        STBIR__FREE_AND_CLEAR( info->vertical.coefficients );
+        STBIR__FREE_AND_CLEAR( info->vertical.contributors );
+      }
+      STBIR__FREE_AND_CLEAR( info->horizontal.coefficients );
+      STBIR__FREE_AND_CLEAR( info->horizontal.contributors );
+      if ( info->fixed_point )
+      {
+        STBIR__FREE_AND_CLEAR( info->fixed_horizontal_coefficients );
+        STBIR__FREE_AND_CLEAR( info->fixed_vertical_coefficients );
+      }
     }
-    STBIR__FREE_AND_CLEAR( info->horizontal.coefficients );
-    STBIR__FREE_AND_CLEAR( info->horizontal.contributors );
     STBIR__FREE_AND_CLEAR( info->alloced_mem );
     STBIR_FREE( info, info->user_data );
   #endif
@@ -6927,11 +8157,80 @@ typedef struct STBIR__V_FIRST_INFO
 
 #ifdef STBIR__V_FIRST_INFO_BUFFER
 static STBIR__V_FIRST_INFO STBIR__V_FIRST_INFO_BUFFER = {0};
-#define STBIR__V_FIRST_INFO_POINTER &STBIR__V_FIRST_INFO_BUFFER
-#else
-#define STBIR__V_FIRST_INFO_POINTER 0
 #endif
 
+// maps effective channels to the first index of stbir__compute_weights
+static char stbir__channel_count_index[8]={ 9,0,1,2, 3,9,9,4 };
+
+// measured results from stbir_calibrate_vertical_first - for each channel count and classification,
+//   the resizes are bucketed by their predicted vertical/horizontal cost ratio (in half octaves
+//   from 1/16 to 16), and each bucket keeps a running vote of which order was actually faster
+#define STBIR__V_FIRST_CALIBRATION_BUCKETS 16
+
+// a vote of (h-v)/(h+v) this close to zero is about a 5% difference in time, which is within
+//   run-to-run timing noise - a bucket has to average more than this to overrule the trained costs
+#define STBIR__V_FIRST_CALIBRATION_NOISE 0.025f
+
+typedef struct
+{
+  float vote;  // sum of (horizontal time - vertical time) / (horizontal time + vertical time)
+  int count;
+} stbir__vertical_first_calibration_entry;
+
+static stbir__vertical_first_calibration_entry stbir__vertical_first_calibration[5][STBIR_RESIZE_CLASSIFICATIONS][STBIR__V_FIRST_CALIBRATION_BUCKETS];
+
+// costs can be zero with some of the weights
+#define STBIR__MIN_V_FIRST_COST 0.125
+
+static int stbir__vertical_first_calibration_bucket( STBIR__V_FIRST_INFO const * v_info )
+{
+  double v_cost = ( v_info->v_cost < STBIR__MIN_V_FIRST_COST ) ? STBIR__MIN_V_FIRST_COST : v_info->v_cost;
+  double h_cost = ( v_info->h_cost < STBIR__MIN_V_FIRST_COST ) ? STBIR__MIN_V_FIRST_COST : v_info->h_cost;
+  double ratio = v_cost / h_cost;
+  int bucket = STBIR__V_FIRST_CALIBRATION_BUCKETS / 2;
+
+  while ( ( ratio >= 1.41421356 ) && ( bucket < STBIR__V_FIRST_CALIBRATION_BUCKETS - 1 ) )
+  {
+    ratio *= 0.70710678;
+    ++bucket;
+  }
+  while ( ( ratio < 1.0 ) && ( bucket > 0 ) )
+  {
+    ratio *= 1.41421356;
+    --bucket;
+  }
+
+  return bucket;
+}
+
+static int stbir__calibrated_vertical_first( int channel_index, STBIR__V_FIRST_INFO const * v_info, int vertical_first )
+{
+  stbir__vertical_first_calibration_entry const * entries = stbir__vertical_first_calibration[ channel_index ][ v_info->v_resize_classification ];
+  int bucket = stbir__vertical_first_calibration_bucket( v_info );
+  float vote = entries[ bucket ].vote;
+  int count = entries[ bucket ].count;
+
+  // if this bucket hasn't been timed, go with its neighbours
+  if ( count == 0 )
+  {
+    if ( bucket > 0 )
+    {
+      vote += entries[ bucket - 1 ].vote;
+      count += entries[ bucket - 1 ].count;
+    }
+    if ( bucket < STBIR__V_FIRST_CALIBRATION_BUCKETS - 1 )
+    {
+      vote += entries[ bucket + 1 ].vote;
+      count += entries[ bucket + 1 ].count;
+    }
+  }
+
+  if ( ( count == 0 ) || ( ( vote <= STBIR__V_FIRST_CALIBRATION_NOISE * count ) && ( vote >= -STBIR__V_FIRST_CALIBRATION_NOISE * count ) ) )
+    return vertical_first;
+
+  return ( vote > 0.0f ) ? 1 : 0;
+}
+
 // Figure out whether to scale along the horizontal or vertical first.
 //   This only *super* important when you are scaling by a massively
 //   different amount in the vertical vs the horizontal (for example, if
@@ -6953,6 +8252,11 @@ static STBIR__V_FIRST_INFO STBIR__V_FIRST_INFO_BUFFER = {0};
 //     is the app that does a bunch of timings, and vf_train.c is the
 //     app that solves for the best weights (and shows how well it
 //     does currently).
+//
+//   Since no set of weights is right for every CPU, you can also time
+//     the two orders at runtime with stbir_calibrate_vertical_first,
+//     and the measured winners override these costs for similar
+//     resizes (see stbir__calibrated_vertical_first).
 
 static int stbir__should_do_vertical_first( float weights_table[STBIR_RESIZE_CLASSIFICATIONS][4], int horizontal_filter_pixel_width, float horizontal_scale, int horizontal_output_size, int vertical_filter_pixel_width, float vertical_scale, int vertical_output_size, int is_gather, STBIR__V_FIRST_INFO * info )
 {
@@ -7017,11 +8321,12 @@ static stbir_internal_pixel_layout stbir__pixel_layout_convert_public_to_interna
   STBIRI_RGBA_PM, STBIRI_BGRA_PM, STBIRI_ARGB_PM, STBIRI_ABGR_PM, STBIRI_RA_PM, STBIRI_AR_PM,
 };
 
-static stbir__info * stbir__alloc_internal_mem_and_build_samplers( stbir__sampler * horizontal, stbir__sampler * vertical, stbir__contributors * conservative, stbir_pixel_layout input_pixel_layout_public, stbir_pixel_layout output_pixel_layout_public, int splits, int new_x, int new_y, int fast_alpha, void * user_data STBIR_ONLY_PROFILE_BUILD_GET_INFO )
+static stbir__info * stbir__alloc_internal_mem_and_build_samplers( stbir__sampler * horizontal, stbir__sampler * vertical, stbir__contributors * conservative, stbir_pixel_layout input_pixel_layout_public, stbir_pixel_layout output_pixel_layout_public, int splits, int new_x, int new_y, int fast_alpha, int fixed_point, stbir__info const * shared, STBIR__V_FIRST_INFO * v_info, void * user_data STBIR_ONLY_PROFILE_BUILD_GET_INFO )
 {
-  static char stbir_channel_count_index[8]={ 9,0,1,2, 3,9,9,4 };
-
   stbir__info * info = 0;
+  #ifndef STBIR__V_FIRST_INFO_BUFFER
+  STBIR__V_FIRST_INFO v_info_local;
+  #endif
   void * alloced = 0;
   size_t alloced_total = 0;
   int vertical_first;
@@ -7067,8 +8372,40 @@ static stbir__info * stbir__alloc_internal_mem_and_build_samplers( stbir__sample
   if ( channels != stbir__pixel_channels[ output_pixel_layout ] )
     return 0;
 
+  // the fixed point path only does straight gathers (no alpha weighting, no channel swapping,
+  //   no wrapped edge spans), and only if the samplers we're sharing have fixed coefficients
+  if ( ( alpha_weighting_type ) || ( input_pixel_layout != output_pixel_layout ) || ( !vertical->is_gather ) || ( horizontal->edge == STBIR_EDGE_WRAP ) || ( ( shared ) && ( !shared->fixed_point ) ) )
+    fixed_point = 0;
+
+  // we always need the costs for the calibration (the override buffer is for the timing tools)
+  if ( v_info == 0 )
+  {
+    #ifdef STBIR__V_FIRST_INFO_BUFFER
+    v_info = &STBIR__V_FIRST_INFO_BUFFER;
+    #else
+    v_info_local.control_v_first = 0;
+    v_info = &v_info_local;
+    #endif
+  }
+
   // get vertical first
-  vertical_first = stbir__should_do_vertical_first( stbir__compute_weights[ (int)stbir_channel_count_index[ effective_channels ] ], horizontal->filter_pixel_width, horizontal->scale_info.scale, horizontal->scale_info.output_sub_size, vertical->filter_pixel_width, vertical->scale_info.scale, vertical->scale_info.output_sub_size, vertical->is_gather, STBIR__V_FIRST_INFO_POINTER );
+  vertical_first = stbir__should_do_vertical_first( stbir__compute_weights[ (int)stbir__channel_count_index[ effective_channels ] ], horizontal->filter_pixel_width, horizontal->scale_info.scale, horizontal->scale_info.output_sub_size, vertical->filter_pixel_width, vertical->scale_info.scale, vertical->scale_info.output_sub_size, vertical->is_gather, v_info );
+
+  // if this kind of resize has been calibrated on this machine, use the measured costs
+  if ( v_info->control_v_first == 0 )
+    vertical_first = v_info->v_first = stbir__calibrated_vertical_first( (int)stbir__channel_count_index[ effective_channels ], v_info, vertical_first );
+
+  // the fixed point path is always vertical first, and its pmaddwd kernels only beat the
+  //   float ones once the horizontal pass runs on few enough scanlines. Timed with
+  //   fixedtimings.c (SSE2 and AVX2): at 1/2 it's 0.6x-1.0x for 1 to 3 channels (~1.0x-1.2x
+  //   for 4), from 1/4 down it's 1.1x-1.5x, except 2 channels, which are 0.8x-1.0x until 1/7.
+  if ( fixed_point )
+  {
+    if ( vertical->scale_info.scale <= ( ( effective_channels == 2 ) ? ( 1.0f / 7.0f ) : 0.25f ) )
+      vertical_first = 1;
+    else
+      fixed_point = 0;
+  }
 
   // sometimes read one float off in some of the unrolled loops (with a weight of zero coeff, so it doesn't have an effect)
   //   we use a few extra floats instead of just 1, so that input callback buffer can overlap with the decode buffer without
@@ -7086,10 +8423,23 @@ static stbir__info * stbir__alloc_internal_mem_and_build_samplers( stbir__sample
   if ( vertical_first )
     ring_buffer_length_bytes = ( decode_buffer_size + 15 ) & ~15;
 
+  // the fixed point path just has the one 16-bit vertically resampled input scanline (plus a float,
+  //   since 3 channel avx bumps separately allocated ring buffers by one)
+  if ( fixed_point )
+    ring_buffer_length_bytes = ( (size_t)horizontal->scale_info.input_full_size * (size_t)channels * sizeof(short) + sizeof(float) + 15 ) & ~15;
+
   if ( ( ring_buffer_length_bytes & 4095 ) == 0 ) ring_buffer_length_bytes += 64*3; // avoid 4k alias
 
   // One extra entry because floating point precision problems sometimes cause an extra to be necessary.
   alloc_ring_buffer_num_entries = vertical->filter_pixel_width + 1;
+  if ( fixed_point )
+    alloc_ring_buffer_num_entries = 1;
+
+  // when scattering, the ring buffer holds output scanlines, and each input scanline only adds into
+  //   coefficient_width of them, so the ring stays this small no matter how far we downsample
+  //   (filter_pixel_width is in input scanlines, and grows with the downsample ratio)
+  if ( !vertical->is_gather )
+    alloc_ring_buffer_num_entries = vertical->coefficient_width + 1;
 
   // we never need more ring buffer entries than the scanlines we're outputting when in scatter mode
   if ( ( !vertical->is_gather ) && ( alloc_ring_buffer_num_entries > conservative_split_output_size ) )
@@ -7103,6 +8453,10 @@ static stbir__info * stbir__alloc_internal_mem_and_build_samplers( stbir__sample
   //   If gathering, it's just the output buffer.
   vertical_buffer_size = (size_t)horizontal->scale_info.output_sub_size * (size_t)effective_channels * sizeof(float) + sizeof(float);  // extra float for padding
 
+  // the fixed point path accumulates whole input scanlines in it
+  if ( fixed_point )
+    vertical_buffer_size = (size_t)horizontal->scale_info.input_full_size * (size_t)channels * sizeof(int);
+
   // we make two passes through this loop, 1st to add everything up, 2nd to allocate and init
   for(;;)
   {
@@ -7131,6 +8485,9 @@ static stbir__info * stbir__alloc_internal_mem_and_build_samplers( stbir__sample
       // initialize info fields
       info->alloced_mem = alloced;
       info->alloced_total = alloced_total;
+      info->split_buffers_size = decode_buffer_size + ring_buffer_size + vertical_buffer_size;
+      info->shared_samplers = 0;
+      info->fixed_point = fixed_point;
 
       info->channels = channels;
       info->effective_channels = effective_channels;
@@ -7217,6 +8574,16 @@ static stbir__info * stbir__alloc_internal_mem_and_build_samplers( stbir__sample
       STBIR__NEXT_PTR( info->split_info[i].vertical_buffer, vertical_buffer_size, float );
     }
 
+    // when sharing another info's samplers, we only need our own per-split buffers
+    if ( shared )
+      goto no_vert_alloc;
+
+    if ( fixed_point )
+    {
+      STBIR__NEXT_PTR( info->fixed_horizontal_coefficients, (size_t) horizontal->scale_info.output_sub_size * STBIR__FIXED_PAIRS( horizontal->coefficient_width ) * sizeof( int ), int );
+      STBIR__NEXT_PTR( info->fixed_vertical_coefficients, (size_t) vertical->scale_info.output_sub_size * STBIR__FIXED_PAIRS( vertical->coefficient_width ) * sizeof( int ), int );
+    }
+
     // alloc memory for to-be-pivoted coeffs (if necessary)
     if ( vertical->is_gather == 0 )
     {
@@ -7282,7 +8649,20 @@ static stbir__info * stbir__alloc_internal_mem_and_build_samplers( stbir__sample
 
    no_vert_alloc:
 
-    if ( info )
+    if ( ( info ) && ( shared ) )
+    {
+      // the coefficients are read-only once built, so just point at them
+      STBIR_MEMCPY( &info->horizontal, &shared->horizontal, sizeof( stbir__sampler ) );
+      STBIR_MEMCPY( &info->vertical, &shared->vertical, sizeof( stbir__sampler ) );
+      info->vertical.gather_prescatter_contributors = 0;  // only used during the build
+      info->vertical.gather_prescatter_coefficients = 0;
+      info->scanline_extents = shared->scanline_extents;
+      info->horizontal_gather_channels = shared->horizontal_gather_channels;
+      info->fixed_horizontal_coefficients = shared->fixed_horizontal_coefficients;
+      info->fixed_vertical_coefficients = shared->fixed_vertical_coefficients;
+      info->shared_samplers = shared;
+    }
+    else if ( info )
     {
       STBIR_PROFILE_BUILD_START( horizontal );
 
@@ -7322,11 +8702,20 @@ static stbir__info * stbir__alloc_internal_mem_and_build_samplers( stbir__sample
         STBIR_PROFILE_BUILD_END( vertical );
       }
 
+      if ( fixed_point )
+      {
+        stbir__build_fixed_coefficients( info->fixed_horizontal_coefficients, info->horizontal.contributors, info->horizontal.coefficients, info->horizontal.coefficient_width, info->horizontal.scale_info.output_sub_size );
+        stbir__build_fixed_coefficients( info->fixed_vertical_coefficients, info->vertical.contributors, info->vertical.coefficients, info->vertical.coefficient_width, info->vertical.scale_info.output_sub_size );
+      }
+    }
+
+    if ( info )
+    {
       // setup the vertical split ranges
       stbir__get_split_info( info->split_info, info->splits, info->vertical.scale_info.output_sub_size, info->vertical.filter_pixel_margin, info->vertical.scale_info.input_full_size, info->vertical.is_gather, info->vertical.contributors );
 
-      // now we know precisely how many entries we need
-      info->ring_buffer_num_entries = info->vertical.extent_info.widest;
+      // now we know precisely how many entries we need (scatters use what we allocated, see above)
+      info->ring_buffer_num_entries = ( info->fixed_point ) ? 1 : ( info->vertical.is_gather ) ? info->vertical.extent_info.widest : info->alloc_ring_buffer_num_entries;
 
       // we never need more ring buffer entries than the scanlines we're outputting
       if ( ( !info->vertical.is_gather ) && ( info->ring_buffer_num_entries > conservative_split_output_size ) )
@@ -7356,7 +8745,9 @@ static int stbir__perform_resize( stbir__info const * info, int split_start, int
   STBIR_PROFILE_CLEAR_EXTRAS();
 
   STBIR_PROFILE_FIRST_START( looping );
-  if (info->vertical.is_gather)
+  if (info->fixed_point)
+    stbir__fixed_gather_loop( info, split_info, split_count );
+  else if (info->vertical.is_gather)
     stbir__vertical_gather_loop( info, split_info, split_count );
   else
     stbir__vertical_scatter_loop( info, split_info, split_count );
@@ -7367,19 +8758,19 @@ static int stbir__perform_resize( stbir__info const * info, int split_start, int
 
 static void stbir__update_info_from_resize( stbir__info * info, STBIR_RESIZE * resize )
 {
-  static stbir__decode_pixels_func * decode_simple[STBIR_TYPE_HALF_FLOAT-STBIR_TYPE_UINT8_SRGB+1]=
+  static stbir__decode_pixels_func * decode_simple[STBIR_TYPE_BFLOAT16-STBIR_TYPE_UINT8_SRGB+1]=
   {
-    /* 1ch-4ch */ stbir__decode_uint8_srgb, stbir__decode_uint8_srgb, 0, stbir__decode_float_linear, stbir__decode_half_float_linear,
+    /* 1ch-4ch */ stbir__decode_uint8_srgb, stbir__decode_uint8_srgb, 0, stbir__decode_float_linear, stbir__decode_half_float_linear, stbir__decode_bfloat16_linear,
   };
 
-  static stbir__decode_pixels_func * decode_alphas[STBIRI_AR-STBIRI_RGBA+1][STBIR_TYPE_HALF_FLOAT-STBIR_TYPE_UINT8_SRGB+1]=
+  static stbir__decode_pixels_func * decode_alphas[STBIRI_AR-STBIRI_RGBA+1][STBIR_TYPE_BFLOAT16-STBIR_TYPE_UINT8_SRGB+1]=
   {
-    { /* RGBA */ stbir__decode_uint8_srgb4_linearalpha,      stbir__decode_uint8_srgb,      0, stbir__decode_float_linear,      stbir__decode_half_float_linear },
-    { /* BGRA */ stbir__decode_uint8_srgb4_linearalpha_BGRA, stbir__decode_uint8_srgb_BGRA, 0, stbir__decode_float_linear_BGRA, stbir__decode_half_float_linear_BGRA },
-    { /* ARGB */ stbir__decode_uint8_srgb4_linearalpha_ARGB, stbir__decode_uint8_srgb_ARGB, 0, stbir__decode_float_linear_ARGB, stbir__decode_half_float_linear_ARGB },
-    { /* ABGR */ stbir__decode_uint8_srgb4_linearalpha_ABGR, stbir__decode_uint8_srgb_ABGR, 0, stbir__decode_float_linear_ABGR, stbir__decode_half_float_linear_ABGR },
-    { /* RA   */ stbir__decode_uint8_srgb2_linearalpha,      stbir__decode_uint8_srgb,      0, stbir__decode_float_linear,      stbir__decode_half_float_linear },
-    { /* AR   */ stbir__decode_uint8_srgb2_linearalpha_AR,   stbir__decode_uint8_srgb_AR,   0, stbir__decode_float_linear_AR,   stbir__decode_half_float_linear_AR },
+    { /* RGBA */ stbir__decode_uint8_srgb4_linearalpha,      stbir__decode_uint8_srgb,      0, stbir__decode_float_linear,      stbir__decode_half_float_linear,     stbir__decode_bfloat16_linear },
+    { /* BGRA */ stbir__decode_uint8_srgb4_linearalpha_BGRA, stbir__decode_uint8_srgb_BGRA, 0, stbir__decode_float_linear_BGRA, stbir__decode_half_float_linear_BGRA, stbir__decode_bfloat16_linear_BGRA },
+    { /* ARGB */ stbir__decode_uint8_srgb4_linearalpha_ARGB, stbir__decode_uint8_srgb_ARGB, 0, stbir__decode_float_linear_ARGB, stbir__decode_half_float_linear_ARGB, stbir__decode_bfloat16_linear_ARGB },
+    { /* ABGR */ stbir__decode_uint8_srgb4_linearalpha_ABGR, stbir__decode_uint8_srgb_ABGR, 0, stbir__decode_float_linear_ABGR, stbir__decode_half_float_linear_ABGR, stbir__decode_bfloat16_linear_ABGR },
+    { /* RA   */ stbir__decode_uint8_srgb2_linearalpha,      stbir__decode_uint8_srgb,      0, stbir__decode_float_linear,      stbir__decode_half_float_linear,     stbir__decode_bfloat16_linear },
+    { /* AR   */ stbir__decode_uint8_srgb2_linearalpha_AR,   stbir__decode_uint8_srgb_AR,   0, stbir__decode_float_linear_AR,   stbir__decode_half_float_linear_AR,  stbir__decode_bfloat16_linear_AR },
   };
 
   static stbir__decode_pixels_func * decode_simple_scaled_or_not[2][2]=
@@ -7397,19 +8788,19 @@ static void stbir__update_info_from_resize( stbir__info * info, STBIR_RESIZE * r
     { /* AR   */ { stbir__decode_uint8_linear_scaled_AR,    stbir__decode_uint8_linear_AR },   { stbir__decode_uint16_linear_scaled_AR,   stbir__decode_uint16_linear_AR } }
   };
 
-  static stbir__encode_pixels_func * encode_simple[STBIR_TYPE_HALF_FLOAT-STBIR_TYPE_UINT8_SRGB+1]=
+  static stbir__encode_pixels_func * encode_simple[STBIR_TYPE_BFLOAT16-STBIR_TYPE_UINT8_SRGB+1]=
   {
-    /* 1ch-4ch */ stbir__encode_uint8_srgb, stbir__encode_uint8_srgb, 0, stbir__encode_float_linear, stbir__encode_half_float_linear,
+    /* 1ch-4ch */ stbir__encode_uint8_srgb, stbir__encode_uint8_srgb, 0, stbir__encode_float_linear, stbir__encode_half_float_linear, stbir__encode_bfloat16_linear,
   };
 
-  static stbir__encode_pixels_func * encode_alphas[STBIRI_AR-STBIRI_RGBA+1][STBIR_TYPE_HALF_FLOAT-STBIR_TYPE_UINT8_SRGB+1]=
+  static stbir__encode_pixels_func * encode_alphas[STBIRI_AR-STBIRI_RGBA+1][STBIR_TYPE_BFLOAT16-STBIR_TYPE_UINT8_SRGB+1]=
   {
-    { /* RGBA */ stbir__encode_uint8_srgb4_linearalpha,      stbir__encode_uint8_srgb,      0, stbir__encode_float_linear,      stbir__encode_half_float_linear },
-    { /* BGRA */ stbir__encode_uint8_srgb4_linearalpha_BGRA, stbir__encode_uint8_srgb_BGRA, 0, stbir__encode_float_linear_BGRA, stbir__encode_half_float_linear_BGRA },
-    { /* ARGB */ stbir__encode_uint8_srgb4_linearalpha_ARGB, stbir__encode_uint8_srgb_ARGB, 0, stbir__encode_float_linear_ARGB, stbir__encode_half_float_linear_ARGB },
-    { /* ABGR */ stbir__encode_uint8_srgb4_linearalpha_ABGR, stbir__encode_uint8_srgb_ABGR, 0, stbir__encode_float_linear_ABGR, stbir__encode_half_float_linear_ABGR },
-    { /* RA   */ stbir__encode_uint8_srgb2_linearalpha,      stbir__encode_uint8_srgb,      0, stbir__encode_float_linear,      stbir__encode_half_float_linear },
-    { /* AR   */ stbir__encode_uint8_srgb2_linearalpha_AR,   stbir__encode_uint8_srgb_AR,   0, stbir__encode_float_linear_AR,   stbir__encode_half_float_linear_AR }
+    { /* RGBA */ stbir__encode_uint8_srgb4_linearalpha,      stbir__encode_uint8_srgb,      0, stbir__encode_float_linear,      stbir__encode_half_float_linear,     stbir__encode_bfloat16_linear },
+    { /* BGRA */ stbir__encode_uint8_srgb4_linearalpha_BGRA, stbir__encode_uint8_srgb_BGRA, 0, stbir__encode_float_linear_BGRA, stbir__encode_half_float_linear_BGRA, stbir__encode_bfloat16_linear_BGRA },
+    { /* ARGB */ stbir__encode_uint8_srgb4_linearalpha_ARGB, stbir__encode_uint8_srgb_ARGB, 0, stbir__encode_float_linear_ARGB, stbir__encode_half_float_linear_ARGB, stbir__encode_bfloat16_linear_ARGB },
+    { /* ABGR */ stbir__encode_uint8_srgb4_linearalpha_ABGR, stbir__encode_uint8_srgb_ABGR, 0, stbir__encode_float_linear_ABGR, stbir__encode_half_float_linear_ABGR, stbir__encode_bfloat16_linear_ABGR },
+    { /* RA   */ stbir__encode_uint8_srgb2_linearalpha,      stbir__encode_uint8_srgb,      0, stbir__encode_float_linear,      stbir__encode_half_float_linear,     stbir__encode_bfloat16_linear },
+    { /* AR   */ stbir__encode_uint8_srgb2_linearalpha_AR,   stbir__encode_uint8_srgb_AR,   0, stbir__encode_float_linear_AR,   stbir__encode_half_float_linear_AR,  stbir__encode_bfloat16_linear_AR }
   };
 
   static stbir__encode_pixels_func * encode_simple_scaled_or_not[2][2]=
@@ -7437,8 +8828,34 @@ static void stbir__update_info_from_resize( stbir__info * info, STBIR_RESIZE * r
   info->input_stride_bytes = resize->input_stride_in_bytes;
   info->output_stride_bytes = resize->output_stride_in_bytes;
 
-  // if we're completely point sampling, then we can turn off SRGB
-  if ( ( info->horizontal.filter_enum == STBIR_FILTER_POINT_SAMPLE ) && ( info->vertical.filter_enum == STBIR_FILTER_POINT_SAMPLE ) )
+  // the color matrix works on linear colors in the scanlines (scaled 0 to 1), and is
+  //   stored in the order the channels are in there (3 channel output is in output order)
+  info->color_matrix_mode = 0;
+  if ( ( resize->use_output_color_matrix ) && ( info->channels >= 3 ) )
+  {
+    int i;
+    info->color_matrix_mode = 1;
+    if ( ( info->output_pixel_layout_internal >= STBIRI_RGBA_PM ) && ( info->output_pixel_layout_internal <= STBIRI_ABGR_PM ) &&
+         ( ( info->input_pixel_layout_internal >= STBIRI_RGBA_PM ) || ( info->alpha_weight ) ) )
+      info->color_matrix_mode = 2;
+    for( i = 0 ; i < 12 ; i++ )
+      info->color_matrix[ i ] = resize->output_color_matrix[ i ];
+    if ( info->output_pixel_layout_internal == STBIRI_BGR )
+    {
+      // swap the r and b rows, and the r and b columns
+      for( i = 0 ; i < 4 ; i++ )
+      {
+        float t = info->color_matrix[ i ]; info->color_matrix[ i ] = info->color_matrix[ 8 + i ]; info->color_matrix[ 8 + i ] = t;
+      }
+      for( i = 0 ; i < 12 ; i += 4 )
+      {
+        float t = info->color_matrix[ i ]; info->color_matrix[ i ] = info->color_matrix[ i + 2 ]; info->color_matrix[ i + 2 ] = t;
+      }
+    }
+  }
+
+  // if we're completely point sampling, then we can turn off SRGB (unless there's a color matrix, which needs linear)
+  if ( ( info->horizontal.filter_enum == STBIR_FILTER_POINT_SAMPLE ) && ( info->vertical.filter_enum == STBIR_FILTER_POINT_SAMPLE ) && ( !info->color_matrix_mode ) )
   {
     if ( ( ( input_type  == STBIR_TYPE_UINT8_SRGB ) || ( input_type  == STBIR_TYPE_UINT8_SRGB_ALPHA ) ) &&
          ( ( output_type == STBIR_TYPE_UINT8_SRGB ) || ( output_type == STBIR_TYPE_UINT8_SRGB_ALPHA ) ) )
@@ -7468,7 +8885,7 @@ static void stbir__update_info_from_resize( stbir__info * info, STBIR_RESIZE * r
     int non_scaled = 0;
 
     // check if we can run unscaled - 0-255.0/0-65535.0 instead of 0-1.0 (which is a tiny bit faster when doing linear 8->8 or 16->16)
-    if ( ( !info->alpha_weight ) && ( !info->alpha_unweight )  ) // don't short circuit when alpha weighting (get everything to 0-1.0 as usual)
+    if ( ( !info->alpha_weight ) && ( !info->alpha_unweight ) && ( !info->color_matrix_mode ) ) // don't short circuit when alpha weighting or color matrixing (get everything to 0-1.0 as usual)
       if ( ( ( input_type == STBIR_TYPE_UINT8 ) && ( output_type == STBIR_TYPE_UINT8 ) ) || ( ( input_type == STBIR_TYPE_UINT16 ) && ( output_type == STBIR_TYPE_UINT16 ) ) )
         non_scaled = 1;
 
@@ -7491,7 +8908,7 @@ static void stbir__update_info_from_resize( stbir__info * info, STBIR_RESIZE * r
     int non_scaled = 0;
 
     // check if we can run unscaled - 0-255.0/0-65535.0 instead of 0-1.0 (which is a tiny bit faster when doing linear 8->8 or 16->16)
-    if ( ( !info->alpha_weight ) && ( !info->alpha_unweight ) ) // don't short circuit when alpha weighting (get everything to 0-1.0 as usual)
+    if ( ( !info->alpha_weight ) && ( !info->alpha_unweight ) && ( !info->color_matrix_mode ) ) // don't short circuit when alpha weighting or color matrixing (get everything to 0-1.0 as usual)
       if ( ( ( input_type == STBIR_TYPE_UINT8 ) && ( output_type == STBIR_TYPE_UINT8 ) ) || ( ( input_type == STBIR_TYPE_UINT16 ) && ( output_type == STBIR_TYPE_UINT16 ) ) )
         non_scaled = 1;
 
@@ -7703,6 +9120,8 @@ STBIRDEF void stbir_resize_init( STBIR_RESIZE * resize,
   resize->output_h = output_h;
   resize->output_stride_in_bytes = output_stride_in_bytes;
   resize->fast_alpha = 0;
+  resize->uint8_fixed_point = 0;
+  resize->use_output_color_matrix = 0;
 
   stbir__init_and_set_layout( resize, pixel_layout, data_type );
 }
@@ -7713,7 +9132,13 @@ STBIRDEF void stbir_set_datatypes( STBIR_RESIZE * resize, stbir_datatype input_t
   resize->input_data_type = input_type;
   resize->output_data_type = output_type;
   if ( ( resize->samplers ) && ( !resize->needs_rebuild ) )
-    stbir__update_info_from_resize( resize->samplers, resize );
+  {
+    // the fixed point path's buffers are only big enough for uint8
+    if ( ( resize->samplers->fixed_point ) && ( ( input_type != STBIR_TYPE_UINT8 ) || ( output_type != STBIR_TYPE_UINT8 ) ) )
+      resize->needs_rebuild = 1;
+    else
+      stbir__update_info_from_resize( resize->samplers, resize );
+  }
 }
 
 STBIRDEF void stbir_set_pixel_callbacks( STBIR_RESIZE * resize, stbir_input_callback * input_cb, stbir_output_callback * output_cb )   // no callbacks by default
@@ -7723,6 +9148,9 @@ STBIRDEF void stbir_set_pixel_callbacks( STBIR_RESIZE * resize, stbir_input_call
 
   if ( ( resize->samplers ) && ( !resize->needs_rebuild ) )
   {
+    // the fixed point path doesn't do callbacks
+    if ( ( resize->samplers->fixed_point ) && ( ( input_cb ) || ( output_cb ) ) )
+      resize->needs_rebuild = 1;
     resize->samplers->in_pixels_cb = input_cb;
     resize->samplers->out_pixels_cb = output_cb;
   }
@@ -7745,6 +9173,27 @@ STBIRDEF void stbir_set_buffer_ptrs( STBIR_RESIZE * resize, const void * input_p
     stbir__update_info_from_resize( resize->samplers, resize );
 }
 
+STBIRDEF int stbir_set_output_color_matrix( STBIR_RESIZE * resize, float const * matrix )                        // no color matrix by default
+{
+  int i;
+
+  resize->use_output_color_matrix = ( matrix != 0 );
+  if ( matrix )
+    for( i = 0 ; i < 12 ; i++ )
+      resize->output_color_matrix[ i ] = matrix[ i ];
+
+  if ( ( resize->samplers ) && ( !resize->needs_rebuild ) )
+  {
+    // the fixed point path never has float scanlines to apply it to
+    if ( ( resize->samplers->fixed_point ) && ( matrix ) )
+      resize->needs_rebuild = 1;
+    else
+      stbir__update_info_from_resize( resize->samplers, resize );
+  }
+
+  return ( stbir__pixel_channels[ stbir__pixel_layout_convert_public_to_internal[ resize->output_pixel_layout_public ] ] >= 3 );
+}
+
 
 STBIRDEF int stbir_set_edgemodes( STBIR_RESIZE * resize, stbir_edge horizontal_edge, stbir_edge vertical_edge )       // CLAMP by default
 {
@@ -7786,6 +9235,13 @@ STBIRDEF int stbir_set_non_pm_alpha_speed_over_quality( STBIR_RESIZE * resize, i
   return 1;
 }
 
+STBIRDEF int stbir_set_uint8_fixed_point( STBIR_RESIZE * resize, int use_fixed_point )   // sets fixed point for uint8
+{
+  resize->uint8_fixed_point = use_fixed_point;
+  resize->needs_rebuild = 1;
+  return 1;
+}
+
 STBIRDEF int stbir_set_input_subrect( STBIR_RESIZE * resize, double s0, double t0, double s1, double t1 )                 // sets input region (full region by default)
 {
   resize->input_s0 = s0;
@@ -7845,11 +9301,17 @@ STBIRDEF int stbir_set_pixel_subrect( STBIR_RESIZE * resize, int subx, int suby,
   return 1;
 }
 
-static int stbir__perform_build( STBIR_RESIZE * resize, int splits )
+static int stbir__wants_fixed_point( STBIR_RESIZE const * resize )
+{
+  return ( resize->uint8_fixed_point ) && ( resize->input_data_type == STBIR_TYPE_UINT8 ) && ( resize->output_data_type == STBIR_TYPE_UINT8 ) && ( !resize->use_output_color_matrix );
+}
+
+static int stbir__perform_build( STBIR_RESIZE * resize, int splits, stbir__info const * shared, STBIR__V_FIRST_INFO * v_info )
 {
   stbir__contributors conservative = { 0, 0 };
   stbir__sampler horizontal, vertical;
   int new_output_subx, new_output_suby;
+  int fixed_point;
   stbir__info * out_info;
   #ifdef STBIR_PROFILE
   stbir__info profile_infod;  // used to contain building profile info before everything is allocated
@@ -7895,8 +9357,11 @@ static int stbir__perform_build( STBIR_RESIZE * resize, int splits )
     if ( splits == 0 ) splits = 1;
   }
 
+  // the fixed point path reads and writes uint8 pixels directly, so no callbacks
+  fixed_point = ( stbir__wants_fixed_point( resize ) ) && ( resize->input_cb == 0 ) && ( resize->output_cb == 0 );
+
   STBIR_PROFILE_BUILD_START( alloc );
-  out_info = stbir__alloc_internal_mem_and_build_samplers( &horizontal, &vertical, &conservative, resize->input_pixel_layout_public, resize->output_pixel_layout_public, splits, new_output_subx, new_output_suby, resize->fast_alpha, resize->user_data STBIR_ONLY_PROFILE_BUILD_SET_INFO );
+  out_info = stbir__alloc_internal_mem_and_build_samplers( &horizontal, &vertical, &conservative, resize->input_pixel_layout_public, resize->output_pixel_layout_public, splits, new_output_subx, new_output_suby, resize->fast_alpha, fixed_point, shared, v_info, resize->user_data STBIR_ONLY_PROFILE_BUILD_SET_INFO );
   STBIR_PROFILE_BUILD_END( alloc );
   STBIR_PROFILE_BUILD_END( build );
 
@@ -7936,7 +9401,7 @@ STBIRDEF int stbir_build_samplers_with_splits( STBIR_RESIZE * resize, int splits
       stbir_free_samplers( resize );
 
     resize->called_alloc = 1;
-    return stbir__perform_build( resize, splits );
+    return stbir__perform_build( resize, splits, 0, 0 );
   }
 
   STBIR_PROFILE_BUILD_CLEAR( resize->samplers );
@@ -8012,10 +9477,543 @@ STBIRDEF int stbir_resize_extended_split( STBIR_RESIZE * resize, int split_start
   return stbir__perform_resize( resize->samplers, split_start, split_count );
 }
 
+#ifdef STBIR_USE_THREADS
 
-static void * stbir_quick_resize_helper( const void *input_pixels , int input_w , int input_h, int input_stride_in_bytes,
-                                               void *output_pixels, int output_w, int output_h, int output_stride_in_bytes,
-                                               stbir_pixel_layout pixel_layout, stbir_datatype data_type, stbir_edge edge, stbir_filter filter )
+#ifdef _WIN32
+  #ifndef WIN32_LEAN_AND_MEAN
+  #define WIN32_LEAN_AND_MEAN
+  #endif
+  #include <windows.h>
+  typedef HANDLE stbir__thread;
+  typedef SRWLOCK stbir__mutex;
+  typedef CONDITION_VARIABLE stbir__cond;
+  #define STBIR__THREAD_PROC( name, arg ) static DWORD WINAPI name( LPVOID arg )
+  #define STBIR__THREAD_RETURN return 0
+  #define stbir__thread_start( t, proc, arg ) ( ( *(t) = CreateThread( 0, 0, proc, arg, 0, 0 ) ) != 0 )
+  #define stbir__thread_join( t ) { WaitForSingleObject( t, INFINITE ); CloseHandle( t ); }
+  #define stbir__mutex_init( m ) InitializeSRWLock( m )
+  #define stbir__mutex_destroy( m )
+  #define stbir__mutex_lock( m ) AcquireSRWLockExclusive( m )
+  #define stbir__mutex_unlock( m ) ReleaseSRWLockExclusive( m )
+  #define stbir__cond_init( c ) InitializeConditionVariable( c )
+  #define stbir__cond_destroy( c )
+  #define stbir__cond_wait( c, m ) SleepConditionVariableSRW( c, m, INFINITE, 0 )
+  #define stbir__cond_broadcast( c ) WakeAllConditionVariable( c )
+#else
+  #include <pthread.h>
+  typedef pthread_t stbir__thread;
+  typedef pthread_mutex_t stbir__mutex;
+  typedef pthread_cond_t stbir__cond;
+  #define STBIR__THREAD_PROC( name, arg ) static void * name( void * arg )
+  #define STBIR__THREAD_RETURN return 0
+  #define stbir__thread_start( t, proc, arg ) ( pthread_create( t, 0, proc, arg ) == 0 )
+  #define stbir__thread_join( t ) pthread_join( t, 0 )
+  #define stbir__mutex_init( m ) pthread_mutex_init( m, 0 )
+  #define stbir__mutex_destroy( m ) pthread_mutex_destroy( m )
+  #define stbir__mutex_lock( m ) pthread_mutex_lock( m )
+  #define stbir__mutex_unlock( m ) pthread_mutex_unlock( m )
+  #define stbir__cond_init( c ) pthread_cond_init( c, 0 )
+  #define stbir__cond_destroy( c ) pthread_cond_destroy( c )
+  #define stbir__cond_wait( c, m ) pthread_cond_wait( c, m )
+  #define stbir__cond_broadcast( c ) pthread_cond_broadcast( c )
+#endif
+
+struct stbir_thread_pool
+{
+  void * user_data;
+  stbir__mutex lock;
+  stbir__cond wake;       // workers wait here for a new batch (or quit)
+  stbir__cond finished;   // dispatcher waits here for the batch to complete
+
+  // current batch - only touched while holding the lock
+  stbir_task_func * task;
+  void * task_data;
+  int task_count, next_task, tasks_done;
+  unsigned int batch;
+  int quit;
+
+  int num_workers;
+  stbir__thread * workers;
+};
+
+// runs tasks from the current batch until there are none left to start - call with the lock held
+static void stbir__pool_run_tasks( stbir_thread_pool * pool )
+{
+  while ( pool->next_task < pool->task_count )
+  {
+    stbir_task_func * task = pool->task;
+    void * task_data = pool->task_data;
+    int index = pool->next_task++;
+
+    stbir__mutex_unlock( &pool->lock );
+    task( task_data, index );
+    stbir__mutex_lock( &pool->lock );
+
+    if ( ++pool->tasks_done == pool->task_count )
+      stbir__cond_broadcast( &pool->finished );
+  }
+}
+
+STBIR__THREAD_PROC( stbir__pool_worker, data )
+{
+  stbir_thread_pool * pool = (stbir_thread_pool *) data;
+  unsigned int seen_batch = 0;
+
+  stbir__mutex_lock( &pool->lock );
+  for(;;)
+  {
+    while ( ( pool->batch == seen_batch ) && ( !pool->quit ) )
+      stbir__cond_wait( &pool->wake, &pool->lock );
+    if ( pool->quit )
+      break;
+    seen_batch = pool->batch;
+    stbir__pool_run_tasks( pool );
+  }
+  stbir__mutex_unlock( &pool->lock );
+
+  STBIR__THREAD_RETURN;
+}
+
+STBIRDEF stbir_thread_pool * stbir_thread_pool_create( int num_threads, void * user_data )
+{
+  stbir_thread_pool * pool;
+  int workers = ( num_threads > 1 ) ? ( num_threads - 1 ) : 0;
+
+  pool = (stbir_thread_pool *) STBIR_MALLOC( sizeof( stbir_thread_pool ) + sizeof( stbir__thread ) * workers, user_data );
+  if ( pool == 0 )
+    return 0;
+
+  pool->user_data = user_data;
+  pool->task = 0;
+  pool->task_data = 0;
+  pool->task_count = pool->next_task = pool->tasks_done = 0;
+  pool->batch = 0;
+  pool->quit = 0;
+  pool->workers = (stbir__thread *) ( pool + 1 );
+  stbir__mutex_init( &pool->lock );
+  stbir__cond_init( &pool->wake );
+  stbir__cond_init( &pool->finished );
+
+  // if we can't start them all, just run with what we got
+  for( pool->num_workers = 0 ; pool->num_workers < workers ; pool->num_workers++ )
+    if ( !stbir__thread_start( &pool->workers[ pool->num_workers ], stbir__pool_worker, pool ) )
+      break;
+
+  return pool;
+}
+
+STBIRDEF void stbir_thread_pool_destroy( stbir_thread_pool * pool )
+{
+  int i;
+
+  if ( pool == 0 )
+    return;
+
+  stbir__mutex_lock( &pool->lock );
+  pool->quit = 1;
+  stbir__cond_broadcast( &pool->wake );
+  stbir__mutex_unlock( &pool->lock );
+
+  for( i = 0 ; i < pool->num_workers ; i++ )
+    stbir__thread_join( pool->workers[ i ] );
+
+  stbir__cond_destroy( &pool->finished );
+  stbir__cond_destroy( &pool->wake );
+  stbir__mutex_destroy( &pool->lock );
+  STBIR_FREE( pool, pool->user_data );
+}
+
+STBIRDEF void stbir_thread_pool_dispatch( stbir_task_func * task, void * task_data, int task_count, void * pool_ptr )
+{
+  stbir_thread_pool * pool = (stbir_thread_pool *) pool_ptr;
+
+  if ( task_count <= 0 )
+    return;
+
+  stbir__mutex_lock( &pool->lock );
+  pool->task = task;
+  pool->task_data = task_data;
+  pool->task_count = task_count;
+  pool->next_task = 0;
+  pool->tasks_done = 0;
+  ++pool->batch;
+  stbir__cond_broadcast( &pool->wake );
+
+  // the calling thread works too
+  stbir__pool_run_tasks( pool );
+
+  while ( pool->tasks_done < pool->task_count )
+    stbir__cond_wait( &pool->finished, &pool->lock );
+  stbir__mutex_unlock( &pool->lock );
+}
+
+#endif // STBIR_USE_THREADS
+
+typedef struct
+{
+  stbir__info const * info;
+  int const * order; // split to run for each task (most expensive first), or NULL for in order
+} stbir__split_job;
+
+static void stbir__split_task( void * data, int task_index )
+{
+  stbir__split_job const * job = (stbir__split_job const *) data;
+  int split = ( job->order ) ? job->order[ task_index ] : task_index;
+
+  stbir__perform_resize( job->info, split, 1 );
+}
+
+// rough relative cost of a split: input scanlines decoded and horizontally resampled,
+//   plus output scanlines vertically resampled and encoded
+static float stbir__split_cost( stbir__info const * info, int split )
+{
+  stbir__per_split_info const * s = info->split_info + split;
+  float out_rows = (float) ( s->end_output_y - s->start_output_y );
+  float in_rows;
+  float horizontal_work = (float) ( info->scanline_extents.conservative.n1 - info->scanline_extents.conservative.n0 + 1 ) + (float) info->horizontal.scale_info.output_sub_size * (float) info->horizontal.filter_pixel_width;
+  float vertical_work = (float) info->horizontal.scale_info.output_sub_size * (float) info->vertical.filter_pixel_width;
+
+  if ( s->end_output_y <= s->start_output_y )
+    return 0.0f;
+
+  if ( info->vertical.is_gather )
+  {
+    stbir__contributors const * contribs = info->vertical.contributors;
+    in_rows = (float) ( contribs[ s->end_output_y - 1 ].n1 - contribs[ s->start_output_y ].n0 + 1 );
+  }
+  else
+  {
+    // scattering does the vertical work for every input scanline
+    in_rows = out_rows * info->vertical.scale_info.inv_scale + (float) ( 2 * info->vertical.filter_pixel_margin );
+    vertical_work *= in_rows / out_rows;
+  }
+
+  return in_rows * horizontal_work + out_rows * vertical_work;
+}
+
+STBIRDEF int stbir_resize_extended_threaded( STBIR_RESIZE * resize, int max_threads, stbir_dispatch_callback * dispatch, void * dispatch_context )
+{
+  stbir__split_job job;
+  int * order;
+  int i, splits;
+
+  if ( max_threads <= 1 )
+    return stbir_resize_extended( resize );
+
+  if ( ( resize->samplers == 0 ) || ( resize->needs_rebuild ) )
+  {
+    int alloc_state = resize->called_alloc;  // remember allocated state
+
+    if ( resize->samplers )
+    {
+      stbir__free_internal_mem( resize->samplers );
+      resize->samplers = 0;
+    }
+
+    if ( !stbir_build_samplers_with_splits( resize, max_threads * STBIR_SPLITS_PER_THREAD ) )
+      return 0;
+
+    resize->called_alloc = alloc_state;
+
+    // zero sized output, nothing to do (see stbir_resize_extended)
+    if ( resize->samplers == 0 )
+      return 1;
+  }
+  else
+  {
+    STBIR_PROFILE_BUILD_CLEAR( resize->samplers );
+  }
+
+  splits = resize->splits;
+  job.info = resize->samplers;
+  job.order = 0;
+
+  if ( splits > 1 )
+  {
+    // order the splits most expensive first, so the cheap ones fill in at the end
+    order = (int *) STBIR_MALLOC( ( sizeof( int ) + sizeof( float ) ) * splits, resize->user_data );
+    if ( order )
+    {
+      float * costs = (float *) ( order + splits );
+      for( i = 0 ; i < splits ; i++ )
+      {
+        int j = i;
+        float cost = stbir__split_cost( job.info, i );
+        for( ; ( j > 0 ) && ( costs[ j - 1 ] < cost ) ; j-- )
+        {
+          costs[ j ] = costs[ j - 1 ];
+          order[ j ] = order[ j - 1 ];
+        }
+        costs[ j ] = cost;
+        order[ j ] = i;
+      }
+      job.order = order;
+    }
+
+    if ( dispatch )
+      dispatch( stbir__split_task, &job, splits, dispatch_context );
+    else
+    {
+    #ifdef STBIR_USE_THREADS
+      stbir_thread_pool * pool = stbir_thread_pool_create( ( max_threads < splits ) ? max_threads : splits, resize->user_data );
+      if ( pool )
+      {
+        stbir_thread_pool_dispatch( stbir__split_task, &job, splits, pool );
+        stbir_thread_pool_destroy( pool );
+      }
+      else
+    #endif
+        stbir__perform_resize( job.info, 0, splits );
+    }
+
+    if ( order )
+      STBIR_FREE( order, resize->user_data );
+  }
+  else
+  {
+    stbir__perform_resize( job.info, 0, splits );
+  }
+
+  // if we alloced, then free
+  if ( !resize->called_alloc )
+    stbir_free_samplers( resize );
+
+  return 1;
+}
+
+typedef struct
+{
+  STBIR_RESIZE * workers;
+  int worker_count;
+  stbir_batch_image const * images;
+  int image_count;
+} stbir__batch_job;
+
+// each task runs an even share of the images with its own buffers
+static void stbir__batch_task( void * data, int task_index )
+{
+  stbir__batch_job const * job = (stbir__batch_job const *) data;
+  STBIR_RESIZE * worker = job->workers + task_index;
+  int i = (int) ( ( (stbir_uint64) job->image_count * (stbir_uint64) task_index ) / (stbir_uint64) job->worker_count );
+  int end = (int) ( ( (stbir_uint64) job->image_count * (stbir_uint64) ( task_index + 1 ) ) / (stbir_uint64) job->worker_count );
+
+  for( ; i < end ; i++ )
+  {
+    stbir_batch_image const * image = job->images + i;
+    stbir_set_buffer_ptrs( worker, image->input_pixels, image->input_stride_in_bytes, image->output_pixels, image->output_stride_in_bytes );
+    stbir__perform_resize( worker->samplers, 0, worker->splits );
+  }
+}
+
+STBIRDEF int stbir_resize_batch( STBIR_RESIZE * resize, stbir_batch_image const * images, int image_count, int max_threads, stbir_dispatch_callback * dispatch, void * dispatch_context )
+{
+  stbir__batch_job job;
+  STBIR_RESIZE * workers;
+  int i, built_samplers = 0;
+
+  if ( image_count <= 0 )
+    return 1;
+
+  if ( ( resize->samplers == 0 ) || ( resize->needs_rebuild ) )
+  {
+    stbir_free_samplers( resize );
+    if ( !stbir_build_samplers_with_splits( resize, 1 ) )
+      return 0;
+
+    // zero sized output, nothing to do (see stbir_resize_extended)
+    if ( resize->samplers == 0 )
+      return 1;
+    built_samplers = 1;
+  }
+  else
+  {
+    STBIR_PROFILE_BUILD_CLEAR( resize->samplers );
+  }
+
+  if ( max_threads > image_count )
+    max_threads = image_count;
+  if ( max_threads < 1 )
+    max_threads = 1;
+
+  workers = (STBIR_RESIZE *) STBIR_MALLOC( sizeof( STBIR_RESIZE ) * max_threads, resize->user_data );
+  if ( workers == 0 )
+  {
+    if ( built_samplers )
+      stbir_free_samplers( resize );
+    return 0;
+  }
+
+  // the first worker uses resize's samplers, the others build buffers around the same coefficients
+  job.workers = workers;
+  job.worker_count = 1;
+  job.images = images;
+  job.image_count = image_count;
+  workers[ 0 ] = *resize;
+  for( i = 1 ; i < max_threads ; i++ )
+  {
+    workers[ i ] = *resize;
+    workers[ i ].samplers = 0;
+    if ( !stbir__perform_build( workers + i, 1, resize->samplers, 0 ) )
+      break;
+    ++job.worker_count;
+  }
+
+  if ( job.worker_count == 1 )
+    stbir__batch_task( &job, 0 );
+  else if ( dispatch )
+    dispatch( stbir__batch_task, &job, job.worker_count, dispatch_context );
+  else
+  {
+  #ifdef STBIR_USE_THREADS
+    stbir_thread_pool * pool = stbir_thread_pool_create( job.worker_count, resize->user_data );
+    if ( pool )
+    {
+      stbir_thread_pool_dispatch( stbir__batch_task, &job, job.worker_count, pool );
+      stbir_thread_pool_destroy( pool );
+    }
+    else
+  #endif
+    {
+      for( i = 0 ; i < job.worker_count ; i++ )
+        stbir__batch_task( &job, i );
+    }
+  }
+
+  for( i = 1 ; i < job.worker_count ; i++ )
+    stbir_free_samplers( workers + i );
+  STBIR_FREE( workers, resize->user_data );
+
+  // put resize's own buffers back
+  if ( built_samplers )
+    stbir_free_samplers( resize );
+  else
+    stbir_set_buffer_ptrs( resize, resize->input_pixels, resize->input_stride_in_bytes, resize->output_pixels, resize->output_stride_in_bytes );
+
+  return 1;
+}
+
+
+
+struct stbir_sampler_cache
+{
+  void * user_data;
+  int num_entries, max_entries;
+  STBIR_RESIZE * entries;  // built with one split and no pixels - never changed once added
+#ifdef STBIR_USE_THREADS
+  stbir__mutex lock;       // held while looking up or adding entries
+#endif
+};
+
+STBIRDEF stbir_sampler_cache * stbir_sampler_cache_create( int max_entries, void * user_data )
+{
+  stbir_sampler_cache * cache;
+
+  if ( max_entries <= 0 )
+    return 0;
+
+  cache = (stbir_sampler_cache *) STBIR_MALLOC( sizeof( stbir_sampler_cache ) + sizeof( STBIR_RESIZE ) * max_entries, user_data );
+  if ( cache == 0 )
+    return 0;
+
+  cache->user_data = user_data;
+  cache->num_entries = 0;
+  cache->max_entries = max_entries;
+  cache->entries = (STBIR_RESIZE *) ( cache + 1 );
+#ifdef STBIR_USE_THREADS
+  stbir__mutex_init( &cache->lock );
+#endif
+
+  return cache;
+}
+
+STBIRDEF void stbir_sampler_cache_destroy( stbir_sampler_cache * cache )
+{
+  int i;
+
+  if ( cache == 0 )
+    return;
+
+  for( i = 0 ; i < cache->num_entries ; i++ )
+    stbir_free_samplers( cache->entries + i );
+#ifdef STBIR_USE_THREADS
+  stbir__mutex_destroy( &cache->lock );
+#endif
+  STBIR_FREE( cache, cache->user_data );
+}
+
+// everything that goes into building the samplers (but not the buffers, or datatypes beyond picking the fixed point path)
+static int stbir__same_sampler_geometry( STBIR_RESIZE const * a, STBIR_RESIZE const * b )
+{
+  return ( a->input_w == b->input_w ) && ( a->input_h == b->input_h ) && ( a->output_w == b->output_w ) && ( a->output_h == b->output_h ) &&
+         ( a->input_s0 == b->input_s0 ) && ( a->input_t0 == b->input_t0 ) && ( a->input_s1 == b->input_s1 ) && ( a->input_t1 == b->input_t1 ) &&
+         ( a->output_subx == b->output_subx ) && ( a->output_suby == b->output_suby ) && ( a->output_subw == b->output_subw ) && ( a->output_subh == b->output_subh ) &&
+         ( a->input_pixel_layout_public == b->input_pixel_layout_public ) && ( a->output_pixel_layout_public == b->output_pixel_layout_public ) && ( a->fast_alpha == b->fast_alpha ) &&
+         ( stbir__wants_fixed_point( a ) == stbir__wants_fixed_point( b ) ) &&
+         ( a->horizontal_filter == b->horizontal_filter ) && ( a->vertical_filter == b->vertical_filter ) &&
+         ( a->horizontal_edge == b->horizontal_edge ) && ( a->vertical_edge == b->vertical_edge ) &&
+         ( a->horizontal_filter_kernel == b->horizontal_filter_kernel ) && ( a->horizontal_filter_support == b->horizontal_filter_support ) &&
+         ( a->vertical_filter_kernel == b->vertical_filter_kernel ) && ( a->vertical_filter_support == b->vertical_filter_support );
+}
+
+STBIRDEF int stbir_build_samplers_from_cache( STBIR_RESIZE * resize, stbir_sampler_cache * cache, int splits )
+{
+  STBIR_RESIZE * entry = 0;
+  int i;
+
+  if ( ( resize->samplers ) && ( !resize->needs_rebuild ) )
+  {
+    STBIR_PROFILE_BUILD_CLEAR( resize->samplers );
+    return 1;
+  }
+
+  if ( resize->samplers )
+    stbir_free_samplers( resize );
+
+#ifdef STBIR_USE_THREADS
+  stbir__mutex_lock( &cache->lock );
+#endif
+
+  for( i = 0 ; i < cache->num_entries ; i++ )
+  {
+    if ( stbir__same_sampler_geometry( cache->entries + i, resize ) )
+    {
+      entry = cache->entries + i;
+      break;
+    }
+  }
+
+  if ( ( entry == 0 ) && ( cache->num_entries < cache->max_entries ) )
+  {
+    // new geometry - the cache gets its own copy, with no buffers and only one split
+    entry = cache->entries + cache->num_entries;
+    STBIR_MEMCPY( entry, resize, sizeof( STBIR_RESIZE ) );
+    entry->input_pixels = 0;
+    entry->output_pixels = 0;
+    entry->input_cb = 0;
+    entry->output_cb = 0;
+    entry->user_data = cache->user_data;
+    entry->samplers = 0;
+    entry->called_alloc = 1;
+
+    if ( stbir__perform_build( entry, 1, 0, 0 ) )
+      ++cache->num_entries;
+    else
+      entry = 0;
+  }
+
+#ifdef STBIR_USE_THREADS
+  stbir__mutex_unlock( &cache->lock );
+#endif
+
+  // entries are read-only once added, so we can build from them without the lock
+  resize->called_alloc = 1;
+  return stbir__perform_build( resize, splits, ( entry ) ? entry->samplers : 0, 0 );
+}
+
+
+static void * stbir_quick_resize_helper( const void *input_pixels , int input_w , int input_h, int input_stride_in_bytes,
+                                               void *output_pixels, int output_w, int output_h, int output_stride_in_bytes,
+                                               stbir_pixel_layout pixel_layout, stbir_datatype data_type, stbir_edge edge, stbir_filter filter )
 {
   STBIR_RESIZE resize;
   int scanline_output_in_bytes;
@@ -8036,100 +10034,856 @@ static void * stbir_quick_resize_helper( const void *input_pixels , int input_w
   if ( positive_output_stride_in_bytes < 0 )
     positive_output_stride_in_bytes = -positive_output_stride_in_bytes;
 
-  // is the requested stride smaller than the scanline output? if so, just fail
-  if ( positive_output_stride_in_bytes < scanline_output_in_bytes )
-    return 0;
+  // is the requested stride smaller than the scanline output? if so, just fail
+  if ( positive_output_stride_in_bytes < scanline_output_in_bytes )
+    return 0;
+
+  start_ptr = output_pixels;
+  free_ptr = 0;  // no free pointer, since they passed buffer to use
+
+  // did they pass a zero for the dest? if so, allocate the buffer
+  if ( output_pixels == 0 )
+  {
+    size_t size;
+    char * ptr;
+  
+    size = (size_t)positive_output_stride_in_bytes * (size_t)output_h;
+    if ( size == 0 )
+      return 0;
+
+    ptr = (char*) STBIR_MALLOC( size, 0 );
+    if ( ptr == 0 )
+      return 0;
+
+    free_ptr = ptr;
+
+    // point at the last scanline, if they requested a flipped image
+    if ( output_stride_in_bytes < 0 )
+      start_ptr = ptr + ( (size_t)positive_output_stride_in_bytes * (size_t)( output_h - 1 ) );
+    else
+      start_ptr = ptr;
+  }
+
+  // ok, now do the resize
+  stbir_resize_init( &resize,
+                     input_pixels,  input_w,  input_h,  input_stride_in_bytes,
+                     start_ptr, output_w, output_h, output_stride_in_bytes,
+                     pixel_layout, data_type );
+
+  resize.horizontal_edge = edge;
+  resize.vertical_edge = edge;
+  resize.horizontal_filter = filter;
+  resize.vertical_filter = filter;
+
+  if ( !stbir_resize_extended( &resize ) )
+  {
+    if ( free_ptr )
+      STBIR_FREE( free_ptr, 0 );
+    return 0;
+  }
+
+  return (free_ptr) ? free_ptr : start_ptr;
+}
+
+
+
+STBIRDEF unsigned char * stbir_resize_uint8_linear( const unsigned char *input_pixels , int input_w , int input_h, int input_stride_in_bytes,
+                                                          unsigned char *output_pixels, int output_w, int output_h, int output_stride_in_bytes,
+                                                          stbir_pixel_layout pixel_layout )
+{
+  return (unsigned char *) stbir_quick_resize_helper( input_pixels , input_w , input_h, input_stride_in_bytes, 
+                                                      output_pixels, output_w, output_h, output_stride_in_bytes, 
+                                                      pixel_layout, STBIR_TYPE_UINT8, STBIR_EDGE_CLAMP, STBIR_FILTER_DEFAULT );
+}
+
+STBIRDEF unsigned char * stbir_resize_uint8_srgb( const unsigned char *input_pixels , int input_w , int input_h, int input_stride_in_bytes,
+                                                        unsigned char *output_pixels, int output_w, int output_h, int output_stride_in_bytes,
+                                                        stbir_pixel_layout pixel_layout )
+{
+  return (unsigned char *) stbir_quick_resize_helper( input_pixels , input_w , input_h, input_stride_in_bytes, 
+                                                      output_pixels, output_w, output_h, output_stride_in_bytes, 
+                                                      pixel_layout, STBIR_TYPE_UINT8_SRGB, STBIR_EDGE_CLAMP, STBIR_FILTER_DEFAULT );
+}
+
+
+STBIRDEF float * stbir_resize_float_linear( const float *input_pixels , int input_w , int input_h, int input_stride_in_bytes,
+                                                  float *output_pixels, int output_w, int output_h, int output_stride_in_bytes,
+                                                  stbir_pixel_layout pixel_layout )
+{
+  return (float *) stbir_quick_resize_helper( input_pixels , input_w , input_h, input_stride_in_bytes, 
+                                              output_pixels, output_w, output_h, output_stride_in_bytes, 
+                                              pixel_layout, STBIR_TYPE_FLOAT, STBIR_EDGE_CLAMP, STBIR_FILTER_DEFAULT  );
+}
+
+
+STBIRDEF void * stbir_resize( const void *input_pixels , int input_w , int input_h, int input_stride_in_bytes,
+                                    void *output_pixels, int output_w, int output_h, int output_stride_in_bytes,
+                                    stbir_pixel_layout pixel_layout, stbir_datatype data_type,
+                                    stbir_edge edge, stbir_filter filter )
+{
+  return (void *) stbir_quick_resize_helper( input_pixels , input_w , input_h, input_stride_in_bytes, 
+                                             output_pixels, output_w, output_h, output_stride_in_bytes, 
+                                             pixel_layout, data_type, edge, filter  );
+}
+
+
+STBIRDEF void stbir_free_mipmaps( STBIR_MIPMAPS * mips )
+{
+  if ( mips->resizes )
+  {
+    int i, count = ( mips->data_type == STBIR_TYPE_FLOAT ) ? mips->levels : mips->levels * 2;
+    for( i = 0 ; i < count ; i++ )
+      stbir_free_samplers( mips->resizes + i );
+    STBIR_FREE( mips->resizes, mips->user_data );
+    mips->resizes = 0;
+  }
+  mips->levels = 0;
+}
+
+STBIRDEF int stbir_build_mipmaps( STBIR_MIPMAPS * mips, int input_w, int input_h, int num_levels,
+                                  stbir_pixel_layout pixel_layout, stbir_datatype data_type,
+                                  stbir_edge edge, stbir_filter filter, void * user_data )
+{
+  stbir_internal_pixel_layout internal_layout;
+  stbir_pixel_layout float_layout;
+  size_t level_bytes[2];
+  float * work[2];
+  int max_levels, count, direct, i;
+
+  mips->user_data = user_data;
+  mips->input_w = input_w;
+  mips->input_h = input_h;
+  mips->levels = 0;
+  mips->pixel_layout = pixel_layout;
+  mips->data_type = data_type;
+  mips->resizes = 0;
+
+  if ( ( input_w <= 0 ) || ( input_h <= 0 ) || ( (unsigned)pixel_layout >= STBIR__ARRAY_SIZE( stbir__pixel_layout_convert_public_to_internal ) ) )
+    return 0;
+
+  max_levels = 0;
+  while( ( ( input_w >> max_levels ) > 1 ) || ( ( input_h >> max_levels ) > 1 ) )
+    ++max_levels;
+  if ( ( num_levels <= 0 ) || ( num_levels > max_levels ) )
+    num_levels = max_levels;
+  if ( num_levels == 0 )
+    return 1;
+
+  // float levels are resized from each other in place, everything else goes through
+  //   two linear float buffers (odd levels in the first, even in the second)
+  direct = ( data_type == STBIR_TYPE_FLOAT );
+  count = ( direct ) ? num_levels : num_levels * 2;
+
+  // keep the float copies premultiplied, so only the first resize weights the alpha
+  //   and only the encodes unweight it
+  internal_layout = stbir__pixel_layout_convert_public_to_internal[ pixel_layout ];
+  float_layout = pixel_layout;
+  if ( ( internal_layout >= STBIRI_RGBA ) && ( internal_layout <= STBIRI_AR ) )
+    float_layout = (stbir_pixel_layout) ( internal_layout + ( STBIRI_RGBA_PM - STBIRI_RGBA ) );
+
+  level_bytes[0] = level_bytes[1] = 0;
+  if ( !direct )
+  {
+    for( i = 0 ; i < 2 ; i++ )
+    {
+      int w = input_w >> ( i + 1 ), h = input_h >> ( i + 1 );
+      level_bytes[i] = (size_t) ( ( w ) ? w : 1 ) * (size_t) ( ( h ) ? h : 1 ) * stbir__pixel_channels[ internal_layout ] * sizeof( float );
+    }
+  }
+
+  mips->resizes = (STBIR_RESIZE *) STBIR_MALLOC( sizeof( STBIR_RESIZE ) * count + level_bytes[0] + level_bytes[1], user_data );
+  if ( mips->resizes == 0 )
+    return 0;
+  for( i = 0 ; i < count ; i++ )
+    mips->resizes[i].samplers = 0;
+  mips->levels = num_levels;
+
+  work[0] = (float *) ( mips->resizes + count );
+  work[1] = (float *) ( ( (char *) work[0] ) + level_bytes[0] );
+
+  for( i = 1 ; i <= num_levels ; i++ )
+  {
+    STBIR_RESIZE * resize = mips->resizes + ( i - 1 );
+    int pw = input_w >> ( i - 1 ), ph = input_h >> ( i - 1 );
+    int w = input_w >> i, h = input_h >> i;
+    if ( pw == 0 ) pw = 1;
+    if ( ph == 0 ) ph = 1;
+    if ( w == 0 ) w = 1;
+    if ( h == 0 ) h = 1;
+
+    // pixel pointers are filled in on each stbir_resize_mipmaps_extended call
+    stbir_resize_init( resize, 0, pw, ph, 0, 0, w, h, 0, pixel_layout, data_type );
+    if ( !direct )
+    {
+      stbir_set_datatypes( resize, ( i == 1 ) ? data_type : STBIR_TYPE_FLOAT, STBIR_TYPE_FLOAT );
+      stbir_set_pixel_layouts( resize, ( i == 1 ) ? pixel_layout : float_layout, float_layout );
+      stbir_set_buffer_ptrs( resize, ( i == 1 ) ? 0 : work[ i & 1 ], 0, work[ ( i - 1 ) & 1 ], 0 );
+    }
+    stbir_set_edgemodes( resize, edge, edge );
+    stbir_set_filters( resize, filter, filter );
+    resize->user_data = user_data;
+    if ( !stbir_build_samplers( resize ) )
+    {
+      stbir_free_mipmaps( mips );
+      return 0;
+    }
+
+    if ( !direct )
+    {
+      // 1:1 box filtered copy of the float level into your datatype (box, rather
+      //   than point sampling, since point sampling skips the alpha unweighting)
+      resize = mips->resizes + num_levels + ( i - 1 );
+      stbir_resize_init( resize, work[ ( i - 1 ) & 1 ], w, h, 0, 0, w, h, 0, float_layout, STBIR_TYPE_FLOAT );
+      stbir_set_datatypes( resize, STBIR_TYPE_FLOAT, data_type );
+      stbir_set_pixel_layouts( resize, float_layout, pixel_layout );
+      stbir_set_filters( resize, STBIR_FILTER_BOX, STBIR_FILTER_BOX );
+      resize->user_data = user_data;
+      if ( !stbir_build_samplers( resize ) )
+      {
+        stbir_free_mipmaps( mips );
+        return 0;
+      }
+    }
+  }
+
+  return 1;
+}
+
+STBIRDEF int stbir_resize_mipmaps_extended( STBIR_MIPMAPS * mips, const void * input_pixels, int input_stride_in_bytes,
+                                            void * const * level_pixels, int const * level_strides )
+{
+  int i;
+
+  for( i = 0 ; i < mips->levels ; i++ )
+  {
+    STBIR_RESIZE * resize = mips->resizes + i;
+    int stride = ( level_strides ) ? level_strides[ i ] : 0;
+
+    if ( mips->data_type == STBIR_TYPE_FLOAT )
+    {
+      // each level reads the level you just got back
+      if ( i == 0 )
+        stbir_set_buffer_ptrs( resize, input_pixels, input_stride_in_bytes, level_pixels[ 0 ], stride );
+      else
+        stbir_set_buffer_ptrs( resize, level_pixels[ i - 1 ], ( level_strides ) ? level_strides[ i - 1 ] : 0, level_pixels[ i ], stride );
+      if ( !stbir_resize_extended( resize ) )
+        return 0;
+    }
+    else
+    {
+      STBIR_RESIZE * encode = mips->resizes + mips->levels + i;
+      if ( i == 0 )
+        stbir_set_buffer_ptrs( resize, input_pixels, input_stride_in_bytes, resize->output_pixels, 0 );
+      if ( !stbir_resize_extended( resize ) )
+        return 0;
+      stbir_set_buffer_ptrs( encode, encode->input_pixels, 0, level_pixels[ i ], stride );
+      if ( !stbir_resize_extended( encode ) )
+        return 0;
+    }
+  }
+
+  return 1;
+}
+
+STBIRDEF int stbir_resize_mipmaps( const void * input_pixels, int input_w, int input_h, int input_stride_in_bytes,
+                                   void * const * level_pixels, int const * level_strides, int num_levels,
+                                   stbir_pixel_layout pixel_layout, stbir_datatype data_type,
+                                   stbir_edge edge, stbir_filter filter )
+{
+  STBIR_MIPMAPS mips;
+  int result;
+
+  if ( !stbir_build_mipmaps( &mips, input_w, input_h, num_levels, pixel_layout, data_type, edge, filter, 0 ) )
+    return 0;
+
+  result = stbir_resize_mipmaps_extended( &mips, input_pixels, input_stride_in_bytes, level_pixels, level_strides ) ? mips.levels : 0;
+  stbir_free_mipmaps( &mips );
+  return result;
+}
+
+// phases of the sub-pixel position that the warp gather weights are tabled at
+#define STBIR__WARP_PHASES 256
+
+// output pixels per side of the tiles the warp gathers in
+#define STBIR__WARP_TILE 32
+
+// maps the taps of one axis into the decoded box, and zeros the weights of taps that are
+//   off the input with the zero edge mode (those just read a valid pixel with no weight)
+static void stbir__warp_taps( int * index, float * weights, float const * phase_weights, int first, int taps, int size, int box0, int box_size, stbir_edge edge )
+{
+  int i;
+  for( i = 0 ; i < taps ; i++ )
+  {
+    int n = first + i;
+    weights[ i ] = phase_weights[ i ];
+    if ( ( n < 0 ) || ( n >= size ) )
+    {
+      if ( edge == STBIR_EDGE_ZERO )
+      {
+        weights[ i ] = 0.0f;
+        n = box0;
+      }
+      else
+        n = stbir__edge_wrap_slow[ edge ]( n, size );
+    }
+    n -= box0;
+    // the box has a margin for rounding, but never read outside it
+    if ( n < 0 ) n = 0;
+    if ( n >= box_size ) n = box_size - 1;
+    index[ i ] = n;
+  }
+}
+
+stbir__inline static void stbir__warp_gather( float * out, char const * box, ptrdiff_t box_stride, int channels, int taps, int const * xs, int const * ys, float const * wx, float const * wy )
+{
+  int i, j, c;
+
+  #ifdef STBIR_SIMD
+  if ( channels == 4 )
+  {
+    stbir__simdf tot, row, p, w;
+    stbir__simdf_zero( tot );
+    for( j = 0 ; j < taps ; j++ )
+    {
+      float const * src = (float const *) ( box + (ptrdiff_t) ys[ j ] * box_stride );
+      stbir__simdf_zero( row );
+      for( i = 0 ; i < taps ; i++ )
+      {
+        stbir__simdf_load( p, src + xs[ i ] * 4 );
+        stbir__simdf_load1frep4( w, wx[ i ] );
+        stbir__simdf_madd( row, row, p, w );
+      }
+      stbir__simdf_load1frep4( w, wy[ j ] );
+      stbir__simdf_madd( tot, tot, row, w );
+    }
+    stbir__simdf_store( out, tot );
+    return;
+  }
+  #endif
+
+  for( c = 0 ; c < channels ; c++ )
+    out[ c ] = 0.0f;
+  for( j = 0 ; j < taps ; j++ )
+  {
+    float const * src = (float const *) ( box + (ptrdiff_t) ys[ j ] * box_stride );
+    float row[ 4 ] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for( i = 0 ; i < taps ; i++ )
+      for( c = 0 ; c < channels ; c++ )
+        row[ c ] += src[ xs[ i ] * channels + c ] * wx[ i ];
+    for( c = 0 ; c < channels ; c++ )
+      out[ c ] += row[ c ] * wy[ j ];
+  }
+}
+
+// the input pixels that the output can touch, in one axis (from the input coordinates of
+//   the output corners), with a margin for the taps and for rounding
+static void stbir__warp_box( int * box0, int * box1, float const * coords, int size, stbir_edge edge )
+{
+  float lo = coords[ 0 ], hi = coords[ 0 ];
+  int i;
+
+  for( i = 1 ; i < 4 ; i++ )
+  {
+    if ( coords[ i ] < lo ) lo = coords[ i ];
+    if ( coords[ i ] > hi ) hi = coords[ i ];
+  }
+  if ( lo < -16777216.0f ) lo = -16777216.0f;
+  if ( hi > 16777216.0f ) hi = 16777216.0f;
+
+  *box0 = (int) STBIR_FLOORF( lo ) - 3;
+  *box1 = (int) STBIR_FLOORF( hi ) + 4;
+
+  // wrap and reflect can land anywhere, once we're off the edge
+  if ( ( ( *box0 < 0 ) || ( *box1 > size ) ) && ( ( edge == STBIR_EDGE_WRAP ) || ( edge == STBIR_EDGE_REFLECT ) ) )
+  {
+    *box0 = 0;
+    *box1 = size;
+    return;
+  }
+
+  if ( *box0 < 0 ) *box0 = 0;
+  if ( *box0 > size - 1 ) *box0 = size - 1;
+  if ( *box1 > size ) *box1 = size;
+  if ( *box1 < *box0 + 1 ) *box1 = *box0 + 1;
+}
+
+STBIRDEF int stbir_warp_affine( const void *input_pixels, int input_w, int input_h, int input_stride_in_bytes,
+                                void *output_pixels, int output_w, int output_h, int output_stride_in_bytes,
+                                stbir_pixel_layout pixel_layout, stbir_datatype data_type,
+                                stbir_edge edge, stbir_filter filter, float const matrix[6] )
+{
+  STBIR_RESIZE resize;
+  stbir_internal_pixel_layout internal_layout;
+  stbir_pixel_layout float_layout;
+  stbir__kernel_callback * kernel;
+  float coords[ 2 ][ 4 ];
+  float * phase_weights;
+  char const * box;
+  char * out;
+  char * mem;
+  ptrdiff_t box_stride, out_stride;
+  int channels, direct, taps, first, box_x0, box_x1, box_y0, box_y1, box_w, box_h, tile_x, tile_y, x, y, i;
+  int ok = 1;
+
+  if ( ( input_w <= 0 ) || ( input_h <= 0 ) || ( output_w <= 0 ) || ( output_h <= 0 ) ||
+       ( (unsigned)pixel_layout >= STBIR__ARRAY_SIZE( stbir__pixel_layout_convert_public_to_internal ) ) ||
+       ( (unsigned)data_type >= STBIR__ARRAY_SIZE( stbir__type_size ) ) ||
+       ( (unsigned)edge > STBIR_EDGE_ZERO ) || ( (unsigned)filter >= STBIR_FILTER_OTHER ) )
+    return 0;
+
+  // also catches NaNs
+  for( i = 0 ; i < 6 ; i++ )
+    if ( !( ( matrix[ i ] > -1e30f ) && ( matrix[ i ] < 1e30f ) ) )
+      return 0;
+
+  // just a scale and an offset, inside the input? then it's a normal resize of a subrect
+  //   (subrects hanging off the input go through the gather, which does the edges per tap)
+  if ( ( matrix[ 1 ] == 0.0f ) && ( matrix[ 3 ] == 0.0f ) && ( matrix[ 0 ] > 0.0f ) && ( matrix[ 4 ] > 0.0f ) )
+  {
+    double s0 = (double) matrix[ 2 ] / input_w, s1 = ( (double) matrix[ 0 ] * output_w + matrix[ 2 ] ) / input_w;
+    double t0 = (double) matrix[ 5 ] / input_h, t1 = ( (double) matrix[ 4 ] * output_h + matrix[ 5 ] ) / input_h;
+    if ( ( s0 >= 0.0 ) && ( t0 >= 0.0 ) && ( s1 <= 1.0 ) && ( t1 <= 1.0 ) )
+    {
+      stbir_resize_init( &resize, input_pixels, input_w, input_h, input_stride_in_bytes, output_pixels, output_w, output_h, output_stride_in_bytes, pixel_layout, data_type );
+      stbir_set_edgemodes( &resize, edge, edge );
+      stbir_set_filters( &resize, filter, filter );
+      if ( stbir_set_input_subrect( &resize, s0, t0, s1, t1 ) )
+        return stbir_resize_extended( &resize );
+    }
+  }
+
+  if ( filter == STBIR_FILTER_DEFAULT )
+    filter = STBIR_DEFAULT_FILTER_UPSAMPLE;
+  if ( filter == STBIR_FILTER_POINT_SAMPLE )
+    taps = 1;
+  else if ( ( filter == STBIR_FILTER_BOX ) || ( filter == STBIR_FILTER_TRIANGLE ) )
+    taps = 2;
+  else
+    taps = 4;
+  kernel = ( taps == 2 ) ? stbir__filter_triangle : stbir__builtin_kernels[ filter ];
+  first = ( taps == 4 ) ? 1 : 0;  // how far left of the position the taps start
+
+  // same float layout as the mipmaps - premultiplied, so only the decode weights the alpha
+  //   and only the encode unweights it
+  internal_layout = stbir__pixel_layout_convert_public_to_internal[ pixel_layout ];
+  channels = stbir__pixel_channels[ internal_layout ];
+  float_layout = pixel_layout;
+  if ( ( internal_layout >= STBIRI_RGBA ) && ( internal_layout <= STBIRI_AR ) )
+    float_layout = (stbir_pixel_layout) ( internal_layout + ( STBIRI_RGBA_PM - STBIRI_RGBA ) );
+  direct = ( data_type == STBIR_TYPE_FLOAT ) && ( float_layout == pixel_layout );
+
+  if ( input_stride_in_bytes == 0 )
+    input_stride_in_bytes = input_w * channels * stbir__type_size[ data_type ];
+  if ( output_stride_in_bytes == 0 )
+    output_stride_in_bytes = output_w * channels * stbir__type_size[ data_type ];
+
+  // input coordinates of the corner output pixel centers (minus a half, so whole numbers
+  //   are pixel centers from here on)
+  for( i = 0 ; i < 4 ; i++ )
+  {
+    float ox = ( i & 1 ) ? ( (float) output_w - 0.5f ) : 0.5f;
+    float oy = ( i & 2 ) ? ( (float) output_h - 0.5f ) : 0.5f;
+    coords[ 0 ][ i ] = matrix[ 0 ] * ox + matrix[ 1 ] * oy + matrix[ 2 ] - 0.5f;
+    coords[ 1 ][ i ] = matrix[ 3 ] * ox + matrix[ 4 ] * oy + matrix[ 5 ] - 0.5f;
+  }
+  stbir__warp_box( &box_x0, &box_x1, coords[ 0 ], input_w, edge );
+  stbir__warp_box( &box_y0, &box_y1, coords[ 1 ], input_h, edge );
+  box_w = box_x1 - box_x0;
+  box_h = box_y1 - box_y0;
+
+  box_stride = (ptrdiff_t) box_w * channels * sizeof( float );
+  out_stride = (ptrdiff_t) output_w * channels * sizeof( float );
+  mem = (char *) STBIR_MALLOC( ( STBIR__WARP_PHASES + 1 ) * 4 * sizeof( float ) + ( ( direct ) ? 0 : (size_t) box_stride * box_h + (size_t) out_stride * output_h ), 0 );
+  if ( mem == 0 )
+    return 0;
+  phase_weights = (float *) mem;
+
+  if ( direct )
+  {
+    box = ( (char const *) input_pixels ) + (ptrdiff_t) box_y0 * input_stride_in_bytes + (ptrdiff_t) box_x0 * channels * sizeof( float );
+    box_stride = input_stride_in_bytes;
+    out = (char *) output_pixels;
+    out_stride = output_stride_in_bytes;
+  }
+  else
+  {
+    char * decoded = mem + ( STBIR__WARP_PHASES + 1 ) * 4 * sizeof( float );
+    box = decoded;
+    out = decoded + box_stride * box_h;
+
+    // 1:1 box filtered decode of just the part we need (see stbir_build_mipmaps for why box)
+    stbir_resize_init( &resize, ( (char const *) input_pixels ) + (ptrdiff_t) box_y0 * input_stride_in_bytes + (ptrdiff_t) box_x0 * channels * stbir__type_size[ data_type ],
+                       box_w, box_h, input_stride_in_bytes, decoded, box_w, box_h, 0, pixel_layout, data_type );
+    stbir_set_datatypes( &resize, data_type, STBIR_TYPE_FLOAT );
+    stbir_set_pixel_layouts( &resize, pixel_layout, float_layout );
+    stbir_set_filters( &resize, STBIR_FILTER_BOX, STBIR_FILTER_BOX );
+    if ( !stbir_resize_extended( &resize ) )
+    {
+      STBIR_FREE( mem, 0 );
+      return 0;
+    }
+  }
+
+  // the tap weights at each sub-pixel phase (normalized, so the sums are exactly one)
+  for( i = 0 ; i <= STBIR__WARP_PHASES ; i++ )
+  {
+    float frac = (float) i / (float) STBIR__WARP_PHASES;
+    float * w = phase_weights + i * 4;
+    float total = 0.0f;
+    int t;
+
+    if ( taps == 1 )
+    {
+      w[ 0 ] = 1.0f;
+      continue;
+    }
+    for( t = 0 ; t < taps ; t++ )
+    {
+      w[ t ] = kernel( (float) ( t - first ) - frac, 1.0f, 0 );
+      total += w[ t ];
+    }
+    for( t = 0 ; t < taps ; t++ )
+      w[ t ] /= total;
+  }
+
+  // walk the output in tiles, so rotated footprints stay in the cache (going along a whole
+  //   output row steps across a new input row every pixel or two)
+  for( tile_y = 0 ; tile_y < output_h ; tile_y += STBIR__WARP_TILE )
+  {
+    for( tile_x = 0 ; tile_x < output_w ; tile_x += STBIR__WARP_TILE )
+    {
+      int end_y = ( tile_y + STBIR__WARP_TILE < output_h ) ? tile_y + STBIR__WARP_TILE : output_h;
+      int end_x = ( tile_x + STBIR__WARP_TILE < output_w ) ? tile_x + STBIR__WARP_TILE : output_w;
+
+      for( y = tile_y ; y < end_y ; y++ )
+      {
+        float * dest = (float *) ( out + (ptrdiff_t) y * out_stride );
+        float row_x = matrix[ 1 ] * ( (float) y + 0.5f ) + matrix[ 2 ] - 0.5f;
+        float row_y = matrix[ 4 ] * ( (float) y + 0.5f ) + matrix[ 5 ] - 0.5f;
+
+        for( x = tile_x ; x < end_x ; x++ )
+        {
+          int xs[ 4 ], ys[ 4 ];
+          float wx[ 4 ], wy[ 4 ];
+          float fx = matrix[ 0 ] * ( (float) x + 0.5f ) + row_x;
+          float fy = matrix[ 3 ] * ( (float) x + 0.5f ) + row_y;
+          float flx, fly;
+          int phase_x, phase_y, tap_x, tap_y;
+
+          if ( fx < -16777216.0f ) fx = -16777216.0f;
+          if ( fx > 16777216.0f ) fx = 16777216.0f;
+          if ( fy < -16777216.0f ) fy = -16777216.0f;
+          if ( fy > 16777216.0f ) fy = 16777216.0f;
+
+          // nearest rounds to the closest pixel center
+          if ( taps == 1 )
+          {
+            fx += 0.5f;
+            fy += 0.5f;
+          }
+          flx = STBIR_FLOORF( fx );
+          fly = STBIR_FLOORF( fy );
+          phase_x = (int) ( ( fx - flx ) * STBIR__WARP_PHASES + 0.5f );
+          phase_y = (int) ( ( fy - fly ) * STBIR__WARP_PHASES + 0.5f );
+
+          tap_x = (int) flx - first - box_x0;
+          tap_y = (int) fly - first - box_y0;
+
+          // all of the taps in the box (which is always inside the input)? then there's no edge handling
+          //   (compared signed, since a box smaller than the footprint makes box_w - taps negative)
+          if ( ( tap_x >= 0 ) && ( tap_x <= box_w - taps ) && ( tap_y >= 0 ) && ( tap_y <= box_h - taps ) )
+          {
+            for( i = 0 ; i < taps ; i++ )
+            {
+              xs[ i ] = tap_x + i;
+              ys[ i ] = tap_y + i;
+            }
+            // constant tap counts, so each of these unrolls
+            if ( taps == 1 )
+              stbir__warp_gather( dest + x * channels, box, box_stride, channels, 1, xs, ys, phase_weights, phase_weights );
+            else if ( taps == 2 )
+              stbir__warp_gather( dest + x * channels, box, box_stride, channels, 2, xs, ys, phase_weights + phase_x * 4, phase_weights + phase_y * 4 );
+            else
+              stbir__warp_gather( dest + x * channels, box, box_stride, channels, 4, xs, ys, phase_weights + phase_x * 4, phase_weights + phase_y * 4 );
+          }
+          else
+          {
+            stbir__warp_taps( xs, wx, phase_weights + phase_x * 4, tap_x + box_x0, taps, input_w, box_x0, box_w, edge );
+            stbir__warp_taps( ys, wy, phase_weights + phase_y * 4, tap_y + box_y0, taps, input_h, box_y0, box_h, edge );
+            stbir__warp_gather( dest + x * channels, box, box_stride, channels, taps, xs, ys, wx, wy );
+          }
+        }
+      }
+    }
+  }
+
+  if ( !direct )
+  {
+    // 1:1 box filtered encode back to your datatype and layout
+    stbir_resize_init( &resize, out, output_w, output_h, 0, output_pixels, output_w, output_h, output_stride_in_bytes, float_layout, STBIR_TYPE_FLOAT );
+    stbir_set_datatypes( &resize, STBIR_TYPE_FLOAT, data_type );
+    stbir_set_pixel_layouts( &resize, float_layout, pixel_layout );
+    stbir_set_filters( &resize, STBIR_FILTER_BOX, STBIR_FILTER_BOX );
+    ok = stbir_resize_extended( &resize );
+  }
+
+  STBIR_FREE( mem, 0 );
+  return ok;
+}
+
+// the calibration times with the profiler's tick counter, if there is one for this platform
+#ifdef STBIR__HAS_PROFILE_FUNC
+#define STBIR__CALIBRATION_TICKS() ( (double) STBIR_PROFILE_FUNC() )
+#else
+#include <time.h>
+#define STBIR__CALIBRATION_TICKS() ( (double) clock() )
+#endif
+
+// the saved calibration is only valid for the same simd (the costs are very different)
+#if defined(STBIR_AVX512)
+#define STBIR__CALIBRATION_SIMD 5
+#elif defined(STBIR_AVX2)
+#define STBIR__CALIBRATION_SIMD 4
+#elif defined(STBIR_AVX)
+#define STBIR__CALIBRATION_SIMD 3
+#elif defined(STBIR_SSE2)
+#define STBIR__CALIBRATION_SIMD 2
+#elif defined(STBIR_NEON)
+#define STBIR__CALIBRATION_SIMD 6
+#elif defined(STBIR_WASM)
+#define STBIR__CALIBRATION_SIMD 7
+#else
+#define STBIR__CALIBRATION_SIMD 1
+#endif
+
+// "SRVF", version, simd, the table dimensions, then the vote and count (little endian) of every entry
+#define STBIR__CALIBRATION_VERSION 1
+#define STBIR__CALIBRATION_HEADER_SIZE 8
+#define STBIR__CALIBRATION_SIZE ( STBIR__CALIBRATION_HEADER_SIZE + 5 * STBIR_RESIZE_CLASSIFICATIONS * STBIR__V_FIRST_CALIBRATION_BUCKETS * 8 )
+
+static double stbir__time_resize( STBIR_RESIZE * resize, int repeats )
+{
+  double best = 0.0;
+  int i;
+
+  // the first run is just to warm up the caches
+  for( i = 0 ; i <= repeats ; i++ )
+  {
+    double t = STBIR__CALIBRATION_TICKS();
+    if ( !stbir_resize_extended( resize ) )
+      return 0.0;
+    t = STBIR__CALIBRATION_TICKS() - t;
+    if ( ( i == 1 ) || ( t < best ) )
+      best = t;
+  }
+
+  return best;
+}
+
+STBIRDEF int stbir_calibrate_vertical_first( STBIR_RESIZE * resize, int repeats )
+{
+  STBIR__V_FIRST_INFO v_info;
+  stbir__vertical_first_calibration_entry * entry;
+  double times[2];
+  float vote;
+  int uint8_fixed_point = resize->uint8_fixed_point;
+  int called_alloc = resize->called_alloc;  // the caller's samplers get rebuilt at the end
+  int splits = resize->splits;
+  int order, channel_index = 0, result = 0;
+
+  if ( repeats < 1 )
+    repeats = 1;
+
+  stbir_free_samplers( resize );
+
+  // the fixed point path ignores the order, so calibrate the float path it falls back to
+  resize->uint8_fixed_point = 0;
+
+  for( order = 0 ; order < 2 ; order++ )
+  {
+    v_info.control_v_first = order + 1; // 1 = horizontal first, 2 = vertical first
+    times[ order ] = 0.0;
+    if ( stbir__perform_build( resize, 1, 0, &v_info ) )
+    {
+      resize->called_alloc = 1; // keep the samplers between the timed resizes
+      channel_index = stbir__channel_count_index[ resize->samplers->effective_channels ];
+      times[ order ] = stbir__time_resize( resize, repeats );
+    }
+    stbir_free_samplers( resize );
+  }
+
+  resize->uint8_fixed_point = uint8_fixed_point;
+
+  // couldn't build or too fast to time?
+  if ( ( times[ 0 ] > 0.0 ) && ( times[ 1 ] > 0.0 ) )
+  {
+    vote = (float) ( ( times[ 0 ] - times[ 1 ] ) / ( times[ 0 ] + times[ 1 ] ) );
+    entry = &stbir__vertical_first_calibration[ channel_index ][ v_info.v_resize_classification ][ stbir__vertical_first_calibration_bucket( &v_info ) ];
+    entry->vote += vote;
+    ++entry->count;
+
+    if ( ( vote <= STBIR__V_FIRST_CALIBRATION_NOISE ) && ( vote >= -STBIR__V_FIRST_CALIBRATION_NOISE ) )
+      result = 3;
+    else
+      result = ( vote > 0.0f ) ? 2 : 1;
+  }
+
+  // put the caller's samplers back (they'll use the new calibration)
+  if ( called_alloc )
+    stbir_build_samplers_with_splits( resize, splits );
+  resize->called_alloc = called_alloc;
+
+  return result;
+}
+
+STBIRDEF void stbir_reset_vertical_first_calibration( void )
+{
+  stbir__vertical_first_calibration_entry * entry = stbir__vertical_first_calibration[0][0];
+  int i;
+
+  for( i = 0 ; i < 5 * STBIR_RESIZE_CLASSIFICATIONS * STBIR__V_FIRST_CALIBRATION_BUCKETS ; i++ )
+  {
+    entry[ i ].vote = 0.0f;
+    entry[ i ].count = 0;
+  }
+}
+
+static void stbir__put_uint32( unsigned char * out, stbir_uint32 v )
+{
+  out[0] = (unsigned char) v;
+  out[1] = (unsigned char) ( v >> 8 );
+  out[2] = (unsigned char) ( v >> 16 );
+  out[3] = (unsigned char) ( v >> 24 );
+}
+
+static stbir_uint32 stbir__get_uint32( unsigned char const * in )
+{
+  return ( (stbir_uint32) in[0] ) | ( ( (stbir_uint32) in[1] ) << 8 ) | ( ( (stbir_uint32) in[2] ) << 16 ) | ( ( (stbir_uint32) in[3] ) << 24 );
+}
+
+STBIRDEF int stbir_get_vertical_first_calibration( void * buffer, int buffer_size )
+{
+  stbir__vertical_first_calibration_entry const * entry = stbir__vertical_first_calibration[0][0];
+  unsigned char * out = (unsigned char *) buffer;
+  int i;
+
+  if ( ( out == 0 ) || ( buffer_size < STBIR__CALIBRATION_SIZE ) )
+    return STBIR__CALIBRATION_SIZE;
 
-  start_ptr = output_pixels;
-  free_ptr = 0;  // no free pointer, since they passed buffer to use
+  out[0] = 'S'; out[1] = 'R'; out[2] = 'V'; out[3] = 'F';
+  out[4] = STBIR__CALIBRATION_VERSION;
+  out[5] = STBIR__CALIBRATION_SIMD;
+  out[6] = STBIR_RESIZE_CLASSIFICATIONS;
+  out[7] = STBIR__V_FIRST_CALIBRATION_BUCKETS;
+  out += STBIR__CALIBRATION_HEADER_SIZE;
 
-  // did they pass a zero for the dest? if so, allocate the buffer
-  if ( output_pixels == 0 )
+  for( i = 0 ; i < 5 * STBIR_RESIZE_CLASSIFICATIONS * STBIR__V_FIRST_CALIBRATION_BUCKETS ; i++ )
   {
-    size_t size;
-    char * ptr;
-  
-    size = (size_t)positive_output_stride_in_bytes * (size_t)output_h;
-    if ( size == 0 )
-      return 0;
+    stbir__FP32 vote;
+    vote.f = entry[ i ].vote;
+    stbir__put_uint32( out, vote.u );
+    stbir__put_uint32( out + 4, (stbir_uint32) entry[ i ].count );
+    out += 8;
+  }
 
-    ptr = (char*) STBIR_MALLOC( size, 0 );
-    if ( ptr == 0 )
-      return 0;
+  return STBIR__CALIBRATION_SIZE;
+}
 
-    free_ptr = ptr;
+STBIRDEF int stbir_set_vertical_first_calibration( const void * buffer, int buffer_size )
+{
+  stbir__vertical_first_calibration_entry * entry = stbir__vertical_first_calibration[0][0];
+  unsigned char const * in = (unsigned char const *) buffer;
+  int i;
 
-    // point at the last scanline, if they requested a flipped image
-    if ( output_stride_in_bytes < 0 )
-      start_ptr = ptr + ( (size_t)positive_output_stride_in_bytes * (size_t)( output_h - 1 ) );
-    else
-      start_ptr = ptr;
-  }
+  if ( ( in == 0 ) || ( buffer_size < STBIR__CALIBRATION_SIZE ) )
+    return 0;
 
-  // ok, now do the resize
-  stbir_resize_init( &resize,
-                     input_pixels,  input_w,  input_h,  input_stride_in_bytes,
-                     start_ptr, output_w, output_h, output_stride_in_bytes,
-                     pixel_layout, data_type );
+  if ( ( in[0] != 'S' ) || ( in[1] != 'R' ) || ( in[2] != 'V' ) || ( in[3] != 'F' ) ||
+       ( in[4] != STBIR__CALIBRATION_VERSION ) || ( in[5] != STBIR__CALIBRATION_SIMD ) ||
+       ( in[6] != STBIR_RESIZE_CLASSIFICATIONS ) || ( in[7] != STBIR__V_FIRST_CALIBRATION_BUCKETS ) )
+    return 0;
+  in += STBIR__CALIBRATION_HEADER_SIZE;
 
-  resize.horizontal_edge = edge;
-  resize.vertical_edge = edge;
-  resize.horizontal_filter = filter;
-  resize.vertical_filter = filter;
+  // validate everything before replacing anything (each timing adds between -1 and 1 to a vote)
+  for( i = 0 ; i < 5 * STBIR_RESIZE_CLASSIFICATIONS * STBIR__V_FIRST_CALIBRATION_BUCKETS ; i++ )
+  {
+    stbir__FP32 vote;
+    stbir_uint32 count = stbir__get_uint32( in + i * 8 + 4 );
+    vote.u = stbir__get_uint32( in + i * 8 );
+    if ( ( count > 0x7fffff ) || ( !( vote.f >= -(float)count ) ) || ( !( vote.f <= (float)count ) ) )
+      return 0;
+  }
 
-  if ( !stbir_resize_extended( &resize ) )
+  for( i = 0 ; i < 5 * STBIR_RESIZE_CLASSIFICATIONS * STBIR__V_FIRST_CALIBRATION_BUCKETS ; i++ )
   {
-    if ( free_ptr )
-      STBIR_FREE( free_ptr, 0 );
-    return 0;
+    stbir__FP32 vote;
+    vote.u = stbir__get_uint32( in );
+    entry[ i ].vote = vote.f;
+    entry[ i ].count = (int) stbir__get_uint32( in + 4 );
+    in += 8;
   }
 
-  return (free_ptr) ? free_ptr : start_ptr;
+  return 1;
 }
 
+#ifndef STBIR_NO_STDIO
 
+#include <stdio.h>
 
-STBIRDEF unsigned char * stbir_resize_uint8_linear( const unsigned char *input_pixels , int input_w , int input_h, int input_stride_in_bytes,
-                                                          unsigned char *output_pixels, int output_w, int output_h, int output_stride_in_bytes,
-                                                          stbir_pixel_layout pixel_layout )
+static FILE * stbir__fopen( char const * filename, char const * mode )
 {
-  return (unsigned char *) stbir_quick_resize_helper( input_pixels , input_w , input_h, input_stride_in_bytes, 
-                                                      output_pixels, output_w, output_h, output_stride_in_bytes, 
-                                                      pixel_layout, STBIR_TYPE_UINT8, STBIR_EDGE_CLAMP, STBIR_FILTER_DEFAULT );
+  FILE * f;
+#if defined(_MSC_VER) && _MSC_VER >= 1400
+  if ( fopen_s( &f, filename, mode ) != 0 )
+    f = 0;
+#else
+  f = fopen( filename, mode );
+#endif
+  return f;
 }
 
-STBIRDEF unsigned char * stbir_resize_uint8_srgb( const unsigned char *input_pixels , int input_w , int input_h, int input_stride_in_bytes,
-                                                        unsigned char *output_pixels, int output_w, int output_h, int output_stride_in_bytes,
-                                                        stbir_pixel_layout pixel_layout )
+STBIRDEF int stbir_save_vertical_first_calibration( char const * filename )
 {
-  return (unsigned char *) stbir_quick_resize_helper( input_pixels , input_w , input_h, input_stride_in_bytes, 
-                                                      output_pixels, output_w, output_h, output_stride_in_bytes, 
-                                                      pixel_layout, STBIR_TYPE_UINT8_SRGB, STBIR_EDGE_CLAMP, STBIR_FILTER_DEFAULT );
-}
+  unsigned char buffer[ STBIR__CALIBRATION_SIZE ];
+  int size = stbir_get_vertical_first_calibration( buffer, sizeof( buffer ) );
+  int result;
+  FILE * f = stbir__fopen( filename, "wb" );
 
+  if ( f == 0 )
+    return 0;
 
-STBIRDEF float * stbir_resize_float_linear( const float *input_pixels , int input_w , int input_h, int input_stride_in_bytes,
-                                                  float *output_pixels, int output_w, int output_h, int output_stride_in_bytes,
-                                                  stbir_pixel_layout pixel_layout )
-{
-  return (float *) stbir_quick_resize_helper( input_pixels , input_w , input_h, input_stride_in_bytes, 
-                                              output_pixels, output_w, output_h, output_stride_in_bytes, 
-                                              pixel_layout, STBIR_TYPE_FLOAT, STBIR_EDGE_CLAMP, STBIR_FILTER_DEFAULT  );
+  result = ( fwrite( buffer, 1, (size_t) size, f ) == (size_t) size );
+  if ( fclose( f ) != 0 )
+    result = 0;
+  return result;
 }
 
-
-STBIRDEF void * stbir_resize( const void *input_pixels , int input_w , int input_h, int input_stride_in_bytes,
-                                    void *output_pixels, int output_w, int output_h, int output_stride_in_bytes,
-                                    stbir_pixel_layout pixel_layout, stbir_datatype data_type,
-                                    stbir_edge edge, stbir_filter filter )
+STBIRDEF int stbir_load_vertical_first_calibration( char const * filename )
 {
-  return (void *) stbir_quick_resize_helper( input_pixels , input_w , input_h, input_stride_in_bytes, 
-                                             output_pixels, output_w, output_h, output_stride_in_bytes, 
-                                             pixel_layout, data_type, edge, filter  );
+  unsigned char buffer[ STBIR__CALIBRATION_SIZE ];
+  size_t size;
+  FILE * f = stbir__fopen( filename, "rb" );
+
+  if ( f == 0 )
+    return 0;
+
+  size = fread( buffer, 1, sizeof( buffer ), f );
+  fclose( f );
+
+  return stbir_set_vertical_first_calibration( buffer, (int) size );
 }
 
+#endif // STBIR_NO_STDIO
+
 #ifdef STBIR_PROFILE
 
+static void stbir__profile_memory_info( STBIR_PROFILE_INFO * info, stbir__info const * samp )
+{
+  info->total_memory = samp->alloced_total;
+  info->split_memory = samp->split_buffers_size;
+  info->ring_buffer_entries = (stbir_uint32) samp->ring_buffer_num_entries;
+}
+
 STBIRDEF void stbir_resize_build_profile_info( STBIR_PROFILE_INFO * info, STBIR_RESIZE const * resize )
 {
   static char const * bdescriptions[6] = { "Building", "Allocating", "Horizontal sampler", "Vertical sampler", "Coefficient cleanup", "Coefficient piovot" } ;
@@ -8146,6 +10900,7 @@ STBIRDEF void stbir_resize_build_profile_info( STBIR_PROFILE_INFO * info, STBIR_
   info->total_clocks = samp->profile.named.total;
   info->descriptions = bdescriptions;
   info->count = STBIR__ARRAY_SIZE( bdescriptions );
+  stbir__profile_memory_info( info, samp );
 }
 
 STBIRDEF void stbir_resize_split_profile_info( STBIR_PROFILE_INFO * info, STBIR_RESIZE const * resize, int split_start, int split_count )
@@ -8169,6 +10924,9 @@ STBIRDEF void stbir_resize_split_profile_info( STBIR_PROFILE_INFO * info, STBIR_
     info->total_clocks = 0;
     info->descriptions = 0;
     info->count = 0;
+    info->total_memory = 0;
+    info->split_memory = 0;
+    info->ring_buffer_entries = 0;
     return;
   }
 
@@ -8186,6 +10944,7 @@ STBIRDEF void stbir_resize_split_profile_info( STBIR_PROFILE_INFO * info, STBIR_
   info->total_clocks = split_info->profile.named.total;
   info->descriptions = descriptions;
   info->count = STBIR__ARRAY_SIZE( descriptions );
+  stbir__profile_memory_info( info, resize->samplers );
 }
 
 STBIRDEF void stbir_resize_extended_profile_info( STBIR_PROFILE_INFO * info, STBIR_RESIZE const * resize )
@@ -9602,6 +12361,177 @@ static void STBIR__CODER_NAME( stbir__encode_half_float_linear )( void * outputp
   #endif
 }
 
+static float * STBIR__CODER_NAME(stbir__decode_bfloat16_linear)( float * decodep, int width_times_channels, void const * inputp )
+{
+  float STBIR_STREAMOUT_PTR( * ) decode = decodep;
+  float * decode_end = (float*) decode + width_times_channels;
+  unsigned short const * input = (unsigned short const *)inputp;
+
+  #ifdef STBIR_SIMD
+  if ( width_times_channels >= 8 )
+  {
+    unsigned short const * end_input_m8 = input + width_times_channels - 8;
+    decode_end -= 8;
+    STBIR_NO_UNROLL_LOOP_START_INF_FOR
+    for(;;)
+    {
+      STBIR_NO_UNROLL(decode);
+
+      stbir__bf16_to_float_SIMD( decode, input );
+      #ifdef stbir__decode_swizzle
+      #ifdef STBIR_SIMD8
+      {
+        stbir__simdf8 of;
+        stbir__simdf8_load( of, decode );
+        stbir__decode_simdf8_flip( of );
+        stbir__simdf8_store( decode, of );
+      }
+      #else
+      {
+        stbir__simdf of0,of1;
+        stbir__simdf_load( of0, decode );
+        stbir__simdf_load( of1, decode+4 );
+        stbir__decode_simdf4_flip( of0 );
+        stbir__decode_simdf4_flip( of1 );
+        stbir__simdf_store( decode, of0 );
+        stbir__simdf_store( decode+4, of1 );
+      }
+      #endif
+      #endif
+      decode += 8;
+      input += 8;
+      if ( decode <= decode_end )
+        continue;
+      if ( decode == ( decode_end + 8 ) )
+        break;
+      decode = decode_end; // backup and do last couple
+      input = end_input_m8;
+    }
+    return decode_end + 8;
+  }
+  #endif
+
+  // try to do blocks of 4 when you can
+  #if stbir__coder_min_num != 3 // doesn't divide cleanly by four
+  decode += 4;
+  STBIR_SIMD_NO_UNROLL_LOOP_START
+  while( decode <= decode_end )
+  {
+    STBIR_SIMD_NO_UNROLL(decode);
+    decode[0-4] = stbir__bf16_to_float(input[stbir__decode_order0]);
+    decode[1-4] = stbir__bf16_to_float(input[stbir__decode_order1]);
+    decode[2-4] = stbir__bf16_to_float(input[stbir__decode_order2]);
+    decode[3-4] = stbir__bf16_to_float(input[stbir__decode_order3]);
+    decode += 4;
+    input += 4;
+  }
+  decode -= 4;
+  #endif
+
+  // do the remnants
+  #if stbir__coder_min_num < 4
+  STBIR_NO_UNROLL_LOOP_START
+  while( decode < decode_end )
+  {
+    STBIR_NO_UNROLL(decode);
+    decode[0] = stbir__bf16_to_float(input[stbir__decode_order0]);
+    #if stbir__coder_min_num >= 2
+    decode[1] = stbir__bf16_to_float(input[stbir__decode_order1]);
+    #endif
+    #if stbir__coder_min_num >= 3
+    decode[2] = stbir__bf16_to_float(input[stbir__decode_order2]);
+    #endif
+    decode += stbir__coder_min_num;
+    input += stbir__coder_min_num;
+  }
+  #endif
+  return decode_end;
+}
+
+static void STBIR__CODER_NAME( stbir__encode_bfloat16_linear )( void * outputp, int width_times_channels, float const * encode )
+{
+  unsigned short STBIR_SIMD_STREAMOUT_PTR( * ) output = (unsigned short*) outputp;
+  unsigned short * end_output = ( (unsigned short*) output ) + width_times_channels;
+
+  #ifdef STBIR_SIMD
+  if ( width_times_channels >= 8 )
+  {
+    float const * end_encode_m8 = encode + width_times_channels - 8;
+    end_output -= 8;
+    STBIR_SIMD_NO_UNROLL_LOOP_START_INF_FOR
+    for(;;)
+    {
+      STBIR_SIMD_NO_UNROLL(encode);
+      #ifdef stbir__decode_swizzle
+      #ifdef STBIR_SIMD8
+      {
+        stbir__simdf8 of;
+        stbir__simdf8_load( of, encode );
+        stbir__encode_simdf8_unflip( of );
+        stbir__float_to_bf16_SIMD( output, (float*)&of );
+      }
+      #else
+      {
+        stbir__simdf of[2];
+        stbir__simdf_load( of[0], encode );
+        stbir__simdf_load( of[1], encode+4 );
+        stbir__encode_simdf4_unflip( of[0] );
+        stbir__encode_simdf4_unflip( of[1] );
+        stbir__float_to_bf16_SIMD( output, (float*)of );
+      }
+      #endif
+      #else
+      stbir__float_to_bf16_SIMD( output, encode );
+      #endif
+      encode += 8;
+      output += 8;
+      if ( output <= end_output )
+        continue;
+      if ( output == ( end_output + 8 ) )
+        break;
+      output = end_output; // backup and do last couple
+      encode = end_encode_m8;
+    }
+    return;
+  }
+  #endif
+
+  // try to do blocks of 4 when you can
+  #if stbir__coder_min_num != 3 // doesn't divide cleanly by four
+  output += 4;
+  STBIR_SIMD_NO_UNROLL_LOOP_START
+  while( output <= end_output )
+  {
+    STBIR_SIMD_NO_UNROLL(output);
+    output[0-4] = stbir__float_to_bf16(encode[stbir__encode_order0]);
+    output[1-4] = stbir__float_to_bf16(encode[stbir__encode_order1]);
+    output[2-4] = stbir__float_to_bf16(encode[stbir__encode_order2]);
+    output[3-4] = stbir__float_to_bf16(encode[stbir__encode_order3]);
+    output += 4;
+    encode += 4;
+  }
+  output -= 4;
+  #endif
+
+  // do the remnants
+  #if stbir__coder_min_num < 4
+  STBIR_NO_UNROLL_LOOP_START
+  while( output < end_output )
+  {
+    STBIR_NO_UNROLL(output);
+    output[0] = stbir__float_to_bf16(encode[stbir__encode_order0]);
+    #if stbir__coder_min_num >= 2
+    output[1] = stbir__float_to_bf16(encode[stbir__encode_order1]);
+    #endif
+    #if stbir__coder_min_num >= 3
+    output[2] = stbir__float_to_bf16(encode[stbir__encode_order2]);
+    #endif
+    output += stbir__coder_min_num;
+    encode += stbir__coder_min_num;
+  }
+  #endif
+}
+
 static float * STBIR__CODER_NAME(stbir__decode_float_linear)( float * decodep, int width_times_channels, void const * inputp )
 {
   #ifdef stbir__decode_swizzle
@@ -9932,6 +12862,76 @@ static void STBIR_chans( stbir__vertical_scatter_with_,_coeffs)( float ** output
     stbIF5(stbir__simdfX c5 = stbir__simdf_frepX( c5s ); )
     stbIF6(stbir__simdfX c6 = stbir__simdf_frepX( c6s ); )
     stbIF7(stbir__simdfX c7 = stbir__simdf_frepX( c7s ); )
+
+    #ifdef STBIR_SIMD16
+    {
+      // AVX-512: same math per lane as below, 64 floats at a time (the loops below do the tail)
+      stbIF0( stbir__simdf16 z0 = stbir__simdf16_frep16( c0s ); )
+      stbIF1( stbir__simdf16 z1 = stbir__simdf16_frep16( c1s ); )
+      stbIF2( stbir__simdf16 z2 = stbir__simdf16_frep16( c2s ); )
+      stbIF3( stbir__simdf16 z3 = stbir__simdf16_frep16( c3s ); )
+      stbIF4( stbir__simdf16 z4 = stbir__simdf16_frep16( c4s ); )
+      stbIF5( stbir__simdf16 z5 = stbir__simdf16_frep16( c5s ); )
+      stbIF6( stbir__simdf16 z6 = stbir__simdf16_frep16( c6s ); )
+      stbIF7( stbir__simdf16 z7 = stbir__simdf16_frep16( c7s ); )
+      STBIR_SIMD_NO_UNROLL_LOOP_START
+      while ( ( (char*)input_end - (char*) input ) >= (64*4) )
+      {
+        stbir__simdf16 o0, o1, o2, o3, r0, r1, r2, r3;
+        STBIR_SIMD_NO_UNROLL(output0);
+
+        stbir__simdf16_load( r0, input );      stbir__simdf16_load( r1, input+16 );     stbir__simdf16_load( r2, input+32 );     stbir__simdf16_load( r3, input+48 );
+
+        #ifdef STB_IMAGE_RESIZE_VERTICAL_CONTINUE
+        stbIF0( stbir__simdf16_load( o0, output0 );    stbir__simdf16_load( o1, output0+16 );  stbir__simdf16_load( o2, output0+32 );  stbir__simdf16_load( o3, output0+48 );
+                stbir__simdf16_madd( o0, o0, r0, z0 ); stbir__simdf16_madd( o1, o1, r1, z0 );  stbir__simdf16_madd( o2, o2, r2, z0 );  stbir__simdf16_madd( o3, o3, r3, z0 );
+                stbir__simdf16_store( output0, o0 );   stbir__simdf16_store( output0+16, o1 ); stbir__simdf16_store( output0+32, o2 ); stbir__simdf16_store( output0+48, o3 ); )
+        stbIF1( stbir__simdf16_load( o0, output1 );    stbir__simdf16_load( o1, output1+16 );  stbir__simdf16_load( o2, output1+32 );  stbir__simdf16_load( o3, output1+48 );
+                stbir__simdf16_madd( o0, o0, r0, z1 ); stbir__simdf16_madd( o1, o1, r1, z1 );  stbir__simdf16_madd( o2, o2, r2, z1 );  stbir__simdf16_madd( o3, o3, r3, z1 );
+                stbir__simdf16_store( output1, o0 );   stbir__simdf16_store( output1+16, o1 ); stbir__simdf16_store( output1+32, o2 ); stbir__simdf16_store( output1+48, o3 ); )
+        stbIF2( stbir__simdf16_load( o0, output2 );    stbir__simdf16_load( o1, output2+16 );  stbir__simdf16_load( o2, output2+32 );  stbir__simdf16_load( o3, output2+48 );
+                stbir__simdf16_madd( o0, o0, r0, z2 ); stbir__simdf16_madd( o1, o1, r1, z2 );  stbir__simdf16_madd( o2, o2, r2, z2 );  stbir__simdf16_madd( o3, o3, r3, z2 );
+                stbir__simdf16_store( output2, o0 );   stbir__simdf16_store( output2+16, o1 ); stbir__simdf16_store( output2+32, o2 ); stbir__simdf16_store( output2+48, o3 ); )
+        stbIF3( stbir__simdf16_load( o0, output3 );    stbir__simdf16_load( o1, output3+16 );  stbir__simdf16_load( o2, output3+32 );  stbir__simdf16_load( o3, output3+48 );
+                stbir__simdf16_madd( o0, o0, r0, z3 ); stbir__simdf16_madd( o1, o1, r1, z3 );  stbir__simdf16_madd( o2, o2, r2, z3 );  stbir__simdf16_madd( o3, o3, r3, z3 );
+                stbir__simdf16_store( output3, o0 );   stbir__simdf16_store( output3+16, o1 ); stbir__simdf16_store( output3+32, o2 ); stbir__simdf16_store( output3+48, o3 ); )
+        stbIF4( stbir__simdf16_load( o0, output4 );    stbir__simdf16_load( o1, output4+16 );  stbir__simdf16_load( o2, output4+32 );  stbir__simdf16_load( o3, output4+48 );
+                stbir__simdf16_madd( o0, o0, r0, z4 ); stbir__simdf16_madd( o1, o1, r1, z4 );  stbir__simdf16_madd( o2, o2, r2, z4 );  stbir__simdf16_madd( o3, o3, r3, z4 );
+                stbir__simdf16_store( output4, o0 );   stbir__simdf16_store( output4+16, o1 ); stbir__simdf16_store( output4+32, o2 ); stbir__simdf16_store( output4+48, o3 ); )
+        stbIF5( stbir__simdf16_load( o0, output5 );    stbir__simdf16_load( o1, output5+16 );  stbir__simdf16_load( o2, output5+32 );  stbir__simdf16_load( o3, output5+48 );
+                stbir__simdf16_madd( o0, o0, r0, z5 ); stbir__simdf16_madd( o1, o1, r1, z5 );  stbir__simdf16_madd( o2, o2, r2, z5 );  stbir__simdf16_madd( o3, o3, r3, z5 );
+                stbir__simdf16_store( output5, o0 );   stbir__simdf16_store( output5+16, o1 ); stbir__simdf16_store( output5+32, o2 ); stbir__simdf16_store( output5+48, o3 ); )
+        stbIF6( stbir__simdf16_load( o0, output6 );    stbir__simdf16_load( o1, output6+16 );  stbir__simdf16_load( o2, output6+32 );  stbir__simdf16_load( o3, output6+48 );
+                stbir__simdf16_madd( o0, o0, r0, z6 ); stbir__simdf16_madd( o1, o1, r1, z6 );  stbir__simdf16_madd( o2, o2, r2, z6 );  stbir__simdf16_madd( o3, o3, r3, z6 );
+                stbir__simdf16_store( output6, o0 );   stbir__simdf16_store( output6+16, o1 ); stbir__simdf16_store( output6+32, o2 ); stbir__simdf16_store( output6+48, o3 ); )
+        stbIF7( stbir__simdf16_load( o0, output7 );    stbir__simdf16_load( o1, output7+16 );  stbir__simdf16_load( o2, output7+32 );  stbir__simdf16_load( o3, output7+48 );
+                stbir__simdf16_madd( o0, o0, r0, z7 ); stbir__simdf16_madd( o1, o1, r1, z7 );  stbir__simdf16_madd( o2, o2, r2, z7 );  stbir__simdf16_madd( o3, o3, r3, z7 );
+                stbir__simdf16_store( output7, o0 );   stbir__simdf16_store( output7+16, o1 ); stbir__simdf16_store( output7+32, o2 ); stbir__simdf16_store( output7+48, o3 ); )
+        #else
+        stbIF0( stbir__simdf16_mult( o0, r0, z0 );     stbir__simdf16_mult( o1, r1, z0 );      stbir__simdf16_mult( o2, r2, z0 );      stbir__simdf16_mult( o3, r3, z0 );
+                stbir__simdf16_store( output0, o0 );   stbir__simdf16_store( output0+16, o1 ); stbir__simdf16_store( output0+32, o2 ); stbir__simdf16_store( output0+48, o3 ); )
+        stbIF1( stbir__simdf16_mult( o0, r0, z1 );     stbir__simdf16_mult( o1, r1, z1 );      stbir__simdf16_mult( o2, r2, z1 );      stbir__simdf16_mult( o3, r3, z1 );
+                stbir__simdf16_store( output1, o0 );   stbir__simdf16_store( output1+16, o1 ); stbir__simdf16_store( output1+32, o2 ); stbir__simdf16_store( output1+48, o3 ); )
+        stbIF2( stbir__simdf16_mult( o0, r0, z2 );     stbir__simdf16_mult( o1, r1, z2 );      stbir__simdf16_mult( o2, r2, z2 );      stbir__simdf16_mult( o3, r3, z2 );
+                stbir__simdf16_store( output2, o0 );   stbir__simdf16_store( output2+16, o1 ); stbir__simdf16_store( output2+32, o2 ); stbir__simdf16_store( output2+48, o3 ); )
+        stbIF3( stbir__simdf16_mult( o0, r0, z3 );     stbir__simdf16_mult( o1, r1, z3 );      stbir__simdf16_mult( o2, r2, z3 );      stbir__simdf16_mult( o3, r3, z3 );
+                stbir__simdf16_store( output3, o0 );   stbir__simdf16_store( output3+16, o1 ); stbir__simdf16_store( output3+32, o2 ); stbir__simdf16_store( output3+48, o3 ); )
+        stbIF4( stbir__simdf16_mult( o0, r0, z4 );     stbir__simdf16_mult( o1, r1, z4 );      stbir__simdf16_mult( o2, r2, z4 );      stbir__simdf16_mult( o3, r3, z4 );
+                stbir__simdf16_store( output4, o0 );   stbir__simdf16_store( output4+16, o1 ); stbir__simdf16_store( output4+32, o2 ); stbir__simdf16_store( output4+48, o3 ); )
+        stbIF5( stbir__simdf16_mult( o0, r0, z5 );     stbir__simdf16_mult( o1, r1, z5 );      stbir__simdf16_mult( o2, r2, z5 );      stbir__simdf16_mult( o3, r3, z5 );
+                stbir__simdf16_store( output5, o0 );   stbir__simdf16_store( output5+16, o1 ); stbir__simdf16_store( output5+32, o2 ); stbir__simdf16_store( output5+48, o3 ); )
+        stbIF6( stbir__simdf16_mult( o0, r0, z6 );     stbir__simdf16_mult( o1, r1, z6 );      stbir__simdf16_mult( o2, r2, z6 );      stbir__simdf16_mult( o3, r3, z6 );
+                stbir__simdf16_store( output6, o0 );   stbir__simdf16_store( output6+16, o1 ); stbir__simdf16_store( output6+32, o2 ); stbir__simdf16_store( output6+48, o3 ); )
+        stbIF7( stbir__simdf16_mult( o0, r0, z7 );     stbir__simdf16_mult( o1, r1, z7 );      stbir__simdf16_mult( o2, r2, z7 );      stbir__simdf16_mult( o3, r3, z7 );
+                stbir__simdf16_store( output7, o0 );   stbir__simdf16_store( output7+16, o1 ); stbir__simdf16_store( output7+32, o2 ); stbir__simdf16_store( output7+48, o3 ); )
+        #endif
+
+        input += 64;
+        stbIF0( output0 += 64; ) stbIF1( output1 += 64; ) stbIF2( output2 += 64; ) stbIF3( output3 += 64; ) stbIF4( output4 += 64; ) stbIF5( output5 += 64; ) stbIF6( output6 += 64; ) stbIF7( output7 += 64; )
+      }
+    }
+    #endif
+
     STBIR_SIMD_NO_UNROLL_LOOP_START
     while ( ( (char*)input_end - (char*) input ) >= (16*stbir__simdfX_float_count) )
     {
@@ -10116,6 +13116,53 @@ static void STBIR_chans( stbir__vertical_gather_with_,_coeffs)( float * outputp,
     stbIF6(stbir__simdfX c6 = stbir__simdf_frepX( c6s ); )
     stbIF7(stbir__simdfX c7 = stbir__simdf_frepX( c7s ); )
 
+    #ifdef STBIR_SIMD16
+    {
+      // AVX-512: same math per lane as below, 64 floats at a time (the loops below do the tail)
+      stbIF0( stbir__simdf16 z0 = stbir__simdf16_frep16( c0s ); )
+      stbIF1( stbir__simdf16 z1 = stbir__simdf16_frep16( c1s ); )
+      stbIF2( stbir__simdf16 z2 = stbir__simdf16_frep16( c2s ); )
+      stbIF3( stbir__simdf16 z3 = stbir__simdf16_frep16( c3s ); )
+      stbIF4( stbir__simdf16 z4 = stbir__simdf16_frep16( c4s ); )
+      stbIF5( stbir__simdf16 z5 = stbir__simdf16_frep16( c5s ); )
+      stbIF6( stbir__simdf16 z6 = stbir__simdf16_frep16( c6s ); )
+      stbIF7( stbir__simdf16 z7 = stbir__simdf16_frep16( c7s ); )
+      STBIR_SIMD_NO_UNROLL_LOOP_START
+      while ( ( (char*)input0_end - (char*) input0 ) >= (64*4) )
+      {
+        stbir__simdf16 o0, o1, o2, o3, r0, r1, r2, r3;
+        STBIR_SIMD_NO_UNROLL(output);
+
+        #ifdef STB_IMAGE_RESIZE_VERTICAL_CONTINUE
+        stbIF0( stbir__simdf16_load( o0, output );     stbir__simdf16_load( o1, output+16 );     stbir__simdf16_load( o2, output+32 );     stbir__simdf16_load( o3, output+48 );
+                stbir__simdf16_load( r0, input0 );     stbir__simdf16_load( r1, input0+16 );     stbir__simdf16_load( r2, input0+32 );     stbir__simdf16_load( r3, input0+48 );
+                stbir__simdf16_madd( o0, o0, r0, z0 ); stbir__simdf16_madd( o1, o1, r1, z0 );    stbir__simdf16_madd( o2, o2, r2, z0 );    stbir__simdf16_madd( o3, o3, r3, z0 ); )
+        #else
+        stbIF0( stbir__simdf16_load( r0, input0 );     stbir__simdf16_load( r1, input0+16 );     stbir__simdf16_load( r2, input0+32 );     stbir__simdf16_load( r3, input0+48 );
+                stbir__simdf16_mult( o0, r0, z0 );     stbir__simdf16_mult( o1, r1, z0 );        stbir__simdf16_mult( o2, r2, z0 );        stbir__simdf16_mult( o3, r3, z0 ); )
+        #endif
+        stbIF1( stbir__simdf16_load( r0, input1 );     stbir__simdf16_load( r1, input1+16 );     stbir__simdf16_load( r2, input1+32 );     stbir__simdf16_load( r3, input1+48 );
+                stbir__simdf16_madd( o0, o0, r0, z1 ); stbir__simdf16_madd( o1, o1, r1, z1 );    stbir__simdf16_madd( o2, o2, r2, z1 );    stbir__simdf16_madd( o3, o3, r3, z1 ); )
+        stbIF2( stbir__simdf16_load( r0, input2 );     stbir__simdf16_load( r1, input2+16 );     stbir__simdf16_load( r2, input2+32 );     stbir__simdf16_load( r3, input2+48 );
+                stbir__simdf16_madd( o0, o0, r0, z2 ); stbir__simdf16_madd( o1, o1, r1, z2 );    stbir__simdf16_madd( o2, o2, r2, z2 );    stbir__simdf16_madd( o3, o3, r3, z2 ); )
+        stbIF3( stbir__simdf16_load( r0, input3 );     stbir__simdf16_load( r1, input3+16 );     stbir__simdf16_load( r2, input3+32 );     stbir__simdf16_load( r3, input3+48 );
+                stbir__simdf16_madd( o0, o0, r0, z3 ); stbir__simdf16_madd( o1, o1, r1, z3 );    stbir__simdf16_madd( o2, o2, r2, z3 );    stbir__simdf16_madd( o3, o3, r3, z3 ); )
+        stbIF4( stbir__simdf16_load( r0, input4 );     stbir__simdf16_load( r1, input4+16 );     stbir__simdf16_load( r2, input4+32 );     stbir__simdf16_load( r3, input4+48 );
+                stbir__simdf16_madd( o0, o0, r0, z4 ); stbir__simdf16_madd( o1, o1, r1, z4 );    stbir__simdf16_madd( o2, o2, r2, z4 );    stbir__simdf16_madd( o3, o3, r3, z4 ); )
+        stbIF5( stbir__simdf16_load( r0, input5 );     stbir__simdf16_load( r1, input5+16 );     stbir__simdf16_load( r2, input5+32 );     stbir__simdf16_load( r3, input5+48 );
+                stbir__simdf16_madd( o0, o0, r0, z5 ); stbir__simdf16_madd( o1, o1, r1, z5 );    stbir__simdf16_madd( o2, o2, r2, z5 );    stbir__simdf16_madd( o3, o3, r3, z5 ); )
+        stbIF6( stbir__simdf16_load( r0, input6 );     stbir__simdf16_load( r1, input6+16 );     stbir__simdf16_load( r2, input6+32 );     stbir__simdf16_load( r3, input6+48 );
+                stbir__simdf16_madd( o0, o0, r0, z6 ); stbir__simdf16_madd( o1, o1, r1, z6 );    stbir__simdf16_madd( o2, o2, r2, z6 );    stbir__simdf16_madd( o3, o3, r3, z6 ); )
+        stbIF7( stbir__simdf16_load( r0, input7 );     stbir__simdf16_load( r1, input7+16 );     stbir__simdf16_load( r2, input7+32 );     stbir__simdf16_load( r3, input7+48 );
+                stbir__simdf16_madd( o0, o0, r0, z7 ); stbir__simdf16_madd( o1, o1, r1, z7 );    stbir__simdf16_madd( o2, o2, r2, z7 );    stbir__simdf16_madd( o3, o3, r3, z7 ); )
+
+        stbir__simdf16_store( output, o0 );     stbir__simdf16_store( output+16, o1 );    stbir__simdf16_store( output+32, o2 );    stbir__simdf16_store( output+48, o3 );
+        output += 64;
+        stbIF0( input0 += 64; ) stbIF1( input1 += 64; ) stbIF2( input2 += 64; ) stbIF3( input3 += 64; ) stbIF4( input4 += 64; ) stbIF5( input5 += 64; ) stbIF6( input6 += 64; ) stbIF7( input7 += 64; )
+      }
+    }
+    #endif
+
     STBIR_SIMD_NO_UNROLL_LOOP_START
     while ( ( (char*)input0_end - (char*) input0 ) >= (16*stbir__simdfX_float_count) )
     {
@@ -0,0 +1,171 @@
+// Times resizing lots of small images with stbir_resize_batch against calling
+//   stbir_resize for each one, and checks that they produce the same pixels.
+//
+//   gcc -O2 batchtimings.c -I.. -lpthread -lm -o batchtimings
+//   batchtimings [max_threads] [image_count]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+
+#include <windows.h>
+
+static int get_cpu_count()
+{
+  SYSTEM_INFO si;
+  GetSystemInfo( &si );
+  return (int) si.dwNumberOfProcessors;
+}
+
+static double get_milliseconds()
+{
+  LARGE_INTEGER c, f;
+  QueryPerformanceCounter( &c );
+  QueryPerformanceFrequency( &f );
+  return (double) c.QuadPart * 1000.0 / (double) f.QuadPart;
+}
+
+#else
+
+#include <time.h>
+#include <unistd.h>
+
+static int get_cpu_count()
+{
+  return (int) sysconf( _SC_NPROCESSORS_ONLN );
+}
+
+static double get_milliseconds()
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (double) ts.tv_sec * 1000.0 + (double) ts.tv_nsec / 1000000.0;
+}
+
+#endif
+
+#define STBIR_USE_THREADS
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include "stb_image_resize2.h"
+
+#define REPEATS 5
+#define IN_SIZE 64
+#define OUT_SIZE ( 96 * 96 * 4 )
+
+typedef struct
+{
+  char const * name;
+  int out_w, out_h;
+  stbir_pixel_layout layout;
+  stbir_datatype type;
+  int channels;
+} test_case;
+
+static test_case cases[] =
+{
+  { "64->32 rgba srgb",  32, 32, STBIR_RGBA,     STBIR_TYPE_UINT8_SRGB, 4 },
+  { "64->48 rgba lin",   48, 48, STBIR_RGBA,     STBIR_TYPE_UINT8,      4 },
+  { "64->16 rgb",        16, 16, STBIR_RGB,      STBIR_TYPE_UINT8,      3 },
+  { "64->96 1ch",        96, 96, STBIR_1CHANNEL, STBIR_TYPE_UINT8,      1 },
+};
+
+static int compare( unsigned char const * reference, unsigned char const * output, int count, test_case const * tc )
+{
+  int i;
+  for( i = 0 ; i < count ; i++ )
+    if ( memcmp( reference + OUT_SIZE * i, output + OUT_SIZE * i, tc->out_w * tc->out_h * tc->channels ) != 0 )
+      return 0;
+  return 1;
+}
+
+int main( int argc, char ** argv )
+{
+  int max_threads = ( argc > 1 ) ? atoi( argv[1] ) : get_cpu_count();
+  int count = ( argc > 2 ) ? atoi( argv[2] ) : 4096;
+  size_t in_size = IN_SIZE * IN_SIZE * 4;
+  size_t out_size = OUT_SIZE;
+  unsigned char * input, * reference, * output;
+  stbir_batch_image * images;
+  stbir_thread_pool * pool;
+  int c, i, r;
+  int failed = 0;
+
+  if ( max_threads < 1 ) max_threads = 1;
+
+  input = (unsigned char *) malloc( in_size * count );
+  reference = (unsigned char *) malloc( out_size * count );
+  output = (unsigned char *) malloc( out_size * count );
+  images = (stbir_batch_image *) malloc( sizeof( stbir_batch_image ) * count );
+  if ( ( input == 0 ) || ( reference == 0 ) || ( output == 0 ) || ( images == 0 ) )
+    return 1;
+
+  for( i = 0 ; i < (int) in_size * count ; i++ )
+    input[ i ] = (unsigned char) ( ( i * 2654435761u ) >> 24 );
+
+  pool = stbir_thread_pool_create( max_threads, 0 );
+
+  printf( "%d %dx%d images, best of %d\n\n", count, IN_SIZE, IN_SIZE, REPEATS );
+
+  for( c = 0 ; c < (int) ( sizeof( cases ) / sizeof( cases[0] ) ) ; c++ )
+  {
+    test_case const * tc = cases + c;
+    double single = 1e30, batch = 1e30, threaded = 1e30;
+    STBIR_RESIZE resize;
+
+    for( i = 0 ; i < count ; i++ )
+    {
+      images[ i ].input_pixels = input + in_size * i;
+      images[ i ].input_stride_in_bytes = 0;
+      images[ i ].output_pixels = output + out_size * i;
+      images[ i ].output_stride_in_bytes = 0;
+    }
+
+    for( r = 0 ; r < REPEATS ; r++ )
+    {
+      double t = get_milliseconds();
+      for( i = 0 ; i < count ; i++ )
+        stbir_resize( input + in_size * i, IN_SIZE, IN_SIZE, 0, reference + out_size * i, tc->out_w, tc->out_h, 0, tc->layout, tc->type, STBIR_EDGE_CLAMP, STBIR_FILTER_DEFAULT );
+      t = get_milliseconds() - t;
+      if ( t < single )
+        single = t;
+
+      memset( output, 0, out_size * count );
+      stbir_resize_init( &resize, 0, IN_SIZE, IN_SIZE, 0, 0, tc->out_w, tc->out_h, 0, tc->layout, tc->type );
+      t = get_milliseconds();
+      stbir_resize_batch( &resize, images, count, 1, 0, 0 );
+      t = get_milliseconds() - t;
+      if ( t < batch )
+        batch = t;
+
+      if ( !compare( reference, output, count, tc ) )
+      {
+        printf( "  MISMATCH on one thread!\n" );
+        failed = 1;
+      }
+
+      memset( output, 0, out_size * count );
+      t = get_milliseconds();
+      stbir_resize_batch( &resize, images, count, max_threads, stbir_thread_pool_dispatch, pool );
+      t = get_milliseconds() - t;
+      if ( t < threaded )
+        threaded = t;
+
+      if ( !compare( reference, output, count, tc ) )
+      {
+        printf( "  MISMATCH with %d threads!\n", max_threads );
+        failed = 1;
+      }
+    }
+
+    printf( "%-18s stbir_resize: %7.2f ms  batch: %7.2f ms %5.2fx  batch %d threads: %7.2f ms %5.2fx\n", tc->name, single, batch, single / batch, max_threads, threaded, single / threaded );
+  }
+
+  stbir_thread_pool_destroy( pool );
+  free( images );
+  free( output );
+  free( reference );
+  free( input );
+  return failed;
+}
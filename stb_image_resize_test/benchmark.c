@@ -0,0 +1,525 @@
+// Benchmark sweep for stb_image_resize2 - resizes a generated test image across
+//   datatypes, pixel layouts, filters, scale ratios and split counts, and reports
+//   megapixels per second (output pixels) and cycles per output pixel (from the
+//   STBIR_PROFILE counters). Results can be saved as JSON, and a later run can be
+//   compared against a saved file to catch regressions.
+//
+//   gcc -O2 benchmark.c -I.. -lm -o benchmark
+//   benchmark [options]
+//     -full              every combination (the default varies types and layouts at
+//                          each scale, then filters and splits on u8 rgba only)
+//     -size W H          input size (default 1024 768)
+//     -repeats N         best of N (default 5)
+//     -match TEXT        only run cases with TEXT in their name
+//     -save FILE         write the results to FILE as JSON
+//     -baseline FILE     compare against a JSON file written with -save
+//     -threshold PCT     cycles/pixel increase that counts as a regression (default 10)
+//
+//   Returns 1 if any case regressed against the baseline. Splits are run one after
+//   the other on this thread, so split counts show the split overhead and the
+//   numbers don't depend on the number of cores.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _MSC_VER
+
+#include <windows.h>
+
+static double get_milliseconds()
+{
+  LARGE_INTEGER c, f;
+  QueryPerformanceCounter( &c );
+  QueryPerformanceFrequency( &f );
+  return (double) c.QuadPart * 1000.0 / (double) f.QuadPart;
+}
+
+#else
+
+#include <time.h>
+
+static double get_milliseconds()
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (double) ts.tv_sec * 1000.0 + (double) ts.tv_nsec / 1000000.0;
+}
+
+#endif
+
+#define STBIR_PROFILE
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include "stb_image_resize2.h"
+
+#define REPEATS 5
+#define MAX_RESULTS 4096
+
+#if defined( STBIR_NO_SIMD )
+  #define SIMD_NAME "scalar"
+#elif defined( STBIR_AVX512 )
+  #define SIMD_NAME "avx512"
+#elif defined( STBIR_AVX2 )
+  #define SIMD_NAME "avx2"
+#elif defined( STBIR_AVX )
+  #define SIMD_NAME "avx"
+#elif defined( STBIR_SSE2 )
+  #define SIMD_NAME "sse2"
+#elif defined( STBIR_NEON )
+  #define SIMD_NAME "neon"
+#elif defined( STBIR_WASM )
+  #define SIMD_NAME "wasm"
+#else
+  #define SIMD_NAME "scalar"
+#endif
+
+typedef struct
+{
+  char const * name;
+  stbir_datatype type;
+} test_type;
+
+static test_type types[] =
+{
+  { "u8",   STBIR_TYPE_UINT8 },
+  { "srgb", STBIR_TYPE_UINT8_SRGB },
+  { "u16",  STBIR_TYPE_UINT16 },
+  { "half", STBIR_TYPE_HALF_FLOAT },
+  { "bf16", STBIR_TYPE_BFLOAT16 },
+  { "f32",  STBIR_TYPE_FLOAT },
+};
+
+typedef struct
+{
+  char const * name;
+  stbir_pixel_layout layout;
+  int channels;
+} test_layout;
+
+static test_layout layouts[] =
+{
+  { "1ch",  STBIR_1CHANNEL, 1 },
+  { "ra",   STBIR_RA,       2 },
+  { "rgb",  STBIR_RGB,      3 },
+  { "rgba", STBIR_RGBA,     4 },
+  { "pm",   STBIR_RGBA_PM,  4 },
+  { "4ch",  STBIR_4CHANNEL, 4 },
+};
+
+typedef struct
+{
+  char const * name;
+  stbir_filter filter;
+} test_filter;
+
+static test_filter filters[] =
+{
+  { "point",    STBIR_FILTER_POINT_SAMPLE },
+  { "box",      STBIR_FILTER_BOX },
+  { "triangle", STBIR_FILTER_TRIANGLE },
+  { "cubic",    STBIR_FILTER_CUBICBSPLINE },
+  { "catmull",  STBIR_FILTER_CATMULLROM },
+  { "mitchell", STBIR_FILTER_MITCHELL },
+};
+
+// output size as a fraction of the input
+static int scales[][2] =
+{
+  { 1, 8 }, { 1, 3 }, { 1, 2 }, { 3, 4 }, { 1, 1 }, { 3, 2 }, { 2, 1 },
+};
+
+static int split_counts[] = { 1, 2, 4, 8 };
+
+#define COUNT( a ) ( (int) ( sizeof( a ) / sizeof( a[0] ) ) )
+
+// the defaults the non-full sweep holds still while varying the other axes
+#define DEFAULT_TYPE 0
+#define DEFAULT_LAYOUT 3
+#define DEFAULT_FILTER 5
+#define DEFAULT_SPLIT 0
+
+typedef struct
+{
+  char name[ 64 ];
+  double mpix_per_sec;
+  double cycles_per_pixel;
+} result;
+
+static result results[ MAX_RESULTS ];
+static int result_count;
+
+static result baseline[ MAX_RESULTS ];
+static int baseline_count, baseline_w, baseline_h;
+
+static int in_w = 1024, in_h = 768, repeats = REPEATS;
+static float * corpus;
+static void * input;
+static void * output;
+
+// a fixed test image: smooth gradients, a hard edged checkerboard, and hashed noise,
+//   with an alpha that ramps from 0 to 1 across the image (so the alpha weighting
+//   paths see transparent, partial and opaque pixels). Always the same bits.
+static void make_corpus( void )
+{
+  int x, y, c;
+  float * p = corpus;
+
+  for( y = 0 ; y < in_h ; y++ )
+  {
+    for( x = 0 ; x < in_w ; x++ )
+    {
+      unsigned int h = ( (unsigned int) ( y * in_w + x ) ) * 2654435761u;
+      float check = ( ( ( x >> 4 ) ^ ( y >> 4 ) ) & 1 ) ? 0.9f : 0.1f;
+      float noise = (float) ( h >> 24 ) / 255.0f;
+      float gx = (float) x / (float) in_w, gy = (float) y / (float) in_h;
+
+      for( c = 0 ; c < 3 ; c++ )
+      {
+        float v;
+        switch( ( x / 64 + y / 64 + c ) % 3 )
+        {
+          case 0:  v = gx * 0.5f + gy * 0.5f; break;
+          case 1:  v = check; break;
+          default: v = noise; break;
+        }
+        *p++ = v;
+      }
+      *p++ = ( x < 8 ) ? 0.0f : gx;
+    }
+  }
+}
+
+// convert the corpus to the datatype and layout being timed (with a 1:1 point sample)
+static int make_input( test_type const * tt, test_layout const * tl )
+{
+  STBIR_RESIZE resize;
+  stbir_pixel_layout from = ( tl->channels == 1 ) ? STBIR_1CHANNEL : ( tl->channels == 2 ) ? STBIR_RA : ( tl->channels == 3 ) ? STBIR_RGB : STBIR_4CHANNEL;
+
+  stbir_resize_init( &resize, corpus, in_w, in_h, in_w * 16, input, in_w, in_h, 0, from, STBIR_TYPE_FLOAT );
+  stbir_set_datatypes( &resize, STBIR_TYPE_FLOAT, tt->type );
+  stbir_set_filters( &resize, STBIR_FILTER_POINT_SAMPLE, STBIR_FILTER_POINT_SAMPLE );
+  if ( tl->channels == 2 )
+  {
+    // the corpus is 4 floats per pixel, so pull r and a out with a 2 channel view of every other pair
+    int i;
+    float * f = (float *) output;
+    for( i = 0 ; i < in_w * in_h ; i++ )
+    {
+      f[ i * 2 + 0 ] = corpus[ i * 4 + 0 ];
+      f[ i * 2 + 1 ] = corpus[ i * 4 + 3 ];
+    }
+    stbir_set_buffer_ptrs( &resize, f, in_w * 8, input, 0 );
+  }
+  return stbir_resize_extended( &resize );
+}
+
+static void run_case( test_type const * tt, test_layout const * tl, test_filter const * tf, int * scale, int splits_wanted, char const * match )
+{
+  STBIR_RESIZE resize;
+  STBIR_PROFILE_INFO profile;
+  int out_w = in_w * scale[ 0 ] / scale[ 1 ];
+  int out_h = in_h * scale[ 0 ] / scale[ 1 ];
+  double best_ms = 1e30, best_clocks = 1e30;
+  result * res;
+  int splits, r, s;
+
+  if ( result_count >= MAX_RESULTS )
+    return;
+  res = results + result_count;
+
+  sprintf( res->name, "%s %s %s %d/%d %ds", tt->name, tl->name, tf->name, scale[ 0 ], scale[ 1 ], splits_wanted );
+  if ( ( match ) && ( strstr( res->name, match ) == 0 ) )
+    return;
+
+  stbir_resize_init( &resize, input, in_w, in_h, 0, output, out_w, out_h, 0, tl->layout, tt->type );
+  stbir_set_filters( &resize, tf->filter, tf->filter );
+  splits = stbir_build_samplers_with_splits( &resize, splits_wanted );
+  if ( splits == 0 )
+  {
+    printf( "%-32s FAILED to build samplers\n", res->name );
+    return;
+  }
+
+  for( r = 0 ; r < repeats ; r++ )
+  {
+    double clocks = 0;
+    double ms = get_milliseconds();
+    int z;
+    for( s = 0 ; s < splits ; s++ )
+      stbir_resize_extended_split( &resize, s, 1 );
+    ms = get_milliseconds() - ms;
+
+    // each zone excludes the zones inside it, so the total is the sum of all of them
+    stbir_resize_extended_profile_info( &profile, &resize );
+    for( z = 0 ; z < (int) profile.count ; z++ )
+      clocks += (double) profile.clocks[ z ];
+
+    if ( ms < best_ms ) best_ms = ms;
+    if ( clocks < best_clocks ) best_clocks = clocks;
+  }
+
+  stbir_free_samplers( &resize );
+
+  res->mpix_per_sec = ( (double) out_w * out_h / 1000000.0 ) / ( best_ms / 1000.0 );
+  res->cycles_per_pixel = best_clocks / ( (double) out_w * out_h );
+  ++result_count;
+
+  printf( "%-32s %5dx%-5d %9.2f Mpix/s %9.2f cycles/pix\n", res->name, out_w, out_h, res->mpix_per_sec, res->cycles_per_pixel );
+}
+
+static void run_sweep( int full, char const * match )
+{
+  int t, l, f, z, s;
+
+  for( z = 0 ; z < COUNT( scales ) ; z++ )
+  {
+    for( t = 0 ; t < COUNT( types ) ; t++ )
+    {
+      for( l = 0 ; l < COUNT( layouts ) ; l++ )
+      {
+        if ( !make_input( types + t, layouts + l ) )
+        {
+          printf( "couldn't make the %s %s input\n", types[ t ].name, layouts[ l ].name );
+          continue;
+        }
+
+        for( f = 0 ; f < COUNT( filters ) ; f++ )
+        {
+          for( s = 0 ; s < COUNT( split_counts ) ; s++ )
+          {
+            if ( !full )
+            {
+              // types x layouts with the default filter and splits, then the filters and
+              //   split counts with the default type and layout
+              int default_type = ( t == DEFAULT_TYPE ) && ( l == DEFAULT_LAYOUT );
+              int default_rest = ( f == DEFAULT_FILTER ) && ( s == DEFAULT_SPLIT );
+              if ( !default_rest )
+              {
+                if ( !default_type )
+                  continue;
+                if ( ( f != DEFAULT_FILTER ) && ( s != DEFAULT_SPLIT ) )
+                  continue;
+              }
+            }
+            run_case( types + t, layouts + l, filters + f, scales[ z ], split_counts[ s ], match );
+          }
+        }
+      }
+    }
+  }
+}
+
+static int save_results( char const * filename )
+{
+  FILE * f;
+  int i;
+
+  #ifdef _MSC_VER
+    if ( fopen_s( &f, filename, "w" ) != 0 ) f = 0;
+  #else
+    f = fopen( filename, "w" );
+  #endif
+  if ( f == 0 )
+    return 0;
+
+  // one result per line, so load_baseline doesn't need a real json parser
+  fprintf( f, "{\n  \"simd\": \"%s\",\n  \"input\": [ %d, %d ],\n  \"repeats\": %d,\n  \"results\": [\n", SIMD_NAME, in_w, in_h, repeats );
+  for( i = 0 ; i < result_count ; i++ )
+    fprintf( f, "    { \"name\": \"%s\", \"mpix_per_sec\": %.3f, \"cycles_per_pixel\": %.4f }%s\n", results[ i ].name, results[ i ].mpix_per_sec, results[ i ].cycles_per_pixel, ( i + 1 < result_count ) ? "," : "" );
+  fprintf( f, "  ]\n}\n" );
+
+  fclose( f );
+  return 1;
+}
+
+static int load_baseline( char const * filename )
+{
+  char line[ 512 ];
+  FILE * f;
+
+  #ifdef _MSC_VER
+    if ( fopen_s( &f, filename, "r" ) != 0 ) f = 0;
+  #else
+    f = fopen( filename, "r" );
+  #endif
+  if ( f == 0 )
+    return 0;
+
+  while( ( baseline_count < MAX_RESULTS ) && ( fgets( line, sizeof( line ), f ) ) )
+  {
+    result * b = baseline + baseline_count;
+    char * p = strstr( line, "\"name\": \"" );
+    char * e;
+
+    if ( p == 0 )
+    {
+      p = strstr( line, "\"input\": [" );
+      if ( p )
+        sscanf( p + 10, "%d ,%d", &baseline_w, &baseline_h );
+      continue;
+    }
+    p += 9;
+    e = strchr( p, '"' );
+    if ( ( e == 0 ) || ( ( e - p ) >= (int) sizeof( b->name ) ) )
+      continue;
+    memcpy( b->name, p, e - p );
+    b->name[ e - p ] = 0;
+
+    p = strstr( e, "\"mpix_per_sec\":" );
+    e = strstr( e, "\"cycles_per_pixel\":" );
+    if ( ( p == 0 ) || ( e == 0 ) )
+      continue;
+    b->mpix_per_sec = atof( p + 15 );
+    b->cycles_per_pixel = atof( e + 19 );
+    ++baseline_count;
+  }
+
+  fclose( f );
+  return 1;
+}
+
+// compares cycles per pixel (less noisy than wall clock time on a busy machine)
+static int compare_baseline( double threshold )
+{
+  int i, j, regressions = 0, improvements = 0, compared = 0;
+  double log_sum = 0;
+
+  printf( "\ncompared to the baseline (cycles/pix, regressions past %.1f%%):\n\n", threshold );
+
+  for( i = 0 ; i < result_count ; i++ )
+  {
+    for( j = 0 ; j < baseline_count ; j++ )
+      if ( strcmp( results[ i ].name, baseline[ j ].name ) == 0 )
+        break;
+
+    if ( j == baseline_count )
+    {
+      printf( "%-32s not in the baseline\n", results[ i ].name );
+      continue;
+    }
+
+    if ( baseline[ j ].cycles_per_pixel > 0.0 )
+    {
+      double ratio = results[ i ].cycles_per_pixel / baseline[ j ].cycles_per_pixel;
+      double pct = ( ratio - 1.0 ) * 100.0;
+      char const * mark = "";
+
+      if ( pct > threshold )
+      {
+        mark = "  REGRESSION";
+        ++regressions;
+      }
+      else if ( pct < -threshold )
+      {
+        mark = "  faster";
+        ++improvements;
+      }
+
+      if ( mark[ 0 ] )
+        printf( "%-32s %9.2f -> %9.2f cycles/pix %+7.1f%%%s\n", results[ i ].name, baseline[ j ].cycles_per_pixel, results[ i ].cycles_per_pixel, pct, mark );
+
+      // geometric mean, so a few huge ratios don't swamp it
+      log_sum += log( ratio );
+      ++compared;
+    }
+  }
+
+  if ( compared )
+  {
+    printf( "\n%d cases compared, %d regressed, %d faster, overall %+.1f%% cycles/pix\n", compared, regressions, improvements, ( exp( log_sum / compared ) - 1.0 ) * 100.0 );
+  }
+
+  return regressions;
+}
+
+int main( int argc, char ** argv )
+{
+  char const * save_file = 0, * baseline_file = 0, * match = 0;
+  double threshold = 10.0;
+  int full = 0, i, regressions = 0;
+  size_t in_size, out_size;
+
+  for( i = 1 ; i < argc ; i++ )
+  {
+    if ( strcmp( argv[ i ], "-full" ) == 0 )
+      full = 1;
+    else if ( ( strcmp( argv[ i ], "-size" ) == 0 ) && ( i + 2 < argc ) )
+    {
+      in_w = atoi( argv[ ++i ] );
+      in_h = atoi( argv[ ++i ] );
+    }
+    else if ( ( strcmp( argv[ i ], "-repeats" ) == 0 ) && ( i + 1 < argc ) )
+      repeats = atoi( argv[ ++i ] );
+    else if ( ( strcmp( argv[ i ], "-match" ) == 0 ) && ( i + 1 < argc ) )
+      match = argv[ ++i ];
+    else if ( ( strcmp( argv[ i ], "-save" ) == 0 ) && ( i + 1 < argc ) )
+      save_file = argv[ ++i ];
+    else if ( ( strcmp( argv[ i ], "-baseline" ) == 0 ) && ( i + 1 < argc ) )
+      baseline_file = argv[ ++i ];
+    else if ( ( strcmp( argv[ i ], "-threshold" ) == 0 ) && ( i + 1 < argc ) )
+      threshold = atof( argv[ ++i ] );
+    else
+    {
+      printf( "usage: benchmark [-full] [-size w h] [-repeats n] [-match text] [-save file] [-baseline file] [-threshold pct]\n" );
+      return 2;
+    }
+  }
+
+  if ( ( in_w < 8 ) || ( in_h < 8 ) || ( repeats < 1 ) )
+    return 2;
+
+  if ( baseline_file )
+  {
+    if ( !load_baseline( baseline_file ) )
+    {
+      printf( "couldn't read %s\n", baseline_file );
+      return 2;
+    }
+
+    // the case names don't include the input size, so don't compare different sizes
+    if ( ( baseline_w != in_w ) || ( baseline_h != in_h ) )
+    {
+      printf( "%s was run on a %dx%d input, use -size %d %d\n", baseline_file, baseline_w, baseline_h, baseline_w, baseline_h );
+      return 2;
+    }
+  }
+
+  // input is at most 4 floats a pixel, output is at most that at the largest scale
+  //   (and the output buffer also holds the 2 channel staging for make_input)
+  in_size = (size_t) in_w * in_h * 16;
+  out_size = in_size;
+  for( i = 0 ; i < COUNT( scales ) ; i++ )
+  {
+    size_t s = (size_t) ( in_w * scales[ i ][ 0 ] / scales[ i ][ 1 ] ) * ( in_h * scales[ i ][ 0 ] / scales[ i ][ 1 ] ) * 16;
+    if ( s > out_size ) out_size = s;
+  }
+
+  corpus = (float *) malloc( in_size );
+  input = malloc( in_size );
+  output = malloc( out_size );
+  if ( ( corpus == 0 ) || ( input == 0 ) || ( output == 0 ) )
+    return 1;
+
+  make_corpus();
+
+  printf( "%dx%d input, %s, best of %d\n\n", in_w, in_h, SIMD_NAME, repeats );
+
+  run_sweep( full, match );
+
+  if ( save_file )
+  {
+    if ( !save_results( save_file ) )
+      printf( "couldn't write %s\n", save_file );
+    else
+      printf( "\nsaved %d results to %s\n", result_count, save_file );
+  }
+
+  if ( baseline_file )
+    regressions = compare_baseline( threshold );
+
+  free( output );
+  free( input );
+  free( corpus );
+  return ( regressions ) ? 1 : 0;
+}
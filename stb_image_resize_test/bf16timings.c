@@ -0,0 +1,183 @@
+// Times resizing straight into (and out of) bfloat16 against resizing to float and
+//   converting in a second pass, and checks that they produce the same bits.
+//
+//   gcc -O2 bf16timings.c -I.. -lm -o bf16timings
+//   bf16timings [input_w input_h]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+
+#include <windows.h>
+
+static double get_milliseconds()
+{
+  LARGE_INTEGER c, f;
+  QueryPerformanceCounter( &c );
+  QueryPerformanceFrequency( &f );
+  return (double) c.QuadPart * 1000.0 / (double) f.QuadPart;
+}
+
+#else
+
+#include <time.h>
+
+static double get_milliseconds()
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (double) ts.tv_sec * 1000.0 + (double) ts.tv_nsec / 1000000.0;
+}
+
+#endif
+
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include "stb_image_resize2.h"
+
+#define REPEATS 5
+
+// round to nearest even, the same as the resizer
+static unsigned short to_bf16( float f )
+{
+  unsigned int u;
+  memcpy( &u, &f, 4 );
+  if ( ( u & 0x7fffffff ) > 0x7f800000 )
+    return (unsigned short) ( ( u >> 16 ) | 0x40 );
+  return (unsigned short) ( ( u + 0x7fff + ( ( u >> 16 ) & 1 ) ) >> 16 );
+}
+
+static float from_bf16( unsigned short h )
+{
+  unsigned int u = ( (unsigned int) h ) << 16;
+  float f;
+  memcpy( &f, &u, 4 );
+  return f;
+}
+
+typedef struct
+{
+  char const * name;
+  stbir_pixel_layout layout;
+  stbir_datatype type;
+  int channels;
+} test_case;
+
+static test_case cases[] =
+{
+  { "u8 rgb -> bf16 rgb",     STBIR_RGB,      STBIR_TYPE_UINT8,      3 },
+  { "u8 srgb rgba -> bf16",   STBIR_RGBA,     STBIR_TYPE_UINT8_SRGB, 4 },
+  { "u8 1ch -> bf16",         STBIR_1CHANNEL, STBIR_TYPE_UINT8,      1 },
+  { "u8 bgra -> bf16 rgba",   STBIR_BGRA,     STBIR_TYPE_UINT8,      4 },
+};
+
+int main( int argc, char ** argv )
+{
+  int in_w = ( argc > 2 ) ? atoi( argv[1] ) : 1920;
+  int in_h = ( argc > 2 ) ? atoi( argv[2] ) : 1080;
+  int out_w = 224 * 2, out_h = 224 * 2;
+  size_t in_count = (size_t) in_w * in_h * 4, out_count = (size_t) out_w * out_h * 4;
+  unsigned char * input;
+  unsigned short * input_bf16, * output, * reference;
+  float * input_float, * floats;
+  int c, r, failed = 0;
+  size_t i;
+
+  input = (unsigned char *) malloc( in_count );
+  input_bf16 = (unsigned short *) malloc( in_count * 2 );
+  input_float = (float *) malloc( in_count * 4 );
+  output = (unsigned short *) malloc( out_count * 2 );
+  reference = (unsigned short *) malloc( out_count * 2 );
+  floats = (float *) malloc( out_count * 4 );
+  if ( ( input == 0 ) || ( input_bf16 == 0 ) || ( input_float == 0 ) || ( output == 0 ) || ( reference == 0 ) || ( floats == 0 ) )
+    return 1;
+
+  for( i = 0 ; i < in_count ; i++ )
+  {
+    input[ i ] = (unsigned char) ( ( i * 2654435761u ) >> 24 );
+    input_bf16[ i ] = to_bf16( (float) input[ i ] / 255.0f - 0.5f );
+    input_float[ i ] = from_bf16( input_bf16[ i ] );
+  }
+
+  printf( "%dx%d input to %dx%d, best of %d\n\n", in_w, in_h, out_w, out_h, REPEATS );
+
+  for( c = 0 ; c < (int) ( sizeof( cases ) / sizeof( cases[0] ) ) ; c++ )
+  {
+    test_case const * tc = cases + c;
+    stbir_pixel_layout out_layout = ( tc->layout == STBIR_BGRA ) ? STBIR_RGBA : tc->layout;
+    size_t n = (size_t) out_w * out_h * tc->channels;
+    double two_pass = 1e30, direct = 1e30;
+    STBIR_RESIZE resize;
+
+    for( r = 0 ; r < REPEATS ; r++ )
+    {
+      double t = get_milliseconds();
+      stbir_resize_init( &resize, input, in_w, in_h, 0, floats, out_w, out_h, 0, tc->layout, tc->type );
+      stbir_set_datatypes( &resize, tc->type, STBIR_TYPE_FLOAT );
+      stbir_set_pixel_layouts( &resize, tc->layout, out_layout );
+      stbir_resize_extended( &resize );
+      for( i = 0 ; i < n ; i++ )
+        reference[ i ] = to_bf16( floats[ i ] );
+      t = get_milliseconds() - t;
+      if ( t < two_pass )
+        two_pass = t;
+
+      t = get_milliseconds();
+      stbir_resize_init( &resize, input, in_w, in_h, 0, output, out_w, out_h, 0, tc->layout, tc->type );
+      stbir_set_datatypes( &resize, tc->type, STBIR_TYPE_BFLOAT16 );
+      stbir_set_pixel_layouts( &resize, tc->layout, out_layout );
+      stbir_resize_extended( &resize );
+      t = get_milliseconds() - t;
+      if ( t < direct )
+        direct = t;
+    }
+
+    if ( memcmp( reference, output, n * 2 ) != 0 )
+    {
+      printf( "  MISMATCH!\n" );
+      failed = 1;
+    }
+
+    printf( "%-22s float + convert: %7.2f ms  direct: %7.2f ms  %5.2fx\n", tc->name, two_pass, direct, two_pass / direct );
+  }
+
+  // bfloat16 in: should match the same values handed in as floats
+  {
+    double from_float = 1e30, from_bf16_ms = 1e30;
+
+    for( r = 0 ; r < REPEATS ; r++ )
+    {
+      double t = get_milliseconds();
+      stbir_resize( input_float, in_w, in_h, 0, floats, out_w, out_h, 0, STBIR_4CHANNEL, STBIR_TYPE_FLOAT, STBIR_EDGE_CLAMP, STBIR_FILTER_DEFAULT );
+      t = get_milliseconds() - t;
+      if ( t < from_float )
+        from_float = t;
+
+      t = get_milliseconds();
+      stbir_resize( input_bf16, in_w, in_h, 0, output, out_w, out_h, 0, STBIR_4CHANNEL, STBIR_TYPE_BFLOAT16, STBIR_EDGE_CLAMP, STBIR_FILTER_DEFAULT );
+      t = get_milliseconds() - t;
+      if ( t < from_bf16_ms )
+        from_bf16_ms = t;
+    }
+
+    for( i = 0 ; i < out_count ; i++ )
+      if ( to_bf16( floats[ i ] ) != output[ i ] )
+        break;
+    if ( i != out_count )
+    {
+      printf( "  MISMATCH!\n" );
+      failed = 1;
+    }
+
+    printf( "%-22s float in: %7.2f ms  bf16 in: %7.2f ms\n", "bf16 4ch -> bf16 4ch", from_float, from_bf16_ms );
+  }
+
+  free( floats );
+  free( reference );
+  free( output );
+  free( input_float );
+  free( input_bf16 );
+  free( input );
+  return failed;
+}
@@ -0,0 +1,207 @@
+// Times resizing with an output color matrix (stbir_set_output_color_matrix) against
+//   resizing to linear float, applying the matrix in a second pass and then encoding,
+//   and checks that the two agree (to within 1 for 8-bit outputs).
+//
+//   gcc -O2 colormatrixtimings.c -I.. -lm -o colormatrixtimings
+//   colormatrixtimings [input_w input_h]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _MSC_VER
+
+#include <windows.h>
+
+static double get_milliseconds()
+{
+  LARGE_INTEGER c, f;
+  QueryPerformanceCounter( &c );
+  QueryPerformanceFrequency( &f );
+  return (double) c.QuadPart * 1000.0 / (double) f.QuadPart;
+}
+
+#else
+
+#include <time.h>
+
+static double get_milliseconds()
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (double) ts.tv_sec * 1000.0 + (double) ts.tv_nsec / 1000000.0;
+}
+
+#endif
+
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include "stb_image_resize2.h"
+
+#define REPEATS 5
+
+// a bit of saturation, a warm tint and some lift - pushes values out of 0 to 1 too
+static float const matrix[ 12 ] =
+{
+   1.20f, -0.10f, -0.10f,  0.02f,
+  -0.05f,  1.10f, -0.05f,  0.00f,
+   0.00f, -0.20f,  1.20f, -0.03f,
+};
+
+typedef struct
+{
+  char const * name;
+  stbir_pixel_layout in_layout, out_layout;
+  stbir_datatype in_type, out_type;
+  int channels;
+  int r, g, b, a;  // where r, g, b and alpha are in the output pixel (a < 0 for none)
+  int premultiplied;
+} test_case;
+
+static test_case cases[] =
+{
+  { "srgb rgba -> rgba",      STBIR_RGBA, STBIR_RGBA,    STBIR_TYPE_UINT8_SRGB, STBIR_TYPE_UINT8_SRGB, 4, 0, 1, 2, 3,  0 },
+  { "srgb rgba -> bgra_pm",   STBIR_RGBA, STBIR_BGRA_PM, STBIR_TYPE_UINT8_SRGB, STBIR_TYPE_UINT8_SRGB, 4, 2, 1, 0, 3,  1 },
+  { "u8 rgb -> bgr",          STBIR_RGB,  STBIR_BGR,     STBIR_TYPE_UINT8,      STBIR_TYPE_UINT8,      3, 2, 1, 0, -1, 0 },
+  { "float rgba -> rgba",     STBIR_RGBA, STBIR_RGBA,    STBIR_TYPE_FLOAT,      STBIR_TYPE_FLOAT,      4, 0, 1, 2, 3,  0 },
+};
+
+// the second pass: the matrix on linear floats, laid out as the output
+static void apply_matrix( float * p, size_t pixels, test_case const * tc )
+{
+  size_t i;
+  for( i = 0 ; i < pixels ; i++, p += tc->channels )
+  {
+    float r = p[ tc->r ], g = p[ tc->g ], b = p[ tc->b ];
+    float o = ( tc->premultiplied ) ? p[ tc->a ] : 1.0f;
+    p[ tc->r ] = matrix[ 0 ] * r + matrix[ 1 ] * g + matrix[ 2 ]  * b + matrix[ 3 ]  * o;
+    p[ tc->g ] = matrix[ 4 ] * r + matrix[ 5 ] * g + matrix[ 6 ]  * b + matrix[ 7 ]  * o;
+    p[ tc->b ] = matrix[ 8 ] * r + matrix[ 9 ] * g + matrix[ 10 ] * b + matrix[ 11 ] * o;
+  }
+}
+
+int main( int argc, char ** argv )
+{
+  int in_w = ( argc > 2 ) ? atoi( argv[1] ) : 1920;
+  int in_h = ( argc > 2 ) ? atoi( argv[2] ) : 1080;
+  int out_w = 1280, out_h = 720;
+  size_t in_count = (size_t) in_w * in_h * 4, out_count = (size_t) out_w * out_h * 4;
+  unsigned char * input;
+  float * input_float, * floats, * output_float, * reference_float;
+  unsigned char * output, * reference;
+  int c, r, failed = 0;
+  size_t i;
+
+  input = (unsigned char *) malloc( in_count );
+  input_float = (float *) malloc( in_count * 4 );
+  floats = (float *) malloc( out_count * 4 );
+  output_float = (float *) malloc( out_count * 4 );
+  reference_float = (float *) malloc( out_count * 4 );
+  output = (unsigned char *) malloc( out_count );
+  reference = (unsigned char *) malloc( out_count );
+  if ( ( input == 0 ) || ( input_float == 0 ) || ( floats == 0 ) || ( output_float == 0 ) || ( reference_float == 0 ) || ( output == 0 ) || ( reference == 0 ) )
+    return 1;
+
+  for( i = 0 ; i < in_count ; i++ )
+  {
+    input[ i ] = (unsigned char) ( ( i * 2654435761u ) >> 24 );
+    // keep some of the alphas at 0 and 255
+    if ( ( i & 3 ) == 3 )
+      input[ i ] = ( ( i >> 2 ) % 7 == 0 ) ? 0 : ( ( ( i >> 2 ) % 7 == 1 ) ? 255 : input[ i ] );
+    input_float[ i ] = (float) input[ i ] / 255.0f;
+  }
+
+  printf( "%dx%d input to %dx%d, best of %d\n\n", in_w, in_h, out_w, out_h, REPEATS );
+
+  for( c = 0 ; c < (int) ( sizeof( cases ) / sizeof( cases[0] ) ) ; c++ )
+  {
+    test_case const * tc = cases + c;
+    int is_float = ( tc->out_type == STBIR_TYPE_FLOAT );
+    void const * in = ( tc->in_type == STBIR_TYPE_FLOAT ) ? (void const *) input_float : (void const *) input;
+    void * out = is_float ? (void *) output_float : (void *) output;
+    size_t n = (size_t) out_w * out_h * tc->channels;
+    double plain = 1e30, fused = 1e30, two_pass = 1e30, max_diff = 0.0;
+    STBIR_RESIZE resize;
+
+    for( r = 0 ; r < REPEATS ; r++ )
+    {
+      double t = get_milliseconds();
+      stbir_resize_init( &resize, in, in_w, in_h, 0, out, out_w, out_h, 0, tc->in_layout, tc->in_type );
+      stbir_set_datatypes( &resize, tc->in_type, tc->out_type );
+      stbir_set_pixel_layouts( &resize, tc->in_layout, tc->out_layout );
+      stbir_resize_extended( &resize );
+      t = get_milliseconds() - t;
+      if ( t < plain )
+        plain = t;
+
+      t = get_milliseconds();
+      stbir_resize_init( &resize, in, in_w, in_h, 0, out, out_w, out_h, 0, tc->in_layout, tc->in_type );
+      stbir_set_datatypes( &resize, tc->in_type, tc->out_type );
+      stbir_set_pixel_layouts( &resize, tc->in_layout, tc->out_layout );
+      if ( !stbir_set_output_color_matrix( &resize, matrix ) )
+      {
+        printf( "  matrix refused!\n" );
+        failed = 1;
+      }
+      stbir_resize_extended( &resize );
+      t = get_milliseconds() - t;
+      if ( t < fused )
+        fused = t;
+
+      // resize to linear float, matrix, then encode with a 1:1 box "resize" (which is a straight copy)
+      t = get_milliseconds();
+      stbir_resize_init( &resize, in, in_w, in_h, 0, floats, out_w, out_h, 0, tc->in_layout, tc->in_type );
+      stbir_set_datatypes( &resize, tc->in_type, STBIR_TYPE_FLOAT );
+      stbir_set_pixel_layouts( &resize, tc->in_layout, tc->out_layout );
+      stbir_resize_extended( &resize );
+      apply_matrix( floats, (size_t) out_w * out_h, tc );
+      if ( is_float )
+        memcpy( reference_float, floats, n * 4 );
+      else
+      {
+        stbir_resize_init( &resize, floats, out_w, out_h, 0, reference, out_w, out_h, 0, tc->out_layout, STBIR_TYPE_FLOAT );
+        stbir_set_datatypes( &resize, STBIR_TYPE_FLOAT, tc->out_type );
+        stbir_set_filters( &resize, STBIR_FILTER_BOX, STBIR_FILTER_BOX );
+        stbir_resize_extended( &resize );
+      }
+      t = get_milliseconds() - t;
+      if ( t < two_pass )
+        two_pass = t;
+    }
+
+    for( i = 0 ; i < n ; i++ )
+    {
+      // float output isn't clamped, and un-premultiplying by tiny alphas makes big values, so compare floats relatively
+      double d = is_float ? fabs( (double) output_float[ i ] - (double) reference_float[ i ] ) / ( fabs( (double) reference_float[ i ] ) + 1.0 ) : fabs( (double) output[ i ] - (double) reference[ i ] );
+      if ( d > max_diff )
+        max_diff = d;
+    }
+    if ( max_diff > ( is_float ? 0.0001 : 1.0 ) )
+    {
+      printf( "  MISMATCH! (max diff %g)\n", max_diff );
+      failed = 1;
+    }
+
+    printf( "%-22s no matrix: %7.2f ms  fused: %7.2f ms  two pass: %7.2f ms  %5.2fx  max diff: %g\n", tc->name, plain, fused, two_pass, two_pass / fused, max_diff );
+  }
+
+  // 1 and 2 channel layouts refuse a matrix
+  {
+    STBIR_RESIZE resize;
+    stbir_resize_init( &resize, input, in_w, in_h, 0, output, out_w, out_h, 0, STBIR_2CHANNEL, STBIR_TYPE_UINT8 );
+    if ( stbir_set_output_color_matrix( &resize, matrix ) )
+    {
+      printf( "  2 channel matrix accepted!\n" );
+      failed = 1;
+    }
+  }
+
+  free( reference );
+  free( output );
+  free( reference_float );
+  free( output_float );
+  free( floats );
+  free( input_float );
+  free( input );
+  return failed;
+}
@@ -0,0 +1,146 @@
+// Times uint8 resizes with and without stbir_set_uint8_fixed_point, and reports
+//   how far apart the two results are (the fixed point path should be within 1).
+//   The reductions it isn't picked for (where it was timed slower) show as falling
+//   back to float.
+//
+//   gcc -O2 fixedtimings.c -I.. -lm -o fixedtimings
+//   fixedtimings [input_w input_h]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+
+#include <windows.h>
+
+static double get_milliseconds()
+{
+  LARGE_INTEGER c, f;
+  QueryPerformanceCounter( &c );
+  QueryPerformanceFrequency( &f );
+  return (double) c.QuadPart * 1000.0 / (double) f.QuadPart;
+}
+
+#else
+
+#include <time.h>
+
+static double get_milliseconds()
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (double) ts.tv_sec * 1000.0 + (double) ts.tv_nsec / 1000000.0;
+}
+
+#endif
+
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include "stb_image_resize2.h"
+
+#define REPEATS 25
+
+typedef struct
+{
+  char const * name;
+  int out_w_num, out_w_den, out_h_num, out_h_den;
+  stbir_pixel_layout layout;
+  int channels;
+} test_case;
+
+static test_case cases[] =
+{
+  { "down 1/4 4ch",     1,4,   1,4,   STBIR_4CHANNEL, 4 },
+  { "down 1/8 rgba pm", 1,8,   1,8,   STBIR_RGBA_PM,  4 },
+  { "down 1/2 4ch",     1,2,   1,2,   STBIR_4CHANNEL, 4 },
+  { "down 2/3 4ch",     2,3,   2,3,   STBIR_4CHANNEL, 4 },
+  { "down 1/4 rgb",     1,4,   1,4,   STBIR_RGB,      3 },
+  { "down 1/2 rgb",     1,2,   1,2,   STBIR_RGB,      3 },
+  { "down 1/4 1ch",     1,4,   1,4,   STBIR_1CHANNEL, 1 },
+  { "down 1/4 2ch",     1,4,   1,4,   STBIR_2CHANNEL, 2 },
+  { "down 1/8 2ch",     1,8,   1,8,   STBIR_2CHANNEL, 2 },
+  { "up 3/2 4ch",       3,2,   3,2,   STBIR_4CHANNEL, 4 },
+};
+
+// alternates the two resizes, so a noisy machine slows both alike
+static void time_resizes( STBIR_RESIZE * a, STBIR_RESIZE * b, double * a_ms, double * b_ms )
+{
+  int i;
+
+  *a_ms = *b_ms = 1e30;
+  for( i = 0 ; i < REPEATS ; i++ )
+  {
+    double t = get_milliseconds();
+    stbir_resize_extended( a );
+    t = get_milliseconds() - t;
+    if ( t < *a_ms )
+      *a_ms = t;
+
+    t = get_milliseconds();
+    stbir_resize_extended( b );
+    t = get_milliseconds() - t;
+    if ( t < *b_ms )
+      *b_ms = t;
+  }
+}
+
+int main( int argc, char ** argv )
+{
+  int in_w = ( argc > 2 ) ? atoi( argv[1] ) : 1920;
+  int in_h = ( argc > 2 ) ? atoi( argv[2] ) : 1080;
+  unsigned char * input;
+  int c, i;
+
+  input = (unsigned char *) malloc( (size_t) in_w * in_h * 4 );
+  if ( input == 0 )
+    return 1;
+
+  for( i = 0 ; i < in_w * in_h * 4 ; i++ )
+    input[ i ] = (unsigned char) ( ( i * 2654435761u ) >> 24 );
+
+  printf( "%dx%d input, best of %d\n\n", in_w, in_h, REPEATS );
+
+  for( c = 0 ; c < (int) ( sizeof( cases ) / sizeof( cases[0] ) ) ; c++ )
+  {
+    test_case const * tc = cases + c;
+    int out_w = in_w * tc->out_w_num / tc->out_w_den;
+    int out_h = in_h * tc->out_h_num / tc->out_h_den;
+    size_t out_size = (size_t) out_w * out_h * tc->channels;
+    unsigned char * reference = (unsigned char *) malloc( out_size );
+    unsigned char * output = (unsigned char *) malloc( out_size );
+    STBIR_RESIZE float_resize, fixed_resize;
+    double float_ms, fixed_ms;
+    int used, max_diff = 0;
+    size_t j;
+
+    if ( ( reference == 0 ) || ( output == 0 ) )
+      return 1;
+
+    stbir_resize_init( &float_resize, input, in_w, in_h, 0, reference, out_w, out_h, 0, tc->layout, STBIR_TYPE_UINT8 );
+    stbir_build_samplers( &float_resize );
+
+    stbir_resize_init( &fixed_resize, input, in_w, in_h, 0, output, out_w, out_h, 0, tc->layout, STBIR_TYPE_UINT8 );
+    stbir_set_uint8_fixed_point( &fixed_resize, 1 );
+    stbir_build_samplers( &fixed_resize );
+    used = fixed_resize.samplers->fixed_point;
+
+    time_resizes( &float_resize, &fixed_resize, &float_ms, &fixed_ms );
+    stbir_free_samplers( &fixed_resize );
+    stbir_free_samplers( &float_resize );
+
+    for( j = 0 ; j < out_size ; j++ )
+    {
+      int d = reference[ j ] - output[ j ];
+      if ( d < 0 ) d = -d;
+      if ( d > max_diff ) max_diff = d;
+    }
+
+    printf( "%-18s %5dx%-5d float: %7.2f ms  fixed: %7.2f ms  %5.2fx  max diff %d%s\n", tc->name, out_w, out_h, float_ms, fixed_ms, float_ms / fixed_ms, max_diff, ( used ) ? "" : "  (fell back to float)" );
+
+    free( output );
+    free( reference );
+  }
+
+  free( input );
+  return 0;
+}
@@ -0,0 +1,149 @@
+// Times building a whole mip chain with stbir_resize_mipmaps_extended against
+//   calling stbir_resize from the original image for every level, and reports
+//   how far apart the two results are.
+//
+//   gcc -O2 miptimings.c -I.. -lm -o miptimings
+//   miptimings [input_w input_h]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+
+#include <windows.h>
+
+static double get_milliseconds()
+{
+  LARGE_INTEGER c, f;
+  QueryPerformanceCounter( &c );
+  QueryPerformanceFrequency( &f );
+  return (double) c.QuadPart * 1000.0 / (double) f.QuadPart;
+}
+
+#else
+
+#include <time.h>
+
+static double get_milliseconds()
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (double) ts.tv_sec * 1000.0 + (double) ts.tv_nsec / 1000000.0;
+}
+
+#endif
+
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include "stb_image_resize2.h"
+
+#define REPEATS 5
+#define MAX_LEVELS 32
+
+typedef struct
+{
+  char const * name;
+  stbir_pixel_layout layout;
+  stbir_datatype type;
+  int channels, type_size;
+} test_case;
+
+static test_case cases[] =
+{
+  { "rgba srgb",      STBIR_RGBA,     STBIR_TYPE_UINT8_SRGB, 4, 1 },
+  { "rgba linear",    STBIR_RGBA,     STBIR_TYPE_UINT8,      4, 1 },
+  { "rgb srgb",       STBIR_RGB,      STBIR_TYPE_UINT8_SRGB, 3, 1 },
+  { "rgba pm uint16", STBIR_RGBA_PM,  STBIR_TYPE_UINT16,     4, 2 },
+  { "4ch float",      STBIR_4CHANNEL, STBIR_TYPE_FLOAT,      4, 4 },
+};
+
+int main( int argc, char ** argv )
+{
+  int in_w = ( argc > 2 ) ? atoi( argv[1] ) : 2048;
+  int in_h = ( argc > 2 ) ? atoi( argv[2] ) : 2048;
+  void * levels[ MAX_LEVELS ];
+  void * reference[ MAX_LEVELS ];
+  unsigned char * input;
+  int c, i, r;
+
+  input = (unsigned char *) malloc( (size_t) in_w * in_h * 16 );
+  if ( input == 0 )
+    return 1;
+
+  // noise-ish pattern, valid as both integers and (0 to 1) floats
+  for( i = 0 ; i < in_w * in_h * 4 ; i++ )
+    ( (float*) input )[ i ] = (float) ( ( i * 2654435761u ) >> 24 ) / 255.0f;
+
+  printf( "%dx%d input, full chain, best of %d\n\n", in_w, in_h, REPEATS );
+
+  for( c = 0 ; c < (int) ( sizeof( cases ) / sizeof( cases[0] ) ) ; c++ )
+  {
+    test_case const * tc = cases + c;
+    double per_level = 1e30, chain = 1e30, build;
+    STBIR_MIPMAPS mips;
+    int max_diff = 0;
+
+    build = get_milliseconds();
+    if ( !stbir_build_mipmaps( &mips, in_w, in_h, 0, tc->layout, tc->type, STBIR_EDGE_CLAMP, STBIR_FILTER_DEFAULT, 0 ) )
+      return 1;
+    build = get_milliseconds() - build;
+
+    for( i = 0 ; i < mips.levels ; i++ )
+    {
+      int w = in_w >> ( i + 1 ), h = in_h >> ( i + 1 );
+      size_t size = (size_t) ( w ? w : 1 ) * ( h ? h : 1 ) * tc->channels * tc->type_size;
+      levels[ i ] = malloc( size );
+      reference[ i ] = malloc( size );
+    }
+
+    for( r = 0 ; r < REPEATS ; r++ )
+    {
+      double t = get_milliseconds();
+      for( i = 0 ; i < mips.levels ; i++ )
+      {
+        int w = in_w >> ( i + 1 ), h = in_h >> ( i + 1 );
+        stbir_resize( input, in_w, in_h, 0, reference[ i ], w ? w : 1, h ? h : 1, 0, tc->layout, tc->type, STBIR_EDGE_CLAMP, STBIR_FILTER_DEFAULT );
+      }
+      t = get_milliseconds() - t;
+      if ( t < per_level )
+        per_level = t;
+
+      t = get_milliseconds();
+      stbir_resize_mipmaps_extended( &mips, input, 0, levels, 0 );
+      t = get_milliseconds() - t;
+      if ( t < chain )
+        chain = t;
+    }
+
+    // the chain resizes level to level, so it's close to, but not exactly, the per-level result
+    if ( tc->type_size == 1 )
+    {
+      for( i = 0 ; i < mips.levels ; i++ )
+      {
+        int w = in_w >> ( i + 1 ), h = in_h >> ( i + 1 );
+        int j, n = ( w ? w : 1 ) * ( h ? h : 1 ) * tc->channels;
+        for( j = 0 ; j < n ; j++ )
+        {
+          int d = ( (unsigned char*) levels[ i ] )[ j ] - ( (unsigned char*) reference[ i ] )[ j ];
+          if ( d < 0 ) d = -d;
+          if ( d > max_diff ) max_diff = d;
+        }
+      }
+    }
+
+    printf( "%-16s %2d levels  per-level: %8.2f ms  chain: %8.2f ms (+%.2f ms build)  %5.2fx", tc->name, mips.levels, per_level, chain, build, per_level / chain );
+    if ( tc->type_size == 1 )
+      printf( "  max diff %d", max_diff );
+    printf( "\n" );
+
+    for( i = 0 ; i < mips.levels ; i++ )
+    {
+      free( levels[ i ] );
+      free( reference[ i ] );
+    }
+    stbir_free_mipmaps( &mips );
+  }
+
+  free( input );
+  return 0;
+}
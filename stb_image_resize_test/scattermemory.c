@@ -0,0 +1,104 @@
+// Reports the working memory and time of very tall downsamples (which scatter vertically),
+//   using the memory fields of STBIR_PROFILE_INFO.
+//
+//   gcc -O2 scattermemory.c -I.. -lm -o scattermemory
+//   scattermemory [input_w input_h]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STBIR_PROFILE
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include "stb_image_resize2.h"
+
+#ifdef _MSC_VER
+
+#include <windows.h>
+
+static double get_milliseconds()
+{
+  LARGE_INTEGER c, f;
+  QueryPerformanceCounter( &c );
+  QueryPerformanceFrequency( &f );
+  return (double) c.QuadPart * 1000.0 / (double) f.QuadPart;
+}
+
+#else
+
+#include <time.h>
+
+static double get_milliseconds()
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (double) ts.tv_sec * 1000.0 + (double) ts.tv_nsec / 1000000.0;
+}
+
+#endif
+
+#define REPEATS 5
+
+// output heights, as a divisor of the input height
+static int divisors[] = { 4, 16, 64, 256, 1024 };
+
+static int split_counts[] = { 1, 4 };
+
+int main( int argc, char ** argv )
+{
+  int in_w = ( argc > 2 ) ? atoi( argv[1] ) : 512;
+  int in_h = ( argc > 2 ) ? atoi( argv[2] ) : 32768;
+  size_t in_count = (size_t) in_w * in_h * 4;
+  float * input, * output;
+  int d, s, r;
+  size_t i;
+
+  input = (float *) malloc( in_count * sizeof( float ) );
+  output = (float *) malloc( (size_t) in_w * ( in_h / divisors[ 0 ] ) * 4 * sizeof( float ) );
+  if ( ( input == 0 ) || ( output == 0 ) )
+    return 1;
+
+  for( i = 0 ; i < in_count ; i++ )
+    input[ i ] = (float) ( ( i * 2654435761u ) >> 24 ) / 255.0f;
+
+  printf( "%dx%d 4ch float input, width kept, best of %d\n\n", in_w, in_h, REPEATS );
+
+  for( d = 0 ; d < (int) ( sizeof( divisors ) / sizeof( divisors[0] ) ) ; d++ )
+  {
+    int out_h = in_h / divisors[ d ];
+
+    for( s = 0 ; s < (int) ( sizeof( split_counts ) / sizeof( split_counts[0] ) ) ; s++ )
+    {
+      STBIR_RESIZE resize;
+      STBIR_PROFILE_INFO profile;
+      double best = 1e30;
+      int splits;
+
+      stbir_resize_init( &resize, input, in_w, in_h, 0, output, in_w, out_h, 0, STBIR_4CHANNEL, STBIR_TYPE_FLOAT );
+      splits = stbir_build_samplers_with_splits( &resize, split_counts[ s ] );
+      if ( splits == 0 )
+        return 1;
+
+      for( r = 0 ; r < REPEATS ; r++ )
+      {
+        double t = get_milliseconds();
+        for( i = 0 ; i < (size_t) splits ; i++ )
+          stbir_resize_extended_split( &resize, (int) i, 1 );
+        t = get_milliseconds() - t;
+        if ( t < best )
+          best = t;
+      }
+
+      stbir_resize_extended_profile_info( &profile, &resize );
+      printf( "1/%-4d %dx%-5d %d split%s: %s  ring %3u scanlines  per split %8.1f KB  total %9.1f KB  %7.2f ms\n",
+              divisors[ d ], in_w, out_h, splits, ( splits == 1 ) ? " " : "s", ( resize.samplers->vertical.is_gather ) ? "gather " : "scatter",
+              profile.ring_buffer_entries, (double) profile.split_memory / 1024.0, (double) profile.total_memory / 1024.0, best );
+
+      stbir_free_samplers( &resize );
+    }
+  }
+
+  free( output );
+  free( input );
+  return 0;
+}
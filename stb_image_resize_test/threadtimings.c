@@ -0,0 +1,158 @@
+// Times stbir_resize_extended_threaded from 1 to N threads, and checks that
+//   every thread count produces the same pixels as the single threaded resize.
+//
+//   gcc -O2 threadtimings.c -I.. -lpthread -lm -o threadtimings
+//   threadtimings [max_threads] [input_w input_h]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+
+#include <windows.h>
+
+static int get_cpu_count()
+{
+  SYSTEM_INFO si;
+  GetSystemInfo( &si );
+  return (int) si.dwNumberOfProcessors;
+}
+
+static double get_milliseconds()
+{
+  LARGE_INTEGER c, f;
+  QueryPerformanceCounter( &c );
+  QueryPerformanceFrequency( &f );
+  return (double) c.QuadPart * 1000.0 / (double) f.QuadPart;
+}
+
+#else
+
+#include <time.h>
+#include <unistd.h>
+
+static int get_cpu_count()
+{
+  return (int) sysconf( _SC_NPROCESSORS_ONLN );
+}
+
+static double get_milliseconds()
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (double) ts.tv_sec * 1000.0 + (double) ts.tv_nsec / 1000000.0;
+}
+
+#endif
+
+#define STBIR_USE_THREADS
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include "stb_image_resize2.h"
+
+#define REPEATS 5
+
+typedef struct
+{
+  char const * name;
+  int out_w_num, out_w_den, out_h_num, out_h_den;
+  stbir_pixel_layout layout;
+  stbir_datatype type;
+} test_case;
+
+static test_case cases[] =
+{
+  { "down 1/3 rgba srgb",  1,3, 1,3, STBIR_RGBA,     STBIR_TYPE_UINT8_SRGB },
+  { "down 3/4 rgba lin",   3,4, 3,4, STBIR_RGBA,     STBIR_TYPE_UINT8 },
+  { "up 2x rgb",           2,1, 2,1, STBIR_RGB,      STBIR_TYPE_UINT8 },
+  { "wide 2x1/2 rgba pm",  2,1, 1,2, STBIR_RGBA_PM,  STBIR_TYPE_UINT8 },
+  { "down 1/8 rgba float", 1,8, 1,8, STBIR_4CHANNEL, STBIR_TYPE_FLOAT },
+};
+
+static double time_resize( STBIR_RESIZE * resize, int threads, stbir_thread_pool * pool )
+{
+  int i;
+  double best = 1e30;
+
+  for( i = 0 ; i < REPEATS ; i++ )
+  {
+    double t = get_milliseconds();
+    if ( threads == 1 )
+      stbir_resize_extended( resize );
+    else
+      stbir_resize_extended_threaded( resize, threads, stbir_thread_pool_dispatch, pool );
+    t = get_milliseconds() - t;
+    if ( t < best )
+      best = t;
+  }
+  return best;
+}
+
+int main( int argc, char ** argv )
+{
+  int max_threads = ( argc > 1 ) ? atoi( argv[1] ) : get_cpu_count();
+  int in_w = ( argc > 3 ) ? atoi( argv[2] ) : 3840;
+  int in_h = ( argc > 3 ) ? atoi( argv[3] ) : 2160;
+  unsigned char * input;
+  int c, t, i;
+  int failed = 0;
+
+  if ( max_threads < 1 ) max_threads = 1;
+
+  input = (unsigned char *) malloc( (size_t) in_w * in_h * 16 );
+  if ( input == 0 )
+    return 1;
+
+  // noise-ish pattern, valid as both bytes and (0 to 1) floats
+  for( i = 0 ; i < in_w * in_h * 4 ; i++ )
+    ( (float*) input )[ i ] = (float) ( ( i * 2654435761u ) >> 24 ) / 255.0f;
+
+  printf( "%dx%d input, 1 to %d threads, best of %d\n\n", in_w, in_h, max_threads, REPEATS );
+
+  for( c = 0 ; c < (int) ( sizeof( cases ) / sizeof( cases[0] ) ) ; c++ )
+  {
+    test_case const * tc = cases + c;
+    int out_w = in_w * tc->out_w_num / tc->out_w_den;
+    int out_h = in_h * tc->out_h_num / tc->out_h_den;
+    size_t out_size = (size_t) out_w * out_h * 16;
+    unsigned char * reference = (unsigned char *) malloc( out_size );
+    unsigned char * output = (unsigned char *) malloc( out_size );
+    double base = 0.0;
+
+    if ( ( reference == 0 ) || ( output == 0 ) )
+      return 1;
+
+    memset( reference, 0, out_size );
+    printf( "%-20s %dx%d\n", tc->name, out_w, out_h );
+
+    for( t = 1 ; t <= max_threads ; t++ )
+    {
+      STBIR_RESIZE resize;
+      stbir_thread_pool * pool = stbir_thread_pool_create( t, 0 );
+      double ms;
+
+      memset( output, 0, out_size );
+      stbir_resize_init( &resize, input, in_w, in_h, 0, ( t == 1 ) ? reference : output, out_w, out_h, 0, tc->layout, tc->type );
+      stbir_build_samplers_with_splits( &resize, t * STBIR_SPLITS_PER_THREAD );
+      ms = time_resize( &resize, t, pool );
+      stbir_free_samplers( &resize );
+      stbir_thread_pool_destroy( pool );
+
+      if ( t == 1 )
+        base = ms;
+      else if ( memcmp( reference, output, out_size ) != 0 )
+      {
+        printf( "  MISMATCH with %d threads!\n", t );
+        failed = 1;
+      }
+
+      printf( "  %2d threads: %8.2f ms  %5.2fx\n", t, ms, base / ms );
+    }
+
+    free( output );
+    free( reference );
+  }
+
+  free( input );
+  return failed;
+}
@@ -0,0 +1,165 @@
+// Calibrates the vertical first choice on this machine with a spread of resizes,
+//   shows how many the trained costs got wrong before and after, and saves the
+//   calibration (load it with stbir_load_vertical_first_calibration). A pick only
+//   counts as wrong if every trial timed the other order faster by more than the
+//   noise margin; it fails if any calibrated pick is still wrong.
+//
+//   gcc -O2 vfcalibrate.c -I.. -lm -o vfcalibrate
+//   vfcalibrate [output_file]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include "stb_image_resize2.h"
+
+#define REPEATS 5
+#define TRIALS 3
+#define IN_W 1024
+#define IN_H 1024
+
+typedef struct
+{
+  stbir_pixel_layout layout;
+  stbir_datatype type;
+  int channels, type_size;
+} test_type;
+
+static test_type types[] =
+{
+  { STBIR_1CHANNEL, STBIR_TYPE_UINT8,      1, 1 },
+  { STBIR_RGB,      STBIR_TYPE_UINT8_SRGB, 3, 1 },
+  { STBIR_RGBA,     STBIR_TYPE_UINT8_SRGB, 4, 1 },
+  { STBIR_RGBA_PM,  STBIR_TYPE_UINT8,      4, 1 },
+  { STBIR_4CHANNEL, STBIR_TYPE_FLOAT,      4, 4 },
+};
+
+// output sizes as a percentage of the input
+static int sizes[][2] =
+{
+  { 25, 25 }, { 50, 50 }, { 75, 75 }, { 150, 150 }, { 250, 250 },
+  { 200, 50 }, { 50, 200 }, { 100, 30 }, { 30, 100 }, { 350, 120 },
+};
+
+static unsigned char * input;
+static unsigned char * output;
+
+// times each resize TRIALS times (putting the calibration back after each, so checking
+//   doesn't change the picks), and counts a pick as wrong only when every trial found the
+//   other order faster by more than the noise margin (stbir_calibrate_vertical_first
+//   returns 3 within it). Cases where the trials disagree or tie are counted as noise.
+static int count_wrong( int * noise )
+{
+  int size = stbir_get_vertical_first_calibration( 0, 0 );
+  unsigned char * saved = (unsigned char *) malloc( size );
+  int t, z, k, wrong = 0;
+
+  *noise = 0;
+  if ( saved == 0 )
+    return -1;
+  stbir_get_vertical_first_calibration( saved, size );
+
+  for( t = 0 ; t < (int) ( sizeof( types ) / sizeof( types[0] ) ) ; t++ )
+  {
+    for( z = 0 ; z < (int) ( sizeof( sizes ) / sizeof( sizes[0] ) ) ; z++ )
+    {
+      STBIR_RESIZE resize;
+      int out_w = IN_W * sizes[ z ][ 0 ] / 100;
+      int out_h = IN_H * sizes[ z ][ 1 ] / 100;
+      int picked, slower = 0, timed = 0;
+
+      stbir_resize_init( &resize, input, IN_W, IN_H, 0, output, out_w, out_h, 0, types[ t ].layout, types[ t ].type );
+      if ( !stbir_build_samplers( &resize ) )
+        continue;
+      picked = resize.samplers->vertical_first;
+      stbir_free_samplers( &resize );
+
+      for( k = 0 ; k < TRIALS ; k++ )
+      {
+        int faster = stbir_calibrate_vertical_first( &resize, REPEATS );
+        stbir_set_vertical_first_calibration( saved, size );
+        if ( faster == 0 )
+          continue;
+        ++timed;
+        if ( ( faster != 3 ) && ( picked != ( faster == 2 ) ) )
+          ++slower;
+      }
+
+      if ( timed == 0 )
+        continue;
+      if ( slower == timed )
+        ++wrong;
+      else if ( slower )
+        ++*noise;
+    }
+  }
+
+  free( saved );
+  return wrong;
+}
+
+static void calibrate( void )
+{
+  int t, z;
+
+  for( t = 0 ; t < (int) ( sizeof( types ) / sizeof( types[0] ) ) ; t++ )
+  {
+    for( z = 0 ; z < (int) ( sizeof( sizes ) / sizeof( sizes[0] ) ) ; z++ )
+    {
+      STBIR_RESIZE resize;
+      int k;
+
+      stbir_resize_init( &resize, input, IN_W, IN_H, 0, output, IN_W * sizes[ z ][ 0 ] / 100, IN_H * sizes[ z ][ 1 ] / 100, 0, types[ t ].layout, types[ t ].type );
+      for( k = 0 ; k < TRIALS ; k++ )
+        stbir_calibrate_vertical_first( &resize, REPEATS );
+    }
+  }
+}
+
+int main( int argc, char ** argv )
+{
+  char const * filename = ( argc > 1 ) ? argv[1] : "vfcalibrate.bin";
+  int i, total, before, after, before_noise, after_noise;
+  int failed = 0;
+
+  input = (unsigned char *) malloc( (size_t) IN_W * IN_H * 16 );
+  output = (unsigned char *) malloc( (size_t) IN_W * IN_H * 16 * 4 * 2 );
+  if ( ( input == 0 ) || ( output == 0 ) )
+    return 1;
+
+  // noise-ish pattern, valid as both bytes and (0 to 1) floats
+  for( i = 0 ; i < IN_W * IN_H * 4 ; i++ )
+    ( (float*) input )[ i ] = (float) ( ( i * 2654435761u ) >> 24 ) / 255.0f;
+
+  total = (int) ( ( sizeof( types ) / sizeof( types[0] ) ) * ( sizeof( sizes ) / sizeof( sizes[0] ) ) );
+
+  printf( "%dx%d input, %d resizes, best of %d, %d trials\n\n", IN_W, IN_H, total, REPEATS, TRIALS );
+
+  before = count_wrong( &before_noise );
+  printf( "trained costs picked the slower order: %d (and %d within noise)\n", before, before_noise );
+
+  calibrate();
+  after = count_wrong( &after_noise );
+  printf( "after calibrating, picked the slower order: %d (and %d within noise)\n", after, after_noise );
+  if ( after > 0 )
+    failed = 1;
+
+  if ( !stbir_save_vertical_first_calibration( filename ) )
+  {
+    printf( "couldn't write %s\n", filename );
+    return 1;
+  }
+
+  stbir_reset_vertical_first_calibration();
+  if ( !stbir_load_vertical_first_calibration( filename ) )
+  {
+    printf( "couldn't read back %s\n", filename );
+    return 1;
+  }
+  printf( "saved to %s\n", filename );
+
+  free( output );
+  free( input );
+  return failed;
+}
@@ -0,0 +1,200 @@
+// Times stbir_warp_affine rotations against a plain stbir_resize of the same size,
+//   and checks the gather by rotating 90 degrees (which lands exactly on pixel
+//   centers), comparing against a rotated copy of the input. Inputs smaller than
+//   the filter footprint (1xN, Nx1, 2x2, 3x3...) are checked the same way. The
+//   b-spline and mitchell filters blur even on pixel centers, so those only
+//   have to succeed.
+//
+//   gcc -O2 warptimings.c -I.. -lm -o warptimings
+//   warptimings [input_w input_h]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _MSC_VER
+
+#include <windows.h>
+
+static double get_milliseconds()
+{
+  LARGE_INTEGER c, f;
+  QueryPerformanceCounter( &c );
+  QueryPerformanceFrequency( &f );
+  return (double) c.QuadPart * 1000.0 / (double) f.QuadPart;
+}
+
+#else
+
+#include <time.h>
+
+static double get_milliseconds()
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (double) ts.tv_sec * 1000.0 + (double) ts.tv_nsec / 1000000.0;
+}
+
+#endif
+
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include "stb_image_resize2.h"
+
+#define REPEATS 5
+
+typedef struct
+{
+  char const * name;
+  stbir_pixel_layout layout;
+  stbir_datatype type;
+  int channels;
+} test_type;
+
+static test_type types[] =
+{
+  { "rgba srgb",   STBIR_RGBA,     STBIR_TYPE_UINT8_SRGB, 4 },
+  { "rgba pm",     STBIR_RGBA_PM,  STBIR_TYPE_UINT8,      4 },
+  { "rgb",         STBIR_RGB,      STBIR_TYPE_UINT8,      3 },
+  { "1ch",         STBIR_1CHANNEL, STBIR_TYPE_UINT8,      1 },
+};
+
+typedef struct
+{
+  char const * name;
+  stbir_filter filter;
+  int exact;  // interpolating, so a quarter turn reproduces the input exactly
+} test_filter;
+
+static test_filter filters[] =
+{
+  { "nearest",    STBIR_FILTER_POINT_SAMPLE, 1 },
+  { "box",        STBIR_FILTER_BOX,          1 },
+  { "bilinear",   STBIR_FILTER_TRIANGLE,     1 },
+  { "bspline",    STBIR_FILTER_CUBICBSPLINE, 0 },
+  { "catmullrom", STBIR_FILTER_CATMULLROM,   1 },
+  { "mitchell",   STBIR_FILTER_MITCHELL,     0 },
+};
+
+// quarter turns clockwise with the warp, and returns the biggest difference from a
+//   rotated copy of the input (output pixel (x,y) is input pixel (y, in_h-1-x))
+static int quarter_turn_diff( unsigned char const * input, int in_w, int in_h, test_type const * tt, stbir_filter filter, unsigned char * output, unsigned char * rotated )
+{
+  float quarter[ 6 ] = { 0.0f, 1.0f, 0.0f, -1.0f, 0.0f, (float) in_h };
+  int c = tt->channels;
+  int max_diff = 0;
+  int x, y;
+  size_t j;
+
+  for( y = 0 ; y < in_w ; y++ )
+    for( x = 0 ; x < in_h ; x++ )
+      memcpy( rotated + ( (size_t) y * in_h + x ) * c, input + ( (size_t) ( in_h - 1 - x ) * in_w + y ) * c, c );
+
+  memset( output, 0, (size_t) in_w * in_h * c );
+  if ( !stbir_warp_affine( input, in_w, in_h, 0, output, in_h, in_w, 0, tt->layout, tt->type, STBIR_EDGE_CLAMP, filter, quarter ) )
+    return 256;
+  for( j = 0 ; j < (size_t) in_w * in_h * c ; j++ )
+  {
+    int d = output[ j ] - rotated[ j ];
+    if ( d < 0 ) d = -d;
+    if ( d > max_diff ) max_diff = d;
+  }
+  return max_diff;
+}
+
+// inputs smaller than the filter footprint, where every tap needs edge handling
+static int tiny_sizes[][ 2 ] = { { 1, 1 }, { 1, 50 }, { 50, 1 }, { 2, 2 }, { 3, 3 }, { 2, 7 }, { 7, 3 } };
+
+int main( int argc, char ** argv )
+{
+  int in_w = ( argc > 2 ) ? atoi( argv[1] ) : 1920;
+  int in_h = ( argc > 2 ) ? atoi( argv[2] ) : 1080;
+  size_t size = (size_t) in_w * in_h * 4;
+  unsigned char * input, * output, * rotated;
+  int t, f, i, r;
+  int failed = 0;
+
+  input = (unsigned char *) malloc( size );
+  output = (unsigned char *) malloc( size );
+  rotated = (unsigned char *) malloc( size );
+  if ( ( input == 0 ) || ( output == 0 ) || ( rotated == 0 ) )
+    return 1;
+
+  // noise, with every 4th byte 255 - that's opaque alpha in the 4 channel cases (zero
+  //   alpha loses the color going through premultiplied floats, so it wouldn't round trip)
+  for( i = 0 ; i < (int) size ; i++ )
+    input[ i ] = (unsigned char) ( ( i * 2654435761u ) >> 24 );
+  for( i = 3 ; i < (int) size ; i += 4 )
+    input[ i ] = 255;
+
+  printf( "%dx%d input, best of %d\n\n", in_w, in_h, REPEATS );
+
+  for( t = 0 ; t < (int) ( sizeof( types ) / sizeof( types[0] ) ) ; t++ )
+  {
+    test_type const * tt = types + t;
+    double resize_ms = 1e30;
+
+    for( r = 0 ; r < REPEATS ; r++ )
+    {
+      double ms = get_milliseconds();
+      stbir_resize( input, in_w, in_h, 0, output, in_w, in_h, 0, tt->layout, tt->type, STBIR_EDGE_CLAMP, STBIR_FILTER_TRIANGLE );
+      ms = get_milliseconds() - ms;
+      if ( ms < resize_ms )
+        resize_ms = ms;
+    }
+
+    printf( "%-10s stbir_resize %dx%d: %7.2f ms\n", tt->name, in_w, in_h, resize_ms );
+
+    for( f = 0 ; f < (int) ( sizeof( filters ) / sizeof( filters[0] ) ) ; f++ )
+    {
+      float spin[ 6 ];
+      double warp_ms = 1e30;
+      float s = (float) sin( 0.5 ), co = (float) cos( 0.5 );
+      int max_diff, tiny_diff = 0, k;
+
+      // rotate about the center by ~29 degrees, same output size as the input
+      spin[ 0 ] = co; spin[ 1 ] = -s; spin[ 2 ] = in_w * 0.5f - co * in_w * 0.5f + s * in_h * 0.5f;
+      spin[ 3 ] = s;  spin[ 4 ] = co; spin[ 5 ] = in_h * 0.5f - s * in_w * 0.5f - co * in_h * 0.5f;
+
+      for( r = 0 ; r < REPEATS ; r++ )
+      {
+        double ms = get_milliseconds();
+        if ( !stbir_warp_affine( input, in_w, in_h, 0, output, in_w, in_h, 0, tt->layout, tt->type, STBIR_EDGE_ZERO, filters[ f ].filter, spin ) )
+        {
+          printf( "  warp FAILED\n" );
+          return 1;
+        }
+        ms = get_milliseconds() - ms;
+        if ( ms < warp_ms )
+          warp_ms = ms;
+      }
+
+      max_diff = quarter_turn_diff( input, in_w, in_h, tt, filters[ f ].filter, output, rotated );
+
+      // the tiny inputs also get the spin (scaled to their size), which mostly samples off the edges
+      for( k = 0 ; k < (int) ( sizeof( tiny_sizes ) / sizeof( tiny_sizes[0] ) ) ; k++ )
+      {
+        int tw = tiny_sizes[ k ][ 0 ], th = tiny_sizes[ k ][ 1 ], d;
+        float tiny_spin[ 6 ];
+        tiny_spin[ 0 ] = co; tiny_spin[ 1 ] = -s; tiny_spin[ 2 ] = tw * 0.5f - co * tw * 0.5f + s * th * 0.5f;
+        tiny_spin[ 3 ] = s;  tiny_spin[ 4 ] = co; tiny_spin[ 5 ] = th * 0.5f - s * tw * 0.5f - co * th * 0.5f;
+        if ( !stbir_warp_affine( input, tw, th, 0, output, tw, th, 0, tt->layout, tt->type, STBIR_EDGE_ZERO, filters[ f ].filter, tiny_spin ) )
+          d = 256;
+        else
+          d = quarter_turn_diff( input, tw, th, tt, filters[ f ].filter, output, rotated );
+        if ( d > tiny_diff ) tiny_diff = d;
+      }
+
+      // the blurring cubics only have to run (tiny_diff is 256 if a warp failed)
+      if ( filters[ f ].exact ? ( ( max_diff != 0 ) || ( tiny_diff != 0 ) ) : ( tiny_diff > 255 ) )
+        failed = 1;
+
+      printf( "  %-10s rotate: %7.2f ms %5.2fx of resize  quarter turn max diff %d  tiny inputs %d%s\n", filters[ f ].name, warp_ms, warp_ms / resize_ms, max_diff, tiny_diff, filters[ f ].exact ? "" : " (blurs, not checked)" );
+    }
+  }
+
+  free( rotated );
+  free( output );
+  free( input );
+  return failed;
+}
@@ -26,6 +26,8 @@ BUILDING:
    You can #define STBIW_MALLOC(), STBIW_REALLOC(), and STBIW_FREE() to replace
    malloc,realloc,free.
    You can #define STBIW_MEMMOVE() to replace memmove()
+   SSE2 is used automatically when the compiler targets it; #define STBIW_NEON
+   to use NEON on ARM, or STBIW_NO_SIMD to disable both.
    You can #define STBIW_ZLIB_COMPRESS to use a custom zlib-style compress function
    for PNG compression (instead of the builtin one), it must have the following signature:
    unsigned char * my_compress(unsigned char *data, int data_len, int *out_len, int quality);
@@ -68,6 +70,9 @@ USAGE:
       int stbi_write_tga_with_rle;             // defaults to true; set to 0 to disable RLE
       int stbi_write_png_compression_level;    // defaults to 8; set to higher for more compression
       int stbi_write_force_png_filter;         // defaults to -1; set to 0..5 to force a filter mode
+      int stbi_write_jpg_optimize_huffman;     // defaults to 0; set to 1 to compute optimal JPEG huffman tables
+      int stbi_write_jpg_progressive;          // defaults to 0; set to 1 to write progressive JPEG
+      int stbi_write_jpg_chroma_subsampling;   // defaults to -1 (automatic); set to 444, 422 or 420
 
 
    You can define STBI_WRITE_NO_STDIO to disable the file variant of these
@@ -106,9 +111,38 @@ USAGE:
    TGA supports RLE or non-RLE compressed data. To use non-RLE-compressed
    data, set the global variable 'stbi_write_tga_with_rle' to 0.
 
+   REUSING ALLOCATIONS:
+
+   Each PNG encode allocates a filter buffer, a line buffer, the deflate hash
+   table and the output. When encoding many images (e.g. capturing frames),
+   keep a stbi_write_png_context around instead; its buffers are kept and only
+   grow, so once they've warmed up to the image size, encoding rarely touches
+   the heap:
+
+     stbi_write_png_context ctx = { 0 };   // optionally set alloc_fn+free_fn, and user_data
+     unsigned char *png = stbi_write_png_to_mem_ctx(&ctx, pixels, stride, w, h, comp, &len);
+     // 'png' is owned by ctx and valid until the next call using ctx
+     stbi_write_png_context_free(&ctx);
+
+   stbi_write_png_to_func_ctx does the same for the callback interface. A
+   context must not be used by more than one thread at a time. If you use
+   STBIW_ZLIB_COMPRESS, the compressed data is still allocated by your
+   function each time.
+
    JPEG does ignore alpha channels in input data; quality is between 1 and 100.
    Higher quality looks better but results in a bigger image.
-   JPEG baseline (no JPEG progressive).
+   JPEG is written as baseline with the standard huffman tables by default.
+   Setting 'stbi_write_jpg_optimize_huffman' makes the writer gather symbol
+   statistics in a first pass and emit optimal tables, which typically saves
+   5-10% of the file size. Setting 'stbi_write_jpg_progressive' writes a
+   progressive JPEG (spectral selection only), which always uses optimized
+   tables. Both modes keep all quantized coefficients in memory (128 bytes
+   per 8x8 block) and cost roughly twice the entropy-coding time.
+
+   By default JPEG chroma is subsampled 4:2:0 when quality <= 90 and kept at
+   full resolution above that. Set 'stbi_write_jpg_chroma_subsampling' to 444,
+   422 or 420 to pick the mode explicitly regardless of quality; 4:2:0 gives
+   the smallest files and fastest encoding, 4:4:4 preserves colored edges.
 
 CREDITS:
 
@@ -170,6 +204,9 @@ LICENSE
 STBIWDEF int stbi_write_tga_with_rle;
 STBIWDEF int stbi_write_png_compression_level;
 STBIWDEF int stbi_write_force_png_filter;
+STBIWDEF int stbi_write_jpg_optimize_huffman;
+STBIWDEF int stbi_write_jpg_progressive;
+STBIWDEF int stbi_write_jpg_chroma_subsampling;
 #endif
 
 #ifndef STBI_WRITE_NO_STDIO
@@ -194,6 +231,27 @@ STBIWDEF int stbi_write_jpg_to_func(stbi_write_func *func, void *context, int x,
 
 STBIWDEF void stbi_flip_vertically_on_write(int flip_boolean);
 
+// Reusable PNG encoder state; see "REUSING ALLOCATIONS" above.
+typedef struct
+{
+   // optional allocator; set both or neither. If either is NULL,
+   // STBIW_MALLOC/STBIW_FREE are used (and setting just one asserts)
+   void *(*alloc_fn)(void *user_data, size_t size);
+   void  (*free_fn)(void *user_data, void *ptr);
+   void   *user_data;
+
+   // buffers kept between calls -- private
+   unsigned char *filt, *out, *zbuf;
+   signed char *line_buffer;
+   unsigned char ***hash_table;
+   size_t filt_size, line_size, out_size;
+} stbi_write_png_context;
+
+STBIWDEF unsigned char *stbi_write_png_to_mem_ctx(stbi_write_png_context *ctx, const unsigned char *pixels, int stride_bytes, int x, int y, int comp, int *out_len);
+STBIWDEF int stbi_write_png_to_func_ctx(stbi_write_png_context *ctx, stbi_write_func *func, void *context, int w, int h, int comp, const void *data, int stride_in_bytes);
+STBIWDEF void stbi_write_png_context_free(stbi_write_png_context *ctx);
+// frees the context's buffers (not the context itself); NULL is ignored
+
 #endif//INCLUDE_STB_IMAGE_WRITE_H
 
 #ifdef STB_IMAGE_WRITE_IMPLEMENTATION
@@ -247,14 +305,33 @@ STBIWDEF void stbi_flip_vertically_on_write(int flip_boolean);
 
 #define STBIW_UCHAR(x) (unsigned char) ((x) & 0xff)
 
+#if !defined(STBIW_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define STBIW_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(STBIW_NO_SIMD) && defined(STBIW_NEON)
+#undef STBIW_NEON
+#endif
+
+#ifdef STBIW_NEON
+#include <arm_neon.h>
+#endif
+
 #ifdef STB_IMAGE_WRITE_STATIC
 static int stbi_write_png_compression_level = 8;
 static int stbi_write_tga_with_rle = 1;
 static int stbi_write_force_png_filter = -1;
+static int stbi_write_jpg_optimize_huffman = 0;
+static int stbi_write_jpg_progressive = 0;
+static int stbi_write_jpg_chroma_subsampling = -1;
 #else
 int stbi_write_png_compression_level = 8;
 int stbi_write_tga_with_rle = 1;
 int stbi_write_force_png_filter = -1;
+int stbi_write_jpg_optimize_huffman = 0;
+int stbi_write_jpg_progressive = 0;
+int stbi_write_jpg_chroma_subsampling = -1;
 #endif
 
 static int stbi__flip_vertically_on_write = 0;
@@ -809,24 +886,72 @@ STBIWDEF int stbi_write_hdr(char const *filename, int x, int y, int comp, const
 // PNG writer
 //
 
+// allocation through an optional stbi_write_png_context; NULL uses STBIW_MALLOC etc.
+// the hooks only count as a pair, so a half-set context never mixes allocators
+static int stbiw__ctx_hooked(stbi_write_png_context *c)
+{
+   if (!c)
+      return 0;
+   STBIW_ASSERT((c->alloc_fn == NULL) == (c->free_fn == NULL));
+   return c->alloc_fn && c->free_fn;
+}
+
+static void *stbiw__ctx_malloc(stbi_write_png_context *c, size_t size)
+{
+   if (stbiw__ctx_hooked(c))
+      return c->alloc_fn(c->user_data, size);
+   return STBIW_MALLOC(size);
+}
+
+static void stbiw__ctx_free(stbi_write_png_context *c, void *p)
+{
+   if (!p)
+      return;
+   if (stbiw__ctx_hooked(c))
+      c->free_fn(c->user_data, p);
+   else
+      STBIW_FREE(p);
+}
+
+// make sure *buf holds at least 'size' bytes; the old contents are not preserved
+static void *stbiw__ctx_reserve(stbi_write_png_context *c, void **buf, size_t *cap, size_t size)
+{
+   if (*buf && *cap >= size)
+      return *buf;
+   stbiw__ctx_free(c, *buf);
+   *buf = stbiw__ctx_malloc(c, size);
+   *cap = *buf ? size : 0;
+   return *buf;
+}
+
 #ifndef STBIW_ZLIB_COMPRESS
 // stretchy buffer; stbiw__sbpush() == vector<>::push_back() -- stbiw__sbcount() == vector<>::size()
+// (these use the allocator of the 'zctx' variable in scope)
 #define stbiw__sbraw(a) ((int *) (void *) (a) - 2)
 #define stbiw__sbm(a)   stbiw__sbraw(a)[0]
 #define stbiw__sbn(a)   stbiw__sbraw(a)[1]
 
 #define stbiw__sbneedgrow(a,n)  ((a)==0 || stbiw__sbn(a)+n >= stbiw__sbm(a))
 #define stbiw__sbmaybegrow(a,n) (stbiw__sbneedgrow(a,(n)) ? stbiw__sbgrow(a,n) : 0)
-#define stbiw__sbgrow(a,n)  stbiw__sbgrowf((void **) &(a), (n), sizeof(*(a)))
+#define stbiw__sbgrow(a,n)  stbiw__sbgrowf((void **) &(a), (n), sizeof(*(a)), zctx)
 
 #define stbiw__sbpush(a, v)      (stbiw__sbmaybegrow(a,1), (a)[stbiw__sbn(a)++] = (v))
 #define stbiw__sbcount(a)        ((a) ? stbiw__sbn(a) : 0)
-#define stbiw__sbfree(a)         ((a) ? STBIW_FREE(stbiw__sbraw(a)),0 : 0)
+#define stbiw__sbfree(a)         ((a) ? stbiw__ctx_free(zctx, stbiw__sbraw(a)),0 : 0)
 
-static void *stbiw__sbgrowf(void **arr, int increment, int itemsize)
+static void *stbiw__sbgrowf(void **arr, int increment, int itemsize, stbi_write_png_context *zctx)
 {
    int m = *arr ? 2*stbiw__sbm(*arr)+increment : increment+1;
-   void *p = STBIW_REALLOC_SIZED(*arr ? stbiw__sbraw(*arr) : 0, *arr ? (stbiw__sbm(*arr)*itemsize + sizeof(int)*2) : 0, itemsize * m + sizeof(int)*2);
+   void *p;
+   if (stbiw__ctx_hooked(zctx)) {
+      // user allocator has no realloc
+      p = zctx->alloc_fn(zctx->user_data, itemsize * m + sizeof(int)*2);
+      if (p && *arr) {
+         memcpy(p, stbiw__sbraw(*arr), stbiw__sbm(*arr)*itemsize + sizeof(int)*2);
+         zctx->free_fn(zctx->user_data, stbiw__sbraw(*arr));
+      }
+   } else
+      p = STBIW_REALLOC_SIZED(*arr ? stbiw__sbraw(*arr) : 0, *arr ? (stbiw__sbm(*arr)*itemsize + sizeof(int)*2) : 0, itemsize * m + sizeof(int)*2);
    STBIW_ASSERT(p);
    if (p) {
       if (!*arr) ((int *) p)[1] = 0;
@@ -836,7 +961,7 @@ static void *stbiw__sbgrowf(void **arr, int increment, int itemsize)
    return *arr;
 }
 
-static unsigned char *stbiw__zlib_flushf(unsigned char *data, unsigned int *bitbuffer, int *bitcount)
+static unsigned char *stbiw__zlib_flushf(stbi_write_png_context *zctx, unsigned char *data, unsigned int *bitbuffer, int *bitcount)
 {
    while (*bitcount >= 8) {
       stbiw__sbpush(data, STBIW_UCHAR(*bitbuffer));
@@ -876,7 +1001,7 @@ static unsigned int stbiw__zhash(unsigned char *data)
    return hash;
 }
 
-#define stbiw__zlib_flush() (out = stbiw__zlib_flushf(out, &bitbuf, &bitcount))
+#define stbiw__zlib_flush() (out = stbiw__zlib_flushf(zctx, out, &bitbuf, &bitcount))
 #define stbiw__zlib_add(code,codebits) \
       (bitbuf |= (code) << bitcount, bitcount += (codebits), stbiw__zlib_flush())
 #define stbiw__zlib_huffa(b,c)  stbiw__zlib_add(stbiw__zlib_bitrev(b,c),c)
@@ -890,14 +1015,10 @@ static unsigned int stbiw__zhash(unsigned char *data)
 
 #define stbiw__ZHASH   16384
 
-#endif // STBIW_ZLIB_COMPRESS
-
-STBIWDEF unsigned char * stbi_zlib_compress(unsigned char *data, int data_len, int *out_len, int quality)
+// with a context, the hash chains and the output buffer are kept in it between
+// calls, and the returned buffer is owned by the context
+static unsigned char *stbiw__zlib_compress(stbi_write_png_context *zctx, unsigned char *data, int data_len, int *out_len, int quality)
 {
-#ifdef STBIW_ZLIB_COMPRESS
-   // user provided a zlib compress implementation, use that
-   return STBIW_ZLIB_COMPRESS(data, data_len, out_len, quality);
-#else // use builtin
    static unsigned short lengthc[] = { 3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258, 259 };
    static unsigned char  lengtheb[]= { 0,0,0,0,0,0,0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4,  4,  5,  5,  5,  5,  0 };
    static unsigned short distc[]   = { 1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577, 32768 };
@@ -905,9 +1026,25 @@ STBIWDEF unsigned char * stbi_zlib_compress(unsigned char *data, int data_len, i
    unsigned int bitbuf=0;
    int i,j, bitcount=0;
    unsigned char *out = NULL;
-   unsigned char ***hash_table = (unsigned char***) STBIW_MALLOC(stbiw__ZHASH * sizeof(unsigned char**));
-   if (hash_table == NULL)
-      return NULL;
+   unsigned char ***hash_table = zctx ? zctx->hash_table : NULL;
+   if (hash_table == NULL) {
+      hash_table = (unsigned char***) stbiw__ctx_malloc(zctx, stbiw__ZHASH * sizeof(unsigned char**));
+      if (hash_table == NULL)
+         return NULL;
+      for (i=0; i < stbiw__ZHASH; ++i)
+         hash_table[i] = NULL;
+      if (zctx)
+         zctx->hash_table = hash_table;
+   } else {
+      // keep the chains' storage, just empty them
+      for (i=0; i < stbiw__ZHASH; ++i)
+         if (hash_table[i])
+            stbiw__sbn(hash_table[i]) = 0;
+   }
+   if (zctx && zctx->zbuf) {
+      out = zctx->zbuf;
+      stbiw__sbn(out) = 0;
+   }
    if (quality < 5) quality = 5;
 
    stbiw__sbpush(out, 0x78);   // DEFLATE 32K window
@@ -915,9 +1052,6 @@ STBIWDEF unsigned char * stbi_zlib_compress(unsigned char *data, int data_len, i
    stbiw__zlib_add(1,1);  // BFINAL = 1
    stbiw__zlib_add(1,2);  // BTYPE = 1 -- fixed huffman
 
-   for (i=0; i < stbiw__ZHASH; ++i)
-      hash_table[i] = NULL;
-
    i=0;
    while (i < data_len-3) {
       // hash next 3 bytes of data to be compressed
@@ -977,9 +1111,11 @@ STBIWDEF unsigned char * stbi_zlib_compress(unsigned char *data, int data_len, i
    while (bitcount)
       stbiw__zlib_add(0,1);
 
-   for (i=0; i < stbiw__ZHASH; ++i)
-      (void) stbiw__sbfree(hash_table[i]);
-   STBIW_FREE(hash_table);
+   if (!zctx) {
+      for (i=0; i < stbiw__ZHASH; ++i)
+         (void) stbiw__sbfree(hash_table[i]);
+      STBIW_FREE(hash_table);
+   }
 
    // store uncompressed instead if compression was worse
    if (stbiw__sbn(out) > data_len + 2 + ((data_len+32766)/32767)*5) {
@@ -1015,9 +1151,24 @@ STBIWDEF unsigned char * stbi_zlib_compress(unsigned char *data, int data_len, i
       stbiw__sbpush(out, STBIW_UCHAR(s1));
    }
    *out_len = stbiw__sbn(out);
+   if (zctx) {
+      zctx->zbuf = out;
+      return out;
+   }
    // make returned pointer freeable
    STBIW_MEMMOVE(stbiw__sbraw(out), out, *out_len);
    return (unsigned char *) stbiw__sbraw(out);
+}
+
+#endif // STBIW_ZLIB_COMPRESS
+
+STBIWDEF unsigned char * stbi_zlib_compress(unsigned char *data, int data_len, int *out_len, int quality)
+{
+#ifdef STBIW_ZLIB_COMPRESS
+   // user provided a zlib compress implementation, use that
+   return STBIW_ZLIB_COMPRESS(data, data_len, out_len, quality);
+#else // use builtin
+   return stbiw__zlib_compress(NULL, data, data_len, out_len, quality);
 #endif // STBIW_ZLIB_COMPRESS
 }
 
@@ -1125,7 +1276,18 @@ static void stbiw__encode_png_line(unsigned char *pixels, int stride_bytes, int
    }
 }
 
-STBIWDEF unsigned char *stbi_write_png_to_mem(const unsigned char *pixels, int stride_bytes, int x, int y, int n, int *out_len)
+// compressed data from a context lives in the context; from STBIW_ZLIB_COMPRESS it's always heap
+static void stbiw__free_zlib(stbi_write_png_context *ctx, unsigned char *zlib)
+{
+#ifdef STBIW_ZLIB_COMPRESS
+   (void) ctx;
+   STBIW_FREE(zlib);
+#else
+   if (!ctx) STBIW_FREE(zlib);
+#endif
+}
+
+static unsigned char *stbiw__write_png_to_mem(stbi_write_png_context *ctx, const unsigned char *pixels, int stride_bytes, int x, int y, int n, int *out_len)
 {
    int force_filter = stbi_write_force_png_filter;
    int ctype[5] = { -1, 0, 4, 2, 6 };
@@ -1141,8 +1303,13 @@ STBIWDEF unsigned char *stbi_write_png_to_mem(const unsigned char *pixels, int s
       force_filter = -1;
    }
 
-   filt = (unsigned char *) STBIW_MALLOC((x*n+1) * y); if (!filt) return 0;
-   line_buffer = (signed char *) STBIW_MALLOC(x * n); if (!line_buffer) { STBIW_FREE(filt); return 0; }
+   if (ctx) {
+      filt = (unsigned char *) stbiw__ctx_reserve(ctx, (void **) &ctx->filt, &ctx->filt_size, (size_t) (x*n+1) * y); if (!filt) return 0;
+      line_buffer = (signed char *) stbiw__ctx_reserve(ctx, (void **) &ctx->line_buffer, &ctx->line_size, x * n); if (!line_buffer) return 0;
+   } else {
+      filt = (unsigned char *) STBIW_MALLOC((x*n+1) * y); if (!filt) return 0;
+      line_buffer = (signed char *) STBIW_MALLOC(x * n); if (!line_buffer) { STBIW_FREE(filt); return 0; }
+   }
    for (j=0; j < y; ++j) {
       int filter_type;
       if (force_filter > -1) {
@@ -1172,14 +1339,23 @@ STBIWDEF unsigned char *stbi_write_png_to_mem(const unsigned char *pixels, int s
       filt[j*(x*n+1)] = (unsigned char) filter_type;
       STBIW_MEMMOVE(filt+j*(x*n+1)+1, line_buffer, x*n);
    }
-   STBIW_FREE(line_buffer);
+#ifdef STBIW_ZLIB_COMPRESS
    zlib = stbi_zlib_compress(filt, y*( x*n+1), &zlen, stbi_write_png_compression_level);
-   STBIW_FREE(filt);
+#else
+   zlib = stbiw__zlib_compress(ctx, filt, y*( x*n+1), &zlen, stbi_write_png_compression_level);
+#endif
+   if (!ctx) {
+      STBIW_FREE(line_buffer);
+      STBIW_FREE(filt);
+   }
    if (!zlib) return 0;
 
    // each tag requires 12 bytes of overhead
-   out = (unsigned char *) STBIW_MALLOC(8 + 12+13 + 12+zlen + 12);
-   if (!out) return 0;
+   if (ctx)
+      out = (unsigned char *) stbiw__ctx_reserve(ctx, (void **) &ctx->out, &ctx->out_size, 8 + 12+13 + 12+zlen + 12);
+   else
+      out = (unsigned char *) STBIW_MALLOC(8 + 12+13 + 12+zlen + 12);
+   if (!out) { stbiw__free_zlib(ctx, zlib); return 0; }
    *out_len = 8 + 12+13 + 12+zlen + 12;
 
    o=out;
@@ -1199,7 +1375,7 @@ STBIWDEF unsigned char *stbi_write_png_to_mem(const unsigned char *pixels, int s
    stbiw__wptag(o, "IDAT");
    STBIW_MEMMOVE(o, zlib, zlen);
    o += zlen;
-   STBIW_FREE(zlib);
+   stbiw__free_zlib(ctx, zlib);
    stbiw__wpcrc(&o, zlen);
 
    stbiw__wp32(o,0);
@@ -1211,6 +1387,50 @@ STBIWDEF unsigned char *stbi_write_png_to_mem(const unsigned char *pixels, int s
    return out;
 }
 
+STBIWDEF unsigned char *stbi_write_png_to_mem(const unsigned char *pixels, int stride_bytes, int x, int y, int n, int *out_len)
+{
+   return stbiw__write_png_to_mem(NULL, pixels, stride_bytes, x, y, n, out_len);
+}
+
+STBIWDEF unsigned char *stbi_write_png_to_mem_ctx(stbi_write_png_context *ctx, const unsigned char *pixels, int stride_bytes, int x, int y, int n, int *out_len)
+{
+   return stbiw__write_png_to_mem(ctx, pixels, stride_bytes, x, y, n, out_len);
+}
+
+STBIWDEF int stbi_write_png_to_func_ctx(stbi_write_png_context *ctx, stbi_write_func *func, void *context, int x, int y, int comp, const void *data, int stride_bytes)
+{
+   int len;
+   unsigned char *png = stbiw__write_png_to_mem(ctx, (const unsigned char *) data, stride_bytes, x, y, comp, &len);
+   if (png == NULL) return 0;
+   func(context, png, len);
+   return 1;
+}
+
+STBIWDEF void stbi_write_png_context_free(stbi_write_png_context *ctx)
+{
+#ifndef STBIW_ZLIB_COMPRESS
+   stbi_write_png_context *zctx = ctx;
+#endif
+   if (!ctx)
+      return;
+#ifndef STBIW_ZLIB_COMPRESS
+   if (ctx->hash_table) {
+      int i;
+      for (i=0; i < stbiw__ZHASH; ++i)
+         (void) stbiw__sbfree(ctx->hash_table[i]);
+      stbiw__ctx_free(ctx, ctx->hash_table);
+   }
+   (void) stbiw__sbfree(ctx->zbuf);
+#endif
+   stbiw__ctx_free(ctx, ctx->filt);
+   stbiw__ctx_free(ctx, ctx->line_buffer);
+   stbiw__ctx_free(ctx, ctx->out);
+   ctx->filt = ctx->out = ctx->zbuf = NULL;
+   ctx->line_buffer = NULL;
+   ctx->hash_table = NULL;
+   ctx->filt_size = ctx->line_size = ctx->out_size = 0;
+}
+
 #ifndef STBI_WRITE_NO_STDIO
 STBIWDEF int stbi_write_png(char const *filename, int x, int y, int comp, const void *data, int stride_bytes)
 {
@@ -1325,11 +1545,8 @@ static void stbiw__jpg_calcBits(int val, unsigned short bits[2]) {
    bits[0] = val & ((1<<bits[1])-1);
 }
 
-static int stbiw__jpg_processDU(stbi__write_context *s, int *bitBuf, int *bitCnt, float *CDU, int du_stride, float *fdtbl, int DC, const unsigned short HTDC[256][2], const unsigned short HTAC[256][2]) {
-   const unsigned short EOB[2] = { HTAC[0x00][0], HTAC[0x00][1] };
-   const unsigned short M16zeroes[2] = { HTAC[0xF0][0], HTAC[0xF0][1] };
-   int dataOff, i, j, n, diff, end0pos, x, y;
-   int DU[64];
+static void stbiw__jpg_quantizeDU(float *CDU, int du_stride, float *fdtbl, int *DU) {
+   int dataOff, i, j, n, x, y;
 
    // DCT rows
    for(dataOff=0, n=du_stride*8; dataOff<n; dataOff+=du_stride) {
@@ -1351,50 +1568,336 @@ static int stbiw__jpg_processDU(stbi__write_context *s, int *bitBuf, int *bitCnt
          DU[stbiw__jpg_ZigZag[j]] = (int)(v < 0 ? v - 0.5f : v + 0.5f);
       }
    }
+}
 
-   // Encode DC
-   diff = DU[0] - DC;
-   if (diff == 0) {
-      stbiw__jpg_writeBits(s, bitBuf, bitCnt, HTDC[0]);
-   } else {
-      unsigned short bits[2];
-      stbiw__jpg_calcBits(diff, bits);
-      stbiw__jpg_writeBits(s, bitBuf, bitCnt, HTDC[bits[1]]);
-      stbiw__jpg_writeBits(s, bitBuf, bitCnt, bits);
-   }
-   // Encode ACs
-   end0pos = 63;
-   for(; (end0pos>0)&&(DU[end0pos]==0); --end0pos) {
+// emit one huffman symbol followed by its extra bits; if 'freq' is non-NULL, nothing
+// is written and the symbol is only counted (used to build optimized tables)
+static void stbiw__jpg_emit(stbi__write_context *s, int *bitBuf, int *bitCnt, const unsigned short HT[256][2], unsigned int *freq, int symbol, const unsigned short *extra) {
+   if (freq) {
+      ++freq[symbol];
+      return;
    }
-   // end0pos = first element in reverse order !=0
-   if(end0pos == 0) {
-      stbiw__jpg_writeBits(s, bitBuf, bitCnt, EOB);
-      return DU[0];
+   stbiw__jpg_writeBits(s, bitBuf, bitCnt, HT[symbol]);
+   if (extra && extra[1])
+      stbiw__jpg_writeBits(s, bitBuf, bitCnt, extra);
+}
+
+static void stbiw__jpg_encodeDC(stbi__write_context *s, int *bitBuf, int *bitCnt, int diff, const unsigned short HTDC[256][2], unsigned int *freq) {
+   unsigned short bits[2] = { 0, 0 };
+   if (diff != 0)
+      stbiw__jpg_calcBits(diff, bits);
+   stbiw__jpg_emit(s, bitBuf, bitCnt, HTDC, freq, bits[1], bits);
+}
+
+// progressive scans code runs of all-zero blocks as a single EOBn symbol
+static void stbiw__jpg_flushEOBRun(stbi__write_context *s, int *bitBuf, int *bitCnt, int *eobrun, const unsigned short HTAC[256][2], unsigned int *freq) {
+   if (*eobrun) {
+      unsigned short bits[2];
+      int t = *eobrun, nbits = 0;
+      while (t >>= 1)
+         ++nbits;
+      bits[0] = (unsigned short) (*eobrun & ((1<<nbits)-1));
+      bits[1] = (unsigned short) nbits;
+      stbiw__jpg_emit(s, bitBuf, bitCnt, HTAC, freq, nbits<<4, bits);
+      *eobrun = 0;
    }
-   for(i = 1; i <= end0pos; ++i) {
-      int startpos = i;
-      int nrzeroes;
+}
+
+// encodes coefficients Ss..Se of a zigzagged block. With 'eobrun' NULL this is the
+// baseline coding (EOB per block); otherwise EOBs are accumulated into runs.
+static void stbiw__jpg_encodeAC(stbi__write_context *s, int *bitBuf, int *bitCnt, const int *DU, int Ss, int Se, const unsigned short HTAC[256][2], unsigned int *freq, int *eobrun) {
+   int i, nrzeroes = 0;
+   for(i = Ss; i <= Se; ++i) {
       unsigned short bits[2];
-      for (; DU[i]==0 && i<=end0pos; ++i) {
-      }
-      nrzeroes = i-startpos;
-      if ( nrzeroes >= 16 ) {
-         int lng = nrzeroes>>4;
-         int nrmarker;
-         for (nrmarker=1; nrmarker <= lng; ++nrmarker)
-            stbiw__jpg_writeBits(s, bitBuf, bitCnt, M16zeroes);
-         nrzeroes &= 15;
+      if (DU[i] == 0) {
+         ++nrzeroes;
+         continue;
       }
+      if (eobrun)
+         stbiw__jpg_flushEOBRun(s, bitBuf, bitCnt, eobrun, HTAC, freq);
+      for (; nrzeroes >= 16; nrzeroes -= 16)
+         stbiw__jpg_emit(s, bitBuf, bitCnt, HTAC, freq, 0xF0, NULL);
       stbiw__jpg_calcBits(DU[i], bits);
-      stbiw__jpg_writeBits(s, bitBuf, bitCnt, HTAC[(nrzeroes<<4)+bits[1]]);
-      stbiw__jpg_writeBits(s, bitBuf, bitCnt, bits);
+      stbiw__jpg_emit(s, bitBuf, bitCnt, HTAC, freq, (nrzeroes<<4)+bits[1], bits);
+      nrzeroes = 0;
    }
-   if(end0pos != 63) {
-      stbiw__jpg_writeBits(s, bitBuf, bitCnt, EOB);
+   if (nrzeroes) {
+      if (!eobrun)
+         stbiw__jpg_emit(s, bitBuf, bitCnt, HTAC, freq, 0x00, NULL);
+      else if (++*eobrun == 0x7FFF)
+         stbiw__jpg_flushEOBRun(s, bitBuf, bitCnt, eobrun, HTAC, freq);
    }
+}
+
+static int stbiw__jpg_processDU(stbi__write_context *s, int *bitBuf, int *bitCnt, float *CDU, int du_stride, float *fdtbl, int DC, const unsigned short HTDC[256][2], const unsigned short HTAC[256][2]) {
+   int DU[64];
+   stbiw__jpg_quantizeDU(CDU, du_stride, fdtbl, DU);
+   stbiw__jpg_encodeDC(s, bitBuf, bitCnt, DU[0] - DC, HTDC, NULL);
+   stbiw__jpg_encodeAC(s, bitBuf, bitCnt, DU, 1, 63, HTAC, NULL, NULL);
    return DU[0];
 }
 
+// builds a length-limited (16 bit) huffman code from symbol frequencies, returning it
+// in DHT form; this is the procedure from section K.2 of the JPEG spec
+static void stbiw__jpg_optimalHuffman(const unsigned int *freq_in, unsigned char *nrcodes, unsigned char *values) {
+   unsigned int freq[257];
+   int codesize[257], others[257], bits[33];
+   int i, j, k;
+
+   for(i = 0; i < 256; ++i) {
+      freq[i] = freq_in[i];
+      codesize[i] = 0;
+      others[i] = -1;
+   }
+   // reserve one code point so no symbol gets the all-ones code
+   freq[256] = 1; codesize[256] = 0; others[256] = -1;
+
+   for(;;) {
+      int c1 = -1, c2 = -1;
+      unsigned int v1 = 0xffffffff, v2 = 0xffffffff;
+      // find the two least frequent symbols, preferring the largest index on ties
+      for(i = 0; i <= 256; ++i) {
+         if (freq[i] && freq[i] <= v1) { v1 = freq[i]; c1 = i; }
+      }
+      for(i = 0; i <= 256; ++i) {
+         if (freq[i] && freq[i] <= v2 && i != c1) { v2 = freq[i]; c2 = i; }
+      }
+      if (c2 < 0)
+         break;
+
+      freq[c1] += freq[c2];
+      freq[c2] = 0;
+      ++codesize[c1];
+      while (others[c1] >= 0) {
+         c1 = others[c1];
+         ++codesize[c1];
+      }
+      others[c1] = c2;
+      ++codesize[c2];
+      while (others[c2] >= 0) {
+         c2 = others[c2];
+         ++codesize[c2];
+      }
+   }
+
+   for(i = 0; i <= 32; ++i)
+      bits[i] = 0;
+   for(i = 0; i <= 256; ++i)
+      if (codesize[i])
+         ++bits[codesize[i] > 32 ? 32 : codesize[i]];
+
+   // JPEG limits code lengths to 16 bits; move overlong codes up the tree
+   for(i = 32; i > 16; --i) {
+      while (bits[i] > 0) {
+         j = i - 2;
+         while (bits[j] == 0)
+            --j;
+         bits[i] -= 2;
+         bits[i-1] += 1;
+         bits[j+1] += 2;
+         bits[j] -= 1;
+      }
+   }
+   // remove the reserved code point from the longest codes
+   while (i > 0 && bits[i] == 0)
+      --i;
+   if (i > 0)
+      --bits[i];
+
+   nrcodes[0] = 0;
+   for(i = 1; i <= 16; ++i)
+      nrcodes[i] = (unsigned char) bits[i];
+   for(i = 1, k = 0; i <= 32; ++i)
+      for(j = 0; j < 256; ++j)
+         if (codesize[j] == i)
+            values[k++] = (unsigned char) j;
+}
+
+static void stbiw__jpg_buildHT(const unsigned char *nrcodes, const unsigned char *values, unsigned short HT[256][2]) {
+   int len, i, k = 0, code = 0;
+   memset(HT, 0, sizeof(unsigned short)*256*2);
+   for(len = 1; len <= 16; ++len) {
+      for(i = 0; i < nrcodes[len]; ++i, ++k) {
+         HT[values[k]][0] = (unsigned short) code++;
+         HT[values[k]][1] = (unsigned short) len;
+      }
+      code <<= 1;
+   }
+}
+
+static void stbiw__jpg_writeDHT(stbi__write_context *s, int tc_th, const unsigned char *nrcodes, const unsigned char *values) {
+   int i, n = 0;
+   for(i = 1; i <= 16; ++i)
+      n += nrcodes[i];
+   stbiw__putc(s, 0xFF);
+   stbiw__putc(s, 0xC4);
+   stbiw__putc(s, STBIW_UCHAR((19+n)>>8));
+   stbiw__putc(s, STBIW_UCHAR(19+n));
+   stbiw__putc(s, STBIW_UCHAR(tc_th));
+   s->func(s->context, (void*)(nrcodes+1), 16);
+   s->func(s->context, (void*)values, n);
+}
+
+typedef struct
+{
+   unsigned short HT[256][2];
+   unsigned int freq[257];
+   unsigned char nrcodes[17], values[256];
+} stbiw__jpg_huff;
+
+// the encoders take const tables (the default ones are static const), and C
+// before C23 won't add const to a pointer to array implicitly
+#define stbiw__jpg_constHT(h)  ((const unsigned short (*)[2]) (h)->HT)
+
+// quantized coefficients for the whole image, kept around when the writer
+// needs more than one pass over them (optimized tables, progressive scans)
+typedef struct
+{
+   short *coef[3];
+   int hs[3], vs[3];         // sampling factors
+   int bw[3], bh[3];         // blocks per row/column, padded to whole MCUs
+   int cw[3], ch[3];         // blocks actually covering each component
+   int mcux, mcuy;
+} stbiw__jpg_coefs;
+
+static short *stbiw__jpg_block(const stbiw__jpg_coefs *c, int comp, int bx, int by) {
+   return c->coef[comp] + ((size_t)by*c->bw[comp] + bx)*64;
+}
+
+// average 'in' (an MCU of 8*hs x 8*vs chroma samples) down to one 8x8 block
+static void stbiw__jpg_downsample(const float *in, float *out, int hs, int vs) {
+   int stride = 8*hs, yy;
+   for(yy = 0; yy < 8; ++yy, out += 8) {
+      const float *r0 = in + yy*vs*stride;
+      const float *r1 = r0 + stride;
+      if (vs == 2) {
+#if defined(STBIW_SSE2)
+         __m128 a0 = _mm_loadu_ps(r0), a1 = _mm_loadu_ps(r0+4), a2 = _mm_loadu_ps(r0+8), a3 = _mm_loadu_ps(r0+12);
+         __m128 b0 = _mm_loadu_ps(r1), b1 = _mm_loadu_ps(r1+4), b2 = _mm_loadu_ps(r1+8), b3 = _mm_loadu_ps(r1+12);
+         __m128 quarter = _mm_set1_ps(0.25f);
+         // same summation order as the scalar path, so results are bit-identical
+         __m128 lo = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_shuffle_ps(a0,a1,_MM_SHUFFLE(2,0,2,0)), _mm_shuffle_ps(a0,a1,_MM_SHUFFLE(3,1,3,1))),
+                                                      _mm_shuffle_ps(b0,b1,_MM_SHUFFLE(2,0,2,0))), _mm_shuffle_ps(b0,b1,_MM_SHUFFLE(3,1,3,1)));
+         __m128 hi = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_shuffle_ps(a2,a3,_MM_SHUFFLE(2,0,2,0)), _mm_shuffle_ps(a2,a3,_MM_SHUFFLE(3,1,3,1))),
+                                                      _mm_shuffle_ps(b2,b3,_MM_SHUFFLE(2,0,2,0))), _mm_shuffle_ps(b2,b3,_MM_SHUFFLE(3,1,3,1)));
+         _mm_storeu_ps(out,   _mm_mul_ps(lo, quarter));
+         _mm_storeu_ps(out+4, _mm_mul_ps(hi, quarter));
+#elif defined(STBIW_NEON)
+         float32x4x2_t a01 = vuzpq_f32(vld1q_f32(r0), vld1q_f32(r0+4)), a23 = vuzpq_f32(vld1q_f32(r0+8), vld1q_f32(r0+12));
+         float32x4x2_t b01 = vuzpq_f32(vld1q_f32(r1), vld1q_f32(r1+4)), b23 = vuzpq_f32(vld1q_f32(r1+8), vld1q_f32(r1+12));
+         vst1q_f32(out,   vmulq_n_f32(vaddq_f32(vaddq_f32(vaddq_f32(a01.val[0], a01.val[1]), b01.val[0]), b01.val[1]), 0.25f));
+         vst1q_f32(out+4, vmulq_n_f32(vaddq_f32(vaddq_f32(vaddq_f32(a23.val[0], a23.val[1]), b23.val[0]), b23.val[1]), 0.25f));
+#else
+         int xx;
+         for(xx = 0; xx < 8; ++xx)
+            out[xx] = (r0[xx*2] + r0[xx*2+1] + r1[xx*2] + r1[xx*2+1]) * 0.25f;
+#endif
+      } else if (hs == 2) {
+#if defined(STBIW_SSE2)
+         __m128 a0 = _mm_loadu_ps(r0), a1 = _mm_loadu_ps(r0+4), a2 = _mm_loadu_ps(r0+8), a3 = _mm_loadu_ps(r0+12);
+         __m128 half = _mm_set1_ps(0.5f);
+         _mm_storeu_ps(out,   _mm_mul_ps(_mm_add_ps(_mm_shuffle_ps(a0,a1,_MM_SHUFFLE(2,0,2,0)), _mm_shuffle_ps(a0,a1,_MM_SHUFFLE(3,1,3,1))), half));
+         _mm_storeu_ps(out+4, _mm_mul_ps(_mm_add_ps(_mm_shuffle_ps(a2,a3,_MM_SHUFFLE(2,0,2,0)), _mm_shuffle_ps(a2,a3,_MM_SHUFFLE(3,1,3,1))), half));
+#elif defined(STBIW_NEON)
+         float32x4x2_t a01 = vuzpq_f32(vld1q_f32(r0), vld1q_f32(r0+4)), a23 = vuzpq_f32(vld1q_f32(r0+8), vld1q_f32(r0+12));
+         vst1q_f32(out,   vmulq_n_f32(vaddq_f32(a01.val[0], a01.val[1]), 0.5f));
+         vst1q_f32(out+4, vmulq_n_f32(vaddq_f32(a23.val[0], a23.val[1]), 0.5f));
+#else
+         int xx;
+         for(xx = 0; xx < 8; ++xx)
+            out[xx] = (r0[xx*2] + r0[xx*2+1]) * 0.5f;
+#endif
+      }
+   }
+}
+
+static void stbiw__jpg_storeDU(float *CDU, int du_stride, float *fdtbl, short *coef) {
+   int DU[64], i;
+   stbiw__jpg_quantizeDU(CDU, du_stride, fdtbl, DU);
+   for(i = 0; i < 64; ++i)
+      coef[i] = (short) DU[i];
+}
+
+static void stbiw__jpg_encodeBlock(stbi__write_context *s, int *bitBuf, int *bitCnt, const short *coef, int Ss, int Se, int *DC, int *eobrun, stbiw__jpg_huff *dc, stbiw__jpg_huff *ac, int gather) {
+   int DU[64], i;
+   for(i = 0; i < 64; ++i)
+      DU[i] = coef[i];
+   if (Ss == 0) {
+      stbiw__jpg_encodeDC(s, bitBuf, bitCnt, DU[0] - *DC, stbiw__jpg_constHT(dc), gather ? dc->freq : NULL);
+      *DC = DU[0];
+   }
+   if (Se > 0)
+      stbiw__jpg_encodeAC(s, bitBuf, bitCnt, DU, Ss ? Ss : 1, Se, stbiw__jpg_constHT(ac), gather ? ac->freq : NULL, Ss ? eobrun : NULL);
+}
+
+// codes one scan over stored coefficients; if 'gather' is set nothing is written
+// and the symbol statistics are accumulated into the tables instead
+static void stbiw__jpg_encodeScan(stbi__write_context *s, const stbiw__jpg_coefs *c, int ncomp, const int *comps, int Ss, int Se, stbiw__jpg_huff **dc, stbiw__jpg_huff **ac, int gather) {
+   static const unsigned short fillBits[] = {0x7F, 7};
+   int bitBuf = 0, bitCnt = 0, eobrun = 0;
+   int DC[3] = { 0, 0, 0 };
+   int i, x, y, h, v;
+
+   if (ncomp == 1) {
+      // non-interleaved scans only cover the blocks inside the component
+      int ci = comps[0];
+      for(y = 0; y < c->ch[ci]; ++y)
+         for(x = 0; x < c->cw[ci]; ++x)
+            stbiw__jpg_encodeBlock(s, &bitBuf, &bitCnt, stbiw__jpg_block(c, ci, x, y), Ss, Se, &DC[0], &eobrun, dc[0], ac[0], gather);
+   } else {
+      for(y = 0; y < c->mcuy; ++y)
+         for(x = 0; x < c->mcux; ++x)
+            for(i = 0; i < ncomp; ++i) {
+               int ci = comps[i];
+               for(v = 0; v < c->vs[ci]; ++v)
+                  for(h = 0; h < c->hs[ci]; ++h)
+                     stbiw__jpg_encodeBlock(s, &bitBuf, &bitCnt, stbiw__jpg_block(c, ci, x*c->hs[ci]+h, y*c->vs[ci]+v), Ss, Se, &DC[i], &eobrun, dc[i], ac[i], gather);
+            }
+   }
+   if (Ss)
+      stbiw__jpg_flushEOBRun(s, &bitBuf, &bitCnt, &eobrun, stbiw__jpg_constHT(ac[0]), gather ? ac[0]->freq : NULL);
+   if (!gather)
+      stbiw__jpg_writeBits(s, &bitBuf, &bitCnt, fillBits);
+}
+
+// gathers statistics for a scan, then writes its optimized tables, the SOS header, and the data
+static void stbiw__jpg_writeScan(stbi__write_context *s, const stbiw__jpg_coefs *c, int ncomp, const int *comps, int Ss, int Se, stbiw__jpg_huff *tables) {
+   stbiw__jpg_huff *dc[3], *ac[3];
+   int i;
+   memset(tables, 0, sizeof(stbiw__jpg_huff)*4);
+   // table 0 is used for luma, table 1 for chroma
+   for(i = 0; i < ncomp; ++i) {
+      dc[i] = &tables[comps[i] ? 1 : 0];
+      ac[i] = &tables[comps[i] ? 3 : 2];
+   }
+   stbiw__jpg_encodeScan(s, c, ncomp, comps, Ss, Se, dc, ac, 1);
+   for(i = 0; i < 4; ++i) {
+      int k, used = 0;
+      for(k = 0; k < 256; ++k)
+         used |= tables[i].freq[k] != 0;
+      if (!used)
+         continue;
+      stbiw__jpg_optimalHuffman(tables[i].freq, tables[i].nrcodes, tables[i].values);
+      stbiw__jpg_buildHT(tables[i].nrcodes, tables[i].values, tables[i].HT);
+      stbiw__jpg_writeDHT(s, ((i>>1)<<4) | (i&1), tables[i].nrcodes, tables[i].values);
+   }
+
+   stbiw__putc(s, 0xFF);
+   stbiw__putc(s, 0xDA);
+   stbiw__putc(s, 0);
+   stbiw__putc(s, STBIW_UCHAR(6+2*ncomp));
+   stbiw__putc(s, STBIW_UCHAR(ncomp));
+   for(i = 0; i < ncomp; ++i) {
+      stbiw__putc(s, STBIW_UCHAR(comps[i]+1));
+      stbiw__putc(s, comps[i] ? 0x11 : 0x00);
+   }
+   stbiw__putc(s, STBIW_UCHAR(Ss));
+   stbiw__putc(s, STBIW_UCHAR(Se));
+   stbiw__putc(s, 0);
+
+   stbiw__jpg_encodeScan(s, c, ncomp, comps, Ss, Se, dc, ac, 0);
+}
+
 static int stbi_write_jpg_core(stbi__write_context *s, int width, int height, int comp, const void* data, int quality) {
    // Constants that don't pollute global namespace
    static const unsigned char std_dc_luminance_nrcodes[] = {0,0,1,5,1,1,1,1,1,1,0,0,0,0,0,0,0};
@@ -1467,18 +1970,27 @@ static int stbi_write_jpg_core(stbi__write_context *s, int width, int height, in
    static const float aasf[] = { 1.0f * 2.828427125f, 1.387039845f * 2.828427125f, 1.306562965f * 2.828427125f, 1.175875602f * 2.828427125f,
                                  1.0f * 2.828427125f, 0.785694958f * 2.828427125f, 0.541196100f * 2.828427125f, 0.275899379f * 2.828427125f };
 
-   int row, col, i, k, subsample;
+   int row, col, i, k, hs, vs, optimize;
    float fdtbl_Y[64], fdtbl_UV[64];
    unsigned char YTable[64], UVTable[64];
+   stbiw__jpg_coefs coefs;
 
    if(!data || !width || !height || comp > 4 || comp < 1) {
       return 0;
    }
 
    quality = quality ? quality : 90;
-   subsample = quality <= 90 ? 1 : 0;
+   // luma sampling factors; chroma is always 1x1, so 2x2 is 4:2:0 and 2x1 is 4:2:2
+   switch (stbi_write_jpg_chroma_subsampling) {
+      case 444: hs = 1; vs = 1; break;
+      case 422: hs = 2; vs = 1; break;
+      case 420: hs = 2; vs = 2; break;
+      default:  hs = vs = quality <= 90 ? 2 : 1; break;
+   }
    quality = quality < 1 ? 1 : quality > 100 ? 100 : quality;
    quality = quality < 50 ? 5000 / quality : 200 - quality * 2;
+   // progressive scans need tables with EOB-run symbols, so they always use optimized tables
+   optimize = stbi_write_jpg_optimize_huffman || stbi_write_jpg_progressive;
 
    for(i = 0; i < 64; ++i) {
       int uvti, yti = (YQT[i]*quality+50)/100;
@@ -1494,29 +2006,53 @@ static int stbi_write_jpg_core(stbi__write_context *s, int width, int height, in
       }
    }
 
+   if (optimize) {
+      // optimized tables need a first pass over the symbols, so keep all the coefficients
+      coefs.mcux = (width  + 8*hs-1) / (8*hs);
+      coefs.mcuy = (height + 8*vs-1) / (8*vs);
+      for(i = 0; i < 3; ++i) {
+         coefs.hs[i] = i ? 1 : hs;
+         coefs.vs[i] = i ? 1 : vs;
+         coefs.bw[i] = coefs.mcux * coefs.hs[i];
+         coefs.bh[i] = coefs.mcuy * coefs.vs[i];
+         coefs.cw[i] = ((width  * coefs.hs[i] + hs-1) / hs + 7) >> 3;
+         coefs.ch[i] = ((height * coefs.vs[i] + vs-1) / vs + 7) >> 3;
+         coefs.coef[i] = (short *) STBIW_MALLOC((size_t) coefs.bw[i] * coefs.bh[i] * 64 * sizeof(short));
+         if (!coefs.coef[i]) {
+            while (i--)
+               STBIW_FREE(coefs.coef[i]);
+            return 0;
+         }
+      }
+   }
+
    // Write Headers
    {
       static const unsigned char head0[] = { 0xFF,0xD8,0xFF,0xE0,0,0x10,'J','F','I','F',0,1,1,0,0,1,0,1,0,0,0xFF,0xDB,0,0x84,0 };
       static const unsigned char head2[] = { 0xFF,0xDA,0,0xC,3,1,0,2,0x11,3,0x11,0,0x3F,0 };
-      const unsigned char head1[] = { 0xFF,0xC0,0,0x11,8,(unsigned char)(height>>8),STBIW_UCHAR(height),(unsigned char)(width>>8),STBIW_UCHAR(width),
-                                      3,1,(unsigned char)(subsample?0x22:0x11),0,2,0x11,1,3,0x11,1,0xFF,0xC4,0x01,0xA2,0 };
+      static const unsigned char dht[] = { 0xFF,0xC4,0x01,0xA2,0 };
+      const unsigned char head1[] = { 0xFF,(unsigned char)(stbi_write_jpg_progressive?0xC2:0xC0),0,0x11,8,(unsigned char)(height>>8),STBIW_UCHAR(height),(unsigned char)(width>>8),STBIW_UCHAR(width),
+                                      3,1,(unsigned char)((hs<<4)|vs),0,2,0x11,1,3,0x11,1 };
       s->func(s->context, (void*)head0, sizeof(head0));
       s->func(s->context, (void*)YTable, sizeof(YTable));
       stbiw__putc(s, 1);
       s->func(s->context, UVTable, sizeof(UVTable));
       s->func(s->context, (void*)head1, sizeof(head1));
-      s->func(s->context, (void*)(std_dc_luminance_nrcodes+1), sizeof(std_dc_luminance_nrcodes)-1);
-      s->func(s->context, (void*)std_dc_luminance_values, sizeof(std_dc_luminance_values));
-      stbiw__putc(s, 0x10); // HTYACinfo
-      s->func(s->context, (void*)(std_ac_luminance_nrcodes+1), sizeof(std_ac_luminance_nrcodes)-1);
-      s->func(s->context, (void*)std_ac_luminance_values, sizeof(std_ac_luminance_values));
-      stbiw__putc(s, 1); // HTUDCinfo
-      s->func(s->context, (void*)(std_dc_chrominance_nrcodes+1), sizeof(std_dc_chrominance_nrcodes)-1);
-      s->func(s->context, (void*)std_dc_chrominance_values, sizeof(std_dc_chrominance_values));
-      stbiw__putc(s, 0x11); // HTUACinfo
-      s->func(s->context, (void*)(std_ac_chrominance_nrcodes+1), sizeof(std_ac_chrominance_nrcodes)-1);
-      s->func(s->context, (void*)std_ac_chrominance_values, sizeof(std_ac_chrominance_values));
-      s->func(s->context, (void*)head2, sizeof(head2));
+      if (!optimize) {
+         s->func(s->context, (void*)dht, sizeof(dht));
+         s->func(s->context, (void*)(std_dc_luminance_nrcodes+1), sizeof(std_dc_luminance_nrcodes)-1);
+         s->func(s->context, (void*)std_dc_luminance_values, sizeof(std_dc_luminance_values));
+         stbiw__putc(s, 0x10); // HTYACinfo
+         s->func(s->context, (void*)(std_ac_luminance_nrcodes+1), sizeof(std_ac_luminance_nrcodes)-1);
+         s->func(s->context, (void*)std_ac_luminance_values, sizeof(std_ac_luminance_values));
+         stbiw__putc(s, 1); // HTUDCinfo
+         s->func(s->context, (void*)(std_dc_chrominance_nrcodes+1), sizeof(std_dc_chrominance_nrcodes)-1);
+         s->func(s->context, (void*)std_dc_chrominance_values, sizeof(std_dc_chrominance_values));
+         stbiw__putc(s, 0x11); // HTUACinfo
+         s->func(s->context, (void*)(std_ac_chrominance_nrcodes+1), sizeof(std_ac_chrominance_nrcodes)-1);
+         s->func(s->context, (void*)std_ac_chrominance_values, sizeof(std_ac_chrominance_values));
+         s->func(s->context, (void*)head2, sizeof(head2));
+      }
    }
 
    // Encode 8x8 macroblocks
@@ -1529,72 +2065,75 @@ static int stbi_write_jpg_core(stbi__write_context *s, int width, int height, in
       const unsigned char *dataR = (const unsigned char *)data;
       const unsigned char *dataG = dataR + ofsG;
       const unsigned char *dataB = dataR + ofsB;
-      int x, y, pos;
-      if(subsample) {
-         for(y = 0; y < height; y += 16) {
-            for(x = 0; x < width; x += 16) {
-               float Y[256], U[256], V[256];
-               for(row = y, pos = 0; row < y+16; ++row) {
-                  // row >= height => use last input row
-                  int clamped_row = (row < height) ? row : height - 1;
-                  int base_p = (stbi__flip_vertically_on_write ? (height-1-clamped_row) : clamped_row)*width*comp;
-                  for(col = x; col < x+16; ++col, ++pos) {
-                     // if col >= width => use pixel from last input column
-                     int p = base_p + ((col < width) ? col : (width-1))*comp;
-                     float r = dataR[p], g = dataG[p], b = dataB[p];
-                     Y[pos]= +0.29900f*r + 0.58700f*g + 0.11400f*b - 128;
-                     U[pos]= -0.16874f*r - 0.33126f*g + 0.50000f*b;
-                     V[pos]= +0.50000f*r - 0.41869f*g - 0.08131f*b;
-                  }
-               }
-               DCY = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, Y+0,   16, fdtbl_Y, DCY, YDC_HT, YAC_HT);
-               DCY = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, Y+8,   16, fdtbl_Y, DCY, YDC_HT, YAC_HT);
-               DCY = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, Y+128, 16, fdtbl_Y, DCY, YDC_HT, YAC_HT);
-               DCY = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, Y+136, 16, fdtbl_Y, DCY, YDC_HT, YAC_HT);
-
-               // subsample U,V
-               {
-                  float subU[64], subV[64];
-                  int yy, xx;
-                  for(yy = 0, pos = 0; yy < 8; ++yy) {
-                     for(xx = 0; xx < 8; ++xx, ++pos) {
-                        int j = yy*32+xx*2;
-                        subU[pos] = (U[j+0] + U[j+1] + U[j+16] + U[j+17]) * 0.25f;
-                        subV[pos] = (V[j+0] + V[j+1] + V[j+16] + V[j+17]) * 0.25f;
-                     }
-                  }
-                  DCU = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, subU, 8, fdtbl_UV, DCU, UVDC_HT, UVAC_HT);
-                  DCV = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, subV, 8, fdtbl_UV, DCV, UVDC_HT, UVAC_HT);
+      int mcuw = 8*hs, mcuh = 8*vs;
+      int x, y, mx, my, pos;
+      for(y = 0, my = 0; y < height; y += mcuh, ++my) {
+         for(x = 0, mx = 0; x < width; x += mcuw, ++mx) {
+            float Y[256], U[256], V[256];
+            float *CU = U, *CV = V;
+            float subU[64], subV[64];
+            for(row = y, pos = 0; row < y+mcuh; ++row) {
+               // row >= height => use last input row
+               int clamped_row = (row < height) ? row : height - 1;
+               int base_p = (stbi__flip_vertically_on_write ? (height-1-clamped_row) : clamped_row)*width*comp;
+               for(col = x; col < x+mcuw; ++col, ++pos) {
+                  // if col >= width => use pixel from last input column
+                  int p = base_p + ((col < width) ? col : (width-1))*comp;
+                  float r = dataR[p], g = dataG[p], b = dataB[p];
+                  Y[pos]= +0.29900f*r + 0.58700f*g + 0.11400f*b - 128;
+                  U[pos]= -0.16874f*r - 0.33126f*g + 0.50000f*b;
+                  V[pos]= +0.50000f*r - 0.41869f*g - 0.08131f*b;
                }
             }
-         }
-      } else {
-         for(y = 0; y < height; y += 8) {
-            for(x = 0; x < width; x += 8) {
-               float Y[64], U[64], V[64];
-               for(row = y, pos = 0; row < y+8; ++row) {
-                  // row >= height => use last input row
-                  int clamped_row = (row < height) ? row : height - 1;
-                  int base_p = (stbi__flip_vertically_on_write ? (height-1-clamped_row) : clamped_row)*width*comp;
-                  for(col = x; col < x+8; ++col, ++pos) {
-                     // if col >= width => use pixel from last input column
-                     int p = base_p + ((col < width) ? col : (width-1))*comp;
-                     float r = dataR[p], g = dataG[p], b = dataB[p];
-                     Y[pos]= +0.29900f*r + 0.58700f*g + 0.11400f*b - 128;
-                     U[pos]= -0.16874f*r - 0.33126f*g + 0.50000f*b;
-                     V[pos]= +0.50000f*r - 0.41869f*g - 0.08131f*b;
-                  }
-               }
 
-               DCY = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, Y, 8, fdtbl_Y,  DCY, YDC_HT, YAC_HT);
-               DCU = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, U, 8, fdtbl_UV, DCU, UVDC_HT, UVAC_HT);
-               DCV = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, V, 8, fdtbl_UV, DCV, UVDC_HT, UVAC_HT);
+            // subsample U,V
+            if (hs > 1 || vs > 1) {
+               stbiw__jpg_downsample(U, subU, hs, vs);
+               stbiw__jpg_downsample(V, subV, hs, vs);
+               CU = subU;
+               CV = subV;
+            }
+
+            if (optimize) {
+               for(k = 0; k < hs*vs; ++k)
+                  stbiw__jpg_storeDU(Y + (k/hs)*8*mcuw + (k%hs)*8, mcuw, fdtbl_Y, stbiw__jpg_block(&coefs, 0, mx*hs + k%hs, my*vs + k/hs));
+               stbiw__jpg_storeDU(CU, 8, fdtbl_UV, stbiw__jpg_block(&coefs, 1, mx, my));
+               stbiw__jpg_storeDU(CV, 8, fdtbl_UV, stbiw__jpg_block(&coefs, 2, mx, my));
+            } else {
+               for(k = 0; k < hs*vs; ++k)
+                  DCY = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, Y + (k/hs)*8*mcuw + (k%hs)*8, mcuw, fdtbl_Y, DCY, YDC_HT, YAC_HT);
+               DCU = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, CU, 8, fdtbl_UV, DCU, UVDC_HT, UVAC_HT);
+               DCV = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, CV, 8, fdtbl_UV, DCV, UVDC_HT, UVAC_HT);
             }
          }
       }
 
       // Do the bit alignment of the EOI marker
-      stbiw__jpg_writeBits(s, &bitBuf, &bitCnt, fillBits);
+      if (!optimize)
+         stbiw__jpg_writeBits(s, &bitBuf, &bitCnt, fillBits);
+   }
+
+   if (optimize) {
+      static const int all[3] = { 0, 1, 2 };
+      stbiw__jpg_huff *tables = (stbiw__jpg_huff *) STBIW_MALLOC(4*sizeof(stbiw__jpg_huff));
+      if (tables) {
+         if (stbi_write_jpg_progressive) {
+            // DC first, then the low luma frequencies, so a coarse preview appears early
+            static const int Y = 0, Cb = 1, Cr = 2;
+            stbiw__jpg_writeScan(s, &coefs, 3, all, 0,  0, tables);
+            stbiw__jpg_writeScan(s, &coefs, 1, &Y,  1,  5, tables);
+            stbiw__jpg_writeScan(s, &coefs, 1, &Cb, 1, 63, tables);
+            stbiw__jpg_writeScan(s, &coefs, 1, &Cr, 1, 63, tables);
+            stbiw__jpg_writeScan(s, &coefs, 1, &Y,  6, 63, tables);
+         } else {
+            stbiw__jpg_writeScan(s, &coefs, 3, all, 0, 63, tables);
+         }
+         STBIW_FREE(tables);
+      }
+      for(i = 0; i < 3; ++i)
+         STBIW_FREE(coefs.coef[i]);
+      if (!tables)
+         return 0;
    }
 
    // EOI
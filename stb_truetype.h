@@ -16,6 +16,8 @@
 //        extract glyph shapes
 //        render glyphs to one-channel bitmaps with antialiasing (box filter)
 //        render glyphs to one-channel SDF bitmaps (signed-distance field/function)
+//        render glyphs to three-channel MSDF bitmaps (multi-channel distance field)
+//        render glyphs to RGB subpixel bitmaps for LCD screens
 //
 //   Todo:
 //        non-MS cmaps
@@ -137,6 +139,12 @@
 //        #define STBTT_RASTERIZER_VERSION 1
 //   which will incur about a 15% speed hit.
 //
+//   The new rasterizer accumulates long edge spans and converts its coverage
+//   to 8-bit with SSE2 when the compiler targets it; #define STBTT_NEON to use
+//   NEON on ARM, or STBTT_NO_SIMD to disable both. The SIMD spans round a
+//   little differently, so a few pixels of large glyphs can differ by 1 from
+//   the scalar build.
+//
 // ADDITIONAL DOCUMENTATION
 //
 //   Immediately after this block comment are a series of sample programs.
@@ -673,6 +681,30 @@ STBTT_DEF int  stbtt_PackFontRangesRenderIntoRects(stbtt_pack_context *spc, cons
 // better packing than calling PackFontRanges multiple times
 // (or it may not).
 
+typedef void stbtt_task_func(void *task_data, int task_index);
+typedef void stbtt_dispatch_callback(stbtt_task_func *task, void *task_data, int task_count, void *dispatch_context);
+STBTT_DEF int  stbtt_PackFontRangesRenderIntoRectsThreaded(stbtt_pack_context *spc, const stbtt_fontinfo *info, stbtt_pack_range *ranges, int num_ranges, stbrp_rect *rects,
+                                                           int split_count, stbtt_dispatch_callback *dispatch, void *dispatch_context);
+// Same as stbtt_PackFontRangesRenderIntoRects, but the glyphs are rasterized
+// as split_count tasks through your job system: dispatch must call
+// task(task_data, i) once for every i from 0 to task_count-1, on any threads
+// in any order, and only return once they have all finished. A few splits per
+// thread balances best. If dispatch is NULL, the splits run on this thread.
+// The atlas comes out identical to the single-threaded version.
+//
+// Every split rasterizes with its own temporary memory, so the only shared
+// state is your allocator: STBTT_malloc must be thread-safe (or give each
+// worker thread an stbtt_scratch, see stbtt_SetThreadScratch). The fontinfo
+// is only read, so don't build or free its lookup tables during the call.
+
+STBTT_DEF void stbtt_PackFontRangesRenderSplit(stbtt_pack_context *spc, const stbtt_fontinfo *info, stbtt_pack_range *ranges, int num_ranges, stbrp_rect *rects, int split_index, int split_count);
+STBTT_DEF int  stbtt_PackFontRangesFinishSplits(stbtt_pack_context *spc, const stbtt_fontinfo *info, stbtt_pack_range *ranges, int num_ranges, stbrp_rect *rects);
+// If you'd rather run the threads yourself: call RenderSplit with split_index
+// 0 to split_count-1 (each exactly once, on any threads), then FinishSplits
+// on one thread once they're all done. FinishSplits fills in the glyphs that
+// reuse the missing glyph, adjusts the rects for padding, and returns what
+// stbtt_PackFontRangesRenderIntoRects would have.
+
 // this is an opaque structure that you shouldn't mess with which holds
 // all the context needed from PackBegin to PackEnd.
 struct stbtt_pack_context {
@@ -688,6 +720,157 @@ struct stbtt_pack_context {
    void  *nodes;
 };
 
+//////////////////////////////////////////////////////////////////////////////
+//
+// GLYPH CACHE API
+//
+// For fonts with too many glyphs to pack up front (CJK, emoji), this keeps
+// an atlas of fixed-size pages that glyphs are rasterized into on demand,
+// packed with stb_rect_pack.h (or the simple packer above if you don't
+// have it). Glyphs are keyed on font, glyph index, scale and horizontal
+// subpixel bucket. When no page has room, the least recently used page is
+// evicted: its glyphs are dropped, the page is cleared and repacked from
+// scratch with whatever is requested next.
+//
+// A page that has been used in the current frame is never evicted, since
+// its quads may still be waiting to be drawn; call stbtt_GlyphCacheNextFrame
+// after you flush your draws. If every page is in use this frame, the
+// lookup fails and you should flush, advance the frame and try again.
+//
+// The cache stores the stbtt_fontinfo pointer, so fonts must outlive it.
+
+typedef struct stbtt_glyphcache stbtt_glyphcache;
+
+typedef struct
+{
+   unsigned int hits, misses;  // lookups that found / rasterized the glyph
+   unsigned int evictions;     // pages evicted
+   unsigned int failures;      // lookups that couldn't be cached
+   int glyphs;                 // glyphs currently cached
+} stbtt_glyphcache_stats;
+
+STBTT_DEF int  stbtt_GlyphCacheBegin(stbtt_glyphcache *gc, unsigned char *pixels, int width, int height, int num_pages, int max_glyphs, int padding, void *alloc_context);
+// Initializes a glyph cache stored in the passed-in stbtt_glyphcache.
+// 'pixels' holds num_pages 1-channel bitmaps of width * height, one after
+// the other (page p starts at pixels + p*width*height). At most max_glyphs
+// glyphs are cached at once; when that runs out a page is evicted just as
+// if the pages were full. 'padding' is as for stbtt_PackBegin.
+//
+// Returns 0 on failure, 1 on success.
+
+STBTT_DEF void stbtt_GlyphCacheEnd(stbtt_glyphcache *gc);
+// Frees all memory used by the cache (but not the pixels).
+
+STBTT_DEF void stbtt_GlyphCacheSetSubpixelBuckets(stbtt_glyphcache *gc, int buckets);
+// Sets how many horizontal subpixel positions each glyph is rasterized at
+// (1..STBTT_MAX_OVERSAMPLE, default 1). Each position is cached separately.
+// Call before looking up any glyphs.
+
+STBTT_DEF void stbtt_GlyphCacheNextFrame(stbtt_glyphcache *gc);
+// Marks the end of a frame: pages used before this call may be evicted.
+
+STBTT_DEF int  stbtt_GlyphCacheGet(stbtt_glyphcache *gc, const stbtt_fontinfo *info, int glyph, float scale, float x_fraction, stbtt_packedchar *glyphdata);
+// Looks up a glyph, rasterizing it into the atlas if it isn't there, and
+// fills out 'glyphdata' for it. Returns the page it's on, or -1 if it can't
+// be cached (bigger than a page, or every page is in use this frame).
+//
+// x_fraction is the fractional part of the pen position, x - floor(x); the
+// glyph is rasterized shifted by that amount rounded down to a subpixel
+// bucket, so draw it at floor(x). To draw, pass glyphdata to
+// stbtt_GetPackedQuad with char_index 0 and the page width/height. Glyphs
+// with no pixels (e.g. spaces) get an empty box.
+
+STBTT_DEF int  stbtt_GlyphCacheGetDirtyRect(stbtt_glyphcache *gc, int page, int *x0, int *y0, int *x1, int *y1);
+// Returns 1 and the rectangle of 'page' changed since the last call (so you
+// can update just that part of your texture), or 0 if it hasn't changed.
+
+STBTT_DEF void stbtt_GlyphCacheGetStats(stbtt_glyphcache *gc, stbtt_glyphcache_stats *stats, int reset);
+// Reports hit, miss and eviction counts since Begin or the last reset;
+// the hit rate is hits / (hits + misses). If reset != 0, zeroes the counts.
+
+// this is an opaque structure that you shouldn't mess with which holds
+// all the context needed from GlyphCacheBegin to GlyphCacheEnd.
+struct stbtt_glyphcache {
+   void *user_allocator_context;
+   unsigned char *pixels;
+   int   width;
+   int   height;
+   int   num_pages;
+   int   padding;
+   int   subpixel_buckets;
+   int   max_glyphs;
+   int   hash_mask;
+   int   free_list;
+   int   current_page;
+   unsigned int frame;
+   void *pages;
+   void *entries;
+   int  *hash;
+   stbtt_glyphcache_stats stats;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// TEXT LAYOUT API
+//
+// Lays out UTF-8 text at one size: maps codepoints to glyphs, applies the
+// advances and kerning, and wraps lines at spaces, all in one loop over the
+// string. stbtt_LayoutBegin precomputes every glyph's scaled advance; the
+// rest uses the ordinary lookups, so call stbtt_BuildGlyphLookup and
+// stbtt_BuildKernIndex on the font to make those table reads too (and
+// stbtt_BuildShapeCache for CFF fonts, or every glyph box runs a charstring).
+//
+// Coordinates are in pixels with y increasing downwards, and positions are
+// on the baseline, as for stbtt_GetBakedQuad.
+
+typedef struct
+{
+   int   glyph;             // glyph index, 0 if the font doesn't have the codepoint
+   int   offset;            // byte offset of the codepoint in the text
+   float x, y;              // pen position
+   float x0,y0,x1,y1;       // the glyph's box, e.g. to look up in stbtt_GlyphCacheGet
+} stbtt_layoutglyph;
+
+typedef struct stbtt_layout stbtt_layout;
+
+STBTT_DEF int  stbtt_LayoutBegin(stbtt_layout *lo, const stbtt_fontinfo *info, float scale, void *alloc_context);
+// Prepares to lay out text in 'info' at 'scale' (from stbtt_ScaleForPixelHeight
+// or stbtt_ScaleForMappingEmToPixels). The font must outlive the layout.
+// Returns 0 if it runs out of memory.
+
+STBTT_DEF void stbtt_LayoutEnd(stbtt_layout *lo);
+// Frees the memory allocated by stbtt_LayoutBegin.
+
+STBTT_DEF int  stbtt_LayoutText(const stbtt_layout *lo, const char *text, int text_len, float max_width,
+                                float *xpos, float *ypos, stbtt_layoutglyph *glyphs, int max_glyphs);
+// Lays out text_len bytes of 'text' (up to the 0 byte if text_len < 0),
+// starting at *xpos, *ypos and leaving them where the next glyph would go.
+// Lines break at '\n', and when max_width > 0 also before a word that would
+// reach more than max_width past the starting x (or inside a word that is
+// too wide by itself). Each new line starts back at the starting x,
+// lo->line_height further down. Every codepoint except '\n' and '\r' gets a
+// glyph, spaces included. Returns the number of glyphs written, which
+// stops at max_glyphs.
+
+STBTT_DEF int  stbtt_LayoutLineBreak(const stbtt_layout *lo, const char *text, int text_len, float max_width, float *width);
+// Measures the first line of 'text' as stbtt_LayoutText would break it.
+// Returns the number of bytes in the line, including the spaces or '\n'
+// that end it, so the next line starts at text + the result; and sets
+// *width to the line's width without the trailing spaces. With max_width
+// <= 0 only '\n' ends a line, so this measures a single-line string.
+
+// The scaled font metrics are filled in by stbtt_LayoutBegin for you to
+// read; treat the rest as opaque.
+struct stbtt_layout {
+   const stbtt_fontinfo *info;
+   void  *user_allocator_context;
+   float  scale;
+   float  ascent, descent, line_gap;   // as stbtt_GetFontVMetrics, times scale
+   float  line_height;                 // ascent - descent + line_gap
+   float *advances;                    // advance width of every glyph, times scale
+   int    num_glyphs;
+};
+
 //////////////////////////////////////////////////////////////////////////////
 //
 // FONT LOADING
@@ -728,6 +911,10 @@ struct stbtt_fontinfo
    stbtt__buf subrs;                  // private charstring subroutines index
    stbtt__buf fontdicts;              // array of font dicts
    stbtt__buf fdselect;               // map from glyph to fontdict
+
+   void           * glyph_lookup;      // see stbtt_BuildGlyphLookup
+   void           * kern_index;        // see stbtt_BuildKernIndex
+   void           * shape_cache;       // see stbtt_BuildShapeCache
 };
 
 STBTT_DEF int stbtt_InitFont(stbtt_fontinfo *info, const unsigned char *data, int offset);
@@ -735,7 +922,9 @@ STBTT_DEF int stbtt_InitFont(stbtt_fontinfo *info, const unsigned char *data, in
 // the necessary cached info for the rest of the system. You must allocate
 // the stbtt_fontinfo yourself, and stbtt_InitFont will fill it out. You don't
 // need to do anything special to free it, because the contents are pure
-// value data with no additional data structures. Returns 0 on failure.
+// value data with no additional data structures (unless you ask for them
+// with stbtt_BuildGlyphLookup, stbtt_BuildKernIndex or stbtt_BuildShapeCache).
+// Returns 0 on failure.
 
 
 //////////////////////////////////////////////////////////////////////////////
@@ -749,6 +938,20 @@ STBTT_DEF int stbtt_FindGlyphIndex(const stbtt_fontinfo *info, int unicode_codep
 // codepoint-based functions.
 // Returns 0 if the character codepoint is not defined in the font.
 
+STBTT_DEF void stbtt_FindGlyphIndices(const stbtt_fontinfo *info, const int *codepoints, int num_codepoints, int *glyphs);
+// Converts a whole string of codepoints at once; glyphs[i] is the glyph
+// index of codepoints[i].
+
+STBTT_DEF int  stbtt_BuildGlyphLookup(stbtt_fontinfo *info);
+STBTT_DEF void stbtt_FreeGlyphLookup(stbtt_fontinfo *info);
+// stbtt_FindGlyphIndex normally searches the font's cmap every call. Call
+// stbtt_BuildGlyphLookup right after stbtt_InitFont to flatten the cmap
+// into a table (a two-level page table for the BMP and a sorted array of
+// ranges for the other planes), which makes every lookup a couple of
+// array reads. It allocates with STBTT_malloc(size, info->userdata), so
+// call stbtt_FreeGlyphLookup when you're done with the font. Returns 0
+// if it runs out of memory, in which case lookups just stay slow.
+
 
 //////////////////////////////////////////////////////////////////////////////
 //
@@ -814,6 +1017,19 @@ STBTT_DEF int  stbtt_GetKerningTable(const stbtt_fontinfo *info, stbtt_kerningen
 // stbtt_GetKerningTable never writes more than table_length entries and returns how many entries it did write.
 // The table will be sorted by (a.glyph1 == b.glyph1)?(a.glyph2 < b.glyph2):(a.glyph1 < b.glyph1)
 
+STBTT_DEF void stbtt_GetGlyphKernAdvances(const stbtt_fontinfo *info, const int *glyphs, int num_glyphs, int *advances);
+// Kerns a whole run of glyphs: advances[i] is stbtt_GetGlyphKernAdvance of
+// glyphs[i] and glyphs[i+1], and the last one is 0.
+
+STBTT_DEF int  stbtt_BuildKernIndex(stbtt_fontinfo *info);
+STBTT_DEF void stbtt_FreeKernIndex(stbtt_fontinfo *info);
+// stbtt_GetGlyphKernAdvance normally re-parses the GPOS lookups (or binary
+// searches the kern table) for every pair. stbtt_BuildKernIndex gathers
+// all the pairs into a hash table up front, and for class-based GPOS
+// kerning precomputes every glyph's classes so a pair is a table read,
+// giving the same results. It allocates with STBTT_malloc(size, info->userdata);
+// free it with stbtt_FreeKernIndex. Returns 0 if it runs out of memory.
+
 //////////////////////////////////////////////////////////////////////////////
 //
 // GLYPH SHAPES (you probably don't need these, but they have to go before
@@ -857,6 +1073,21 @@ STBTT_DEF int stbtt_GetGlyphShape(const stbtt_fontinfo *info, int glyph_index, s
 STBTT_DEF void stbtt_FreeShape(const stbtt_fontinfo *info, stbtt_vertex *vertices);
 // frees the data allocated above
 
+STBTT_DEF int  stbtt_BuildShapeCache(stbtt_fontinfo *info);
+STBTT_DEF void stbtt_FreeShapeCache(stbtt_fontinfo *info);
+// stbtt_GetGlyphShape normally parses the glyph out of the file every call,
+// which for CFF fonts means running its charstring program; and the bitmap
+// functions run it yet again to get the glyph's box. If you render the same
+// glyphs many times (at many sizes, or as SDFs), call stbtt_BuildShapeCache
+// after stbtt_InitFont to parse every glyph once into compact storage (just
+// the coordinates each vertex type uses, roughly half the size of the
+// stbtt_vertex arrays). After that, stbtt_GetGlyphShape only unpacks the stored
+// outline, and stbtt_GetGlyphBox and stbtt_IsGlyphEmpty don't run any
+// charstrings. The results are the same, except that coordinates a vertex
+// type doesn't use are 0. The cache is read-only once built, so threads can
+// share the font. It allocates with STBTT_malloc(size, info->userdata);
+// free it with stbtt_FreeShapeCache. Returns 0 if it runs out of memory.
+
 STBTT_DEF unsigned char *stbtt_FindSVGDoc(const stbtt_fontinfo *info, int gl);
 STBTT_DEF int stbtt_GetCodepointSVG(const stbtt_fontinfo *info, int unicode_codepoint, const char **svg);
 STBTT_DEF int stbtt_GetGlyphSVG(const stbtt_fontinfo *info, int gl, const char **svg);
@@ -938,6 +1169,52 @@ STBTT_DEF void stbtt_Rasterize(stbtt__bitmap *result,        // 1-channel bitmap
                                int invert,                   // if non-zero, vertically flip shape
                                void *userdata);              // context for to STBTT_MALLOC
 
+//////////////////////////////////////////////////////////////////////////////
+//
+// LCD (subpixel) rendering
+//
+// These render a glyph to a three-channel RGB coverage bitmap for LCD screens
+// whose pixels are made of three horizontal stripes. The glyph is rasterized
+// at three times the horizontal resolution, one sample per stripe, and then
+// run through a 5-tap FIR filter (the same weights FreeType uses by default)
+// so the color fringes stay faint. Each output pixel is three bytes; 0 is no
+// coverage, 255 is fully covered, per channel. Blend each channel of the
+// destination towards the text color by its own coverage.
+//
+// The filter spreads coverage up to two stripes sideways, so the bitmap is one
+// pixel wider on each side than the grayscale one.
+
+#define STBTT_LCD_BGR   1   // panel stripes run blue, green, red
+
+STBTT_DEF void stbtt_MakeCoverageGammaTable(unsigned char table[256], float gamma);
+// fills in a lookup table for the 'coverage_table' argument below, mapping
+// coverage c to 255 * (c/255)^(1/gamma). If you blend in sRGB (or other
+// non-linear) space, thin dark-on-light text comes out too light and thin;
+// a gamma of 1.4 to 2.2 boosts partial coverage to compensate. A gamma of
+// 1 is the identity.
+
+STBTT_DEF void stbtt_GetGlyphBitmapBoxLCD(const stbtt_fontinfo *font, int glyph, float scale_x, float scale_y, float shift_x, float shift_y, int *ix0, int *iy0, int *ix1, int *iy1);
+STBTT_DEF void stbtt_GetCodepointBitmapBoxLCD(const stbtt_fontinfo *font, int codepoint, float scale_x, float scale_y, float shift_x, float shift_y, int *ix0, int *iy0, int *ix1, int *iy1);
+// same as stbtt_GetGlyphBitmapBoxSubpixel, but widened for the LCD filter;
+// the bitmap is ix1-ix0 pixels (three times as many bytes) wide
+
+STBTT_DEF void stbtt_MakeGlyphBitmapLCD(const stbtt_fontinfo *info, unsigned char *output, int out_w, int out_h, int out_stride, float scale_x, float scale_y, float shift_x, float shift_y, const unsigned char *coverage_table, int flags, int glyph);
+STBTT_DEF void stbtt_MakeCodepointBitmapLCD(const stbtt_fontinfo *info, unsigned char *output, int out_w, int out_h, int out_stride, float scale_x, float scale_y, float shift_x, float shift_y, const unsigned char *coverage_table, int flags, int codepoint);
+// renders into 'output', which is out_w pixels (out_w*3 bytes) by out_h, with
+// rows out_stride bytes apart. Get the size and placement with
+// stbtt_GetGlyphBitmapBoxLCD first. 'coverage_table' is a 256-entry table
+// applied to every channel (see stbtt_MakeCoverageGammaTable), or NULL to
+// leave coverage linear. 'flags' is 0 or STBTT_LCD_BGR. The temporary
+// three-times-wide coverage bitmap comes from the scratch memory if one is
+// set (see SCRATCH MEMORY).
+
+STBTT_DEF unsigned char *stbtt_GetGlyphBitmapLCD(const stbtt_fontinfo *info, float scale_x, float scale_y, float shift_x, float shift_y, const unsigned char *coverage_table, int flags, int glyph, int *width, int *height, int *xoff, int *yoff);
+STBTT_DEF unsigned char *stbtt_GetCodepointBitmapLCD(const stbtt_fontinfo *info, float scale_x, float scale_y, float shift_x, float shift_y, const unsigned char *coverage_table, int flags, int codepoint, int *width, int *height, int *xoff, int *yoff);
+// allocates a width*height*3 byte bitmap and renders into it like
+// stbtt_MakeGlyphBitmapLCD; free it with stbtt_FreeBitmap. *width is in
+// pixels, and xoff/yoff are the offset in pixel space from the glyph origin
+// to the top-left of the bitmap.
+
 //////////////////////////////////////////////////////////////////////////////
 //
 // Signed Distance Function (or Field) rendering
@@ -991,8 +1268,64 @@ STBTT_DEF unsigned char * stbtt_GetCodepointSDF(const stbtt_fontinfo *info, floa
 // unclear if this is true in practice (perhaps building a higher-res bitmap
 // and computing from that can allow drop-out prevention).
 //
-// The algorithm has not been optimized at all, so expect it to be slow
-// if computing lots of characters or very large sizes.
+// Cubic (CFF) outlines are approximated with two quadratics per curve.
+//
+// Only the outline segments near each pixel are measured: past the distance
+// where the output clamps to 0 or 255 the exact value doesn't matter. So the
+// cost grows with the area of the bitmap rather than area times outline
+// complexity, and a small pixel_dist_scale (a wide range) is slower than a
+// large one.
+
+STBTT_DEF unsigned char * stbtt_GetGlyphMSDF(const stbtt_fontinfo *info, float scale, int glyph, int padding, unsigned char onedge_value, float pixel_dist_scale, int *width, int *height, int *xoff, int *yoff);
+STBTT_DEF unsigned char * stbtt_GetCodepointMSDF(const stbtt_fontinfo *info, float scale, int codepoint, int padding, unsigned char onedge_value, float pixel_dist_scale, int *width, int *height, int *xoff, int *yoff);
+// Multi-channel SDF: same parameters as above, but returns width*height*3
+// bytes (RGB), to be freed with stbtt_FreeSDF. Reconstruct the shape from
+// the median of the three channels, max(min(r,g), min(max(r,g),b)), tested
+// against onedge_value. Unlike the single-channel SDF, sharp corners stay
+// sharp when the field is magnified well past the size it was built at.
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// SCRATCH MEMORY
+//
+// Rendering a glyph makes several temporary allocations: the outline, the
+// flattened curves, the edge list, the active edges and maybe a scanline
+// buffer (and more for SDFs). To render without touching the heap, give
+// each thread that renders an stbtt_scratch, and all of those come out of
+// it instead of STBTT_malloc. Allocations are stacked and popped as they're
+// freed, so normally each glyph reuses the memory of the one before, but
+// call stbtt_ScratchReset at a point where nothing is in flight (e.g. once
+// a frame) to be sure nothing is left behind. Anything that doesn't fit
+// falls back to STBTT_malloc.
+//
+// Bitmaps and SDFs returned to you, stbtt_PackBegin and the GlyphCache, and
+// the tables from the Build functions still use STBTT_malloc. Shapes from
+// stbtt_GetGlyphShape are scratch memory while a scratch is set, so free
+// them with stbtt_FreeShape before you reset or change the scratch.
+
+typedef struct stbtt_scratch stbtt_scratch;
+
+STBTT_DEF void stbtt_ScratchInit(stbtt_scratch *scratch, void *memory, int size);
+// Sets up 'scratch' to hand out the 'size' bytes at 'memory'. 64KB covers
+// ordinary text sizes; check 'peak' after a frame to tune it.
+
+STBTT_DEF stbtt_scratch *stbtt_SetThreadScratch(stbtt_scratch *scratch);
+// Makes 'scratch' the calling thread's scratch memory (NULL goes back to
+// STBTT_malloc) and returns the previous one. Each thread needs its own.
+// If the compiler has no thread-local storage, or you #define
+// STBTT_NO_THREAD_LOCALS, there is only one for the whole program.
+
+STBTT_DEF void stbtt_ScratchReset(stbtt_scratch *scratch);
+// Releases everything allocated from 'scratch'.
+
+struct stbtt_scratch {
+   unsigned char *memory;
+   int   size;
+   int   used;
+   int   top;
+   int   peak;        // the most in use at once since stbtt_ScratchInit
+   int   overflows;   // allocations that didn't fit and used STBTT_malloc
+};
 
 
 
@@ -1125,6 +1458,121 @@ typedef int stbtt__test_oversample_pow2[(STBTT_MAX_OVERSAMPLE & (STBTT_MAX_OVERS
 #define STBTT__NOTUSED(v)  (void)sizeof(v)
 #endif
 
+#if !defined(STBTT_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define STBTT_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(STBTT_NO_SIMD) && defined(STBTT_NEON)
+#undef STBTT_NEON
+#endif
+
+#ifdef STBTT_NEON
+#include <arm_neon.h>
+#endif
+
+#ifndef STBTT_NO_THREAD_LOCALS
+   #if defined(__cplusplus) &&  __cplusplus >= 201103L
+      #define STBTT_THREAD_LOCAL       thread_local
+   #elif defined(__GNUC__) && __GNUC__ < 5
+      #define STBTT_THREAD_LOCAL       __thread
+   #elif defined(_MSC_VER)
+      #define STBTT_THREAD_LOCAL       __declspec(thread)
+   #elif defined (__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_THREADS__)
+      #define STBTT_THREAD_LOCAL       _Thread_local
+   #endif
+
+   #ifndef STBTT_THREAD_LOCAL
+      #if defined(__GNUC__)
+        #define STBTT_THREAD_LOCAL       __thread
+      #endif
+   #endif
+#endif
+
+#ifndef STBTT_THREAD_LOCAL
+#define STBTT_THREAD_LOCAL
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+//
+// scratch memory
+//
+// Temporary allocations go through stbtt__temp_alloc/stbtt__temp_free,
+// which use the thread's stbtt_scratch if it has one. Blocks are stacked,
+// each after a header pointing at the block below it; freeing the top
+// block pops it along with any already-freed blocks under it.
+
+#define STBTT__SCRATCH_ALIGN  16
+
+typedef struct
+{
+   int below;   // offset of the previous top block
+   int freed;
+} stbtt__scratch_header;
+
+static STBTT_THREAD_LOCAL stbtt_scratch *stbtt__scratch;
+
+STBTT_DEF void stbtt_ScratchInit(stbtt_scratch *scratch, void *memory, int size)
+{
+   int skip = (int) ((STBTT__SCRATCH_ALIGN - ((size_t) memory & (STBTT__SCRATCH_ALIGN-1))) & (STBTT__SCRATCH_ALIGN-1));
+   scratch->memory = (unsigned char *) memory + skip;
+   scratch->size = size > skip ? size - skip : 0;
+   scratch->used = 0;
+   scratch->top = 0;
+   scratch->peak = 0;
+   scratch->overflows = 0;
+}
+
+STBTT_DEF stbtt_scratch *stbtt_SetThreadScratch(stbtt_scratch *scratch)
+{
+   stbtt_scratch *old = stbtt__scratch;
+   stbtt__scratch = scratch;
+   return old;
+}
+
+STBTT_DEF void stbtt_ScratchReset(stbtt_scratch *scratch)
+{
+   scratch->used = 0;
+   scratch->top = 0;
+}
+
+static void *stbtt__temp_alloc(size_t size, void *userdata)
+{
+   stbtt_scratch *s = stbtt__scratch;
+   if (s) {
+      size_t need = STBTT__SCRATCH_ALIGN + ((size + STBTT__SCRATCH_ALIGN-1) & ~(size_t) (STBTT__SCRATCH_ALIGN-1));
+      if (need <= (size_t) (s->size - s->used)) {
+         stbtt__scratch_header *h = (stbtt__scratch_header *) (s->memory + s->used);
+         h->below = s->top;
+         h->freed = 0;
+         s->top = s->used;
+         s->used += (int) need;
+         if (s->used > s->peak)
+            s->peak = s->used;
+         return (unsigned char *) h + STBTT__SCRATCH_ALIGN;
+      }
+      ++s->overflows;
+   }
+   return STBTT_malloc(size, userdata);
+}
+
+static void stbtt__temp_free(void *p, void *userdata)
+{
+   stbtt_scratch *s = stbtt__scratch;
+   if (s && (unsigned char *) p >= s->memory && (unsigned char *) p < s->memory + s->size) {
+      ((stbtt__scratch_header *) ((unsigned char *) p - STBTT__SCRATCH_ALIGN))->freed = 1;
+      while (s->used) {
+         stbtt__scratch_header *h = (stbtt__scratch_header *) (s->memory + s->top);
+         if (!h->freed)
+            break;
+         s->used = s->top;
+         s->top = h->below;
+      }
+   } else {
+      STBTT_free(p, userdata);
+   }
+}
+
 //////////////////////////////////////////////////////////////////////////
 //
 // stbtt__buf helpers to parse data from file
@@ -1388,6 +1836,9 @@ static int stbtt_InitFont_internal(stbtt_fontinfo *info, unsigned char *data, in
    info->data = data;
    info->fontstart = fontstart;
    info->cff = stbtt__new_buf(NULL, 0);
+   info->glyph_lookup = NULL;
+   info->kern_index = NULL;
+   info->shape_cache = NULL;
 
    cmap = stbtt__find_table(data, fontstart, "cmap");       // required
    info->loca = stbtt__find_table(data, fontstart, "loca"); // required
@@ -1493,7 +1944,7 @@ static int stbtt_InitFont_internal(stbtt_fontinfo *info, unsigned char *data, in
    return 1;
 }
 
-STBTT_DEF int stbtt_FindGlyphIndex(const stbtt_fontinfo *info, int unicode_codepoint)
+static int stbtt__FindGlyphIndexCmap(const stbtt_fontinfo *info, int unicode_codepoint)
 {
    stbtt_uint8 *data = info->data;
    stbtt_uint32 index_map = info->index_map;
@@ -1586,6 +2037,144 @@ STBTT_DEF int stbtt_FindGlyphIndex(const stbtt_fontinfo *info, int unicode_codep
    return 0;
 }
 
+typedef struct
+{
+   stbtt_uint32 start, end;
+   stbtt_uint32 glyph;    // glyph for 'start'
+   stbtt_uint32 constant; // if non-zero, every codepoint in the range maps to 'glyph'
+} stbtt__glyphrange;
+
+typedef struct
+{
+   stbtt_uint16 block[256];      // row of 'glyphs' for each 256 codepoints of the BMP; row 0 is all missing
+   stbtt_uint16 (*glyphs)[256];
+   stbtt__glyphrange *ranges;    // codepoints past the BMP, sorted
+   stbtt_int32 num_ranges;
+} stbtt__glyphlookup;
+
+static int stbtt__glyphlookup_find(const stbtt__glyphlookup *lookup, int unicode_codepoint)
+{
+   stbtt_int32 low, high;
+   if ((stbtt_uint32) unicode_codepoint < 0x10000)
+      return lookup->glyphs[lookup->block[unicode_codepoint >> 8]][unicode_codepoint & 255];
+   if (unicode_codepoint < 0)
+      return 0;
+   low = 0; high = lookup->num_ranges;
+   while (low < high) {
+      stbtt_int32 mid = low + ((high-low) >> 1);
+      const stbtt__glyphrange *r = &lookup->ranges[mid];
+      if ((stbtt_uint32) unicode_codepoint < r->start)
+         high = mid;
+      else if ((stbtt_uint32) unicode_codepoint > r->end)
+         low = mid+1;
+      else
+         return r->constant ? r->glyph : r->glyph + unicode_codepoint - r->start;
+   }
+   return 0;
+}
+
+STBTT_DEF int stbtt_FindGlyphIndex(const stbtt_fontinfo *info, int unicode_codepoint)
+{
+   if (info->glyph_lookup)
+      return stbtt__glyphlookup_find((const stbtt__glyphlookup *) info->glyph_lookup, unicode_codepoint);
+   return stbtt__FindGlyphIndexCmap(info, unicode_codepoint);
+}
+
+STBTT_DEF void stbtt_FindGlyphIndices(const stbtt_fontinfo *info, const int *codepoints, int num_codepoints, int *glyphs)
+{
+   int i;
+   if (info->glyph_lookup) {
+      const stbtt__glyphlookup *lookup = (const stbtt__glyphlookup *) info->glyph_lookup;
+      for (i=0; i < num_codepoints; ++i)
+         glyphs[i] = stbtt__glyphlookup_find(lookup, codepoints[i]);
+   } else {
+      for (i=0; i < num_codepoints; ++i)
+         glyphs[i] = (i > 0 && codepoints[i] == codepoints[i-1]) ? glyphs[i-1] : stbtt__FindGlyphIndexCmap(info, codepoints[i]);
+   }
+}
+
+STBTT_DEF int stbtt_BuildGlyphLookup(stbtt_fontinfo *info)
+{
+   stbtt_uint8 *data = info->data;
+   stbtt_uint32 index_map = info->index_map;
+   stbtt_uint16 format = ttUSHORT(data + index_map);
+   stbtt_uint16 block[256];
+   stbtt_uint16 (*temp)[256];
+   stbtt__glyphlookup *lookup;
+   stbtt_uint32 i, ngroups = 0;
+   int b, c, num_rows = 1, num_ranges = 0;
+
+   if (info->glyph_lookup)
+      return 1;
+   if (format != 0 && format != 4 && format != 6 && format != 12 && format != 13)
+      return 0;
+
+   // fill out the BMP a block at a time, only keeping blocks with glyphs in them
+   temp = (stbtt_uint16 (*)[256]) STBTT_malloc(sizeof(*temp) * 257, info->userdata);
+   if (temp == NULL)
+      return 0;
+   for (b=0; b < 256; ++b) {
+      stbtt_uint16 *row = temp[num_rows];
+      int any = 0;
+      for (c=0; c < 256; ++c) {
+         row[c] = (stbtt_uint16) stbtt__FindGlyphIndexCmap(info, b*256 + c);
+         any |= row[c];
+      }
+      block[b] = (stbtt_uint16) (any ? num_rows++ : 0);
+   }
+
+   // only formats 12 and 13 reach past the BMP; keep their groups as is
+   if (format == 12 || format == 13) {
+      ngroups = ttULONG(data+index_map+12);
+      for (i=0; i < ngroups; ++i)
+         if (ttULONG(data+index_map+16+i*12+4) >= 0x10000)
+            ++num_ranges;
+   }
+
+   lookup = (stbtt__glyphlookup *) STBTT_malloc(sizeof(*lookup) + sizeof(stbtt__glyphrange) * num_ranges + sizeof(*temp) * num_rows, info->userdata);
+   if (lookup == NULL) {
+      STBTT_free(temp, info->userdata);
+      return 0;
+   }
+   lookup->ranges = (stbtt__glyphrange *) (lookup + 1);
+   lookup->glyphs = (stbtt_uint16 (*)[256]) (lookup->ranges + num_ranges);
+   lookup->num_ranges = num_ranges;
+   STBTT_memcpy(lookup->block, block, sizeof(block));
+   STBTT_memset(lookup->glyphs[0], 0, sizeof(*temp));
+   STBTT_memcpy(lookup->glyphs[1], temp[1], sizeof(*temp) * (num_rows-1));
+   STBTT_free(temp, info->userdata);
+
+   num_ranges = 0;
+   for (i=0; i < ngroups; ++i) {
+      stbtt_uint32 start = ttULONG(data+index_map+16+i*12);
+      stbtt_uint32 end   = ttULONG(data+index_map+16+i*12+4);
+      stbtt_uint32 glyph = ttULONG(data+index_map+16+i*12+8);
+      if (end >= 0x10000) {
+         stbtt__glyphrange *r = &lookup->ranges[num_ranges++];
+         r->constant = (format == 13);
+         r->start = start;
+         r->end = end;
+         r->glyph = glyph;
+         if (start < 0x10000) {
+            // straddles the end of the BMP
+            if (format == 12)
+               r->glyph += 0x10000 - start;
+            r->start = 0x10000;
+         }
+      }
+   }
+
+   info->glyph_lookup = lookup;
+   return 1;
+}
+
+STBTT_DEF void stbtt_FreeGlyphLookup(stbtt_fontinfo *info)
+{
+   if (info->glyph_lookup)
+      STBTT_free(info->glyph_lookup, info->userdata);
+   info->glyph_lookup = NULL;
+}
+
 STBTT_DEF int stbtt_GetCodepointShape(const stbtt_fontinfo *info, int unicode_codepoint, stbtt_vertex **vertices)
 {
    return stbtt_GetGlyphShape(info, stbtt_FindGlyphIndex(info, unicode_codepoint), vertices);
@@ -1622,9 +2211,32 @@ static int stbtt__GetGlyfOffset(const stbtt_fontinfo *info, int glyph_index)
 
 static int stbtt__GetGlyphInfoT2(const stbtt_fontinfo *info, int glyph_index, int *x0, int *y0, int *x1, int *y1);
 
+typedef struct
+{
+   stbtt_uint32 *first;         // glyph g is vertices first[g] up to first[g+1]
+   stbtt_uint32 *first_coord;   // and its coordinates start at coords[first_coord[g]]
+   stbtt_uint8  *types;
+   stbtt_int16  *coords;        // x,y for every vertex, then cx,cy for curves, then cx1,cy1 for cubics
+   stbtt_int16  *boxes;         // x0,y0,x1,y1 for every glyph, CFF fonts only
+   int           num_glyphs;
+} stbtt__shapecache;
+
+static const stbtt__shapecache *stbtt__get_shapecache(const stbtt_fontinfo *info, int glyph_index)
+{
+   const stbtt__shapecache *sc = (const stbtt__shapecache *) info->shape_cache;
+   return (sc && glyph_index >= 0 && glyph_index < sc->num_glyphs) ? sc : NULL;
+}
+
 STBTT_DEF int stbtt_GetGlyphBox(const stbtt_fontinfo *info, int glyph_index, int *x0, int *y0, int *x1, int *y1)
 {
-   if (info->cff.size) {
+   const stbtt__shapecache *sc = stbtt__get_shapecache(info, glyph_index);
+   if (info->cff.size && sc) {
+      stbtt_int16 *box = sc->boxes + glyph_index*4;
+      if (x0) *x0 = box[0];
+      if (y0) *y0 = box[1];
+      if (x1) *x1 = box[2];
+      if (y1) *y1 = box[3];
+   } else if (info->cff.size) {
       stbtt__GetGlyphInfoT2(info, glyph_index, x0, y0, x1, y1);
    } else {
       int g = stbtt__GetGlyfOffset(info, glyph_index);
@@ -1645,8 +2257,11 @@ STBTT_DEF int stbtt_GetCodepointBox(const stbtt_fontinfo *info, int codepoint, i
 
 STBTT_DEF int stbtt_IsGlyphEmpty(const stbtt_fontinfo *info, int glyph_index)
 {
+   const stbtt__shapecache *sc = stbtt__get_shapecache(info, glyph_index);
    stbtt_int16 numberOfContours;
    int g;
+   if (info->cff.size && sc)
+      return sc->first[glyph_index] == sc->first[glyph_index+1];
    if (info->cff.size)
       return stbtt__GetGlyphInfoT2(info, glyph_index, NULL, NULL, NULL, NULL) == 0;
    g = stbtt__GetGlyfOffset(info, glyph_index);
@@ -1698,7 +2313,7 @@ static int stbtt__GetGlyphShapeTT(const stbtt_fontinfo *info, int glyph_index, s
       n = 1+ttUSHORT(endPtsOfContours + numberOfContours*2-2);
 
       m = n + 2*numberOfContours;  // a loose bound on how many vertices we might need
-      vertices = (stbtt_vertex *) STBTT_malloc(m * sizeof(vertices[0]), info->userdata);
+      vertices = (stbtt_vertex *) stbtt__temp_alloc(m * sizeof(vertices[0]), info->userdata);
       if (vertices == 0)
          return 0;
 
@@ -1870,17 +2485,17 @@ static int stbtt__GetGlyphShapeTT(const stbtt_fontinfo *info, int glyph_index, s
                v->cy = (stbtt_vertex_type)(n * (mtx[1]*x + mtx[3]*y + mtx[5]));
             }
             // Append vertices.
-            tmp = (stbtt_vertex*)STBTT_malloc((num_vertices+comp_num_verts)*sizeof(stbtt_vertex), info->userdata);
+            tmp = (stbtt_vertex*)stbtt__temp_alloc((num_vertices+comp_num_verts)*sizeof(stbtt_vertex), info->userdata);
             if (!tmp) {
-               if (vertices) STBTT_free(vertices, info->userdata);
-               if (comp_verts) STBTT_free(comp_verts, info->userdata);
+               if (vertices) stbtt__temp_free(vertices, info->userdata);
+               if (comp_verts) stbtt__temp_free(comp_verts, info->userdata);
                return 0;
             }
             if (num_vertices > 0 && vertices) STBTT_memcpy(tmp, vertices, num_vertices*sizeof(stbtt_vertex));
             STBTT_memcpy(tmp+num_vertices, comp_verts, comp_num_verts*sizeof(stbtt_vertex));
-            if (vertices) STBTT_free(vertices, info->userdata);
+            if (vertices) stbtt__temp_free(vertices, info->userdata);
             vertices = tmp;
-            STBTT_free(comp_verts, info->userdata);
+            stbtt__temp_free(comp_verts, info->userdata);
             num_vertices += comp_num_verts;
          }
          // More components ?
@@ -1904,9 +2519,10 @@ typedef struct
 
    stbtt_vertex *pvertices;
    int num_vertices;
+   int max_vertices;   // vertices past this are counted but not stored
 } stbtt__csctx;
 
-#define STBTT__CSCTX_INIT(bounds) {bounds,0, 0,0, 0,0, 0,0,0,0, NULL, 0}
+#define STBTT__CSCTX_INIT(bounds) {bounds,0, 0,0, 0,0, 0,0,0,0, NULL, 0, 0}
 
 static void stbtt__track_vertex(stbtt__csctx *c, stbtt_int32 x, stbtt_int32 y)
 {
@@ -1925,7 +2541,8 @@ static void stbtt__csctx_v(stbtt__csctx *c, stbtt_uint8 type, stbtt_int32 x, stb
          stbtt__track_vertex(c, cx, cy);
          stbtt__track_vertex(c, cx1, cy1);
       }
-   } else {
+   }
+   if (c->num_vertices < c->max_vertices) {
       stbtt_setvertex(&c->pvertices[c->num_vertices], type, x, y, cx, cy);
       c->pvertices[c->num_vertices].cx1 = (stbtt_int16) cx1;
       c->pvertices[c->num_vertices].cy1 = (stbtt_int16) cy1;
@@ -2266,18 +2883,32 @@ static int stbtt__run_charstring(const stbtt_fontinfo *info, int glyph_index, st
 #undef STBTT__CSERR
 }
 
+#define STBTT__CFF_STACK_VERTICES 128
+
 static int stbtt__GetGlyphShapeT2(const stbtt_fontinfo *info, int glyph_index, stbtt_vertex **pvertices)
 {
-   // runs the charstring twice, once to count and once to output (to avoid realloc)
-   stbtt__csctx count_ctx = STBTT__CSCTX_INIT(1);
+   // runs the charstring into a buffer on the stack, and only runs it a second
+   // time (straight into the result) if the glyph didn't fit
+   stbtt_vertex buffer[STBTT__CFF_STACK_VERTICES];
+   stbtt__csctx first_ctx = STBTT__CSCTX_INIT(0);
    stbtt__csctx output_ctx = STBTT__CSCTX_INIT(0);
-   if (stbtt__run_charstring(info, glyph_index, &count_ctx)) {
-      *pvertices = (stbtt_vertex*)STBTT_malloc(count_ctx.num_vertices*sizeof(stbtt_vertex), info->userdata);
+   first_ctx.pvertices = buffer;
+   first_ctx.max_vertices = STBTT__CFF_STACK_VERTICES;
+   if (stbtt__run_charstring(info, glyph_index, &first_ctx)) {
+      *pvertices = (stbtt_vertex*)stbtt__temp_alloc(first_ctx.num_vertices*sizeof(stbtt_vertex), info->userdata);
+      if (*pvertices == NULL)
+         return 0;
+      if (first_ctx.num_vertices <= STBTT__CFF_STACK_VERTICES) {
+         STBTT_memcpy(*pvertices, buffer, first_ctx.num_vertices*sizeof(stbtt_vertex));
+         return first_ctx.num_vertices;
+      }
       output_ctx.pvertices = *pvertices;
+      output_ctx.max_vertices = first_ctx.num_vertices;
       if (stbtt__run_charstring(info, glyph_index, &output_ctx)) {
-         STBTT_assert(output_ctx.num_vertices == count_ctx.num_vertices);
+         STBTT_assert(output_ctx.num_vertices == first_ctx.num_vertices);
          return output_ctx.num_vertices;
       }
+      stbtt__temp_free(*pvertices, info->userdata);
    }
    *pvertices = NULL;
    return 0;
@@ -2294,14 +2925,192 @@ static int stbtt__GetGlyphInfoT2(const stbtt_fontinfo *info, int glyph_index, in
    return r ? c.num_vertices : 0;
 }
 
+static int stbtt__shapecache_unpack(const stbtt_fontinfo *info, const stbtt__shapecache *sc, int glyph_index, stbtt_vertex **pvertices)
+{
+   stbtt_uint8 *types = sc->types + sc->first[glyph_index];
+   stbtt_int16 *c = sc->coords + sc->first_coord[glyph_index];
+   int i, num_vertices = (int) (sc->first[glyph_index+1] - sc->first[glyph_index]);
+   stbtt_vertex *v;
+
+   *pvertices = NULL;
+   if (num_vertices == 0)
+      return 0;
+   v = (stbtt_vertex *) stbtt__temp_alloc(num_vertices * sizeof(stbtt_vertex), info->userdata);
+   if (v == NULL)
+      return 0;
+   STBTT_memset(v, 0, num_vertices * sizeof(stbtt_vertex));
+   for (i=0; i < num_vertices; ++i) {
+      v[i].type = types[i];
+      v[i].x = c[0];
+      v[i].y = c[1];
+      c += 2;
+      if (types[i] == STBTT_vcurve || types[i] == STBTT_vcubic) {
+         v[i].cx = c[0];
+         v[i].cy = c[1];
+         c += 2;
+      }
+      if (types[i] == STBTT_vcubic) {
+         v[i].cx1 = c[0];
+         v[i].cy1 = c[1];
+         c += 2;
+      }
+   }
+   *pvertices = v;
+   return num_vertices;
+}
+
 STBTT_DEF int stbtt_GetGlyphShape(const stbtt_fontinfo *info, int glyph_index, stbtt_vertex **pvertices)
 {
+   const stbtt__shapecache *sc = stbtt__get_shapecache(info, glyph_index);
+   if (sc)
+      return stbtt__shapecache_unpack(info, sc, glyph_index, pvertices);
    if (!info->cff.size)
       return stbtt__GetGlyphShapeTT(info, glyph_index, pvertices);
    else
       return stbtt__GetGlyphShapeT2(info, glyph_index, pvertices);
 }
 
+// makes room for 'needed' elements in a growing array, keeping the first 'count';
+// returns NULL if it runs out of memory, leaving the old array alone
+static void *stbtt__shapecache_grow(void *p, int count, int *capacity, int needed, int size, void *userdata)
+{
+   void *q;
+   int cap = *capacity ? *capacity : 4096;
+   if (needed <= *capacity)
+      return p;
+   while (cap < needed)
+      cap *= 2;
+   q = STBTT_malloc(cap * size, userdata);
+   if (q == NULL)
+      return NULL;
+   if (p) {
+      STBTT_memcpy(q, p, count * size);
+      STBTT_free(p, userdata);
+   }
+   *capacity = cap;
+   return q;
+}
+
+STBTT_DEF int stbtt_BuildShapeCache(stbtt_fontinfo *info)
+{
+   stbtt__shapecache *sc;
+   stbtt_uint32 *first, *first_coord;
+   stbtt_int16 *boxes = NULL, *coords = NULL, *c;
+   stbtt_uint8 *types = NULL;
+   stbtt_vertex *buffer = NULL, *v;
+   int num_glyphs = info->numGlyphs, num_boxes = info->cff.size ? info->numGlyphs : 0;
+   int num_types = 0, num_coords = 0, types_cap = 0, coords_cap = 0, buffer_cap = 0;
+   int g, i, n;
+   void *p;
+
+   if (info->shape_cache)
+      return 1;
+
+   // the offsets and boxes go in their final home right away, the vertices grow as we go
+   sc = (stbtt__shapecache *) STBTT_malloc(sizeof(*sc) + sizeof(stbtt_uint32) * 2 * (num_glyphs+1) + sizeof(stbtt_int16) * 4 * num_boxes, info->userdata);
+   if (sc == NULL)
+      return 0;
+   first = (stbtt_uint32 *) (sc + 1);
+   first_coord = first + num_glyphs + 1;
+   if (num_boxes)
+      boxes = (stbtt_int16 *) (first_coord + num_glyphs + 1);
+
+   for (g=0; g < num_glyphs; ++g) {
+      first[g] = num_types;
+      first_coord[g] = num_coords;
+
+      if (info->cff.size) {
+         // one charstring run gets both the box and the outline, unless the buffer is too small
+         stbtt__csctx ctx = STBTT__CSCTX_INIT(1);
+         ctx.pvertices = buffer;
+         ctx.max_vertices = buffer_cap;
+         n = stbtt__run_charstring(info, g, &ctx) ? ctx.num_vertices : 0;
+         if (n > buffer_cap) {
+            stbtt__csctx again = STBTT__CSCTX_INIT(0);
+            p = stbtt__shapecache_grow(buffer, 0, &buffer_cap, n, sizeof(stbtt_vertex), info->userdata);
+            if (p == NULL) goto error;
+            buffer = again.pvertices = (stbtt_vertex *) p;
+            again.max_vertices = buffer_cap;
+            stbtt__run_charstring(info, g, &again);
+         }
+         boxes[g*4+0] = (stbtt_int16) (n ? ctx.min_x : 0);
+         boxes[g*4+1] = (stbtt_int16) (n ? ctx.min_y : 0);
+         boxes[g*4+2] = (stbtt_int16) (n ? ctx.max_x : 0);
+         boxes[g*4+3] = (stbtt_int16) (n ? ctx.max_y : 0);
+         v = buffer;
+      } else {
+         n = stbtt__GetGlyphShapeTT(info, g, &v);
+      }
+
+      p = stbtt__shapecache_grow(types, num_types, &types_cap, num_types + n, 1, info->userdata);
+      if (p) {
+         types = (stbtt_uint8 *) p;
+         p = stbtt__shapecache_grow(coords, num_coords, &coords_cap, num_coords + n*6, sizeof(stbtt_int16), info->userdata);
+      }
+      if (p == NULL) {
+         if (!info->cff.size && v)
+            stbtt__temp_free(v, info->userdata);
+         goto error;
+      }
+      coords = (stbtt_int16 *) p;
+
+      c = coords + num_coords;
+      for (i=0; i < n; ++i) {
+         types[num_types++] = v[i].type;
+         *c++ = (stbtt_int16) v[i].x;
+         *c++ = (stbtt_int16) v[i].y;
+         if (v[i].type == STBTT_vcurve || v[i].type == STBTT_vcubic) {
+            *c++ = (stbtt_int16) v[i].cx;
+            *c++ = (stbtt_int16) v[i].cy;
+         }
+         if (v[i].type == STBTT_vcubic) {
+            *c++ = (stbtt_int16) v[i].cx1;
+            *c++ = (stbtt_int16) v[i].cy1;
+         }
+      }
+      num_coords = (int) (c - coords);
+      if (!info->cff.size && v)
+         stbtt__temp_free(v, info->userdata);
+   }
+   first[num_glyphs] = num_types;
+   first_coord[num_glyphs] = num_coords;
+
+   // move the vertices in with the offsets so it's all one allocation
+   p = STBTT_malloc(sizeof(*sc) + sizeof(stbtt_uint32) * 2 * (num_glyphs+1) + sizeof(stbtt_int16) * (4 * num_boxes + num_coords) + num_types, info->userdata);
+   if (p == NULL) goto error;
+   STBTT_memcpy(p, sc, sizeof(*sc) + sizeof(stbtt_uint32) * 2 * (num_glyphs+1) + sizeof(stbtt_int16) * 4 * num_boxes);
+   STBTT_free(sc, info->userdata);
+   sc = (stbtt__shapecache *) p;
+   sc->first       = (stbtt_uint32 *) (sc + 1);
+   sc->first_coord = sc->first + num_glyphs + 1;
+   sc->boxes       = (stbtt_int16 *) (sc->first_coord + num_glyphs + 1);
+   sc->coords      = sc->boxes + 4 * num_boxes;
+   sc->types       = (stbtt_uint8 *) (sc->coords + num_coords);
+   sc->num_glyphs  = num_glyphs;
+   if (num_coords) STBTT_memcpy(sc->coords, coords, num_coords * sizeof(stbtt_int16));
+   if (num_types)  STBTT_memcpy(sc->types, types, num_types);
+
+   if (buffer) STBTT_free(buffer, info->userdata);
+   if (coords) STBTT_free(coords, info->userdata);
+   if (types)  STBTT_free(types, info->userdata);
+   info->shape_cache = sc;
+   return 1;
+
+error:
+   if (buffer) STBTT_free(buffer, info->userdata);
+   if (coords) STBTT_free(coords, info->userdata);
+   if (types)  STBTT_free(types, info->userdata);
+   STBTT_free(sc, info->userdata);
+   return 0;
+}
+
+STBTT_DEF void stbtt_FreeShapeCache(stbtt_fontinfo *info)
+{
+   if (info->shape_cache)
+      STBTT_free(info->shape_cache, info->userdata);
+   info->shape_cache = NULL;
+}
+
 STBTT_DEF void stbtt_GetGlyphHMetrics(const stbtt_fontinfo *info, int glyph_index, int *advanceWidth, int *leftSideBearing)
 {
    stbtt_uint16 numOfLongHorMetrics = ttUSHORT(info->data+info->hhea + 34);
@@ -2607,71 +3416,285 @@ static stbtt_int32 stbtt__GetGlyphGPOSInfoAdvance(const stbtt_fontinfo *info, in
    return 0;
 }
 
-STBTT_DEF int  stbtt_GetGlyphKernAdvance(const stbtt_fontinfo *info, int g1, int g2)
-{
-   int xAdvance = 0;
-
-   if (info->gpos)
-      xAdvance += stbtt__GetGlyphGPOSInfoAdvance(info, g1, g2);
-   else if (info->kern)
-      xAdvance += stbtt__GetGlyphKernInfoAdvance(info, g1, g2);
-
-   return xAdvance;
-}
+#define STBTT__KERN_NONE  0xffff  // no subtable decides glyph1 beyond the listed pairs
+#define STBTT__KERN_ZERO  0xfffe  // a subtable covers glyph1 and ends the search with 0
 
-STBTT_DEF int  stbtt_GetCodepointKernAdvance(const stbtt_fontinfo *info, int ch1, int ch2)
+typedef struct
 {
-   if (!info->kern && !info->gpos) // if no kerning table, don't waste time looking up both codepoint->glyphs
-      return 0;
-   return stbtt_GetGlyphKernAdvance(info, stbtt_FindGlyphIndex(info,ch1), stbtt_FindGlyphIndex(info,ch2));
-}
+   stbtt_uint8  *table;         // PairPos format 2 subtable
+   stbtt_uint16  class2_count;
+   stbtt_uint16 *class2;        // classDef2 class of every glyph, 0xffff if unsupported
+} stbtt__kernclasses;
 
-STBTT_DEF void stbtt_GetCodepointHMetrics(const stbtt_fontinfo *info, int codepoint, int *advanceWidth, int *leftSideBearing)
+typedef struct
 {
-   stbtt_GetGlyphHMetrics(info, stbtt_FindGlyphIndex(info,codepoint), advanceWidth, leftSideBearing);
+   stbtt_uint32 *keys;          // glyph1 << 16 | glyph2, 0xffffffff if empty
+   stbtt_int16  *values;
+   int           shift;         // slot is the top bits of key * golden ratio
+   int           num_glyphs;
+   stbtt_uint16 *fallback;      // for each glyph1, index into 'classes' or STBTT__KERN_*
+   stbtt_uint16 *class1;        // for each glyph1, its classDef1 class in that subtable
+   stbtt__kernclasses *classes;
+} stbtt__kernindex;
+
+static void stbtt__kernindex_add(stbtt__kernindex *k, stbtt_uint32 key, stbtt_int16 value)
+{
+   stbtt_uint32 mask = 0xffffffffu >> k->shift;
+   stbtt_uint32 slot = (key * 0x9e3779b1u) >> k->shift;
+   while (k->keys[slot] != 0xffffffffu) {
+      if (k->keys[slot] == key)
+         return; // the first one in lookup order wins
+      slot = (slot + 1) & mask;
+   }
+   k->keys[slot] = key;
+   k->values[slot] = value;
 }
 
-STBTT_DEF void stbtt_GetFontVMetrics(const stbtt_fontinfo *info, int *ascent, int *descent, int *lineGap)
+static int stbtt__kernindex_find(const stbtt__kernindex *k, int glyph1, int glyph2)
 {
-   if (ascent ) *ascent  = ttSHORT(info->data+info->hhea + 4);
-   if (descent) *descent = ttSHORT(info->data+info->hhea + 6);
-   if (lineGap) *lineGap = ttSHORT(info->data+info->hhea + 8);
-}
+   stbtt_uint32 mask = 0xffffffffu >> k->shift;
+   stbtt_uint32 key = (stbtt_uint32) glyph1 << 16 | glyph2;
+   stbtt_uint32 slot = (key * 0x9e3779b1u) >> k->shift;
+   const stbtt__kernclasses *c;
+   stbtt_uint16 fallback, class2;
 
-STBTT_DEF int  stbtt_GetFontVMetricsOS2(const stbtt_fontinfo *info, int *typoAscent, int *typoDescent, int *typoLineGap)
-{
-   int tab = stbtt__find_table(info->data, info->fontstart, "OS/2");
-   if (!tab)
+   while (k->keys[slot] != 0xffffffffu) {
+      if (k->keys[slot] == key)
+         return k->values[slot];
+      slot = (slot + 1) & mask;
+   }
+
+   fallback = k->fallback[glyph1];
+   if (fallback >= STBTT__KERN_ZERO)
       return 0;
-   if (typoAscent ) *typoAscent  = ttSHORT(info->data+tab + 68);
-   if (typoDescent) *typoDescent = ttSHORT(info->data+tab + 70);
-   if (typoLineGap) *typoLineGap = ttSHORT(info->data+tab + 72);
-   return 1;
+   c = &k->classes[fallback];
+   class2 = c->class2[glyph2];
+   if (class2 >= c->class2_count)
+      return 0; // malformed
+   return ttSHORT(c->table + 16 + 2 * (k->class1[glyph1] * c->class2_count + class2));
 }
 
-STBTT_DEF void stbtt_GetFontBoundingBox(const stbtt_fontinfo *info, int *x0, int *y0, int *x1, int *y1)
+// Walks the pair adjustment subtables in the same order as stbtt__GetGlyphGPOSInfoAdvance.
+// With k == NULL, just counts how many pairs and class subtables there are.
+static void stbtt__kernindex_gpos(const stbtt_fontinfo *info, stbtt__kernindex *k, int *num_pairs, int *num_classes)
 {
-   *x0 = ttSHORT(info->data + info->head + 36);
-   *y0 = ttSHORT(info->data + info->head + 38);
-   *x1 = ttSHORT(info->data + info->head + 40);
-   *y1 = ttSHORT(info->data + info->head + 42);
-}
+   stbtt_uint8 *data = info->data + info->gpos;
+   stbtt_uint8 *lookupList;
+   stbtt_int32 i, sti, g, j;
+   int n = 0;
 
-STBTT_DEF float stbtt_ScaleForPixelHeight(const stbtt_fontinfo *info, float height)
-{
-   int fheight = ttSHORT(info->data + info->hhea + 4) - ttSHORT(info->data + info->hhea + 6);
-   return (float) height / fheight;
-}
+   *num_pairs = 0;
+   *num_classes = 0;
+   if (ttUSHORT(data+0) != 1) return; // Major version 1
+   if (ttUSHORT(data+2) != 0) return; // Minor version 0
 
-STBTT_DEF float stbtt_ScaleForMappingEmToPixels(const stbtt_fontinfo *info, float pixels)
-{
-   int unitsPerEm = ttUSHORT(info->data + info->head + 18);
-   return pixels / unitsPerEm;
-}
+   lookupList = data + ttUSHORT(data+8);
+   for (i=0; i < ttUSHORT(lookupList); ++i) {
+      stbtt_uint8 *lookupTable = lookupList + ttUSHORT(lookupList + 2 + 2 * i);
+      stbtt_uint16 subTableCount = ttUSHORT(lookupTable + 4);
+      if (ttUSHORT(lookupTable) != 2) // Pair Adjustment Positioning Subtable
+         continue;
+
+      for (sti=0; sti < subTableCount; ++sti) {
+         stbtt_uint8 *table = lookupTable + ttUSHORT(lookupTable + 6 + 2 * sti);
+         stbtt_uint16 posFormat = ttUSHORT(table);
+         stbtt_uint8 *coverage = table + ttUSHORT(table + 2);
+         int supported = (posFormat == 1 || posFormat == 2) && ttUSHORT(table + 4) == 4 && ttUSHORT(table + 6) == 0;
+
+         if (k == NULL) {
+            if (supported && posFormat == 1) {
+               for (j=0; j < ttUSHORT(table + 8); ++j)
+                  *num_pairs += ttUSHORT(table + ttUSHORT(table + 10 + 2 * j));
+            } else if (supported && posFormat == 2)
+               ++*num_classes;
+            continue;
+         }
+
+         if (supported && posFormat == 2) {
+            stbtt__kernclasses *c = &k->classes[n];
+            stbtt_uint8 *classDef2 = table + ttUSHORT(table + 10);
+            c->table = table;
+            c->class2_count = ttUSHORT(table + 14);
+            c->class2 = (stbtt_uint16 *) (k->class1 + k->num_glyphs) + n * k->num_glyphs;
+            for (g=0; g < k->num_glyphs; ++g) {
+               stbtt_int32 cl = stbtt__GetGlyphClass(classDef2, g);
+               c->class2[g] = (stbtt_uint16) (cl < 0 ? 0xffff : cl);
+            }
+         }
+
+         for (g=0; g < k->num_glyphs; ++g) {
+            stbtt_int32 coverageIndex;
+            if (k->fallback[g] != STBTT__KERN_NONE)
+               continue; // an earlier subtable always answers for this glyph
+            coverageIndex = stbtt__GetCoverageIndex(coverage, g);
+            if (coverageIndex == -1)
+               continue;
+            if (!supported) {
+               k->fallback[g] = STBTT__KERN_ZERO;
+            } else if (posFormat == 1) {
+               stbtt_uint8 *pairValueTable;
+               if (coverageIndex >= ttUSHORT(table + 8)) {
+                  k->fallback[g] = STBTT__KERN_ZERO;
+                  continue;
+               }
+               pairValueTable = table + ttUSHORT(table + 10 + 2 * coverageIndex);
+               for (j=0; j < ttUSHORT(pairValueTable); ++j)
+                  stbtt__kernindex_add(k, (stbtt_uint32) g << 16 | ttUSHORT(pairValueTable + 2 + 4 * j), ttSHORT(pairValueTable + 4 + 4 * j));
+            } else {
+               stbtt_int32 glyph1class = stbtt__GetGlyphClass(table + ttUSHORT(table + 8), g);
+               if (glyph1class < 0 || glyph1class >= ttUSHORT(table + 12)) {
+                  k->fallback[g] = STBTT__KERN_ZERO; // malformed
+               } else {
+                  k->fallback[g] = (stbtt_uint16) n;
+                  k->class1[g] = (stbtt_uint16) glyph1class;
+               }
+            }
+         }
+
+         if (supported && posFormat == 2)
+            ++n;
+      }
+   }
+}
+
+STBTT_DEF int stbtt_BuildKernIndex(stbtt_fontinfo *info)
+{
+   stbtt__kernindex *k;
+   int num_pairs = 0, num_classes = 0, hash_size = 16, shift = 28, num_glyphs = info->numGlyphs, i;
+
+   if (info->kern_index || (!info->gpos && !info->kern))
+      return 1;
+
+   if (info->gpos)
+      stbtt__kernindex_gpos(info, NULL, &num_pairs, &num_classes);
+   else
+      num_pairs = stbtt_GetKerningTableLength(info);
+
+   // keep the table at most half full
+   while (hash_size < num_pairs * 2) {
+      hash_size *= 2;
+      --shift;
+   }
+
+   k = (stbtt__kernindex *) STBTT_malloc(sizeof(*k) + sizeof(stbtt__kernclasses) * num_classes + (sizeof(stbtt_uint32) + sizeof(stbtt_int16)) * hash_size
+                                         + sizeof(stbtt_uint16) * num_glyphs * (2 + num_classes), info->userdata);
+   if (k == NULL)
+      return 0;
+   k->classes    = (stbtt__kernclasses *) (k + 1);
+   k->keys       = (stbtt_uint32 *) (k->classes + num_classes);
+   k->fallback   = (stbtt_uint16 *) (k->keys + hash_size);
+   k->class1     = k->fallback + num_glyphs;
+   k->values     = (stbtt_int16 *) (k->class1 + num_glyphs * (1 + num_classes));
+   k->shift      = shift;
+   k->num_glyphs = num_glyphs;
+   STBTT_memset(k->keys, 0xff, sizeof(stbtt_uint32) * hash_size);
+   for (i=0; i < num_glyphs; ++i)
+      k->fallback[i] = STBTT__KERN_NONE;
+
+   if (info->gpos) {
+      stbtt__kernindex_gpos(info, k, &num_pairs, &num_classes);
+   } else {
+      stbtt_uint8 *data = info->data + info->kern;
+      for (i=0; i < num_pairs; ++i)
+         stbtt__kernindex_add(k, ttULONG(data+18+(i*6)), ttSHORT(data+22+(i*6)));
+   }
+
+   info->kern_index = k;
+   return 1;
+}
+
+STBTT_DEF void stbtt_FreeKernIndex(stbtt_fontinfo *info)
+{
+   if (info->kern_index)
+      STBTT_free(info->kern_index, info->userdata);
+   info->kern_index = NULL;
+}
+
+STBTT_DEF int  stbtt_GetGlyphKernAdvance(const stbtt_fontinfo *info, int g1, int g2)
+{
+   int xAdvance = 0;
+
+   if (info->kern_index) {
+      const stbtt__kernindex *k = (const stbtt__kernindex *) info->kern_index;
+      if (g1 >= 0 && g1 < k->num_glyphs && g2 >= 0 && g2 < k->num_glyphs)
+         return stbtt__kernindex_find(k, g1, g2);
+   }
+
+   if (info->gpos)
+      xAdvance += stbtt__GetGlyphGPOSInfoAdvance(info, g1, g2);
+   else if (info->kern)
+      xAdvance += stbtt__GetGlyphKernInfoAdvance(info, g1, g2);
+
+   return xAdvance;
+}
+
+STBTT_DEF int  stbtt_GetCodepointKernAdvance(const stbtt_fontinfo *info, int ch1, int ch2)
+{
+   if (!info->kern && !info->gpos) // if no kerning table, don't waste time looking up both codepoint->glyphs
+      return 0;
+   return stbtt_GetGlyphKernAdvance(info, stbtt_FindGlyphIndex(info,ch1), stbtt_FindGlyphIndex(info,ch2));
+}
+
+STBTT_DEF void stbtt_GetGlyphKernAdvances(const stbtt_fontinfo *info, const int *glyphs, int num_glyphs, int *advances)
+{
+   int i;
+   if (num_glyphs <= 0)
+      return;
+   if (!info->kern && !info->gpos) {
+      STBTT_memset(advances, 0, sizeof(*advances) * num_glyphs);
+      return;
+   }
+   for (i=0; i < num_glyphs-1; ++i)
+      advances[i] = stbtt_GetGlyphKernAdvance(info, glyphs[i], glyphs[i+1]);
+   advances[num_glyphs-1] = 0;
+}
+
+STBTT_DEF void stbtt_GetCodepointHMetrics(const stbtt_fontinfo *info, int codepoint, int *advanceWidth, int *leftSideBearing)
+{
+   stbtt_GetGlyphHMetrics(info, stbtt_FindGlyphIndex(info,codepoint), advanceWidth, leftSideBearing);
+}
+
+STBTT_DEF void stbtt_GetFontVMetrics(const stbtt_fontinfo *info, int *ascent, int *descent, int *lineGap)
+{
+   if (ascent ) *ascent  = ttSHORT(info->data+info->hhea + 4);
+   if (descent) *descent = ttSHORT(info->data+info->hhea + 6);
+   if (lineGap) *lineGap = ttSHORT(info->data+info->hhea + 8);
+}
+
+STBTT_DEF int  stbtt_GetFontVMetricsOS2(const stbtt_fontinfo *info, int *typoAscent, int *typoDescent, int *typoLineGap)
+{
+   int tab = stbtt__find_table(info->data, info->fontstart, "OS/2");
+   if (!tab)
+      return 0;
+   if (typoAscent ) *typoAscent  = ttSHORT(info->data+tab + 68);
+   if (typoDescent) *typoDescent = ttSHORT(info->data+tab + 70);
+   if (typoLineGap) *typoLineGap = ttSHORT(info->data+tab + 72);
+   return 1;
+}
+
+STBTT_DEF void stbtt_GetFontBoundingBox(const stbtt_fontinfo *info, int *x0, int *y0, int *x1, int *y1)
+{
+   *x0 = ttSHORT(info->data + info->head + 36);
+   *y0 = ttSHORT(info->data + info->head + 38);
+   *x1 = ttSHORT(info->data + info->head + 40);
+   *y1 = ttSHORT(info->data + info->head + 42);
+}
+
+STBTT_DEF float stbtt_ScaleForPixelHeight(const stbtt_fontinfo *info, float height)
+{
+   int fheight = ttSHORT(info->data + info->hhea + 4) - ttSHORT(info->data + info->hhea + 6);
+   return (float) height / fheight;
+}
+
+STBTT_DEF float stbtt_ScaleForMappingEmToPixels(const stbtt_fontinfo *info, float pixels)
+{
+   int unitsPerEm = ttUSHORT(info->data + info->head + 18);
+   return pixels / unitsPerEm;
+}
 
 STBTT_DEF void stbtt_FreeShape(const stbtt_fontinfo *info, stbtt_vertex *v)
 {
-   STBTT_free(v, info->userdata);
+   stbtt__temp_free(v, info->userdata);
 }
 
 STBTT_DEF stbtt_uint8 *stbtt_FindSVGDoc(const stbtt_fontinfo *info, int gl)
@@ -2776,7 +3799,7 @@ static void *stbtt__hheap_alloc(stbtt__hheap *hh, size_t size, void *userdata)
    } else {
       if (hh->num_remaining_in_head_chunk == 0) {
          int count = (size < 32 ? 2000 : size < 128 ? 800 : 100);
-         stbtt__hheap_chunk *c = (stbtt__hheap_chunk *) STBTT_malloc(sizeof(stbtt__hheap_chunk) + size * count, userdata);
+         stbtt__hheap_chunk *c = (stbtt__hheap_chunk *) stbtt__temp_alloc(sizeof(stbtt__hheap_chunk) + size * count, userdata);
          if (c == NULL)
             return NULL;
          c->next = hh->head;
@@ -2799,7 +3822,7 @@ static void stbtt__hheap_cleanup(stbtt__hheap *hh, void *userdata)
    stbtt__hheap_chunk *c = hh->head;
    while (c) {
       stbtt__hheap_chunk *n = c->next;
-      STBTT_free(c, userdata);
+      stbtt__temp_free(c, userdata);
       c = n;
    }
 }
@@ -2931,7 +3954,7 @@ static void stbtt__rasterize_sorted_edges(stbtt__bitmap *result, stbtt__edge *e,
    unsigned char scanline_data[512], *scanline;
 
    if (result->w > 512)
-      scanline = (unsigned char *) STBTT_malloc(result->w, userdata);
+      scanline = (unsigned char *) stbtt__temp_alloc(result->w, userdata);
    else
       scanline = scanline_data;
 
@@ -3018,7 +4041,7 @@ static void stbtt__rasterize_sorted_edges(stbtt__bitmap *result, stbtt__edge *e,
    stbtt__hheap_cleanup(&hh, userdata);
 
    if (scanline != scanline_data)
-      STBTT_free(scanline, userdata);
+      stbtt__temp_free(scanline, userdata);
 }
 
 #elif STBTT_RASTERIZER_VERSION == 2
@@ -3079,6 +4102,55 @@ static float stbtt__sized_triangle_area(float height, float width)
    return height * width / 2;
 }
 
+// adds the coverage of the pixels an edge crosses between its first and last
+// pixel on a scanline: each gets 'area' (the rectangle from the pixels to the
+// left) plus step/2 (its own trapezoid), and 'area' grows by 'step' per pixel.
+// returns 'area' at x1.
+static float stbtt__fill_span(float *scanline, int x0, int x1, float area, float step)
+{
+   int x = x0;
+
+   // The scalar loop adds up 'area += step' one pixel at a time. The SIMD
+   // versions compute each pixel's area directly as area + n*step, which
+   // rounds differently, so on long spans a pixel can come out 1 higher or
+   // lower than the scalar build.
+#if defined(STBTT_SSE2)
+   if (x1 - x0 >= 8) {
+      float start = area + step/2;
+      __m128 vstep = _mm_set1_ps(step), vstart = _mm_set1_ps(start);
+      __m128 n = _mm_setr_ps(0,1,2,3), four = _mm_set1_ps(4.0f);
+      for (; x+4 <= x1; x += 4) {
+         __m128 v = _mm_add_ps(vstart, _mm_mul_ps(n, vstep));
+         _mm_storeu_ps(scanline+x, _mm_add_ps(_mm_loadu_ps(scanline+x), v));
+         n = _mm_add_ps(n, four);
+      }
+      for (; x < x1; ++x)
+         scanline[x] += start + (float) (x - x0) * step;
+      return area + (float) (x1 - x0) * step;
+   }
+#elif defined(STBTT_NEON)
+   if (x1 - x0 >= 8) {
+      float start = area + step/2;
+      static const float first[4] = { 0,1,2,3 };
+      float32x4_t vstart = vdupq_n_f32(start), n = vld1q_f32(first), four = vdupq_n_f32(4.0f);
+      for (; x+4 <= x1; x += 4) {
+         float32x4_t v = vaddq_f32(vstart, vmulq_n_f32(n, step));
+         vst1q_f32(scanline+x, vaddq_f32(vld1q_f32(scanline+x), v));
+         n = vaddq_f32(n, four);
+      }
+      for (; x < x1; ++x)
+         scanline[x] += start + (float) (x - x0) * step;
+      return area + (float) (x1 - x0) * step;
+   }
+#endif
+
+   for (; x < x1; ++x) {
+      scanline[x] += area + step/2; // area of trapezoid is 1*step/2
+      area += step;
+   }
+   return area;
+}
+
 static void stbtt__fill_active_edges_new(float *scanline, float *scanline_fill, int len, stbtt__active_edge *e, float y_top)
 {
    float y_bottom = y_top+1;
@@ -3138,7 +4210,7 @@ static void stbtt__fill_active_edges_new(float *scanline, float *scanline_fill,
                scanline[x]      += stbtt__position_trapezoid_area(height, x_top, x+1.0f, x_bottom, x+1.0f);
                scanline_fill[x] += height; // everything right of this pixel is filled
             } else {
-               int x,x1,x2;
+               int x1,x2;
                float y_crossing, y_final, step, sign, area;
                // covers 2+ pixels
                if (x_top > x_bottom) {
@@ -3213,10 +4285,7 @@ static void stbtt__fill_active_edges_new(float *scanline, float *scanline_fill,
                // which multiplied by 1-pixel-width is how much pixel area changes for each step in x
                // so the area advances by 'step' every time
 
-               for (x = x1+1; x < x2; ++x) {
-                  scanline[x] += area + step/2; // area of trapezoid is 1*step/2
-                  area += step;
-               }
+               area = stbtt__fill_span(scanline, x1+1, x2, area, step);
                STBTT_assert(STBTT_fabs(area) <= 1.01f); // accumulated error from area += step unless we round step down
                STBTT_assert(sy1 > y_final-0.01f);
 
@@ -3293,18 +4362,105 @@ static void stbtt__fill_active_edges_new(float *scanline, float *scanline_fill,
    }
 }
 
+static unsigned char stbtt__coverage_to_byte(float k)
+{
+   int m;
+   k = (float) STBTT_fabs(k)*255 + 0.5f;
+   m = (int) k;
+   if (m > 255) m = 255;
+   return (unsigned char) m;
+}
+
+// converts a scanline of coverage to 8-bit. 'fill' holds the changes in the
+// running sum that's added to every pixel to the right of an edge
+static void stbtt__scanline_to_pixels(unsigned char *out, const float *area, const float *fill, int w)
+{
+   float sum = 0;
+   int i = 0, k;
+
+   // The running sum is a prefix sum, which SIMD adds up in a different order
+   // than the scalar loop. But most of 'fill' is zero, and adding zero is exact,
+   // so in a group of 4 pixels with at most one edge crossing the order doesn't
+   // matter. Groups with more crossings are done one pixel at a time, so the
+   // results are identical either way. Short rows tend to be crowded with
+   // crossings, so they stay scalar.
+#if defined(STBTT_SSE2)
+   if (w >= 16) {
+      __m128 zero = _mm_setzero_ps(), sign = _mm_set1_ps(-0.0f);
+      __m128 scale = _mm_set1_ps(255.0f), half = _mm_set1_ps(0.5f);
+      for (; i+4 <= w; i += 4) {
+         __m128 f = _mm_loadu_ps(fill+i), s;
+         __m128i m;
+         int crossings = _mm_movemask_ps(_mm_cmpneq_ps(f, zero)), v;
+         if (crossings & (crossings-1)) {
+            for (k=0; k < 4; ++k) {
+               sum += fill[i+k];
+               out[i+k] = stbtt__coverage_to_byte(area[i+k] + sum);
+            }
+            continue;
+         }
+         f = _mm_add_ps(f, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(f), 4)));
+         f = _mm_add_ps(f, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(f), 8)));
+         s = _mm_add_ps(_mm_set1_ps(sum), f);
+         sum = _mm_cvtss_f32(_mm_shuffle_ps(s, s, _MM_SHUFFLE(3,3,3,3)));
+         s = _mm_add_ps(_mm_mul_ps(_mm_andnot_ps(sign, _mm_add_ps(_mm_loadu_ps(area+i), s)), scale), half);
+         // truncate like the (int) cast; the saturating packs clamp to 255
+         m = _mm_cvttps_epi32(s);
+         m = _mm_packs_epi32(m, m);
+         v = _mm_cvtsi128_si32(_mm_packus_epi16(m, m));
+         STBTT_memcpy(out+i, &v, 4);
+      }
+   }
+#elif defined(STBTT_NEON)
+   if (w >= 16) {
+      float32x4_t zero = vdupq_n_f32(0.0f), half = vdupq_n_f32(0.5f);
+      for (; i+4 <= w; i += 4) {
+         float32x4_t f = vld1q_f32(fill+i), s;
+         uint32x4_t crossings = vshrq_n_u32(vmvnq_u32(vceqq_f32(f, zero)), 31);
+         uint32x2_t count = vpadd_u32(vget_low_u32(crossings), vget_high_u32(crossings));
+         int16x4_t m;
+         uint8x8_t b;
+         if (vget_lane_u32(vpadd_u32(count, count), 0) > 1) {
+            for (k=0; k < 4; ++k) {
+               sum += fill[i+k];
+               out[i+k] = stbtt__coverage_to_byte(area[i+k] + sum);
+            }
+            continue;
+         }
+         f = vaddq_f32(f, vextq_f32(zero, f, 3));
+         f = vaddq_f32(f, vextq_f32(zero, f, 2));
+         s = vaddq_f32(vdupq_n_f32(sum), f);
+         sum = vgetq_lane_f32(s, 3);
+         s = vaddq_f32(vmulq_n_f32(vabsq_f32(vaddq_f32(vld1q_f32(area+i), s)), 255.0f), half);
+         m = vqmovn_s32(vcvtq_s32_f32(s));
+         b = vqmovun_s16(vcombine_s16(m, m));
+         out[i  ] = vget_lane_u8(b, 0);
+         out[i+1] = vget_lane_u8(b, 1);
+         out[i+2] = vget_lane_u8(b, 2);
+         out[i+3] = vget_lane_u8(b, 3);
+      }
+   }
+#endif
+
+   for (; i < w; ++i) {
+      sum += fill[i];
+      out[i] = stbtt__coverage_to_byte(area[i] + sum);
+   }
+   STBTT__NOTUSED(k);
+}
+
 // directly AA rasterize edges w/o supersampling
 static void stbtt__rasterize_sorted_edges(stbtt__bitmap *result, stbtt__edge *e, int n, int vsubsample, int off_x, int off_y, void *userdata)
 {
    stbtt__hheap hh = { 0, 0, 0 };
    stbtt__active_edge *active = NULL;
-   int y,j=0, i;
+   int y,j=0;
    float scanline_data[129], *scanline, *scanline2;
 
    STBTT__NOTUSED(vsubsample);
 
    if (result->w > 64)
-      scanline = (float *) STBTT_malloc((result->w*2+1) * sizeof(float), userdata);
+      scanline = (float *) stbtt__temp_alloc((result->w*2+1) * sizeof(float), userdata);
    else
       scanline = scanline_data;
 
@@ -3360,19 +4516,8 @@ static void stbtt__rasterize_sorted_edges(stbtt__bitmap *result, stbtt__edge *e,
       if (active)
          stbtt__fill_active_edges_new(scanline, scanline2+1, result->w, active, scan_y_top);
 
-      {
-         float sum = 0;
-         for (i=0; i < result->w; ++i) {
-            float k;
-            int m;
-            sum += scanline2[i];
-            k = scanline[i] + sum;
-            k = (float) STBTT_fabs(k)*255 + 0.5f;
-            m = (int) k;
-            if (m > 255) m = 255;
-            result->pixels[j*result->stride + i] = (unsigned char) m;
-         }
-      }
+      stbtt__scanline_to_pixels(result->pixels + j*result->stride, scanline, scanline2, result->w);
+
       // advance all the edges
       step = &active;
       while (*step) {
@@ -3388,7 +4533,7 @@ static void stbtt__rasterize_sorted_edges(stbtt__bitmap *result, stbtt__edge *e,
    stbtt__hheap_cleanup(&hh, userdata);
 
    if (scanline != scanline_data)
-      STBTT_free(scanline, userdata);
+      stbtt__temp_free(scanline, userdata);
 }
 #else
 #error "Unrecognized value of STBTT_RASTERIZER_VERSION"
@@ -3506,7 +4651,7 @@ static void stbtt__rasterize(stbtt__bitmap *result, stbtt__point *pts, int *wcou
    for (i=0; i < windings; ++i)
       n += wcount[i];
 
-   e = (stbtt__edge *) STBTT_malloc(sizeof(*e) * (n+1), userdata); // add an extra one as a sentinel
+   e = (stbtt__edge *) stbtt__temp_alloc(sizeof(*e) * (n+1), userdata); // add an extra one as a sentinel
    if (e == 0) return;
    n = 0;
 
@@ -3541,7 +4686,7 @@ static void stbtt__rasterize(stbtt__bitmap *result, stbtt__point *pts, int *wcou
    // now, traverse the scanlines and find the intersections on each scanline, use xor winding rule
    stbtt__rasterize_sorted_edges(result, e, n, vsubsample, off_x, off_y, userdata);
 
-   STBTT_free(e, userdata);
+   stbtt__temp_free(e, userdata);
 }
 
 static void stbtt__add_point(stbtt__point *points, int n, float x, float y)
@@ -3631,7 +4776,7 @@ static stbtt__point *stbtt_FlattenCurves(stbtt_vertex *vertices, int num_verts,
    *num_contours = n;
    if (n == 0) return 0;
 
-   *contour_lengths = (int *) STBTT_malloc(sizeof(**contour_lengths) * n, userdata);
+   *contour_lengths = (int *) stbtt__temp_alloc(sizeof(**contour_lengths) * n, userdata);
 
    if (*contour_lengths == 0) {
       *num_contours = 0;
@@ -3642,7 +4787,7 @@ static stbtt__point *stbtt_FlattenCurves(stbtt_vertex *vertices, int num_verts,
    for (pass=0; pass < 2; ++pass) {
       float x=0,y=0;
       if (pass == 1) {
-         points = (stbtt__point *) STBTT_malloc(num_points * sizeof(points[0]), userdata);
+         points = (stbtt__point *) stbtt__temp_alloc(num_points * sizeof(points[0]), userdata);
          if (points == NULL) goto error;
       }
       num_points = 0;
@@ -3685,8 +4830,8 @@ static stbtt__point *stbtt_FlattenCurves(stbtt_vertex *vertices, int num_verts,
 
    return points;
 error:
-   STBTT_free(points, userdata);
-   STBTT_free(*contour_lengths, userdata);
+   stbtt__temp_free(points, userdata);
+   stbtt__temp_free(*contour_lengths, userdata);
    *contour_lengths = 0;
    *num_contours = 0;
    return NULL;
@@ -3700,8 +4845,8 @@ STBTT_DEF void stbtt_Rasterize(stbtt__bitmap *result, float flatness_in_pixels,
    stbtt__point *windings = stbtt_FlattenCurves(vertices, num_verts, flatness_in_pixels / scale, &winding_lengths, &winding_count, userdata);
    if (windings) {
       stbtt__rasterize(result, windings, winding_lengths, winding_count, scale_x, scale_y, shift_x, shift_y, x_off, y_off, invert, userdata);
-      STBTT_free(winding_lengths, userdata);
-      STBTT_free(windings, userdata);
+      stbtt__temp_free(winding_lengths, userdata);
+      stbtt__temp_free(windings, userdata);
    }
 }
 
@@ -3720,7 +4865,7 @@ STBTT_DEF unsigned char *stbtt_GetGlyphBitmapSubpixel(const stbtt_fontinfo *info
    if (scale_x == 0) scale_x = scale_y;
    if (scale_y == 0) {
       if (scale_x == 0) {
-         STBTT_free(vertices, info->userdata);
+         stbtt__temp_free(vertices, info->userdata);
          return NULL;
       }
       scale_y = scale_x;
@@ -3746,7 +4891,7 @@ STBTT_DEF unsigned char *stbtt_GetGlyphBitmapSubpixel(const stbtt_fontinfo *info
          stbtt_Rasterize(&gbm, 0.35f, vertices, num_verts, scale_x, scale_y, shift_x, shift_y, ix0, iy0, 1, info->userdata);
       }
    }
-   STBTT_free(vertices, info->userdata);
+   stbtt__temp_free(vertices, info->userdata);
    return gbm.pixels;
 }
 
@@ -3771,7 +4916,7 @@ STBTT_DEF void stbtt_MakeGlyphBitmapSubpixel(const stbtt_fontinfo *info, unsigne
    if (gbm.w && gbm.h)
       stbtt_Rasterize(&gbm, 0.35f, vertices, num_verts, scale_x, scale_y, shift_x, shift_y, ix0,iy0, 1, info->userdata);
 
-   STBTT_free(vertices, info->userdata);
+   stbtt__temp_free(vertices, info->userdata);
 }
 
 STBTT_DEF void stbtt_MakeGlyphBitmap(const stbtt_fontinfo *info, unsigned char *output, int out_w, int out_h, int out_stride, float scale_x, float scale_y, int glyph)
@@ -3804,6 +4949,186 @@ STBTT_DEF void stbtt_MakeCodepointBitmap(const stbtt_fontinfo *info, unsigned ch
    stbtt_MakeCodepointBitmapSubpixel(info, output, out_w, out_h, out_stride, scale_x, scale_y, 0.0f,0.0f, codepoint);
 }
 
+//////////////////////////////////////////////////////////////////////////////
+//
+// LCD rendering
+//
+
+// FreeType's default LCD filter; the taps are symmetric and add up to 256
+#define STBTT__LCD_TAP0   8
+#define STBTT__LCD_TAP1  77
+#define STBTT__LCD_TAP2  86
+
+// filters n stripes of 3x-wide coverage from 'in' to 'out'. 'in' points at
+// two zero stripes of padding, so out[i] is centered on in[i+2], and there
+// are two more after the end. Every sum fits in 16 bits, so the SIMD paths
+// give exactly the scalar result.
+static void stbtt__lcd_filter_row(unsigned char *out, const unsigned char *in, int n)
+{
+   int i=0;
+#if defined(STBTT_SSE2)
+   {
+      __m128i zero = _mm_setzero_si128(), round = _mm_set1_epi16(128);
+      __m128i t0 = _mm_set1_epi16(STBTT__LCD_TAP0), t1 = _mm_set1_epi16(STBTT__LCD_TAP1), t2 = _mm_set1_epi16(STBTT__LCD_TAP2);
+      for (; i+16 <= n; i += 16) {
+         __m128i a = _mm_loadu_si128((const __m128i *) (in+i  ));
+         __m128i b = _mm_loadu_si128((const __m128i *) (in+i+1));
+         __m128i c = _mm_loadu_si128((const __m128i *) (in+i+2));
+         __m128i d = _mm_loadu_si128((const __m128i *) (in+i+3));
+         __m128i e = _mm_loadu_si128((const __m128i *) (in+i+4));
+         __m128i lo, hi;
+         lo = _mm_mullo_epi16(_mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(e, zero)), t0);
+         hi = _mm_mullo_epi16(_mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(e, zero)), t0);
+         lo = _mm_add_epi16(lo, _mm_mullo_epi16(_mm_add_epi16(_mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(d, zero)), t1));
+         hi = _mm_add_epi16(hi, _mm_mullo_epi16(_mm_add_epi16(_mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(d, zero)), t1));
+         lo = _mm_add_epi16(lo, _mm_mullo_epi16(_mm_unpacklo_epi8(c, zero), t2));
+         hi = _mm_add_epi16(hi, _mm_mullo_epi16(_mm_unpackhi_epi8(c, zero), t2));
+         lo = _mm_srli_epi16(_mm_add_epi16(lo, round), 8);
+         hi = _mm_srli_epi16(_mm_add_epi16(hi, round), 8);
+         _mm_storeu_si128((__m128i *) (out+i), _mm_packus_epi16(lo, hi));
+      }
+   }
+#elif defined(STBTT_NEON)
+   {
+      uint8x8_t t0 = vdup_n_u8(STBTT__LCD_TAP0), t1 = vdup_n_u8(STBTT__LCD_TAP1), t2 = vdup_n_u8(STBTT__LCD_TAP2);
+      for (; i+16 <= n; i += 16) {
+         uint8x16_t a = vld1q_u8(in+i  ), b = vld1q_u8(in+i+1), c = vld1q_u8(in+i+2);
+         uint8x16_t d = vld1q_u8(in+i+3), e = vld1q_u8(in+i+4);
+         uint16x8_t lo = vmull_u8(vget_low_u8 (a), t0);
+         uint16x8_t hi = vmull_u8(vget_high_u8(a), t0);
+         lo = vmlal_u8(lo, vget_low_u8 (b), t1);
+         hi = vmlal_u8(hi, vget_high_u8(b), t1);
+         lo = vmlal_u8(lo, vget_low_u8 (c), t2);
+         hi = vmlal_u8(hi, vget_high_u8(c), t2);
+         lo = vmlal_u8(lo, vget_low_u8 (d), t1);
+         hi = vmlal_u8(hi, vget_high_u8(d), t1);
+         lo = vmlal_u8(lo, vget_low_u8 (e), t0);
+         hi = vmlal_u8(hi, vget_high_u8(e), t0);
+         // vrshrn rounds, so this is (sum+128) >> 8
+         vst1q_u8(out+i, vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+      }
+   }
+#endif
+   for (; i < n; ++i)
+      out[i] = (unsigned char) ((STBTT__LCD_TAP0 * (in[i  ] + in[i+4]) +
+                                 STBTT__LCD_TAP1 * (in[i+1] + in[i+3]) +
+                                 STBTT__LCD_TAP2 *  in[i+2] + 128) >> 8);
+}
+
+STBTT_DEF void stbtt_MakeCoverageGammaTable(unsigned char table[256], float gamma)
+{
+   int i;
+   if (gamma <= 0) gamma = 1;
+   for (i=0; i < 256; ++i)
+      table[i] = (unsigned char) (STBTT_pow(i / 255.0f, 1.0f / gamma) * 255.0f + 0.5f);
+}
+
+STBTT_DEF void stbtt_GetGlyphBitmapBoxLCD(const stbtt_fontinfo *font, int glyph, float scale_x, float scale_y, float shift_x, float shift_y, int *ix0, int *iy0, int *ix1, int *iy1)
+{
+   int x0,x1;
+   stbtt_GetGlyphBitmapBoxSubpixel(font, glyph, scale_x, scale_y, shift_x, shift_y, &x0,iy0,&x1,iy1);
+   // the 3x-wide glyph stays inside the 1x box, and the filter reaches two
+   // stripes past it, so one more pixel on each side covers it
+   if (x0 < x1) {
+      --x0;
+      ++x1;
+   }
+   if (ix0) *ix0 = x0;
+   if (ix1) *ix1 = x1;
+}
+
+STBTT_DEF void stbtt_MakeGlyphBitmapLCD(const stbtt_fontinfo *info, unsigned char *output, int out_w, int out_h, int out_stride, float scale_x, float scale_y, float shift_x, float shift_y, const unsigned char *coverage_table, int flags, int glyph)
+{
+   int ix0,iy0,i,j;
+   int n = out_w * 3, stride = n + 4; // two stripes of padding either side
+   stbtt_vertex *vertices;
+   int num_verts;
+   stbtt__bitmap gbm;
+   unsigned char *coverage;
+
+   if (out_w <= 0 || out_h <= 0)
+      return;
+
+   stbtt_GetGlyphBitmapBoxLCD(info, glyph, scale_x, scale_y, shift_x, shift_y, &ix0,&iy0,0,0);
+   num_verts = stbtt_GetGlyphShape(info, glyph, &vertices);
+   coverage = (unsigned char *) stbtt__temp_alloc(stride * out_h, info->userdata);
+   if (coverage == NULL) {
+      stbtt__temp_free(vertices, info->userdata);
+      return;
+   }
+
+   // the rasterizer writes every pixel it's given, but nothing at all for an
+   // empty glyph, and never the padding
+   STBTT_memset(coverage, 0, stride * out_h);
+   gbm.pixels = coverage + 2;
+   gbm.w = n;
+   gbm.h = out_h;
+   gbm.stride = stride;
+   // output pixel x covers stripes 3x..3x+2
+   stbtt_Rasterize(&gbm, 0.35f, vertices, num_verts, scale_x*3, scale_y, shift_x*3, shift_y, ix0*3,iy0, 1, info->userdata);
+   stbtt__temp_free(vertices, info->userdata);
+
+   for (j=0; j < out_h; ++j) {
+      unsigned char *out = output + j*out_stride;
+      stbtt__lcd_filter_row(out, coverage + j*stride, n);
+      if (flags & STBTT_LCD_BGR) {
+         for (i=0; i < n; i += 3) {
+            unsigned char t = out[i];
+            out[i  ] = out[i+2];
+            out[i+2] = t;
+         }
+      }
+      if (coverage_table)
+         for (i=0; i < n; ++i)
+            out[i] = coverage_table[out[i]];
+   }
+
+   stbtt__temp_free(coverage, info->userdata);
+}
+
+STBTT_DEF unsigned char *stbtt_GetGlyphBitmapLCD(const stbtt_fontinfo *info, float scale_x, float scale_y, float shift_x, float shift_y, const unsigned char *coverage_table, int flags, int glyph, int *width, int *height, int *xoff, int *yoff)
+{
+   int ix0,iy0,ix1,iy1,w,h;
+   unsigned char *pixels = NULL;
+
+   if (scale_x == 0) scale_x = scale_y;
+   if (scale_y == 0) {
+      if (scale_x == 0) return NULL;
+      scale_y = scale_x;
+   }
+
+   stbtt_GetGlyphBitmapBoxLCD(info, glyph, scale_x, scale_y, shift_x, shift_y, &ix0,&iy0,&ix1,&iy1);
+   w = ix1 - ix0;
+   h = iy1 - iy0;
+
+   if (width ) *width  = w;
+   if (height) *height = h;
+   if (xoff  ) *xoff   = ix0;
+   if (yoff  ) *yoff   = iy0;
+
+   if (w && h) {
+      pixels = (unsigned char *) STBTT_malloc(w * h * 3, info->userdata);
+      if (pixels)
+         stbtt_MakeGlyphBitmapLCD(info, pixels, w, h, w*3, scale_x, scale_y, shift_x, shift_y, coverage_table, flags, glyph);
+   }
+   return pixels;
+}
+
+STBTT_DEF void stbtt_GetCodepointBitmapBoxLCD(const stbtt_fontinfo *font, int codepoint, float scale_x, float scale_y, float shift_x, float shift_y, int *ix0, int *iy0, int *ix1, int *iy1)
+{
+   stbtt_GetGlyphBitmapBoxLCD(font, stbtt_FindGlyphIndex(font,codepoint), scale_x, scale_y, shift_x, shift_y, ix0,iy0,ix1,iy1);
+}
+
+STBTT_DEF void stbtt_MakeCodepointBitmapLCD(const stbtt_fontinfo *info, unsigned char *output, int out_w, int out_h, int out_stride, float scale_x, float scale_y, float shift_x, float shift_y, const unsigned char *coverage_table, int flags, int codepoint)
+{
+   stbtt_MakeGlyphBitmapLCD(info, output, out_w, out_h, out_stride, scale_x, scale_y, shift_x, shift_y, coverage_table, flags, stbtt_FindGlyphIndex(info,codepoint));
+}
+
+STBTT_DEF unsigned char *stbtt_GetCodepointBitmapLCD(const stbtt_fontinfo *info, float scale_x, float scale_y, float shift_x, float shift_y, const unsigned char *coverage_table, int flags, int codepoint, int *width, int *height, int *xoff, int *yoff)
+{
+   return stbtt_GetGlyphBitmapLCD(info, scale_x, scale_y, shift_x, shift_y, coverage_table, flags, stbtt_FindGlyphIndex(info,codepoint), width,height,xoff,yoff);
+}
+
 //////////////////////////////////////////////////////////////////////////////
 //
 // bitmap baking
@@ -4204,76 +5529,92 @@ STBTT_DEF void stbtt_MakeGlyphBitmapSubpixelPrefilter(const stbtt_fontinfo *info
    *sub_y = stbtt__oversample_shift(prefilter_y);
 }
 
-// rects array must be big enough to accommodate all characters in the given ranges
-STBTT_DEF int stbtt_PackFontRangesRenderIntoRects(stbtt_pack_context *spc, const stbtt_fontinfo *info, stbtt_pack_range *ranges, int num_ranges, stbrp_rect *rects)
+// rasterizes the glyphs of rects split_index, split_index+split_count, ... and fills
+// in their packedchars. The rects themselves aren't touched, so splits never share
+// anything but the atlas pixels, and those are disjoint.
+STBTT_DEF void stbtt_PackFontRangesRenderSplit(stbtt_pack_context *spc, const stbtt_fontinfo *info, stbtt_pack_range *ranges, int num_ranges, stbrp_rect *rects, int split_index, int split_count)
 {
-   int i,j,k, missing_glyph = -1, return_value = 1;
-
-   // save current values
-   int old_h_over = spc->h_oversample;
-   int old_v_over = spc->v_oversample;
+   int i,j,k,first;
 
    k = 0;
    for (i=0; i < num_ranges; ++i) {
       float fh = ranges[i].font_size;
       float scale = fh > 0 ? stbtt_ScaleForPixelHeight(info, fh) : stbtt_ScaleForMappingEmToPixels(info, -fh);
-      float recip_h,recip_v,sub_x,sub_y;
-      spc->h_oversample = ranges[i].h_oversample;
-      spc->v_oversample = ranges[i].v_oversample;
-      recip_h = 1.0f / spc->h_oversample;
-      recip_v = 1.0f / spc->v_oversample;
-      sub_x = stbtt__oversample_shift(spc->h_oversample);
-      sub_y = stbtt__oversample_shift(spc->v_oversample);
-      for (j=0; j < ranges[i].num_chars; ++j) {
-         stbrp_rect *r = &rects[k];
+      int h_oversample = ranges[i].h_oversample;
+      int v_oversample = ranges[i].v_oversample;
+      float recip_h = 1.0f / h_oversample;
+      float recip_v = 1.0f / v_oversample;
+      float sub_x = stbtt__oversample_shift(h_oversample);
+      float sub_y = stbtt__oversample_shift(v_oversample);
+
+      // first j in this range with (k+j) % split_count == split_index
+      first = (split_index - k % split_count + split_count) % split_count;
+      for (j=first; j < ranges[i].num_chars; j += split_count) {
+         stbrp_rect *r = &rects[k+j];
          if (r->was_packed && r->w != 0 && r->h != 0) {
             stbtt_packedchar *bc = &ranges[i].chardata_for_range[j];
             int advance, lsb, x0,y0,x1,y1;
             int codepoint = ranges[i].array_of_unicode_codepoints == NULL ? ranges[i].first_unicode_codepoint_in_range + j : ranges[i].array_of_unicode_codepoints[j];
             int glyph = stbtt_FindGlyphIndex(info, codepoint);
-            stbrp_coord pad = (stbrp_coord) spc->padding;
+            int pad = spc->padding;
 
             // pad on left and top
-            r->x += pad;
-            r->y += pad;
-            r->w -= pad;
-            r->h -= pad;
+            int rx = r->x + pad, ry = r->y + pad;
+            int rw = r->w - pad, rh = r->h - pad;
+            unsigned char *pixels = spc->pixels + rx + ry*spc->stride_in_bytes;
+
             stbtt_GetGlyphHMetrics(info, glyph, &advance, &lsb);
             stbtt_GetGlyphBitmapBox(info, glyph,
-                                    scale * spc->h_oversample,
-                                    scale * spc->v_oversample,
+                                    scale * h_oversample,
+                                    scale * v_oversample,
                                     &x0,&y0,&x1,&y1);
             stbtt_MakeGlyphBitmapSubpixel(info,
-                                          spc->pixels + r->x + r->y*spc->stride_in_bytes,
-                                          r->w - spc->h_oversample+1,
-                                          r->h - spc->v_oversample+1,
+                                          pixels,
+                                          rw - h_oversample+1,
+                                          rh - v_oversample+1,
                                           spc->stride_in_bytes,
-                                          scale * spc->h_oversample,
-                                          scale * spc->v_oversample,
+                                          scale * h_oversample,
+                                          scale * v_oversample,
                                           0,0,
                                           glyph);
 
-            if (spc->h_oversample > 1)
-               stbtt__h_prefilter(spc->pixels + r->x + r->y*spc->stride_in_bytes,
-                                  r->w, r->h, spc->stride_in_bytes,
-                                  spc->h_oversample);
+            if (h_oversample > 1)
+               stbtt__h_prefilter(pixels, rw, rh, spc->stride_in_bytes, h_oversample);
 
-            if (spc->v_oversample > 1)
-               stbtt__v_prefilter(spc->pixels + r->x + r->y*spc->stride_in_bytes,
-                                  r->w, r->h, spc->stride_in_bytes,
-                                  spc->v_oversample);
+            if (v_oversample > 1)
+               stbtt__v_prefilter(pixels, rw, rh, spc->stride_in_bytes, v_oversample);
 
-            bc->x0       = (stbtt_int16)  r->x;
-            bc->y0       = (stbtt_int16)  r->y;
-            bc->x1       = (stbtt_int16) (r->x + r->w);
-            bc->y1       = (stbtt_int16) (r->y + r->h);
+            bc->x0       = (stbtt_int16)  rx;
+            bc->y0       = (stbtt_int16)  ry;
+            bc->x1       = (stbtt_int16) (rx + rw);
+            bc->y1       = (stbtt_int16) (ry + rh);
             bc->xadvance =                scale * advance;
             bc->xoff     =       (float)  x0 * recip_h + sub_x;
             bc->yoff     =       (float)  y0 * recip_v + sub_y;
-            bc->xoff2    =                (x0 + r->w) * recip_h + sub_x;
-            bc->yoff2    =                (y0 + r->h) * recip_v + sub_y;
+            bc->xoff2    =                (x0 + rw) * recip_h + sub_x;
+            bc->yoff2    =                (y0 + rh) * recip_v + sub_y;
+         }
+      }
+      k += ranges[i].num_chars;
+   }
+}
 
-            if (glyph == 0)
+STBTT_DEF int stbtt_PackFontRangesFinishSplits(stbtt_pack_context *spc, const stbtt_fontinfo *info, stbtt_pack_range *ranges, int num_ranges, stbrp_rect *rects)
+{
+   int i,j,k, missing_glyph = -1, return_value = 1;
+   stbrp_coord pad = (stbrp_coord) spc->padding;
+
+   k = 0;
+   for (i=0; i < num_ranges; ++i) {
+      for (j=0; j < ranges[i].num_chars; ++j) {
+         stbrp_rect *r = &rects[k];
+         if (r->was_packed && r->w != 0 && r->h != 0) {
+            int codepoint = ranges[i].array_of_unicode_codepoints == NULL ? ranges[i].first_unicode_codepoint_in_range + j : ranges[i].array_of_unicode_codepoints[j];
+            r->x += pad;
+            r->y += pad;
+            r->w -= pad;
+            r->h -= pad;
+            if (!spc->skip_missing && stbtt_FindGlyphIndex(info, codepoint) == 0)
                missing_glyph = j;
          } else if (spc->skip_missing) {
             return_value = 0;
@@ -4287,13 +5628,56 @@ STBTT_DEF int stbtt_PackFontRangesRenderIntoRects(stbtt_pack_context *spc, const
       }
    }
 
-   // restore original values
-   spc->h_oversample = old_h_over;
-   spc->v_oversample = old_v_over;
-
    return return_value;
 }
 
+// rects array must be big enough to accommodate all characters in the given ranges
+STBTT_DEF int stbtt_PackFontRangesRenderIntoRects(stbtt_pack_context *spc, const stbtt_fontinfo *info, stbtt_pack_range *ranges, int num_ranges, stbrp_rect *rects)
+{
+   stbtt_PackFontRangesRenderSplit(spc, info, ranges, num_ranges, rects, 0, 1);
+   return stbtt_PackFontRangesFinishSplits(spc, info, ranges, num_ranges, rects);
+}
+
+typedef struct
+{
+   stbtt_pack_context *spc;
+   const stbtt_fontinfo *info;
+   stbtt_pack_range *ranges;
+   stbrp_rect *rects;
+   int num_ranges;
+   int split_count;
+} stbtt__packsplits;
+
+static void stbtt__pack_split_task(void *task_data, int task_index)
+{
+   stbtt__packsplits *t = (stbtt__packsplits *) task_data;
+   stbtt_PackFontRangesRenderSplit(t->spc, t->info, t->ranges, t->num_ranges, t->rects, task_index, t->split_count);
+}
+
+STBTT_DEF int stbtt_PackFontRangesRenderIntoRectsThreaded(stbtt_pack_context *spc, const stbtt_fontinfo *info, stbtt_pack_range *ranges, int num_ranges, stbrp_rect *rects,
+                                                         int split_count, stbtt_dispatch_callback *dispatch, void *dispatch_context)
+{
+   stbtt__packsplits t;
+   int i;
+
+   if (split_count < 1)
+      split_count = 1;
+   t.spc = spc;
+   t.info = info;
+   t.ranges = ranges;
+   t.rects = rects;
+   t.num_ranges = num_ranges;
+   t.split_count = split_count;
+
+   if (dispatch && split_count > 1)
+      dispatch(stbtt__pack_split_task, &t, split_count, dispatch_context);
+   else
+      for (i=0; i < split_count; ++i)
+         stbtt__pack_split_task(&t, i);
+
+   return stbtt_PackFontRangesFinishSplits(spc, info, ranges, num_ranges, rects);
+}
+
 STBTT_DEF void stbtt_PackFontRangesPackRects(stbtt_pack_context *spc, stbrp_rect *rects, int num_rects)
 {
    stbrp_pack_rects((stbrp_context *) spc->pack_info, rects, num_rects);
@@ -4318,7 +5702,7 @@ STBTT_DEF int stbtt_PackFontRanges(stbtt_pack_context *spc, const unsigned char
    for (i=0; i < num_ranges; ++i)
       n += ranges[i].num_chars;
 
-   rects = (stbrp_rect *) STBTT_malloc(sizeof(*rects) * n, spc->user_allocator_context);
+   rects = (stbrp_rect *) stbtt__temp_alloc(sizeof(*rects) * n, spc->user_allocator_context);
    if (rects == NULL)
       return 0;
 
@@ -4331,7 +5715,7 @@ STBTT_DEF int stbtt_PackFontRanges(stbtt_pack_context *spc, const unsigned char
 
    return_value = stbtt_PackFontRangesRenderIntoRects(spc, &info, ranges, num_ranges, rects);
 
-   STBTT_free(rects, spc->user_allocator_context);
+   stbtt__temp_free(rects, spc->user_allocator_context);
    return return_value;
 }
 
@@ -4389,22 +5773,545 @@ STBTT_DEF void stbtt_GetPackedQuad(const stbtt_packedchar *chardata, int pw, int
 
 //////////////////////////////////////////////////////////////////////////////
 //
-// sdf computation
+// glyph cache
 //
 
-#define STBTT_min(a,b)  ((a) < (b) ? (a) : (b))
-#define STBTT_max(a,b)  ((a) < (b) ? (b) : (a))
-
-static int stbtt__ray_intersect_bezier(float orig[2], float ray[2], float q0[2], float q1[2], float q2[2], float hits[2][2])
+typedef struct
+{
+   const stbtt_fontinfo *font; // NULL if the entry is free
+   float scale;
+   int glyph;
+   int bucket;
+   int page;
+   int next;                   // free list
+   stbtt_packedchar data;
+} stbtt__cacheentry;
+
+typedef struct
+{
+   stbrp_context packer;
+   stbrp_node *nodes;
+   unsigned int last_used;      // last frame any of its glyphs was used
+   int glyphs;
+   int dirty_x0, dirty_y0, dirty_x1, dirty_y1; // empty if x0 >= x1
+} stbtt__cachepage;
+
+static stbtt_uint32 stbtt__glyphcache_hash(const stbtt_fontinfo *font, int glyph, float scale, int bucket)
+{
+   stbtt_uint32 h, s;
+   STBTT_memcpy(&s, &scale, 4);
+   h  = (stbtt_uint32) ((size_t) font >> 4) * 0x9e3779b1u;
+   h  = (h ^ (stbtt_uint32) glyph) * 0x85ebca6bu;
+   h  = (h ^ s) * 0xc2b2ae35u;
+   h ^= (stbtt_uint32) bucket;
+   return h ^ (h >> 16);
+}
+
+static void stbtt__glyphcache_insert(stbtt_glyphcache *gc, int index)
+{
+   stbtt__cacheentry *e = (stbtt__cacheentry *) gc->entries + index;
+   stbtt_uint32 slot = stbtt__glyphcache_hash(e->font, e->glyph, e->scale, e->bucket) & gc->hash_mask;
+   while (gc->hash[slot] >= 0)
+      slot = (slot + 1) & gc->hash_mask;
+   gc->hash[slot] = index;
+}
+
+static void stbtt__glyphcache_mark_dirty(stbtt__cachepage *p, int x0, int y0, int x1, int y1)
+{
+   if (p->dirty_x0 >= p->dirty_x1) {
+      p->dirty_x0 = x0; p->dirty_y0 = y0;
+      p->dirty_x1 = x1; p->dirty_y1 = y1;
+   } else {
+      if (x0 < p->dirty_x0) p->dirty_x0 = x0;
+      if (y0 < p->dirty_y0) p->dirty_y0 = y0;
+      if (x1 > p->dirty_x1) p->dirty_x1 = x1;
+      if (y1 > p->dirty_y1) p->dirty_y1 = y1;
+   }
+}
+
+static void stbtt__glyphcache_clear_page(stbtt_glyphcache *gc, int page)
+{
+   stbtt__cachepage *p = (stbtt__cachepage *) gc->pages + page;
+   int num_nodes = gc->width - gc->padding;
+   stbrp_init_target(&p->packer, gc->width - gc->padding, gc->height - gc->padding, p->nodes, num_nodes);
+   STBTT_memset(gc->pixels + (size_t) page * gc->width * gc->height, 0, (size_t) gc->width * gc->height);
+   p->last_used = 0;
+   p->glyphs = 0;
+   p->dirty_x0 = p->dirty_x1 = 0;
+   stbtt__glyphcache_mark_dirty(p, 0, 0, gc->width, gc->height);
+}
+
+// drops everything on the least recently used page that isn't in use this frame
+// (an empty page never needs evicting; anything that fits at all fits in it)
+static int stbtt__glyphcache_evict(stbtt_glyphcache *gc)
 {
-   float q0perp = q0[1]*ray[0] - q0[0]*ray[1];
-   float q1perp = q1[1]*ray[0] - q1[0]*ray[1];
-   float q2perp = q2[1]*ray[0] - q2[0]*ray[1];
-   float roperp = orig[1]*ray[0] - orig[0]*ray[1];
+   stbtt__cachepage  *pages   = (stbtt__cachepage  *) gc->pages;
+   stbtt__cacheentry *entries = (stbtt__cacheentry *) gc->entries;
+   int i, victim = -1;
 
-   float a = q0perp - 2*q1perp + q2perp;
-   float b = q1perp - q0perp;
-   float c = q0perp - roperp;
+   for (i=0; i < gc->num_pages; ++i)
+      if (pages[i].glyphs > 0 && pages[i].last_used != gc->frame && (victim < 0 || pages[i].last_used < pages[victim].last_used))
+         victim = i;
+   if (victim < 0)
+      return -1;
+
+   for (i=0; i < gc->max_glyphs; ++i) {
+      if (entries[i].font != NULL && entries[i].page == victim) {
+         entries[i].font = NULL;
+         entries[i].next = gc->free_list;
+         gc->free_list = i;
+         --gc->stats.glyphs;
+      }
+   }
+
+   // linear probing can't delete in place, so rebuild the table
+   STBTT_memset(gc->hash, 0xff, sizeof(int) * (gc->hash_mask + 1));
+   for (i=0; i < gc->max_glyphs; ++i)
+      if (entries[i].font != NULL)
+         stbtt__glyphcache_insert(gc, i);
+
+   stbtt__glyphcache_clear_page(gc, victim);
+   gc->current_page = victim;
+   ++gc->stats.evictions;
+   return victim;
+}
+
+// tries the page we packed into last, then the rest
+static int stbtt__glyphcache_pack(stbtt_glyphcache *gc, stbrp_rect *r)
+{
+   stbtt__cachepage *pages = (stbtt__cachepage *) gc->pages;
+   int i;
+   for (i=0; i < gc->num_pages; ++i) {
+      int page = (gc->current_page + i) % gc->num_pages;
+      stbrp_pack_rects(&pages[page].packer, r, 1);
+      if (r->was_packed) {
+         gc->current_page = page;
+         return page;
+      }
+   }
+   return -1;
+}
+
+STBTT_DEF int stbtt_GlyphCacheBegin(stbtt_glyphcache *gc, unsigned char *pixels, int width, int height, int num_pages, int max_glyphs, int padding, void *alloc_context)
+{
+   int num_nodes = width - padding;
+   int hash_size = 16, i;
+   stbtt__cachepage  *pages;
+   stbtt__cacheentry *entries;
+   stbrp_node *nodes;
+   char *mem;
+
+   if (num_pages < 1 || max_glyphs < 1 || num_nodes < 1 || height - padding < 1)
+      return 0;
+
+   // keep the table at most half full
+   while (hash_size < max_glyphs * 2)
+      hash_size *= 2;
+
+   mem = (char *) STBTT_malloc(sizeof(*pages) * num_pages + sizeof(*entries) * max_glyphs + sizeof(int) * hash_size + sizeof(*nodes) * num_nodes * num_pages, alloc_context);
+   if (mem == NULL)
+      return 0;
+
+   pages   = (stbtt__cachepage  *) mem;
+   entries = (stbtt__cacheentry *) (pages + num_pages);
+   gc->hash = (int *) (entries + max_glyphs);
+   nodes   = (stbrp_node *) (gc->hash + hash_size);
+
+   gc->user_allocator_context = alloc_context;
+   gc->pixels = pixels;
+   gc->width = width;
+   gc->height = height;
+   gc->num_pages = num_pages;
+   gc->padding = padding;
+   gc->subpixel_buckets = 1;
+   gc->max_glyphs = max_glyphs;
+   gc->hash_mask = hash_size - 1;
+   gc->current_page = 0;
+   gc->frame = 1;
+   gc->pages = pages;
+   gc->entries = entries;
+   STBTT_memset(&gc->stats, 0, sizeof(gc->stats));
+
+   for (i=0; i < num_pages; ++i) {
+      pages[i].nodes = nodes + i * num_nodes;
+      stbtt__glyphcache_clear_page(gc, i);
+   }
+
+   for (i=0; i < max_glyphs; ++i) {
+      entries[i].font = NULL;
+      entries[i].next = i+1 < max_glyphs ? i+1 : -1;
+   }
+   gc->free_list = 0;
+   STBTT_memset(gc->hash, 0xff, sizeof(int) * hash_size);
+
+   return 1;
+}
+
+STBTT_DEF void stbtt_GlyphCacheEnd(stbtt_glyphcache *gc)
+{
+   STBTT_free(gc->pages, gc->user_allocator_context);
+}
+
+STBTT_DEF void stbtt_GlyphCacheSetSubpixelBuckets(stbtt_glyphcache *gc, int buckets)
+{
+   STBTT_assert(buckets >= 1 && buckets <= STBTT_MAX_OVERSAMPLE);
+   if (buckets >= 1 && buckets <= STBTT_MAX_OVERSAMPLE)
+      gc->subpixel_buckets = buckets;
+}
+
+STBTT_DEF void stbtt_GlyphCacheNextFrame(stbtt_glyphcache *gc)
+{
+   ++gc->frame;
+}
+
+STBTT_DEF int stbtt_GlyphCacheGet(stbtt_glyphcache *gc, const stbtt_fontinfo *info, int glyph, float scale, float x_fraction, stbtt_packedchar *glyphdata)
+{
+   stbtt__cachepage  *pages   = (stbtt__cachepage  *) gc->pages;
+   stbtt__cacheentry *entries = (stbtt__cacheentry *) gc->entries;
+   stbtt__cacheentry *e;
+   int bucket = (int) (x_fraction * gc->subpixel_buckets);
+   int i, page, advance, lsb, x0,y0,x1,y1;
+   stbtt_uint32 slot;
+   float shift_x;
+   stbrp_rect r;
+
+   if (bucket < 0) bucket = 0;
+   if (bucket >= gc->subpixel_buckets) bucket = gc->subpixel_buckets - 1;
+
+   slot = stbtt__glyphcache_hash(info, glyph, scale, bucket) & gc->hash_mask;
+   while ((i = gc->hash[slot]) >= 0) {
+      e = &entries[i];
+      if (e->font == info && e->glyph == glyph && e->scale == scale && e->bucket == bucket) {
+         pages[e->page].last_used = gc->frame;
+         *glyphdata = e->data;
+         ++gc->stats.hits;
+         return e->page;
+      }
+      slot = (slot + 1) & gc->hash_mask;
+   }
+
+   ++gc->stats.misses;
+
+   shift_x = (float) bucket / gc->subpixel_buckets;
+   stbtt_GetGlyphBitmapBoxSubpixel(info, glyph, scale, scale, shift_x, 0.0f, &x0,&y0,&x1,&y1);
+   r.id = glyph;
+   r.x = r.y = 0;
+   r.w = r.h = 0;
+   if (x1 > x0 && y1 > y0) {
+      r.w = (stbrp_coord) (x1-x0 + gc->padding);
+      r.h = (stbrp_coord) (y1-y0 + gc->padding);
+   }
+
+   if (r.w > gc->width - gc->padding || r.h > gc->height - gc->padding) {
+      ++gc->stats.failures;
+      return -1;
+   }
+
+   if (gc->free_list < 0 && stbtt__glyphcache_evict(gc) < 0) {
+      ++gc->stats.failures;
+      return -1;
+   }
+
+   if (r.w == 0) {
+      // nothing to pack; it just goes away with whatever page is current
+      page = gc->current_page;
+   } else {
+      page = stbtt__glyphcache_pack(gc, &r);
+      if (page < 0) {
+         if (stbtt__glyphcache_evict(gc) < 0) {
+            ++gc->stats.failures;
+            return -1;
+         }
+         page = stbtt__glyphcache_pack(gc, &r);
+         STBTT_assert(page >= 0); // an empty page always fits it
+      }
+
+      // pad on left and top
+      r.x += gc->padding;
+      r.y += gc->padding;
+      r.w -= gc->padding;
+      r.h -= gc->padding;
+      stbtt_MakeGlyphBitmapSubpixel(info, gc->pixels + (size_t) page * gc->width * gc->height + r.x + r.y * gc->width,
+                                    r.w, r.h, gc->width, scale, scale, shift_x, 0.0f, glyph);
+      stbtt__glyphcache_mark_dirty(&pages[page], r.x, r.y, r.x + r.w, r.y + r.h);
+   }
+
+   i = gc->free_list;
+   e = &entries[i];
+   gc->free_list = e->next;
+   e->font = info;
+   e->scale = scale;
+   e->glyph = glyph;
+   e->bucket = bucket;
+   e->page = page;
+   stbtt_GetGlyphHMetrics(info, glyph, &advance, &lsb);
+   e->data.x0      = (unsigned short)  r.x;
+   e->data.y0      = (unsigned short)  r.y;
+   e->data.x1      = (unsigned short) (r.x + r.w);
+   e->data.y1      = (unsigned short) (r.y + r.h);
+   e->data.xoff    = (float)  x0;
+   e->data.yoff    = (float)  y0;
+   e->data.xoff2   = (float) (x0 + r.w);
+   e->data.yoff2   = (float) (y0 + r.h);
+   e->data.xadvance = scale * advance;
+   stbtt__glyphcache_insert(gc, i);
+
+   pages[page].last_used = gc->frame;
+   ++pages[page].glyphs;
+   ++gc->stats.glyphs;
+   *glyphdata = e->data;
+   return page;
+}
+
+STBTT_DEF int stbtt_GlyphCacheGetDirtyRect(stbtt_glyphcache *gc, int page, int *x0, int *y0, int *x1, int *y1)
+{
+   stbtt__cachepage *p = (stbtt__cachepage *) gc->pages + page;
+   if (p->dirty_x0 >= p->dirty_x1)
+      return 0;
+   *x0 = p->dirty_x0;
+   *y0 = p->dirty_y0;
+   *x1 = p->dirty_x1;
+   *y1 = p->dirty_y1;
+   p->dirty_x0 = p->dirty_x1 = 0;
+   return 1;
+}
+
+STBTT_DEF void stbtt_GlyphCacheGetStats(stbtt_glyphcache *gc, stbtt_glyphcache_stats *stats, int reset)
+{
+   *stats = gc->stats;
+   if (reset) {
+      int glyphs = gc->stats.glyphs;
+      STBTT_memset(&gc->stats, 0, sizeof(gc->stats));
+      gc->stats.glyphs = glyphs;
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// text layout
+//
+
+STBTT_DEF int stbtt_LayoutBegin(stbtt_layout *lo, const stbtt_fontinfo *info, float scale, void *alloc_context)
+{
+   int i, ascent, descent, line_gap, advance;
+
+   lo->advances = (float *) STBTT_malloc(sizeof(float) * (info->numGlyphs > 0 ? info->numGlyphs : 1), alloc_context);
+   if (lo->advances == NULL)
+      return 0;
+   for (i=0; i < info->numGlyphs; ++i) {
+      stbtt_GetGlyphHMetrics(info, i, &advance, NULL);
+      lo->advances[i] = advance * scale;
+   }
+
+   stbtt_GetFontVMetrics(info, &ascent, &descent, &line_gap);
+   lo->info = info;
+   lo->user_allocator_context = alloc_context;
+   lo->scale = scale;
+   lo->num_glyphs = info->numGlyphs;
+   lo->ascent = ascent * scale;
+   lo->descent = descent * scale;
+   lo->line_gap = line_gap * scale;
+   lo->line_height = (ascent - descent + line_gap) * scale;
+   return 1;
+}
+
+STBTT_DEF void stbtt_LayoutEnd(stbtt_layout *lo)
+{
+   STBTT_free(lo->advances, lo->user_allocator_context);
+   lo->advances = NULL;
+}
+
+// decodes the codepoint at s; returns its length in bytes, taking bad
+// sequences one byte at a time as U+FFFD
+static int stbtt__utf8_decode(const stbtt_uint8 *s, int len, int *codepoint)
+{
+   int n, i, c = s[0];
+   if (c < 0x80) { *codepoint = c; return 1; }
+   else if (c >= 0xc2 && c < 0xe0) { n = 2; c &= 0x1f; }
+   else if (c >= 0xe0 && c < 0xf0) { n = 3; c &= 0x0f; }
+   else if (c >= 0xf0 && c < 0xf5) { n = 4; c &= 0x07; }
+   else { *codepoint = 0xfffd; return 1; }
+   if (n > len) { *codepoint = 0xfffd; return 1; }
+   for (i=1; i < n; ++i) {
+      if ((s[i] & 0xc0) != 0x80) { *codepoint = 0xfffd; return 1; }
+      c = (c << 6) | (s[i] & 0x3f);
+   }
+   // overlong, surrogate or past the end of unicode
+   if (c < (n == 3 ? 0x800 : n == 4 ? 0x10000 : 0x80) || (c >= 0xd800 && c < 0xe000) || c > 0x10ffff)
+      c = 0xfffd;
+   *codepoint = c;
+   return n;
+}
+
+static int stbtt__layout_glyph(const stbtt_layout *lo, int codepoint)
+{
+   int g = stbtt_FindGlyphIndex(lo->info, codepoint);
+   return g < lo->num_glyphs ? g : 0;
+}
+
+// the pen position of the next glyph, after kerning with the previous one
+static float stbtt__layout_kern(const stbtt_layout *lo, float x, int prev, int g)
+{
+   if (prev >= 0 && (lo->info->kern || lo->info->gpos))
+      x += lo->scale * stbtt_GetGlyphKernAdvance(lo->info, prev, g);
+   return x;
+}
+
+STBTT_DEF int stbtt_LayoutLineBreak(const stbtt_layout *lo, const char *text, int text_len, float max_width, float *width)
+{
+   const stbtt_uint8 *s = (const stbtt_uint8 *) text;
+   int pos = 0, any = 0, prev = -1, break_pos = 0;
+   float x = 0, w = 0, break_w = 0;
+
+   if (text_len < 0)
+      text_len = (int) STBTT_strlen(text);
+
+   while (pos < text_len) {
+      int codepoint, g, n = stbtt__utf8_decode(s + pos, text_len - pos, &codepoint);
+      if (codepoint == '\n') {
+         pos += n;
+         break;
+      }
+      if (codepoint != '\r') {
+         g = stbtt__layout_glyph(lo, codepoint);
+         x = stbtt__layout_kern(lo, x, prev, g);
+         if (codepoint == ' ') {
+            if (break_pos != pos)
+               break_w = w;
+            break_pos = pos + n;
+         } else if (max_width > 0 && any && x + lo->advances[g] > max_width) {
+            // wrap after the last space, or if there isn't one, right here
+            if (break_pos) {
+               pos = break_pos;
+               w = break_w;
+            }
+            break;
+         }
+         x += lo->advances[g];
+         if (codepoint != ' ')
+            w = x;
+         prev = g;
+         any = 1;
+      }
+      pos += n;
+   }
+
+   if (width) *width = w;
+   return pos;
+}
+
+STBTT_DEF int stbtt_LayoutText(const stbtt_layout *lo, const char *text, int text_len, float max_width,
+                               float *xpos, float *ypos, stbtt_layoutglyph *glyphs, int max_glyphs)
+{
+   const stbtt_uint8 *s = (const stbtt_uint8 *) text;
+   int pos = 0, count = 0, line_start = 0, word_start = -1, prev = -1, i;
+   float line_x = *xpos, y = *ypos, x = 0; // x is relative to line_x
+
+   if (text_len < 0)
+      text_len = (int) STBTT_strlen(text);
+
+   while (pos < text_len && count < max_glyphs) {
+      int codepoint, g, n = stbtt__utf8_decode(s + pos, text_len - pos, &codepoint);
+      stbtt_layoutglyph *q;
+      int x0, y0, x1, y1;
+
+      if (codepoint == '\n') {
+         x = 0;
+         y += lo->line_height;
+         prev = -1;
+         line_start = count;
+         word_start = -1;
+         pos += n;
+         continue;
+      }
+      if (codepoint == '\r') {
+         pos += n;
+         continue;
+      }
+
+      g = stbtt__layout_glyph(lo, codepoint);
+      x = stbtt__layout_kern(lo, x, prev, g);
+      if (codepoint != ' ' && max_width > 0 && count > line_start && x + lo->advances[g] > max_width) {
+         // start a new line, taking along the word so far if there was a space
+         y += lo->line_height;
+         x = 0;
+         prev = -1;
+         if (word_start >= 0) {
+            for (i=word_start; i < count; ++i) {
+               float dx;
+               x = stbtt__layout_kern(lo, x, prev, glyphs[i].glyph);
+               dx = line_x + x - glyphs[i].x;
+               glyphs[i].x = line_x + x;
+               glyphs[i].y = y;
+               glyphs[i].x0 += dx;  glyphs[i].y0 += lo->line_height;
+               glyphs[i].x1 += dx;  glyphs[i].y1 += lo->line_height;
+               x += lo->advances[glyphs[i].glyph];
+               prev = glyphs[i].glyph;
+            }
+            line_start = word_start;
+            word_start = -1;
+            x = stbtt__layout_kern(lo, x, prev, g);
+         } else {
+            line_start = count;
+         }
+         // the word might still be too wide
+         if (count > line_start && x + lo->advances[g] > max_width) {
+            y += lo->line_height;
+            x = 0;
+            prev = -1;
+            line_start = count;
+         }
+      }
+
+      q = &glyphs[count++];
+      q->glyph = g;
+      q->offset = pos;
+      q->x = line_x + x;
+      q->y = y;
+      if (stbtt_GetGlyphBox(lo->info, g, &x0, &y0, &x1, &y1)) {
+         q->x0 = q->x + x0 * lo->scale;
+         q->y0 = y    - y1 * lo->scale;
+         q->x1 = q->x + x1 * lo->scale;
+         q->y1 = y    - y0 * lo->scale;
+      } else {
+         q->x0 = q->x1 = q->x;
+         q->y0 = q->y1 = y;
+      }
+      x += lo->advances[g];
+      prev = g;
+      if (codepoint == ' ')
+         word_start = count;
+      pos += n;
+   }
+
+   *xpos = line_x + x;
+   *ypos = y;
+   return count;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// sdf computation
+//
+
+#define STBTT_min(a,b)  ((a) < (b) ? (a) : (b))
+#define STBTT_max(a,b)  ((a) < (b) ? (b) : (a))
+
+// a crossing of a horizontal ray with the outline; a sample at x is to the right of it
+// if x > min_x and, for lines, x > pos, or for curves, ((pos - x) + a) + b < 0 (the
+// same sum the per-pixel ray test computes, so the results match it exactly)
+typedef struct
+{
+   float pos, a, b, min_x;
+   int dir, curve;
+} stbtt__sdfcrossing;
+
+// finds where a ray from (-infinity,y) to (+infinity,y) crosses the curve q0,q1,q2
+static int stbtt__ray_intersect_bezier(float y, float q0[2], float q1[2], float q2[2], float s[2], float slope[2])
+{
+   float a = q0[1] - 2*q1[1] + q2[1];
+   float b = q1[1] - q0[1];
+   float c = q0[1] - y;
 
    float s0 = 0., s1 = 0.;
    int num_s = 0;
@@ -4431,32 +6338,9 @@ static int stbtt__ray_intersect_bezier(float orig[2], float ray[2], float q0[2],
          num_s = 1;
    }
 
-   if (num_s == 0)
-      return 0;
-   else {
-      float rcp_len2 = 1 / (ray[0]*ray[0] + ray[1]*ray[1]);
-      float rayn_x = ray[0] * rcp_len2, rayn_y = ray[1] * rcp_len2;
-
-      float q0d =   q0[0]*rayn_x +   q0[1]*rayn_y;
-      float q1d =   q1[0]*rayn_x +   q1[1]*rayn_y;
-      float q2d =   q2[0]*rayn_x +   q2[1]*rayn_y;
-      float rod = orig[0]*rayn_x + orig[1]*rayn_y;
-
-      float q10d = q1d - q0d;
-      float q20d = q2d - q0d;
-      float q0rd = q0d - rod;
-
-      hits[0][0] = q0rd + s0*(2.0f - 2.0f*s0)*q10d + s0*s0*q20d;
-      hits[0][1] = a*s0+b;
-
-      if (num_s > 1) {
-         hits[1][0] = q0rd + s1*(2.0f - 2.0f*s1)*q10d + s1*s1*q20d;
-         hits[1][1] = a*s1+b;
-         return 2;
-      } else {
-         return 1;
-      }
-   }
+   s[0] = s0, slope[0] = a*s0+b;
+   s[1] = s1, slope[1] = a*s1+b;
+   return num_s;
 }
 
 static int equal(float *a, float *b)
@@ -4464,12 +6348,11 @@ static int equal(float *a, float *b)
    return (a[0] == b[0] && a[1] == b[1]);
 }
 
-static int stbtt__compute_crossings_x(float x, float y, int nverts, stbtt_vertex *verts)
+// collects the crossings of row y, for stbtt__sdf_winding to test samples against
+static int stbtt__sdf_row_crossings(float y, int nverts, stbtt_vertex *verts, stbtt__sdfcrossing *out)
 {
-   int i;
-   float orig[2], ray[2] = { 1, 0 };
+   int i, n = 0;
    float y_frac;
-   int winding = 0;
 
    // make sure y never passes through a vertex of the shape
    y_frac = (float) STBTT_fmod(y, 1.0f);
@@ -4478,18 +6361,16 @@ static int stbtt__compute_crossings_x(float x, float y, int nverts, stbtt_vertex
    else if (y_frac > 0.99f)
       y -= 0.01f;
 
-   orig[0] = x;
-   orig[1] = y;
-
-   // test a ray from (-infinity,y) to (x,y)
    for (i=0; i < nverts; ++i) {
       if (verts[i].type == STBTT_vline) {
          int x0 = (int) verts[i-1].x, y0 = (int) verts[i-1].y;
          int x1 = (int) verts[i  ].x, y1 = (int) verts[i  ].y;
-         if (y > STBTT_min(y0,y1) && y < STBTT_max(y0,y1) && x > STBTT_min(x0,x1)) {
-            float x_inter = (y - y0) / (y1 - y0) * (x1-x0) + x0;
-            if (x_inter < x)
-               winding += (y0 < y1) ? 1 : -1;
+         if (y > STBTT_min(y0,y1) && y < STBTT_max(y0,y1)) {
+            out[n].pos = (y - y0) / (y1 - y0) * (x1-x0) + x0;
+            out[n].min_x = (float) STBTT_min(x0,x1);
+            out[n].dir = (y0 < y1) ? 1 : -1;
+            out[n].curve = 0;
+            ++n;
          }
       }
       if (verts[i].type == STBTT_vcurve) {
@@ -4498,9 +6379,8 @@ static int stbtt__compute_crossings_x(float x, float y, int nverts, stbtt_vertex
          int x2 = (int) verts[i  ].x , y2 = (int) verts[i  ].y ;
          int ax = STBTT_min(x0,STBTT_min(x1,x2)), ay = STBTT_min(y0,STBTT_min(y1,y2));
          int by = STBTT_max(y0,STBTT_max(y1,y2));
-         if (y > ay && y < by && x > ax) {
+         if (y > ay && y < by) {
             float q0[2],q1[2],q2[2];
-            float hits[2][2];
             q0[0] = (float)x0;
             q0[1] = (float)y0;
             q1[0] = (float)x1;
@@ -4512,26 +6392,181 @@ static int stbtt__compute_crossings_x(float x, float y, int nverts, stbtt_vertex
                y0 = (int)verts[i-1].y;
                x1 = (int)verts[i  ].x;
                y1 = (int)verts[i  ].y;
-               if (y > STBTT_min(y0,y1) && y < STBTT_max(y0,y1) && x > STBTT_min(x0,x1)) {
-                  float x_inter = (y - y0) / (y1 - y0) * (x1-x0) + x0;
-                  if (x_inter < x)
-                     winding += (y0 < y1) ? 1 : -1;
+               if (y > STBTT_min(y0,y1) && y < STBTT_max(y0,y1)) {
+                  out[n].pos = (y - y0) / (y1 - y0) * (x1-x0) + x0;
+                  out[n].min_x = (float) STBTT_min(x0,x1);
+                  out[n].dir = (y0 < y1) ? 1 : -1;
+                  out[n].curve = 0;
+                  ++n;
                }
             } else {
-               int num_hits = stbtt__ray_intersect_bezier(orig, ray, q0, q1, q2, hits);
-               if (num_hits >= 1)
-                  if (hits[0][0] < 0)
-                     winding += (hits[0][1] < 0 ? -1 : 1);
-               if (num_hits >= 2)
-                  if (hits[1][0] < 0)
-                     winding += (hits[1][1] < 0 ? -1 : 1);
+               float s[2], slope[2];
+               float q10d = q1[0] - q0[0];
+               float q20d = q2[0] - q0[0];
+               int k, num_hits = stbtt__ray_intersect_bezier(y, q0, q1, q2, s, slope);
+               for (k=0; k < num_hits; ++k) {
+                  out[n].pos = q0[0];
+                  out[n].a = s[k]*(2.0f - 2.0f*s[k])*q10d;
+                  out[n].b = s[k]*s[k]*q20d;
+                  out[n].min_x = (float) ax;
+                  out[n].dir = (slope[k] < 0 ? -1 : 1);
+                  out[n].curve = 1;
+                  ++n;
+               }
             }
          }
       }
    }
+   return n;
+}
+
+// the winding number at x of the row whose crossings are c[0..n-1]
+static int stbtt__sdf_winding(float x, stbtt__sdfcrossing *c, int n)
+{
+   int i, winding = 0;
+   for (i=0; i < n; ++i) {
+      if (x > c[i].min_x) {
+         if (c[i].curve ? (c[i].pos - x) + c[i].a + c[i].b < 0 : c[i].pos < x)
+            winding += c[i].dir;
+      }
+   }
    return winding;
 }
 
+// Segments are binned into a grid of square cells, each listing the segments
+// that come within 'cutoff' pixels of it, so a sample only measures the
+// segments near it. The cutoff is where the output saturates at 0 or 255, so
+// any segment farther away can't change the result.
+#define STBTT__SDF_CELL  4
+
+typedef struct
+{
+   int w, h, cell;   // size in cells, and the size of a cell in pixels
+   int *first;       // w*h+1 offsets into segs
+   int *segs;
+} stbtt__sdfgrid;
+
+// boxes[] holds x0,y0,x1,y1 for each segment, in pixels relative to the bitmap
+static int stbtt__sdf_build_grid(stbtt__sdfgrid *g, const float *boxes, const int *ids, int n, int w, int h, float cutoff, void *userdata)
+{
+   int i,x,y,pass,total=0;
+
+   // nothing in the bitmap can be farther than this
+   if (cutoff > (float) (w+h))
+      cutoff = (float) (w+h);
+   cutoff += 1;
+
+   g->cell = STBTT__SDF_CELL;
+   if (cutoff > STBTT__SDF_CELL*4)
+      g->cell = (int) cutoff / 4;
+   g->w = (w + g->cell-1) / g->cell;
+   g->h = (h + g->cell-1) / g->cell;
+   g->first = (int *) stbtt__temp_alloc(sizeof(int) * (g->w*g->h+1), userdata);
+   g->segs = NULL;
+   if (g->first == NULL)
+      return 0;
+   STBTT_memset(g->first, 0, sizeof(int) * (g->w*g->h+1));
+
+   // count, then fill; the segments stay in order within each cell
+   for (pass=0; pass < 2; ++pass) {
+      for (i=0; i < n; ++i) {
+         const float *b = boxes + i*4;
+         int cx0 = STBTT_ifloor((b[0] - cutoff) / g->cell), cy0 = STBTT_ifloor((b[1] - cutoff) / g->cell);
+         int cx1 = STBTT_ifloor((b[2] + cutoff) / g->cell), cy1 = STBTT_ifloor((b[3] + cutoff) / g->cell);
+         if (cx0 < 0) cx0 = 0;
+         if (cy0 < 0) cy0 = 0;
+         if (cx1 >= g->w) cx1 = g->w-1;
+         if (cy1 >= g->h) cy1 = g->h-1;
+         for (y=cy0; y <= cy1; ++y)
+            for (x=cx0; x <= cx1; ++x)
+               if (pass == 0)
+                  ++g->first[y*g->w+x];
+               else
+                  g->segs[g->first[y*g->w+x]++] = ids ? ids[i] : i;
+      }
+      if (pass == 0) {
+         for (i=0; i <= g->w*g->h; ++i) {
+            int c = g->first[i];
+            g->first[i] = total;
+            total += c;
+         }
+         g->segs = (int *) stbtt__temp_alloc(sizeof(int) * (total ? total : 1), userdata);
+         if (g->segs == NULL) {
+            stbtt__temp_free(g->first, userdata);
+            return 0;
+         }
+      }
+   }
+
+   // the fill pass advanced each offset to the start of the next cell
+   for (i=g->w*g->h; i > 0; --i)
+      g->first[i] = g->first[i-1];
+   g->first[0] = 0;
+   return 1;
+}
+
+static void stbtt__sdf_free_grid(stbtt__sdfgrid *g, void *userdata)
+{
+   stbtt__temp_free(g->segs, userdata);
+   stbtt__temp_free(g->first, userdata);
+}
+
+// squared distance from (sx,sy) to the segment x0,y0 - x1,y1, whose squared length is 1/inv_len2
+static float stbtt__sdf_chord_dist2(float sx, float sy, float x0, float y0, float x1, float y1, float inv_len2)
+{
+   float dx = x1-x0, dy = y1-y0;
+   float t = ((sx-x0)*dx + (sy-y0)*dy) * inv_len2;
+   if (t < 0) t = 0;
+   if (t > 1) t = 1;
+   dx = x0 + t*dx - sx;
+   dy = y0 + t*dy - sy;
+   return dx*dx + dy*dy;
+}
+
+// the distance code handles lines and quadratics; this splits each cubic in
+// two and approximates the halves with a quadratic each
+static int stbtt__sdf_quadratic_shape(stbtt_vertex **pverts, int num_verts, void *userdata)
+{
+   stbtt_vertex *verts = *pverts, *out;
+   int i, n = 0;
+   for (i=0; i < num_verts; ++i)
+      if (verts[i].type == STBTT_vcubic)
+         break;
+   if (i == num_verts)
+      return num_verts;
+   out = (stbtt_vertex *) stbtt__temp_alloc(num_verts * 2 * sizeof(*out), userdata);
+   if (out == NULL)
+      return num_verts;
+   for (i=0; i < num_verts; ++i) {
+      if (verts[i].type == STBTT_vcubic) {
+         float x0 = verts[i-1].x, y0 = verts[i-1].y;
+         float x3 = verts[i].x, y3 = verts[i].y;
+         float x01 = (x0 + verts[i].cx)*0.5f, y01 = (y0 + verts[i].cy)*0.5f;
+         float x12 = (verts[i].cx + verts[i].cx1)*0.5f, y12 = (verts[i].cy + verts[i].cy1)*0.5f;
+         float x23 = (verts[i].cx1 + x3)*0.5f, y23 = (verts[i].cy1 + y3)*0.5f;
+         float xa = (x01 + x12)*0.5f, ya = (y01 + y12)*0.5f;
+         float xb = (x12 + x23)*0.5f, yb = (y12 + y23)*0.5f;
+         float xm = (xa + xb)*0.5f, ym = (ya + yb)*0.5f;
+         stbtt_setvertex(&out[n++], STBTT_vcurve, STBTT_ifloor(xm + 0.5f), STBTT_ifloor(ym + 0.5f),
+                         STBTT_ifloor((3*(x01+xa) - x0 - xm)*0.25f + 0.5f), STBTT_ifloor((3*(y01+ya) - y0 - ym)*0.25f + 0.5f));
+         stbtt_setvertex(&out[n++], STBTT_vcurve, verts[i].x, verts[i].y,
+                         STBTT_ifloor((3*(xb+x23) - xm - x3)*0.25f + 0.5f), STBTT_ifloor((3*(yb+y23) - ym - y3)*0.25f + 0.5f));
+      } else
+         out[n++] = verts[i];
+   }
+   stbtt__temp_free(verts, userdata);
+   *pverts = out;
+   return n;
+}
+
+// the distance at which onedge_value + pixel_dist_scale*distance leaves 0..255
+static float stbtt__sdf_cutoff(unsigned char onedge_value, float pixel_dist_scale)
+{
+   float range = (float) STBTT_max(onedge_value, 255 - onedge_value);
+   float s = (float) STBTT_fabs(pixel_dist_scale);
+   return s*1e30f > range ? range / s : 1e30f;
+}
+
 static float stbtt__cuberoot( float x )
 {
    if (x<0)
@@ -4606,48 +6641,107 @@ STBTT_DEF unsigned char * stbtt_GetGlyphSDF(const stbtt_fontinfo *info, float sc
    {
       // distance from singular values (in the same units as the pixel grid)
       const float eps = 1./1024, eps2 = eps*eps;
-      int x,y,i,j;
-      float *precompute;
+      int x,y,i,j,k,n,num_crossings;
+      float *precompute, *hull, *boxes, cutoff, far_dist;
+      int *ids;
+      stbtt__sdfcrossing *crossings;
+      stbtt__sdfgrid grid;
       stbtt_vertex *verts;
       int num_verts = stbtt_GetGlyphShape(info, glyph, &verts);
+      num_verts = stbtt__sdf_quadratic_shape(&verts, num_verts, info->userdata);
       data = (unsigned char *) STBTT_malloc(w * h, info->userdata);
-      precompute = (float *) STBTT_malloc(num_verts * sizeof(float), info->userdata);
+      precompute = (float *) stbtt__temp_alloc(num_verts * sizeof(float), info->userdata);
+      hull = (float *) stbtt__temp_alloc(num_verts * 2 * sizeof(float), info->userdata);
+      boxes = (float *) stbtt__temp_alloc(num_verts * 4 * sizeof(float), info->userdata);
+      ids = (int *) stbtt__temp_alloc(num_verts * sizeof(int), info->userdata);
+      crossings = (stbtt__sdfcrossing *) stbtt__temp_alloc(num_verts * 2 * sizeof(*crossings), info->userdata);
+      if (!data || !precompute || !hull || !boxes || !ids || !crossings) {
+         stbtt__temp_free(crossings, info->userdata);
+         stbtt__temp_free(ids, info->userdata);
+         stbtt__temp_free(boxes, info->userdata);
+         stbtt__temp_free(hull, info->userdata);
+         stbtt__temp_free(precompute, info->userdata);
+         STBTT_free(data, info->userdata);
+         stbtt__temp_free(verts, info->userdata);
+         return NULL;
+      }
 
+      n = 0;
       for (i=0,j=num_verts-1; i < num_verts; j=i++) {
+         float *b = boxes + n*4;
          if (verts[i].type == STBTT_vline) {
             float x0 = verts[i].x*scale_x, y0 = verts[i].y*scale_y;
             float x1 = verts[j].x*scale_x, y1 = verts[j].y*scale_y;
             float dist = (float) STBTT_sqrt((x1-x0)*(x1-x0) + (y1-y0)*(y1-y0));
             precompute[i] = (dist < eps) ? 0.0f : 1.0f / dist;
+            if (precompute[i] != 0.0f) {
+               b[0] = STBTT_min(x0,x1); b[1] = STBTT_min(y0,y1);
+               b[2] = STBTT_max(x0,x1); b[3] = STBTT_max(y0,y1);
+               ids[n++] = i;
+            }
          } else if (verts[i].type == STBTT_vcurve) {
             float x2 = verts[j].x *scale_x, y2 = verts[j].y *scale_y;
             float x1 = verts[i].cx*scale_x, y1 = verts[i].cy*scale_y;
             float x0 = verts[i].x *scale_x, y0 = verts[i].y *scale_y;
             float bx = x0 - 2*x1 + x2, by = y0 - 2*y1 + y2;
             float len2 = bx*bx + by*by;
+            float cx = x0 - x2, cy = y0 - y2;
+            float chord2 = cx*cx + cy*cy;
             if (len2 >= eps2)
                precompute[i] = 1.0f / len2;
             else
                precompute[i] = 0.0f;
+            // the curve is never farther from its chord than half of the
+            // control point's distance from the chord's midpoint
+            hull[i*2+0] = (chord2 < eps2) ? 0.0f : 1.0f / chord2;
+            hull[i*2+1] = (float) STBTT_sqrt(bx*bx + by*by) * 0.25f + 1.0f/64;
+            b[0] = STBTT_min(STBTT_min(x0,x1),x2); b[1] = STBTT_min(STBTT_min(y0,y1),y2);
+            b[2] = STBTT_max(STBTT_max(x0,x1),x2); b[3] = STBTT_max(STBTT_max(y0,y1),y2);
+            ids[n++] = i;
          } else
             precompute[i] = 0.0f;
       }
+      for (i=0; i < n*4; i += 2) {
+         boxes[i  ] -= ix0;
+         boxes[i+1] -= iy0;
+      }
+
+      // past the cutoff every distance gives the same clamped output, so start
+      // the search there; that lets the bbox test below skip most curves
+      cutoff = stbtt__sdf_cutoff(onedge_value, pixel_dist_scale);
+      far_dist = STBTT_min(cutoff + 1, 999999.0f);
+
+      if (!stbtt__sdf_build_grid(&grid, boxes, ids, n, w, h, cutoff, info->userdata)) {
+         stbtt__temp_free(crossings, info->userdata);
+         stbtt__temp_free(ids, info->userdata);
+         stbtt__temp_free(boxes, info->userdata);
+         stbtt__temp_free(hull, info->userdata);
+         stbtt__temp_free(precompute, info->userdata);
+         STBTT_free(data, info->userdata);
+         stbtt__temp_free(verts, info->userdata);
+         return NULL;
+      }
 
       for (y=iy0; y < iy1; ++y) {
+         const int *row_cells = grid.first + ((y-iy0) / grid.cell) * grid.w;
+         num_crossings = stbtt__sdf_row_crossings(((float) y + 0.5f) / scale_y, num_verts, verts, crossings);
+
          for (x=ix0; x < ix1; ++x) {
             float val;
-            float min_dist = 999999.0f;
+            float min_dist = far_dist;
             float sx = (float) x + 0.5f;
             float sy = (float) y + 0.5f;
             float x_gspace = (sx / scale_x);
-            float y_gspace = (sy / scale_y);
+            const int *cell = row_cells + (x-ix0) / grid.cell;
 
-            int winding = stbtt__compute_crossings_x(x_gspace, y_gspace, num_verts, verts); // @OPTIMIZE: this could just be a rasterization, but needs to be line vs. non-tesselated curves so a new path
+            int winding = stbtt__sdf_winding(x_gspace, crossings, num_crossings);
 
-            for (i=0; i < num_verts; ++i) {
-               float x0 = verts[i].x*scale_x, y0 = verts[i].y*scale_y;
+            for (k=cell[0]; k < cell[1]; ++k) {
+               float x0,y0;
+               i = grid.segs[k];
+               x0 = verts[i].x*scale_x, y0 = verts[i].y*scale_y;
 
-               if (verts[i].type == STBTT_vline && precompute[i] != 0.0f) {
+               if (verts[i].type == STBTT_vline) {
                   float x1 = verts[i-1].x*scale_x, y1 = verts[i-1].y*scale_y;
 
                   float dist,dist2 = (x0-sx)*(x0-sx) + (y0-sy)*(y0-sy);
@@ -4678,8 +6772,9 @@ STBTT_DEF unsigned char * stbtt_GetGlyphSDF(const stbtt_fontinfo *info, float sc
                   float box_y0 = STBTT_min(STBTT_min(y0,y1),y2);
                   float box_x1 = STBTT_max(STBTT_max(x0,x1),x2);
                   float box_y1 = STBTT_max(STBTT_max(y0,y1),y2);
-                  // coarse culling against bbox to avoid computing cubic unnecessarily
-                  if (sx > box_x0-min_dist && sx < box_x1+min_dist && sy > box_y0-min_dist && sy < box_y1+min_dist) {
+                  // coarse culling against bbox and chord to avoid computing cubic unnecessarily
+                  if (sx > box_x0-min_dist && sx < box_x1+min_dist && sy > box_y0-min_dist && sy < box_y1+min_dist &&
+                      stbtt__sdf_chord_dist2(sx, sy, x2, y2, x0, y0, hull[i*2]) < (min_dist + hull[i*2+1]) * (min_dist + hull[i*2+1])) {
                      int num=0;
                      float ax = x1-x0, ay = y1-y0;
                      float bx = x0 - 2*x1 + x2, by = y0 - 2*y1 + y2;
@@ -4753,8 +6848,13 @@ STBTT_DEF unsigned char * stbtt_GetGlyphSDF(const stbtt_fontinfo *info, float sc
             data[(y-iy0)*w+(x-ix0)] = (unsigned char) val;
          }
       }
-      STBTT_free(precompute, info->userdata);
-      STBTT_free(verts, info->userdata);
+      stbtt__sdf_free_grid(&grid, info->userdata);
+      stbtt__temp_free(crossings, info->userdata);
+      stbtt__temp_free(ids, info->userdata);
+      stbtt__temp_free(boxes, info->userdata);
+      stbtt__temp_free(hull, info->userdata);
+      stbtt__temp_free(precompute, info->userdata);
+      stbtt__temp_free(verts, info->userdata);
    }
    return data;
 }
@@ -4769,6 +6869,375 @@ STBTT_DEF void stbtt_FreeSDF(unsigned char *bitmap, void *userdata)
    STBTT_free(bitmap, userdata);
 }
 
+//////////////////////////////////////////////////////////////////////////////
+//
+// multi-channel sdf
+//
+// Each edge is given one or more of the three channels ("colored") so that
+// the two edges meeting at a corner always share exactly one channel. Each
+// channel is then the signed distance to the nearest edge of its color, and
+// the median of the three keeps corners sharp, which a single channel rounds
+// off. Distances at the ends of edges are measured to the edge's tangent
+// line ("pseudo-distance"), so the channels extend the edges past corners.
+
+#define STBTT__MSDF_RED      1
+#define STBTT__MSDF_GREEN    2
+#define STBTT__MSDF_BLUE     4
+#define STBTT__MSDF_WHITE    7
+
+typedef struct
+{
+   float x0,y0, cx,cy, x1,y1;  // in pixels relative to the bitmap, y down
+   int curve, color;
+} stbtt__msdfedge;
+
+static void stbtt__msdf_dir(const stbtt__msdfedge *e, float t, float *dx, float *dy)
+{
+   if (e->curve) {
+      *dx = (e->cx - e->x0) + t*(e->x1 - 2*e->cx + e->x0);
+      *dy = (e->cy - e->y0) + t*(e->y1 - 2*e->cy + e->y0);
+      if (*dx == 0 && *dy == 0) {
+         *dx = e->x1 - e->x0;
+         *dy = e->y1 - e->y0;
+      }
+   } else {
+      *dx = e->x1 - e->x0;
+      *dy = e->y1 - e->y0;
+   }
+}
+
+static int stbtt__msdf_is_corner(const stbtt__msdfedge *a, const stbtt__msdfedge *b)
+{
+   float ax,ay,bx,by,la,lb,dot,cross;
+   stbtt__msdf_dir(a, 1, &ax, &ay);
+   stbtt__msdf_dir(b, 0, &bx, &by);
+   la = (float) STBTT_sqrt(ax*ax + ay*ay);
+   lb = (float) STBTT_sqrt(bx*bx + by*by);
+   if (la == 0 || lb == 0)
+      return 0;
+   dot = (ax*bx + ay*by) / (la*lb);
+   cross = (ax*by - ay*bx) / (la*lb);
+   // anything sharper than about 8 degrees off straight
+   return dot <= 0 || STBTT_fabs(cross) > 0.1411200f; // sin(3)
+}
+
+// cycles cyan -> magenta -> yellow, or picks the one color that's neither 'color' nor 'banned'
+static int stbtt__msdf_switch_color(int color, int banned)
+{
+   int combined = color & banned;
+   if (combined == STBTT__MSDF_RED || combined == STBTT__MSDF_GREEN || combined == STBTT__MSDF_BLUE)
+      return combined ^ STBTT__MSDF_WHITE;
+   color <<= 1;
+   return (color | (color >> 3)) & STBTT__MSDF_WHITE;
+}
+
+static void stbtt__msdf_color_contour(stbtt__msdfedge *e, int n)
+{
+   int i, corners = 0, first_corner = 0;
+
+   for (i=0; i < n; ++i) {
+      if (stbtt__msdf_is_corner(&e[(i+n-1) % n], &e[i])) {
+         if (corners++ == 0)
+            first_corner = i;
+      }
+   }
+
+   if (corners == 0 || (corners == 1 && n < 3)) {
+      // smooth, or a teardrop too short to split up: a plain sdf is fine
+      for (i=0; i < n; ++i)
+         e[i].color = STBTT__MSDF_WHITE;
+   } else if (corners == 1) {
+      // teardrop: split it into thirds around the corner
+      static const int colors[3] = { STBTT__MSDF_RED|STBTT__MSDF_BLUE, STBTT__MSDF_WHITE, STBTT__MSDF_RED|STBTT__MSDF_GREEN };
+      for (i=0; i < n; ++i)
+         e[(first_corner + i) % n].color = colors[(int) (3 + 2.875f*i/(n-1) - 1.4375f + 0.5f) - 2];
+   } else {
+      // switch colors at every corner; the last run mustn't match the first
+      int color = STBTT__MSDF_GREEN|STBTT__MSDF_BLUE, initial = color, seen = 0;
+      for (i=0; i < n; ++i) {
+         int k = (first_corner + i) % n;
+         if (i > 0 && stbtt__msdf_is_corner(&e[(k+n-1) % n], &e[k])) {
+            ++seen;
+            color = stbtt__msdf_switch_color(color, seen == corners-1 ? initial : 0);
+         }
+         e[k].color = color;
+      }
+   }
+}
+
+// squared distance from (px,py) to the nearest point of e, and where that is along e
+static float stbtt__msdf_nearest(const stbtt__msdfedge *e, float px, float py, float *t_out)
+{
+   float mx = e->x0 - px, my = e->y0 - py;
+   float best, t = 0;
+   if (!e->curve) {
+      float dx = e->x1 - e->x0, dy = e->y1 - e->y0;
+      t = -(mx*dx + my*dy) / (dx*dx + dy*dy);
+      if (t < 0) t = 0;
+      if (t > 1) t = 1;
+      mx += t*dx;
+      my += t*dy;
+      best = mx*mx + my*my;
+   } else {
+      // minimize |B(t)-p|^2 where B(t) = p0 + 2*t*a + t*t*b
+      float ax = e->cx - e->x0, ay = e->cy - e->y0;
+      float bx = e->x1 - 2*e->cx + e->x0, by = e->y1 - 2*e->cy + e->y0;
+      float res[3];
+      float b2 = bx*bx + by*by;
+      float qa = 3*(ax*bx + ay*by), qb = 2*(ax*ax + ay*ay) + (mx*bx + my*by), qc = mx*ax + my*ay;
+      int i, num = 0;
+      float ex = e->x1 - px, ey = e->y1 - py, d2;
+
+      best = mx*mx + my*my;
+      d2 = ex*ex + ey*ey;
+      if (d2 < best)
+         best = d2, t = 1;
+
+      if (b2 >= 1.0f/(1024*1024)) {
+         num = stbtt__solve_cubic(qa / b2, qb / b2, qc / b2, res);
+      } else if (STBTT_fabs(qa) >= 1.0f/(1024*1024)) {
+         float discriminant = qb*qb - 4*qa*qc;
+         if (discriminant >= 0) {
+            float root = (float) STBTT_sqrt(discriminant);
+            res[0] = (-qb - root)/(2*qa);
+            res[1] = (-qb + root)/(2*qa);
+            num = 2;
+         }
+      } else if (STBTT_fabs(qb) >= 1.0f/(1024*1024)) {
+         res[0] = -qc/qb;
+         num = 1;
+      }
+      for (i=0; i < num; ++i) {
+         float s = res[i];
+         if (s > 0 && s < 1) {
+            float x = mx + 2*s*ax + s*s*bx, y = my + 2*s*ay + s*s*by;
+            d2 = x*x + y*y;
+            if (d2 < best)
+               best = d2, t = s;
+         }
+      }
+   }
+   *t_out = t;
+   return best;
+}
+
+// signed distance to the nearest point, or to the tangent line past the ends;
+// positive on the left of the edge
+static float stbtt__msdf_signed_dist(const stbtt__msdfedge *e, float px, float py, float t, float dist)
+{
+   float dx,dy,qx,qy,cross;
+   stbtt__msdf_dir(e, t, &dx, &dy);
+   if (e->curve) {
+      float it = 1-t;
+      qx = it*it*e->x0 + 2*t*it*e->cx + t*t*e->x1;
+      qy = it*it*e->y0 + 2*t*it*e->cy + t*t*e->y1;
+   } else {
+      qx = e->x0 + t*(e->x1 - e->x0);
+      qy = e->y0 + t*(e->y1 - e->y0);
+   }
+   cross = dx*(py-qy) - dy*(px-qx);
+   if (cross < 0)
+      dist = -dist;
+   if (t == 0 || t == 1) {
+      float len = (float) STBTT_sqrt(dx*dx + dy*dy);
+      float along = dx*(px-qx) + dy*(py-qy);
+      if (len > 0 && (t == 0 ? along < 0 : along > 0)) {
+         float pseudo = cross / len;
+         if (STBTT_fabs(pseudo) <= STBTT_fabs(dist))
+            dist = pseudo;
+      }
+   }
+   return dist;
+}
+
+STBTT_DEF unsigned char * stbtt_GetGlyphMSDF(const stbtt_fontinfo *info, float scale, int glyph, int padding, unsigned char onedge_value, float pixel_dist_scale, int *width, int *height, int *xoff, int *yoff)
+{
+   int ix0,iy0,ix1,iy1;
+   int w,h,x,y,i,k,n,num_verts,num_crossings,contour;
+   float cutoff, far_dist, area, orient;
+   unsigned char *data;
+   stbtt_vertex *verts;
+   stbtt__msdfedge *edges;
+   stbtt__sdfcrossing *crossings;
+   stbtt__sdfgrid grid;
+   float *boxes;
+
+   if (scale == 0) return NULL;
+
+   stbtt_GetGlyphBitmapBoxSubpixel(info, glyph, scale, scale, 0.0f,0.0f, &ix0,&iy0,&ix1,&iy1);
+
+   // if empty, return NULL
+   if (ix0 == ix1 || iy0 == iy1)
+      return NULL;
+
+   ix0 -= padding;
+   iy0 -= padding;
+   ix1 += padding;
+   iy1 += padding;
+
+   w = (ix1 - ix0);
+   h = (iy1 - iy0);
+
+   if (width ) *width  = w;
+   if (height) *height = h;
+   if (xoff  ) *xoff   = ix0;
+   if (yoff  ) *yoff   = iy0;
+
+   num_verts = stbtt_GetGlyphShape(info, glyph, &verts);
+   num_verts = stbtt__sdf_quadratic_shape(&verts, num_verts, info->userdata);
+   data = (unsigned char *) STBTT_malloc(w * h * 3, info->userdata);
+   edges = (stbtt__msdfedge *) stbtt__temp_alloc(num_verts * sizeof(*edges), info->userdata);
+   boxes = (float *) stbtt__temp_alloc(num_verts * 4 * sizeof(float), info->userdata);
+   crossings = (stbtt__sdfcrossing *) stbtt__temp_alloc(num_verts * 2 * sizeof(*crossings), info->userdata);
+   if (!data || !edges || !boxes || !crossings)
+      goto error;
+
+   // edges in pixel space, each contour's edges contiguous
+   n = 0;
+   area = 0;
+   contour = 0;
+   for (i=0; i <= num_verts; ++i) {
+      if (i == num_verts || verts[i].type == STBTT_vmove) {
+         if (n > contour)
+            stbtt__msdf_color_contour(edges + contour, n - contour);
+         contour = n;
+      } else {
+         stbtt__msdfedge *e = &edges[n];
+         e->x0 = verts[i-1].x * scale - ix0, e->y0 = -verts[i-1].y * scale - iy0;
+         e->x1 = verts[i  ].x * scale - ix0, e->y1 = -verts[i  ].y * scale - iy0;
+         e->cx = verts[i].cx * scale - ix0, e->cy = -verts[i].cy * scale - iy0;
+         e->curve = verts[i].type == STBTT_vcurve;
+         if (e->curve && ((e->cx == e->x0 && e->cy == e->y0) || (e->cx == e->x1 && e->cy == e->y1)))
+            e->curve = 0;
+         if (e->x0 == e->x1 && e->y0 == e->y1 && !e->curve)
+            continue;
+         if (e->curve) {
+            area += (2.0f/3) * ((e->x0*e->cy - e->cx*e->y0) + (e->cx*e->y1 - e->x1*e->cy)) + (1.0f/3) * (e->x0*e->y1 - e->x1*e->y0);
+            boxes[n*4+0] = STBTT_min(STBTT_min(e->x0,e->cx),e->x1);
+            boxes[n*4+1] = STBTT_min(STBTT_min(e->y0,e->cy),e->y1);
+            boxes[n*4+2] = STBTT_max(STBTT_max(e->x0,e->cx),e->x1);
+            boxes[n*4+3] = STBTT_max(STBTT_max(e->y0,e->cy),e->y1);
+         } else {
+            area += e->x0*e->y1 - e->x1*e->y0;
+            boxes[n*4+0] = STBTT_min(e->x0,e->x1);
+            boxes[n*4+1] = STBTT_min(e->y0,e->y1);
+            boxes[n*4+2] = STBTT_max(e->x0,e->x1);
+            boxes[n*4+3] = STBTT_max(e->y0,e->y1);
+         }
+         ++n;
+      }
+   }
+   // outer contours run the opposite way in TrueType and CFF; the filled
+   // side of an edge is the side the total area says it is
+   orient = area < 0 ? -1.0f : 1.0f;
+
+   cutoff = stbtt__sdf_cutoff(onedge_value, pixel_dist_scale);
+   far_dist = STBTT_min(cutoff + 1, 999999.0f);
+   if (!stbtt__sdf_build_grid(&grid, boxes, NULL, n, w, h, cutoff, info->userdata))
+      goto error;
+
+   for (y=0; y < h; ++y) {
+      const int *row_cells = grid.first + (y / grid.cell) * grid.w;
+      float sy = (float) y + 0.5f;
+      num_crossings = stbtt__sdf_row_crossings((sy + iy0) / -scale, num_verts, verts, crossings);
+
+      for (x=0; x < w; ++x) {
+         float sx = (float) x + 0.5f;
+         float best_d2[3], best_t[3], dist[3], med, min_d2;
+         int best[3], c, inside;
+         const int *cell = row_cells + x / grid.cell;
+
+         for (c=0; c < 3; ++c) {
+            best_d2[c] = far_dist*far_dist;
+            best_t[c] = 0;
+            best[c] = -1;
+         }
+
+         for (k=cell[0]; k < cell[1]; ++k) {
+            const stbtt__msdfedge *e = &edges[grid.segs[k]];
+            const float *b = boxes + grid.segs[k]*4;
+            float t, d2, limit = 0, bx, by;
+            for (c=0; c < 3; ++c)
+               if ((e->color >> c) & 1)
+                  limit = STBTT_max(limit, best_d2[c]);
+            // coarse culling against bbox
+            bx = sx < b[0] ? b[0]-sx : sx > b[2] ? sx-b[2] : 0;
+            by = sy < b[1] ? b[1]-sy : sy > b[3] ? sy-b[3] : 0;
+            if (bx*bx + by*by > limit)
+               continue;
+
+            d2 = stbtt__msdf_nearest(e, sx, sy, &t);
+            for (c=0; c < 3; ++c) {
+               if (((e->color >> c) & 1) && d2 <= best_d2[c]) {
+                  // at a shared corner point, prefer the edge that points away from the sample
+                  if (d2 == best_d2[c] && best[c] >= 0 && (t == 0 || t == 1)) {
+                     float ax,ay,bx2,by2,qx,qy,la,lb;
+                     stbtt__msdf_dir(e, t, &ax, &ay);
+                     stbtt__msdf_dir(&edges[best[c]], best_t[c], &bx2, &by2);
+                     qx = (t == 0 ? e->x0 : e->x1) - sx;
+                     qy = (t == 0 ? e->y0 : e->y1) - sy;
+                     la = (float) STBTT_fabs(ax*qx + ay*qy) / (float) STBTT_sqrt(ax*ax + ay*ay);
+                     lb = (float) STBTT_fabs(bx2*qx + by2*qy) / (float) STBTT_sqrt(bx2*bx2 + by2*by2);
+                     if (la >= lb)
+                        continue;
+                  } else if (d2 == best_d2[c])
+                     continue;
+                  best_d2[c] = d2;
+                  best_t[c] = t;
+                  best[c] = grid.segs[k];
+               }
+            }
+         }
+
+         inside = stbtt__sdf_winding((sx + ix0) / scale, crossings, num_crossings) != 0;
+         min_d2 = STBTT_min(best_d2[0], STBTT_min(best_d2[1], best_d2[2]));
+         for (c=0; c < 3; ++c) {
+            if (best[c] >= 0)
+               dist[c] = orient * stbtt__msdf_signed_dist(&edges[best[c]], sx, sy, best_t[c], (float) STBTT_sqrt(best_d2[c]));
+            else
+               dist[c] = inside ? far_dist : -far_dist;
+         }
+
+         // where the channels disagree with the actual inside/outside (edges
+         // of different colors crossing between samples), fall back to the sdf
+         med = STBTT_max(STBTT_min(dist[0], dist[1]), STBTT_min(STBTT_max(dist[0], dist[1]), dist[2]));
+         if ((med > 0) != inside) {
+            float d = (float) STBTT_sqrt(min_d2);
+            dist[0] = dist[1] = dist[2] = inside ? d : -d;
+         }
+
+         for (c=0; c < 3; ++c) {
+            float val = onedge_value + pixel_dist_scale * dist[c];
+            if (val < 0)
+               val = 0;
+            else if (val > 255)
+               val = 255;
+            data[(y*w+x)*3+c] = (unsigned char) val;
+         }
+      }
+   }
+
+   stbtt__sdf_free_grid(&grid, info->userdata);
+   stbtt__temp_free(crossings, info->userdata);
+   stbtt__temp_free(boxes, info->userdata);
+   stbtt__temp_free(edges, info->userdata);
+   stbtt__temp_free(verts, info->userdata);
+   return data;
+
+error:
+   stbtt__temp_free(crossings, info->userdata);
+   stbtt__temp_free(boxes, info->userdata);
+   stbtt__temp_free(edges, info->userdata);
+   STBTT_free(data, info->userdata);
+   stbtt__temp_free(verts, info->userdata);
+   return NULL;
+}
+
+STBTT_DEF unsigned char * stbtt_GetCodepointMSDF(const stbtt_fontinfo *info, float scale, int codepoint, int padding, unsigned char onedge_value, float pixel_dist_scale, int *width, int *height, int *xoff, int *yoff)
+{
+   return stbtt_GetGlyphMSDF(info, scale, stbtt_FindGlyphIndex(info, codepoint), padding, onedge_value, pixel_dist_scale, width, height, xoff, yoff);
+}
+
 //////////////////////////////////////////////////////////////////////////////
 //
 // font name matching -- recommended not to use this
@@ -17,6 +17,11 @@ static const char img6x5_template[] =
    ".*...."
    ".*....";
 
+static void image_write_test_to_file(void *context, void *data, int size)
+{
+   fwrite(data, 1, size, (FILE *) context);
+}
+
 void image_write_test(void)
 {
    // make a RGB version of the template image
@@ -42,6 +47,34 @@ void image_write_test(void)
    stbi_write_jpg("output/wr6x5_regular.jpg", 6, 5, 3, img6x5_rgb, 95);
    stbi_write_hdr("output/wr6x5_regular.hdr", 6, 5, 3, img6x5_rgbf);
 
+   stbi_write_jpg_optimize_huffman = 1;
+   stbi_write_jpg("output/wr6x5_optimized.jpg", 6, 5, 3, img6x5_rgb, 95);
+   stbi_write_jpg_optimize_huffman = 0;
+
+   stbi_write_jpg_progressive = 1;
+   stbi_write_jpg("output/wr6x5_progressive.jpg", 6, 5, 3, img6x5_rgb, 95);
+   stbi_write_jpg_progressive = 0;
+
+   stbi_write_jpg_chroma_subsampling = 422;
+   stbi_write_jpg("output/wr6x5_422.jpg", 6, 5, 3, img6x5_rgb, 95);
+   stbi_write_jpg_chroma_subsampling = -1;
+
+   {
+      // encode twice through one context to exercise buffer reuse
+      stbi_write_png_context ctx = { 0 };
+      FILE *f = fopen("output/wr6x5_context.png", "wb");
+      if (f) {
+         stbi_write_png_to_func_ctx(&ctx, image_write_test_to_file, f, 6, 5, 3, img6x5_rgb, 6*3);
+         fclose(f);
+      }
+      f = fopen("output/wr6x5_context2.png", "wb");
+      if (f) {
+         stbi_write_png_to_func_ctx(&ctx, image_write_test_to_file, f, 6, 5, 3, img6x5_rgb, 6*3);
+         fclose(f);
+      }
+      stbi_write_png_context_free(&ctx);
+   }
+
    stbi_flip_vertically_on_write(1);
 
    stbi_write_png("output/wr6x5_flip.png", 6, 5, 3, img6x5_rgb, 6*3);
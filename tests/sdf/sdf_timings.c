@@ -0,0 +1,134 @@
+// Times stbtt_GetGlyphSDF and stbtt_GetGlyphMSDF at a few sizes, and prints a
+//   checksum of the fields so builds can be compared.
+//
+//   gcc -O2 sdf_timings.c -I../.. -lm -o sdf_timings
+//   sdf_timings [font.ttf]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+
+#include <windows.h>
+
+static double get_milliseconds()
+{
+  LARGE_INTEGER c, f;
+  QueryPerformanceCounter( &c );
+  QueryPerformanceFrequency( &f );
+  return (double) c.QuadPart * 1000.0 / (double) f.QuadPart;
+}
+
+#else
+
+#include <time.h>
+
+static double get_milliseconds()
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (double) ts.tv_sec * 1000.0 + (double) ts.tv_nsec / 1000000.0;
+}
+
+#endif
+
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "stb_truetype.h"
+
+#define REPEATS 3
+#define FIRST_CHAR 33
+#define NUM_CHARS 94
+
+typedef struct
+{
+  float size;
+  int padding;
+  unsigned char onedge_value;
+  float pixel_dist_scale;
+} sdf_case;
+
+// the first is what sdf_test.c uses
+static sdf_case cases[] =
+{
+  {  32, 3, 128,  64 },
+  {  16, 4, 128,  32 },
+  {  64, 8, 180,  36 },
+  { 128, 8, 128,  16 },
+};
+
+static unsigned char ttf_buffer[ 1 << 25 ];
+
+static unsigned int checksum( unsigned int h, unsigned char const * p, int n )
+{
+  int i;
+  for( i = 0 ; i < n ; i++ )
+    h = ( h ^ p[ i ] ) * 16777619u;
+  return h;
+}
+
+static double time_sdf( stbtt_fontinfo * font, sdf_case const * c, int multi, unsigned int * hash )
+{
+  float scale = stbtt_ScaleForPixelHeight( font, c->size );
+  double best = 1e30;
+  int r, i;
+
+  *hash = 2166136261u;
+  for( r = 0 ; r < REPEATS ; r++ )
+  {
+    double t = get_milliseconds();
+    for( i = 0 ; i < NUM_CHARS ; i++ )
+    {
+      int w, h, xoff, yoff;
+      unsigned char * data;
+      if ( multi )
+        data = stbtt_GetCodepointMSDF( font, scale, FIRST_CHAR + i, c->padding, c->onedge_value, c->pixel_dist_scale, &w, &h, &xoff, &yoff );
+      else
+        data = stbtt_GetCodepointSDF( font, scale, FIRST_CHAR + i, c->padding, c->onedge_value, c->pixel_dist_scale, &w, &h, &xoff, &yoff );
+      if ( data )
+      {
+        if ( r == 0 )
+          *hash = checksum( *hash, data, w * h * ( multi ? 3 : 1 ) );
+        stbtt_FreeSDF( data, NULL );
+      }
+    }
+    t = get_milliseconds() - t;
+    if ( t < best )
+      best = t;
+  }
+  return best;
+}
+
+int main( int argc, char ** argv )
+{
+  stbtt_fontinfo font;
+  FILE * f;
+  int c;
+
+  f = fopen( ( argc > 1 ) ? argv[1] : "c:/windows/fonts/times.ttf", "rb" );
+  if ( f == 0 )
+  {
+    printf( "can't open font\n" );
+    return 1;
+  }
+  fread( ttf_buffer, 1, sizeof( ttf_buffer ), f );
+  fclose( f );
+
+  if ( !stbtt_InitFont( &font, ttf_buffer, stbtt_GetFontOffsetForIndex( ttf_buffer, 0 ) ) )
+    return 1;
+
+  printf( "%d glyphs, best of %d\n\n", NUM_CHARS, REPEATS );
+
+  for( c = 0 ; c < (int) ( sizeof( cases ) / sizeof( cases[0] ) ) ; c++ )
+  {
+    unsigned int sdf_hash, msdf_hash;
+    double sdf_ms = time_sdf( &font, cases + c, 0, &sdf_hash );
+    double msdf_ms = time_sdf( &font, cases + c, 1, &msdf_hash );
+
+    printf( "%3.0fpx pad %d edge %3d scale %3.0f:  sdf %8.2f ms (%08x)  msdf %8.2f ms (%08x)\n",
+            cases[ c ].size, cases[ c ].padding, cases[ c ].onedge_value, cases[ c ].pixel_dist_scale,
+            sdf_ms, sdf_hash, msdf_ms, msdf_hash );
+  }
+
+  return 0;
+}
@@ -79,6 +79,27 @@ int main(int argc, char **argv)
    }
 #endif
 
+#if 1
+   {
+      static stbtt_glyphcache gc;
+      static unsigned char pages[4*256*256];
+      stbtt_glyphcache_stats stats;
+      stbtt_packedchar pc;
+      int frame;
+
+      stbtt_GlyphCacheBegin(&gc, pages, 256,256, 4, 512, 1, NULL);
+      stbtt_GlyphCacheSetSubpixelBuckets(&gc, 4);
+      for (frame=0; frame < 64; ++frame) {
+         for (i=0; i < 64; ++i)
+            stbtt_GlyphCacheGet(&gc, &font, (frame*4 + i) % font.numGlyphs, stbtt_ScaleForPixelHeight(&font, 24.0f), (i & 3) * 0.25f, &pc);
+         stbtt_GlyphCacheNextFrame(&gc);
+      }
+      stbtt_GlyphCacheGetStats(&gc, &stats, 0);
+      printf("glyph cache: %u hits, %u misses, %u evictions, %u failures\n", stats.hits, stats.misses, stats.evictions, stats.failures);
+      stbtt_GlyphCacheEnd(&gc);
+   }
+#endif
+
 
 #if 1
    {
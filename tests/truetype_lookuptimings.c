@@ -0,0 +1,252 @@
+// Checks that the flattened cmap (stbtt_BuildGlyphLookup) gives the same glyph
+//   for every codepoint as searching the cmap, and that the kerning index
+//   (stbtt_BuildKernIndex) gives the same advances as parsing GPOS/kern, and
+//   times both on a text run.
+//
+//   gcc -O2 truetype_lookuptimings.c -I.. -lm -o truetype_lookuptimings
+//   truetype_lookuptimings [font.ttf]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+
+#include <windows.h>
+
+static double get_milliseconds()
+{
+  LARGE_INTEGER c, f;
+  QueryPerformanceCounter( &c );
+  QueryPerformanceFrequency( &f );
+  return (double) c.QuadPart * 1000.0 / (double) f.QuadPart;
+}
+
+#else
+
+#include <time.h>
+
+static double get_milliseconds()
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (double) ts.tv_sec * 1000.0 + (double) ts.tv_nsec / 1000000.0;
+}
+
+#endif
+
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "stb_truetype.h"
+
+#define REPEATS 5
+#define TEXT_LENGTH 4096
+#define PASSES 100
+
+static unsigned char ttf_buffer[ 1 << 25 ];
+
+static int text[ TEXT_LENGTH ];
+static int glyphs[ TEXT_LENGTH ];
+static int reference[ TEXT_LENGTH ];
+static int advances[ TEXT_LENGTH ];
+static int reference_advances[ TEXT_LENGTH ];
+
+// mostly ASCII words, with some Latin-1, Latin Extended, Greek, punctuation and the odd astral codepoint
+static void make_text( void )
+{
+  static int const others[] = { 0xe9, 0xfc, 0xdf, 0x153, 0x17e, 0x3b1, 0x3c9, 0x2014, 0x201c, 0x201d, 0x20ac, 0x1f600 };
+  unsigned int seed = 12345;
+  int i;
+  for( i = 0 ; i < TEXT_LENGTH ; i++ )
+  {
+    seed = seed * 1664525u + 1013904223u;
+    if ( ( seed >> 28 ) == 0 )
+      text[ i ] = ' ';
+    else if ( ( ( seed >> 20 ) & 31 ) == 0 )
+      text[ i ] = others[ ( seed >> 8 ) % ( sizeof( others ) / sizeof( others[0] ) ) ];
+    else
+      text[ i ] = 'a' + (int) ( ( seed >> 8 ) % 26 );
+  }
+}
+
+int main( int argc, char ** argv )
+{
+  stbtt_fontinfo font, indexed;
+  FILE * f;
+  int i, r, p, failed = 0;
+  double cmap_ms = 1e30, lookup_ms = 1e30, bulk_ms = 1e30, build_ms;
+  double parse_ms = 1e30, index_ms = 1e30, batch_ms = 1e30, kern_build_ms;
+  int g1, g2, pairs = 0, kerned = 0;
+
+  f = fopen( ( argc > 1 ) ? argv[1] : "c:/windows/fonts/DejaVuSans.ttf", "rb" );
+  if ( f == 0 )
+  {
+    printf( "can't open font\n" );
+    return 1;
+  }
+  fread( ttf_buffer, 1, sizeof( ttf_buffer ), f );
+  fclose( f );
+
+  if ( !stbtt_InitFont( &font, ttf_buffer, stbtt_GetFontOffsetForIndex( ttf_buffer, 0 ) ) )
+    return 1;
+  if ( !stbtt_InitFont( &indexed, ttf_buffer, stbtt_GetFontOffsetForIndex( ttf_buffer, 0 ) ) )
+    return 1;
+
+  build_ms = get_milliseconds();
+  if ( !stbtt_BuildGlyphLookup( &indexed ) )
+  {
+    printf( "stbtt_BuildGlyphLookup failed\n" );
+    return 1;
+  }
+  build_ms = get_milliseconds() - build_ms;
+
+  // every codepoint (and a few out of range ones) must map to the same glyph
+  for( i = -2 ; i <= 0x110001 ; i++ )
+  {
+    int a = stbtt_FindGlyphIndex( &font, i );
+    int b = stbtt_FindGlyphIndex( &indexed, i );
+    if ( a != b )
+    {
+      if ( !failed )
+        printf( "  MISMATCH at U+%04X: cmap %d, lookup %d\n", i, a, b );
+      failed = 1;
+    }
+  }
+
+  make_text();
+  for( i = 0 ; i < TEXT_LENGTH ; i++ )
+    reference[ i ] = stbtt_FindGlyphIndex( &font, text[ i ] );
+
+  for( r = 0 ; r < REPEATS ; r++ )
+  {
+    double t = get_milliseconds();
+    for( p = 0 ; p < PASSES ; p++ )
+      for( i = 0 ; i < TEXT_LENGTH ; i++ )
+        glyphs[ i ] = stbtt_FindGlyphIndex( &font, text[ i ] );
+    t = get_milliseconds() - t;
+    if ( t < cmap_ms )
+      cmap_ms = t;
+
+    t = get_milliseconds();
+    for( p = 0 ; p < PASSES ; p++ )
+      for( i = 0 ; i < TEXT_LENGTH ; i++ )
+        glyphs[ i ] = stbtt_FindGlyphIndex( &indexed, text[ i ] );
+    t = get_milliseconds() - t;
+    if ( t < lookup_ms )
+      lookup_ms = t;
+
+    t = get_milliseconds();
+    for( p = 0 ; p < PASSES ; p++ )
+      stbtt_FindGlyphIndices( &indexed, text, TEXT_LENGTH, glyphs );
+    t = get_milliseconds() - t;
+    if ( t < bulk_ms )
+      bulk_ms = t;
+  }
+
+  if ( memcmp( glyphs, reference, sizeof( glyphs ) ) != 0 )
+  {
+    printf( "  stbtt_FindGlyphIndices MISMATCH!\n" );
+    failed = 1;
+  }
+  // and the same without the lookup
+  stbtt_FindGlyphIndices( &font, text, TEXT_LENGTH, glyphs );
+  if ( memcmp( glyphs, reference, sizeof( glyphs ) ) != 0 )
+  {
+    printf( "  stbtt_FindGlyphIndices (no lookup) MISMATCH!\n" );
+    failed = 1;
+  }
+
+  kern_build_ms = get_milliseconds();
+  if ( !stbtt_BuildKernIndex( &indexed ) )
+  {
+    printf( "stbtt_BuildKernIndex failed\n" );
+    return 1;
+  }
+  kern_build_ms = get_milliseconds() - kern_build_ms;
+
+  // every pair of the glyphs in the text, plus a spread over the whole font (and one past the end)
+  for( i = 0 ; i < TEXT_LENGTH ; i++ )
+  {
+    for( p = 0 ; p < TEXT_LENGTH ; p += 37 )
+    {
+      int a = stbtt_GetGlyphKernAdvance( &font, reference[ i ], reference[ p ] );
+      int b = stbtt_GetGlyphKernAdvance( &indexed, reference[ i ], reference[ p ] );
+      ++pairs;
+      kerned += ( a != 0 );
+      if ( a != b )
+      {
+        if ( !failed )
+          printf( "  MISMATCH at glyphs %d,%d: parsed %d, index %d\n", reference[ i ], reference[ p ], a, b );
+        failed = 1;
+      }
+    }
+  }
+  for( g1 = 0 ; g1 <= font.numGlyphs ; g1 += 7 )
+  {
+    for( g2 = 0 ; g2 <= font.numGlyphs ; g2 += ( g2 < 512 ) ? 1 : 13 )
+    {
+      int a = stbtt_GetGlyphKernAdvance( &font, g1, g2 );
+      int b = stbtt_GetGlyphKernAdvance( &indexed, g1, g2 );
+      ++pairs;
+      kerned += ( a != 0 );
+      if ( a != b )
+      {
+        if ( !failed )
+          printf( "  MISMATCH at glyphs %d,%d: parsed %d, index %d\n", g1, g2, a, b );
+        failed = 1;
+      }
+    }
+  }
+
+  for( i = 0 ; i < TEXT_LENGTH - 1 ; i++ )
+    reference_advances[ i ] = stbtt_GetGlyphKernAdvance( &font, reference[ i ], reference[ i + 1 ] );
+  reference_advances[ TEXT_LENGTH - 1 ] = 0;
+
+  for( r = 0 ; r < REPEATS ; r++ )
+  {
+    double t = get_milliseconds();
+    for( p = 0 ; p < PASSES ; p++ )
+      for( i = 0 ; i < TEXT_LENGTH - 1 ; i++ )
+        advances[ i ] = stbtt_GetGlyphKernAdvance( &font, reference[ i ], reference[ i + 1 ] );
+    t = get_milliseconds() - t;
+    if ( t < parse_ms )
+      parse_ms = t;
+
+    t = get_milliseconds();
+    for( p = 0 ; p < PASSES ; p++ )
+      for( i = 0 ; i < TEXT_LENGTH - 1 ; i++ )
+        advances[ i ] = stbtt_GetGlyphKernAdvance( &indexed, reference[ i ], reference[ i + 1 ] );
+    t = get_milliseconds() - t;
+    if ( t < index_ms )
+      index_ms = t;
+
+    t = get_milliseconds();
+    for( p = 0 ; p < PASSES ; p++ )
+      stbtt_GetGlyphKernAdvances( &indexed, reference, TEXT_LENGTH, advances );
+    t = get_milliseconds() - t;
+    if ( t < batch_ms )
+      batch_ms = t;
+  }
+
+  if ( memcmp( advances, reference_advances, sizeof( advances ) ) != 0 )
+  {
+    printf( "  stbtt_GetGlyphKernAdvances MISMATCH!\n" );
+    failed = 1;
+  }
+  // and the same without the index
+  stbtt_GetGlyphKernAdvances( &font, reference, TEXT_LENGTH, advances );
+  if ( memcmp( advances, reference_advances, sizeof( advances ) ) != 0 )
+  {
+    printf( "  stbtt_GetGlyphKernAdvances (no index) MISMATCH!\n" );
+    failed = 1;
+  }
+
+  printf( "%d codepoints x %d, best of %d (lookup built in %.2f ms, kern index in %.2f ms)\n\n", TEXT_LENGTH, PASSES, REPEATS, build_ms, kern_build_ms );
+  printf( "cmap search: %7.2f ms  lookup: %7.2f ms  %5.2fx  bulk: %7.2f ms  %5.2fx\n",
+          cmap_ms, lookup_ms, cmap_ms / lookup_ms, bulk_ms, cmap_ms / bulk_ms );
+  printf( "kern parse:  %7.2f ms  index:  %7.2f ms  %5.2fx  batch: %7.2f ms  %5.2fx  (%d of %d pairs checked were kerned)\n",
+          parse_ms, index_ms, parse_ms / index_ms, batch_ms, parse_ms / batch_ms, kerned, pairs );
+
+  stbtt_FreeKernIndex( &indexed );
+  stbtt_FreeGlyphLookup( &indexed );
+  return failed;
+}
@@ -0,0 +1,228 @@
+// Times stbtt_PackFontRangesRenderIntoRectsThreaded from 1 to N threads, and checks
+//   that every thread count produces the same atlas and packedchars as the single
+//   threaded stbtt_PackFontRangesRenderIntoRects.
+//
+//   gcc -O2 truetype_packtimings.c -I.. -lpthread -lm -o truetype_packtimings
+//   truetype_packtimings [max_threads] [font.ttf]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "stb_rect_pack.h"
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "stb_truetype.h"
+
+#ifdef _MSC_VER
+
+#include <windows.h>
+
+static int get_cpu_count()
+{
+  SYSTEM_INFO si;
+  GetSystemInfo( &si );
+  return (int) si.dwNumberOfProcessors;
+}
+
+static double get_milliseconds()
+{
+  LARGE_INTEGER c, f;
+  QueryPerformanceCounter( &c );
+  QueryPerformanceFrequency( &f );
+  return (double) c.QuadPart * 1000.0 / (double) f.QuadPart;
+}
+
+#else
+
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+static int get_cpu_count()
+{
+  return (int) sysconf( _SC_NPROCESSORS_ONLN );
+}
+
+static double get_milliseconds()
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (double) ts.tv_sec * 1000.0 + (double) ts.tv_nsec / 1000000.0;
+}
+
+#endif
+
+#define REPEATS 5
+#define MAX_THREADS 64
+#define ATLAS_W 2048
+#define ATLAS_H 2048
+#define SPLITS_PER_THREAD 4
+
+static float sizes[] = { 12, 16, 24, 32, 48 };
+#define NUM_SIZES ( sizeof( sizes ) / sizeof( sizes[0] ) )
+
+// ASCII plus Latin-1 and Latin Extended-A at every size
+#define FIRST_CHAR 32
+#define NUM_CHARS ( 0x180 - 32 )
+
+static unsigned char ttf_buffer[ 1 << 25 ];
+
+// a minimal job system: thread t runs tasks t, t+threads, t+2*threads...
+typedef struct
+{
+  stbtt_task_func * task;
+  void * task_data;
+  int first, step, count;
+} worker;
+
+static void run_worker( worker * w )
+{
+  int i;
+  for( i = w->first ; i < w->count ; i += w->step )
+    w->task( w->task_data, i );
+}
+
+#ifdef _MSC_VER
+static DWORD WINAPI worker_thread( LPVOID p ) { run_worker( (worker *) p ); return 0; }
+#else
+static void * worker_thread( void * p ) { run_worker( (worker *) p ); return 0; }
+#endif
+
+static void dispatch( stbtt_task_func * task, void * task_data, int task_count, void * dispatch_context )
+{
+  int threads = *(int *) dispatch_context;
+  worker workers[ MAX_THREADS ];
+  int i;
+#ifdef _MSC_VER
+  HANDLE handles[ MAX_THREADS ];
+#else
+  pthread_t handles[ MAX_THREADS ];
+#endif
+
+  if ( threads < 1 )
+    threads = 1;
+  for( i = 0 ; i < threads ; i++ )
+  {
+    workers[ i ].task = task;
+    workers[ i ].task_data = task_data;
+    workers[ i ].first = i;
+    workers[ i ].step = threads;
+    workers[ i ].count = task_count;
+  }
+
+  // this thread does the first share
+  for( i = 1 ; i < threads ; i++ )
+  {
+#ifdef _MSC_VER
+    handles[ i ] = CreateThread( 0, 0, worker_thread, workers + i, 0, 0 );
+#else
+    pthread_create( handles + i, 0, worker_thread, workers + i );
+#endif
+  }
+  run_worker( workers );
+  for( i = 1 ; i < threads ; i++ )
+  {
+#ifdef _MSC_VER
+    WaitForSingleObject( handles[ i ], INFINITE );
+    CloseHandle( handles[ i ] );
+#else
+    pthread_join( handles[ i ], 0 );
+#endif
+  }
+}
+
+// packs every size into the atlas, timing just the rendering
+static double bake( stbtt_fontinfo * font, unsigned char * atlas, stbtt_packedchar * chardata, int threads, int * ok )
+{
+  stbtt_pack_context pc;
+  stbtt_pack_range ranges[ NUM_SIZES ];
+  static stbrp_rect rects[ NUM_SIZES * NUM_CHARS ];
+  double t;
+  int i, n;
+
+  memset( atlas, 0, ATLAS_W * ATLAS_H );
+  stbtt_PackBegin( &pc, atlas, ATLAS_W, ATLAS_H, 0, 1, NULL );
+  stbtt_PackSetOversampling( &pc, 2, 1 );
+  for( i = 0 ; i < (int) NUM_SIZES ; i++ )
+  {
+    ranges[ i ].font_size = sizes[ i ];
+    ranges[ i ].first_unicode_codepoint_in_range = FIRST_CHAR;
+    ranges[ i ].array_of_unicode_codepoints = NULL;
+    ranges[ i ].num_chars = NUM_CHARS;
+    ranges[ i ].chardata_for_range = chardata + i * NUM_CHARS;
+  }
+  n = stbtt_PackFontRangesGatherRects( &pc, font, ranges, NUM_SIZES, rects );
+  stbtt_PackFontRangesPackRects( &pc, rects, n );
+
+  t = get_milliseconds();
+  if ( threads == 0 )
+    *ok = stbtt_PackFontRangesRenderIntoRects( &pc, font, ranges, NUM_SIZES, rects );
+  else
+    *ok = stbtt_PackFontRangesRenderIntoRectsThreaded( &pc, font, ranges, NUM_SIZES, rects, threads * SPLITS_PER_THREAD, dispatch, &threads );
+  t = get_milliseconds() - t;
+
+  stbtt_PackEnd( &pc );
+  return t;
+}
+
+int main( int argc, char ** argv )
+{
+  static stbtt_packedchar ref_chars[ NUM_SIZES * NUM_CHARS ], chars[ NUM_SIZES * NUM_CHARS ];
+  int max_threads = ( argc > 1 ) ? atoi( argv[1] ) : get_cpu_count();
+  unsigned char * reference, * atlas;
+  stbtt_fontinfo font;
+  double base = 0.0;
+  int failed = 0;
+  int t, r, ref_ok, ok;
+  FILE * f;
+
+  if ( max_threads < 1 ) max_threads = 1;
+  if ( max_threads > MAX_THREADS ) max_threads = MAX_THREADS;
+
+  f = fopen( ( argc > 2 ) ? argv[2] : "c:/windows/fonts/DejaVuSans.ttf", "rb" );
+  if ( f == 0 )
+  {
+    printf( "can't open font\n" );
+    return 1;
+  }
+  fread( ttf_buffer, 1, sizeof( ttf_buffer ), f );
+  fclose( f );
+
+  if ( !stbtt_InitFont( &font, ttf_buffer, stbtt_GetFontOffsetForIndex( ttf_buffer, 0 ) ) )
+    return 1;
+
+  reference = (unsigned char *) malloc( ATLAS_W * ATLAS_H );
+  atlas = (unsigned char *) malloc( ATLAS_W * ATLAS_H );
+  if ( ( reference == 0 ) || ( atlas == 0 ) )
+    return 1;
+
+  printf( "%d glyphs at %d sizes into %dx%d, 1 to %d threads, best of %d\n\n", NUM_CHARS, (int) NUM_SIZES, ATLAS_W, ATLAS_H, max_threads, REPEATS );
+
+  bake( &font, reference, ref_chars, 0, &ref_ok );
+
+  for( t = 1 ; t <= max_threads ; t++ )
+  {
+    double best = 1e30;
+    for( r = 0 ; r < REPEATS ; r++ )
+    {
+      double ms = bake( &font, atlas, chars, t, &ok );
+      if ( ms < best )
+        best = ms;
+    }
+
+    if ( t == 1 )
+      base = best;
+    if ( ( ok != ref_ok ) || ( memcmp( reference, atlas, ATLAS_W * ATLAS_H ) != 0 ) || ( memcmp( ref_chars, chars, sizeof( chars ) ) != 0 ) )
+    {
+      printf( "  MISMATCH with %d threads!\n", t );
+      failed = 1;
+    }
+
+    printf( "  %2d threads: %8.2f ms  %5.2fx\n", t, best, base / best );
+  }
+
+  free( atlas );
+  free( reference );
+  return failed;
+}
@@ -0,0 +1,138 @@
+// Times glyph rasterization at common text sizes, grayscale and LCD, and prints
+//   a checksum of the rendered pixels so builds with different options can be
+//   compared.
+//
+//   gcc -O2 truetype_timings.c -I.. -lm -o truetype_timings
+//   gcc -O2 -DSTBTT_NO_SIMD truetype_timings.c -I.. -lm -o truetype_timings_scalar
+//   truetype_timings [font.ttf]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+
+#include <windows.h>
+
+static double get_milliseconds()
+{
+  LARGE_INTEGER c, f;
+  QueryPerformanceCounter( &c );
+  QueryPerformanceFrequency( &f );
+  return (double) c.QuadPart * 1000.0 / (double) f.QuadPart;
+}
+
+#else
+
+#include <time.h>
+
+static double get_milliseconds()
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (double) ts.tv_sec * 1000.0 + (double) ts.tv_nsec / 1000000.0;
+}
+
+#endif
+
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "stb_truetype.h"
+
+#define REPEATS 5
+#define FIRST_CHAR 33
+#define NUM_CHARS 94
+
+static float sizes[] = { 12, 16, 24, 32, 48, 72 };
+
+static unsigned char ttf_buffer[ 1 << 25 ];
+static unsigned char pixels[ 256 * 256 * 3 ];
+
+static unsigned int checksum( unsigned int h, unsigned char const * p, int n )
+{
+  int i;
+  for( i = 0 ; i < n ; i++ )
+    h = ( h ^ p[ i ] ) * 16777619u;
+  return h;
+}
+
+int main( int argc, char ** argv )
+{
+  stbtt_fontinfo font;
+  unsigned char gamma[ 256 ];
+  int glyphs[ NUM_CHARS ];
+  FILE * f;
+  int s, i, r;
+
+  f = fopen( ( argc > 1 ) ? argv[1] : "c:/windows/fonts/DejaVuSans.ttf", "rb" );
+  if ( f == 0 )
+  {
+    printf( "can't open font\n" );
+    return 1;
+  }
+  fread( ttf_buffer, 1, sizeof( ttf_buffer ), f );
+  fclose( f );
+
+  if ( !stbtt_InitFont( &font, ttf_buffer, stbtt_GetFontOffsetForIndex( ttf_buffer, 0 ) ) )
+    return 1;
+  for( i = 0 ; i < NUM_CHARS ; i++ )
+    glyphs[ i ] = stbtt_FindGlyphIndex( &font, FIRST_CHAR + i );
+  stbtt_MakeCoverageGammaTable( gamma, 1.8f );
+
+  printf( "%d glyphs per pass, best of %d\n\n", NUM_CHARS, REPEATS );
+
+  for( s = 0 ; s < (int) ( sizeof( sizes ) / sizeof( sizes[0] ) ) ; s++ )
+  {
+    float scale = stbtt_ScaleForPixelHeight( &font, sizes[ s ] );
+    double best = 1e30;
+    unsigned int hash = 2166136261u;
+    int passes = (int) ( 2000 / sizes[ s ] );
+
+    double lcd_best = 1e30;
+    unsigned int lcd_hash = 2166136261u;
+
+    for( r = 0 ; r < REPEATS ; r++ )
+    {
+      double t = get_milliseconds();
+      int p;
+      for( p = 0 ; p < passes ; p++ )
+      {
+        for( i = 0 ; i < NUM_CHARS ; i++ )
+        {
+          int x0, y0, x1, y1;
+          stbtt_GetGlyphBitmapBox( &font, glyphs[ i ], scale, scale, &x0, &y0, &x1, &y1 );
+          stbtt_MakeGlyphBitmap( &font, pixels, x1 - x0, y1 - y0, x1 - x0, scale, scale, glyphs[ i ] );
+          if ( ( r == 0 ) && ( p == 0 ) )
+            hash = checksum( hash, pixels, ( x1 - x0 ) * ( y1 - y0 ) );
+        }
+      }
+      t = get_milliseconds() - t;
+      if ( t < best )
+        best = t;
+    }
+
+    for( r = 0 ; r < REPEATS ; r++ )
+    {
+      double t = get_milliseconds();
+      int p;
+      for( p = 0 ; p < passes ; p++ )
+      {
+        for( i = 0 ; i < NUM_CHARS ; i++ )
+        {
+          int x0, y0, x1, y1;
+          stbtt_GetGlyphBitmapBoxLCD( &font, glyphs[ i ], scale, scale, 0.0f, 0.0f, &x0, &y0, &x1, &y1 );
+          stbtt_MakeGlyphBitmapLCD( &font, pixels, x1 - x0, y1 - y0, ( x1 - x0 ) * 3, scale, scale, 0.0f, 0.0f, gamma, 0, glyphs[ i ] );
+          if ( ( r == 0 ) && ( p == 0 ) )
+            lcd_hash = checksum( lcd_hash, pixels, ( x1 - x0 ) * ( y1 - y0 ) * 3 );
+        }
+      }
+      t = get_milliseconds() - t;
+      if ( t < lcd_best )
+        lcd_best = t;
+    }
+
+    printf( "%3.0fpx: %9.0f glyphs/s  checksum %08x   lcd %9.0f glyphs/s  checksum %08x\n", sizes[ s ],
+            (double) passes * NUM_CHARS * 1000.0 / best, hash, (double) passes * NUM_CHARS * 1000.0 / lcd_best, lcd_hash );
+  }
+
+  return 0;
+}